@@ -0,0 +1,220 @@
+/*****************************************************************************
+* \file      bench_csv.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Throughput of bstr_csv_reader_t on a synthetic CSV export, whole buffer and in chunks
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bstr_csv.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_RECORDS 400000
+#define NUM_ROUNDS 5
+#define MAX_FIELDS 16
+#define CHUNK_SIZE 65536u
+
+typedef size_t (*parse_func_t)(const uint8_t *pBegin, const uint8_t *pEnd);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t *generate_input(size_t *length);
+static size_t parse_csv(const uint8_t *pBegin, const uint8_t *pEnd);
+static size_t parse_csv_chunked(const uint8_t *pBegin, const uint8_t *pEnd);
+static size_t parse_bytewise(const uint8_t *pBegin, const uint8_t *pEnd);
+static double run(parse_func_t func, const uint8_t *pBegin, const uint8_t *pEnd, size_t *count);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint32_t m_featureSets[4] = {0u, BSTR_SIMD_SSE2, BSTR_SIMD_SSE2 | BSTR_SIMD_PCLMUL | BSTR_SIMD_AVX2, 0xFFFFFFFFu};
+static const char *m_featureNames[4] = {"scalar", "sse2", "avx2", "best"};
+static const char *m_words[8] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel"};
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(void)
+{
+   size_t length;
+   size_t count;
+   double seconds;
+   int i;
+   uint8_t *input = generate_input(&length);
+   if (input == 0)
+   {
+      return 1;
+   }
+   printf("%u records, %u bytes\n", (unsigned) NUM_RECORDS, (unsigned) length);
+   seconds = run(parse_bytewise, input, input + length, &count);
+   printf("   byte loop:         %8.1f MB/s %u fields\n", (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count);
+   for (i = 0; i < 4; i++)
+   {
+      uint32_t features = bstr_simd_set_features(m_featureSets[i]);
+      seconds = run(parse_csv, input, input + length, &count);
+      printf("   bstr_csv (%-6s):  %8.1f MB/s %u fields (features 0x%02x)\n", m_featureNames[i], (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count, (unsigned) features);
+   }
+   seconds = run(parse_csv_chunked, input, input + length, &count);
+   printf("   bstr_csv chunked:  %8.1f MB/s %u fields (%u byte chunks)\n", (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count, (unsigned) CHUNK_SIZE);
+   free(input);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns NUM_RECORDS records looking like a database export: an id, a name, a quoted free text column where every
+ * tenth value has doubled quotes and every fiftieth an embedded newline, an amount and a date.
+ */
+static uint8_t *generate_input(size_t *length)
+{
+   uint8_t *input = (uint8_t*) malloc((size_t) NUM_RECORDS * 160u);
+   size_t offset = 0u;
+   int i;
+   if (input == 0)
+   {
+      return 0;
+   }
+   srand(1234);
+   for (i = 0; i < NUM_RECORDS; i++)
+   {
+      char tmp[160];
+      const char *note = ((i % 50) == 0) ? "multi\nline" : (((i % 10) == 0) ? "said \"\"hello\"\"" : "plain text, with comma");
+      int len = sprintf(tmp, "%d,%s %s,\"%s %s\",%d.%02d,2026-%02d-%02d\r\n", i, m_words[rand() % 8], m_words[rand() % 8],
+                        note, m_words[rand() % 8], rand() % 100000, rand() % 100, 1 + rand() % 12, 1 + rand() % 28);
+      memcpy(&input[offset], tmp, (size_t) len);
+      offset += (size_t) len;
+   }
+   *length = offset;
+   return input;
+}
+
+static size_t parse_csv(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   bstr_csv_reader_t reader;
+   bstr_csv_field_t fields[MAX_FIELDS];
+   size_t count = 0u;
+   bstr_csv_reader_create(&reader, pBegin, pEnd, (uint8_t) ',', 0u);
+   for (;;)
+   {
+      size_t numFields;
+      if ( (bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields) != BSTR_NO_ERROR) || (numFields == 0u) )
+      {
+         break;
+      }
+      count += numFields;
+   }
+   return count;
+}
+
+/**
+ * Reads the input through a CHUNK_SIZE buffer, carrying incomplete records over like a reader of a file or socket would.
+ */
+static size_t parse_csv_chunked(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   static uint8_t buffer[CHUNK_SIZE * 2u];
+   bstr_csv_field_t fields[MAX_FIELDS];
+   const uint8_t *pNext = pBegin;
+   size_t carry = 0u;
+   size_t count = 0u;
+   for (;;)
+   {
+      bstr_csv_reader_t reader;
+      size_t chunkSize = ((size_t) (pEnd - pNext) < CHUNK_SIZE) ? (size_t) (pEnd - pNext) : CHUNK_SIZE;
+      bool isLast = (pNext + chunkSize == pEnd);
+      const uint8_t *pRest;
+      memcpy(&buffer[carry], pNext, chunkSize);
+      pNext += chunkSize;
+      bstr_csv_reader_create(&reader, &buffer[0], &buffer[carry + chunkSize], (uint8_t) ',', isLast ? 0u : BSTR_CSV_PARTIAL);
+      for (;;)
+      {
+         size_t numFields;
+         if ( (bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields) != BSTR_NO_ERROR) || (numFields == 0u) )
+         {
+            break;
+         }
+         count += numFields;
+      }
+      if (isLast)
+      {
+         break;
+      }
+      pRest = bstr_csv_reader_rest(&reader);
+      carry = (size_t) (&buffer[carry + chunkSize] - pRest);
+      memmove(&buffer[0], pRest, carry);
+   }
+   return count;
+}
+
+/**
+ * Reference state machine looking at one byte at a time.
+ */
+static size_t parse_bytewise(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const uint8_t *pNext;
+   size_t count = 0u;
+   bool inQuote = false;
+   for (pNext = pBegin; pNext < pEnd; pNext++)
+   {
+      uint8_t c = *pNext;
+      if (c == (uint8_t) '"')
+      {
+         inQuote = !inQuote;
+      }
+      else if ( !inQuote && ( (c == (uint8_t) ',') || (c == (uint8_t) '\n') ) )
+      {
+         count++;
+      }
+   }
+   return count;
+}
+
+/**
+ * Returns the best time in seconds out of NUM_ROUNDS runs multiplied by NUM_ROUNDS.
+ */
+static double run(parse_func_t func, const uint8_t *pBegin, const uint8_t *pEnd, size_t *count)
+{
+   double best = 0.0;
+   int round;
+   for (round = 0; round < NUM_ROUNDS; round++)
+   {
+      clock_t start = clock();
+      double seconds;
+      *count = func(pBegin, pEnd);
+      seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+      if ( (round == 0) || (seconds < best) )
+      {
+         best = seconds;
+      }
+   }
+   return best * NUM_ROUNDS;
+}
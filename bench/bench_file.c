@@ -0,0 +1,230 @@
+/*****************************************************************************
+* \file      bench_file.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Reading a file into a malloc buffer against mapping it with bstr_file_t
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bstr_file.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define BENCH_FILE_NAME "bstr_bench_file.tmp"
+#define NUM_LINES 2000000
+#define NUM_ROUNDS 5
+#define WINDOW_SIZE ((size_t) 16u * 1024u * 1024u)
+
+typedef size_t (*read_func_t)(uint32_t flags, double *openSeconds);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static size_t generate_file(void);
+static size_t read_malloc(uint32_t flags, double *openSeconds);
+static size_t read_mapped(uint32_t flags, double *openSeconds);
+static size_t read_window(uint32_t flags, double *openSeconds);
+static size_t count_lines(const uint8_t *pBegin, const uint8_t *pEnd);
+static void run(const char *name, read_func_t func, uint32_t flags, size_t length);
+static double now(void);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(void)
+{
+   size_t length = generate_file();
+   if (length == 0u)
+   {
+      return 1;
+   }
+   printf("%u lines, %u bytes (warm page cache)\n", (unsigned) NUM_LINES, (unsigned) length);
+   run("fread into malloc", read_malloc, 0u, length);
+   run("bstr_file_open", read_mapped, 0u, length);
+   run("  sequential", read_mapped, BSTR_FILE_SEQUENTIAL, length);
+   run("  populate", read_mapped, BSTR_FILE_POPULATE, length);
+   run("  huge pages", read_mapped, BSTR_FILE_SEQUENTIAL | BSTR_FILE_HUGE_PAGES, length);
+   run("16 MB window", read_window, BSTR_FILE_SEQUENTIAL, length);
+   (void) remove(BENCH_FILE_NAME);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes NUM_LINES lines of newline-delimited JSON and returns the file size, 0 on failure.
+ */
+static size_t generate_file(void)
+{
+   FILE *fh = fopen(BENCH_FILE_NAME, "wb");
+   size_t length = 0u;
+   int i;
+   if (fh == 0)
+   {
+      return 0u;
+   }
+   for (i = 0; i < NUM_LINES; i++)
+   {
+      int len = fprintf(fh, "{\"id\":%d,\"level\":\"%s\",\"message\":\"request %d took %d ms\",\"score\":%d.%03d}\n",
+                        i, ((i % 7) == 0) ? "warn" : "info", i * 7, i % 1000, i % 100, i % 1000);
+      length += (len > 0) ? (size_t) len : 0u;
+   }
+   return (fclose(fh) == 0) ? length : 0u;
+}
+
+static size_t read_malloc(uint32_t flags, double *openSeconds)
+{
+   double start = now();
+   FILE *fh = fopen(BENCH_FILE_NAME, "rb");
+   uint8_t *data;
+   long size;
+   size_t count = 0u;
+   (void) flags;
+   if (fh == 0)
+   {
+      return 0u;
+   }
+   (void) fseek(fh, 0, SEEK_END);
+   size = ftell(fh);
+   (void) fseek(fh, 0, SEEK_SET);
+   data = (uint8_t*) malloc((size_t) size);
+   if ( (data != 0) && (fread(data, 1u, (size_t) size, fh) == (size_t) size) )
+   {
+      *openSeconds = now() - start;
+      count = count_lines(data, data + size);
+   }
+   free(data);
+   (void) fclose(fh);
+   return count;
+}
+
+static size_t read_mapped(uint32_t flags, double *openSeconds)
+{
+   double start = now();
+   bstr_file_t file;
+   size_t count = 0u;
+   if (bstr_file_open(&file, BENCH_FILE_NAME, flags) == BSTR_NO_ERROR)
+   {
+      *openSeconds = now() - start;
+      count = count_lines(file.pBegin, file.pEnd);
+      bstr_file_close(&file);
+   }
+   return count;
+}
+
+static size_t read_window(uint32_t flags, double *openSeconds)
+{
+   double start = now();
+   bstr_file_t file;
+   size_t count = 0u;
+   if (bstr_file_open_window(&file, BENCH_FILE_NAME, WINDOW_SIZE, flags) == BSTR_NO_ERROR)
+   {
+      *openSeconds = now() - start;
+      while (file.pBegin < file.pEnd)
+      {
+         //slide the window past the last complete line
+         const uint8_t *pLast = file.pEnd;
+         while ( (pLast > file.pBegin) && (pLast[-1] != (uint8_t) '\n') )
+         {
+            pLast--;
+         }
+         if (bstr_file_at_end(&file))
+         {
+            pLast = file.pEnd;
+         }
+         count += count_lines(file.pBegin, pLast);
+         if ( (pLast == file.pBegin) || (bstr_file_advance(&file, pLast) != BSTR_NO_ERROR) )
+         {
+            break;
+         }
+      }
+      bstr_file_close(&file);
+   }
+   return count;
+}
+
+static size_t count_lines(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   size_t count = 0u;
+   const uint8_t *pNext = pBegin;
+   while (pNext < pEnd)
+   {
+      const uint8_t *pLineEnd = bstr_line(pNext, pEnd);
+      if (*pLineEnd != (uint8_t) '\n')
+      {
+         break;
+      }
+      count++;
+      pNext = pLineEnd + 1;
+   }
+   return count;
+}
+
+/**
+ * Prints the best open time (until the first byte can be read) and total time out of NUM_ROUNDS runs.
+ */
+static void run(const char *name, read_func_t func, uint32_t flags, size_t length)
+{
+   double bestOpen = 0.0;
+   double bestTotal = 0.0;
+   size_t count = 0u;
+   int round;
+   for (round = 0; round < NUM_ROUNDS; round++)
+   {
+      double start = now();
+      double openSeconds = 0.0;
+      double seconds;
+      count = func(flags, &openSeconds);
+      seconds = now() - start;
+      if ( (round == 0) || (seconds < bestTotal) )
+      {
+         bestTotal = seconds;
+      }
+      if ( (round == 0) || (openSeconds < bestOpen) )
+      {
+         bestOpen = openSeconds;
+      }
+   }
+   printf("   %-18s open %8.3f ms, total %8.1f MB/s %u lines\n", name, bestOpen * 1e3, (double) length / bestTotal / 1e6, (unsigned) count);
+}
+
+/**
+ * Wall-clock time, clock() doesn't count time spent waiting for I/O.
+ */
+static double now(void)
+{
+   struct timespec ts;
+   (void) timespec_get(&ts, TIME_UTC);
+   return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
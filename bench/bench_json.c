@@ -0,0 +1,367 @@
+/*****************************************************************************
+* \file      bench_json.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Throughput of the tape-based bstr_json_document_t against parsing call by call with bstr_parse_json_* functions
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bstr_json.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_RECORDS 100000
+#define NUM_ROUNDS 5
+
+typedef size_t (*parse_func_t)(const uint8_t *pBegin, const uint8_t *pEnd);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t *generate_input(size_t *length);
+static size_t parse_tape(const uint8_t *pBegin, const uint8_t *pEnd);
+static size_t parse_tape_walk(const uint8_t *pBegin, const uint8_t *pEnd);
+static size_t count_values(bstr_json_value_t value);
+static size_t cursor_last_score(const uint8_t *pBegin, const uint8_t *pEnd);
+static size_t cursor_all_scores(const uint8_t *pBegin, const uint8_t *pEnd);
+static size_t tape_all_scores(const uint8_t *pBegin, const uint8_t *pEnd);
+static size_t parse_call_by_call(const uint8_t *pBegin, const uint8_t *pEnd);
+static const uint8_t *walk_value(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, adt_str_t *str, size_t *count);
+static double run(parse_func_t func, const uint8_t *pBegin, const uint8_t *pEnd, size_t *count);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint32_t m_featureSets[4] = {0u, BSTR_SIMD_SSE2, BSTR_SIMD_SSE2 | BSTR_SIMD_PCLMUL | BSTR_SIMD_AVX2, 0xFFFFFFFFu};
+static const char *m_featureNames[4] = {"scalar", "sse2", "avx2", "best"};
+static const char *m_words[8] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel"};
+static bstr_json_document_t m_document; //reused between rounds like a long-running reader would
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(void)
+{
+   size_t length;
+   size_t count;
+   double seconds;
+   int i;
+   uint8_t *input = generate_input(&length);
+   if (input == 0)
+   {
+      return 1;
+   }
+   bstr_json_document_create(&m_document, 0);
+   printf("%u records, %u bytes\n", (unsigned) NUM_RECORDS, (unsigned) length);
+   seconds = run(parse_call_by_call, input, input + length, &count);
+   printf("   call by call:         %8.1f MB/s %u values\n", (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count);
+   for (i = 0; i < 4; i++)
+   {
+      uint32_t features = bstr_simd_set_features(m_featureSets[i]);
+      seconds = run(parse_tape, input, input + length, &count);
+      printf("   tape (%-6s):        %8.1f MB/s %u entries (features 0x%02x)\n", m_featureNames[i], (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count, (unsigned) features);
+   }
+   seconds = run(parse_tape_walk, input, input + length, &count);
+   printf("   tape + iteration:     %8.1f MB/s %u values\n", (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count);
+   seconds = run(cursor_last_score, input, input + length, &count);
+   printf("   cursor /%d/score:  %8.1f MB/s\n", NUM_RECORDS - 1, (double) length * NUM_ROUNDS / seconds / 1e6);
+   seconds = run(cursor_all_scores, input, input + length, &count);
+   printf("   cursor all scores:    %8.1f MB/s %u scores\n", (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count);
+   seconds = run(tape_all_scores, input, input + length, &count);
+   printf("   tape all scores:      %8.1f MB/s %u scores\n", (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count);
+   bstr_json_document_destroy(&m_document);
+   free(input);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns an array of NUM_RECORDS objects looking like an API response: nested objects, short strings where every
+ * tenth has an escape, integers, doubles, booleans and nulls, pretty-printed with two-space indentation.
+ */
+static uint8_t *generate_input(size_t *length)
+{
+   uint8_t *input = (uint8_t*) malloc((size_t) NUM_RECORDS * 400u + 4u);
+   size_t offset = 0u;
+   int i;
+   if (input == 0)
+   {
+      return 0;
+   }
+   srand(1234);
+   input[offset++] = '[';
+   for (i = 0; i < NUM_RECORDS; i++)
+   {
+      char tmp[400];
+      const char *text = ((i % 10) == 0) ? "line one\\nline \\\"two\\\"" : "plain text without escapes";
+      int len = sprintf(tmp, "%s\n  {\n    \"id\": %d,\n    \"user\": {\"name\": \"%s %s\", \"followers\": %d, \"verified\": %s},\n"
+                        "    \"text\": \"%s\",\n    \"location\": [%d.%04d, -%d.%04d],\n    \"tags\": [\"%s\", \"%s\"],\n"
+                        "    \"score\": %de-3,\n    \"reply_to\": null\n  }",
+                        (i > 0) ? "," : "", i, m_words[rand() % 8], m_words[rand() % 8], rand() % 100000, ((i % 3) == 0) ? "true" : "false",
+                        text, rand() % 90, rand() % 10000, rand() % 180, rand() % 10000, m_words[rand() % 8], m_words[rand() % 8], rand());
+      memcpy(&input[offset], tmp, (size_t) len);
+      offset += (size_t) len;
+   }
+   input[offset++] = '\n';
+   input[offset++] = ']';
+   *length = offset;
+   return input;
+}
+
+static size_t parse_tape(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   if (bstr_json_document_parse(&m_document, pBegin, pEnd) != BSTR_NO_ERROR)
+   {
+      return 0u;
+   }
+   return m_document.tapeLen;
+}
+
+/**
+ * Parses and visits every value, getting the content of strings and numbers like the call by call parser does.
+ */
+static size_t parse_tape_walk(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   if (bstr_json_document_parse(&m_document, pBegin, pEnd) != BSTR_NO_ERROR)
+   {
+      return 0u;
+   }
+   return count_values(bstr_json_document_root(&m_document));
+}
+
+static size_t count_values(bstr_json_value_t value)
+{
+   size_t count = 1u;
+   uint8_t type = bstr_json_value_type(value);
+   bstr_json_value_t child;
+   if ( (type == BSTR_JSON_OBJECT) || (type == BSTR_JSON_ARRAY) )
+   {
+      if (bstr_json_value_child(value, &child))
+      {
+         do
+         {
+            if (type == BSTR_JSON_OBJECT)
+            {
+               (void) bstr_json_value_next(&child); //skip the key
+            }
+            count += count_values(child);
+         } while (bstr_json_value_next(&child));
+      }
+   }
+   else if (type == BSTR_JSON_STRING)
+   {
+      const uint8_t *pStrBegin;
+      const uint8_t *pStrEnd;
+      (void) bstr_json_value_get_string(value, &pStrBegin, &pStrEnd);
+   }
+   else
+   {
+      double number;
+      (void) bstr_json_value_get_double(value, &number);
+   }
+   return count;
+}
+
+/**
+ * Extracting a field in the last record skips all records before it.
+ */
+static size_t cursor_last_score(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   bstr_json_cursor_t cursor;
+   char pointer[32];
+   double score;
+   sprintf(pointer, "/%d/score", NUM_RECORDS - 1);
+   bstr_json_cursor_create(&cursor, pBegin, pEnd);
+   return (bstr_json_cursor_pointer(&cursor, pointer) && bstr_json_cursor_get_double(&cursor, &score)) ? 1u : 0u;
+}
+
+/**
+ * Reads one field of every record, skipping the nested objects and arrays in front of it.
+ */
+static size_t cursor_all_scores(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   bstr_json_cursor_t record;
+   size_t count = 0u;
+   bstr_json_cursor_create(&record, pBegin, pEnd);
+   if (bstr_json_cursor_child(&record))
+   {
+      do
+      {
+         bstr_json_cursor_t cursor = record;
+         double score;
+         if (bstr_json_cursor_find_cstr(&cursor, "score") && bstr_json_cursor_get_double(&cursor, &score))
+         {
+            count++;
+         }
+      } while (bstr_json_cursor_next(&record));
+   }
+   return count;
+}
+
+static size_t tape_all_scores(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   bstr_json_value_t record;
+   size_t count = 0u;
+   if ( (bstr_json_document_parse(&m_document, pBegin, pEnd) != BSTR_NO_ERROR) ||
+        !bstr_json_value_child(bstr_json_document_root(&m_document), &record) )
+   {
+      return 0u;
+   }
+   do
+   {
+      bstr_json_value_t value;
+      double score;
+      if (bstr_json_value_find_cstr(record, "score", &value) && bstr_json_value_get_double(value, &score))
+      {
+         count++;
+      }
+   } while (bstr_json_value_next(&record));
+   return count;
+}
+
+/**
+ * Recursive descent parser made of one bstr call per token, the way documents were parsed before bstr_json_document_t.
+ */
+static size_t parse_call_by_call(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   bstr_context_t ctx;
+   adt_str_t str;
+   size_t count = 0u;
+   const uint8_t *pNext;
+   bstr_context_create(&ctx);
+   adt_str_create(&str);
+   pNext = walk_value(&ctx, pBegin, pEnd, &str, &count);
+   adt_str_destroy(&str);
+   if ( (pNext == 0) || (bstr_lstrip(pNext, pEnd) != pEnd) )
+   {
+      return 0u;
+   }
+   return count;
+}
+
+static const uint8_t *walk_value(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, adt_str_t *str, size_t *count)
+{
+   const uint8_t *pNext = bstr_lstrip(pBegin, pEnd);
+   bstr_number_t number;
+   if (pNext == pEnd)
+   {
+      return 0;
+   }
+   (*count)++;
+   switch (*pNext)
+   {
+   case '{':
+   case '[':
+      {
+         bool isObject = (*pNext == (uint8_t) '{');
+         uint8_t close = isObject ? (uint8_t) '}' : (uint8_t) ']';
+         pNext = bstr_lstrip(pNext + 1, pEnd);
+         if ( (pNext < pEnd) && (*pNext == close) )
+         {
+            return pNext + 1;
+         }
+         for (;;)
+         {
+            if (isObject)
+            {
+               const uint8_t *pKey = pNext;
+               adt_str_clear(str);
+               pNext = bstr_parse_json_string_literal(ctx, pKey, pEnd, str);
+               if ( (pNext == 0) || (pNext == pKey) )
+               {
+                  return 0;
+               }
+               pNext = bstr_lstrip(pNext, pEnd);
+               if ( (pNext == pEnd) || (*pNext != (uint8_t) ':') )
+               {
+                  return 0;
+               }
+               pNext++;
+            }
+            pNext = walk_value(ctx, pNext, pEnd, str, count);
+            if (pNext == 0)
+            {
+               return 0;
+            }
+            pNext = bstr_lstrip(pNext, pEnd);
+            if (pNext == pEnd)
+            {
+               return 0;
+            }
+            if (*pNext == close)
+            {
+               return pNext + 1;
+            }
+            if (*pNext != (uint8_t) ',')
+            {
+               return 0;
+            }
+            pNext = bstr_lstrip(pNext + 1, pEnd);
+         }
+      }
+   case '"':
+      {
+         const uint8_t *pString = pNext;
+         adt_str_clear(str);
+         pNext = bstr_parse_json_string_literal(ctx, pString, pEnd, str);
+         return (pNext == pString) ? 0 : pNext;
+      }
+   case 't':
+      return ( (pEnd - pNext >= 4) && (memcmp(pNext, "true", 4) == 0) ) ? pNext + 4 : 0;
+   case 'f':
+      return ( (pEnd - pNext >= 5) && (memcmp(pNext, "false", 5) == 0) ) ? pNext + 5 : 0;
+   case 'n':
+      return ( (pEnd - pNext >= 4) && (memcmp(pNext, "null", 4) == 0) ) ? pNext + 4 : 0;
+   default:
+      return bstr_parse_json_number(ctx, pNext, pEnd, &number);
+   }
+}
+
+/**
+ * Returns the best time in seconds out of NUM_ROUNDS runs multiplied by NUM_ROUNDS.
+ */
+static double run(parse_func_t func, const uint8_t *pBegin, const uint8_t *pEnd, size_t *count)
+{
+   double best = 0.0;
+   int round;
+   for (round = 0; round < NUM_ROUNDS; round++)
+   {
+      clock_t start = clock();
+      double seconds;
+      *count = func(pBegin, pEnd);
+      seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+      if ( (round == 0) || (seconds < best) )
+      {
+         best = seconds;
+      }
+   }
+   return best * NUM_ROUNDS;
+}
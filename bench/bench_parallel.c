@@ -0,0 +1,228 @@
+/*****************************************************************************
+* \file      bench_parallel.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Benchmark of bstr_parallel_lines on newline-delimited JSON
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bstr_json.h"
+#include "bstr_parallel.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_RECORDS 400000
+#define NUM_ROUNDS 5
+
+/**
+ * Per-worker result, padded to a cache line so that workers don't write to the same line.
+ */
+typedef struct worker_result_tag
+{
+   double sum;
+   size_t count;
+   uint8_t padding[64 - sizeof(double) - sizeof(size_t)];
+} worker_result_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t *generate_input(size_t *length);
+static bool sum_score(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out);
+static bool copy_id(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out);
+static double run(const uint8_t *pBegin, const uint8_t *pEnd, unsigned numThreads, bstr_buf_t *output, size_t *count);
+static double now(void);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_words[8] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel"};
+static worker_result_t m_results[BSTR_PARALLEL_MAX_THREADS];
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * Usage: bstr_bench_parallel [maxThreads], the number of online processors is used by default.
+ */
+int main(int argc, char **argv)
+{
+   size_t length;
+   size_t count;
+   double seconds;
+   double baseline = 0.0;
+   unsigned maxThreads = (argc > 1) ? (unsigned) atoi(argv[1]) : bstr_parallel_num_processors();
+   unsigned numThreads;
+   bstr_buf_t output;
+   uint8_t *input = generate_input(&length);
+   if (input == 0)
+   {
+      return 1;
+   }
+   bstr_buf_create(&output, 0);
+   if ( (maxThreads == 0u) || (maxThreads > BSTR_PARALLEL_MAX_THREADS) )
+   {
+      maxThreads = BSTR_PARALLEL_MAX_THREADS;
+   }
+   printf("%u records, %u bytes, %u processors\n", (unsigned) NUM_RECORDS, (unsigned) length, bstr_parallel_num_processors());
+   for (numThreads = 1u; ; numThreads *= 2u)
+   {
+      if (numThreads > maxThreads)
+      {
+         numThreads = maxThreads;
+      }
+      seconds = run(input, input + length, numThreads, 0, &count);
+      if (numThreads == 1u)
+      {
+         baseline = seconds;
+      }
+      printf("   %3u threads:          %8.1f MB/s %u scores (x%.2f)\n", numThreads, (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count, baseline / seconds);
+      if (numThreads == maxThreads)
+      {
+         break;
+      }
+   }
+   seconds = run(input, input + length, maxThreads, &output, &count);
+   printf("   %3u threads, ordered: %8.1f MB/s %u bytes of output\n", maxThreads, (double) length * NUM_ROUNDS / seconds / 1e6, (unsigned) count);
+   bstr_buf_destroy(&output);
+   free(input);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns NUM_RECORDS lines of newline-delimited JSON looking like a structured log.
+ */
+static uint8_t *generate_input(size_t *length)
+{
+   uint8_t *input = (uint8_t*) malloc((size_t) NUM_RECORDS * 300u);
+   size_t offset = 0u;
+   int i;
+   if (input == 0)
+   {
+      return 0;
+   }
+   srand(1234);
+   for (i = 0; i < NUM_RECORDS; i++)
+   {
+      char tmp[300];
+      int len = sprintf(tmp, "{\"id\":%d,\"level\":\"%s\",\"user\":{\"name\":\"%s %s\",\"groups\":[\"%s\",\"%s\"]},"
+                        "\"message\":\"request from %s took %d ms\",\"latency\":[%d,%d,%d],\"score\":%d.%03d}\n",
+                        i, ((i % 7) == 0) ? "warn" : "info", m_words[rand() % 8], m_words[rand() % 8], m_words[rand() % 8],
+                        m_words[rand() % 8], m_words[rand() % 8], rand() % 1000, rand() % 100, rand() % 100, rand() % 100,
+                        rand() % 100, rand() % 1000);
+      memcpy(&input[offset], tmp, (size_t) len);
+      offset += (size_t) len;
+   }
+   *length = offset;
+   return input;
+}
+
+static bool sum_score(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out)
+{
+   worker_result_t *results = (worker_result_t*) arg;
+   bstr_json_cursor_t cursor;
+   double score;
+   (void) out;
+   bstr_json_cursor_create(&cursor, pBegin, pEnd);
+   if (bstr_json_cursor_find_cstr(&cursor, "score") && bstr_json_cursor_get_double(&cursor, &score))
+   {
+      results[worker].sum += score;
+      results[worker].count++;
+   }
+   return true;
+}
+
+static bool copy_id(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out)
+{
+   bstr_json_cursor_t cursor;
+   const uint8_t *pIdBegin;
+   const uint8_t *pIdEnd;
+   (void) arg;
+   (void) worker;
+   bstr_json_cursor_create(&cursor, pBegin, pEnd);
+   if (bstr_json_cursor_find_cstr(&cursor, "id") && bstr_json_cursor_get_raw(&cursor, &pIdBegin, &pIdEnd))
+   {
+      return (bstr_buf_append_bstr(out, pIdBegin, pIdEnd) == BSTR_NO_ERROR) && (bstr_buf_push(out, (uint8_t) '\n') == BSTR_NO_ERROR);
+   }
+   return true;
+}
+
+/**
+ * Returns the best wall-clock time in seconds out of NUM_ROUNDS runs multiplied by NUM_ROUNDS.
+ * The count is the number of scores summed, or the output length in ordered mode.
+ */
+static double run(const uint8_t *pBegin, const uint8_t *pEnd, unsigned numThreads, bstr_buf_t *output, size_t *count)
+{
+   bstr_parallel_options_t options;
+   double best = 0.0;
+   int round;
+   bstr_parallel_options_create(&options);
+   options.numThreads = numThreads;
+   for (round = 0; round < NUM_ROUNDS; round++)
+   {
+      double start = now();
+      double seconds;
+      unsigned i;
+      memset(m_results, 0, sizeof(m_results));
+      if (output != 0)
+      {
+         bstr_buf_clear(output);
+         (void) bstr_parallel_lines(pBegin, pEnd, copy_id, 0, &options, output);
+         *count = bstr_buf_length(output);
+      }
+      else
+      {
+         (void) bstr_parallel_lines(pBegin, pEnd, sum_score, m_results, &options, 0);
+         *count = 0u;
+         for (i = 0u; i < numThreads; i++)
+         {
+            *count += m_results[i].count;
+         }
+      }
+      seconds = now() - start;
+      if ( (round == 0) || (seconds < best) )
+      {
+         best = seconds;
+      }
+   }
+   return best * NUM_ROUNDS;
+}
+
+/**
+ * Wall-clock time, clock() adds up the processor time of all threads.
+ */
+static double now(void)
+{
+   struct timespec ts;
+   (void) timespec_get(&ts, TIME_UTC);
+   return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
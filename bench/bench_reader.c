@@ -0,0 +1,206 @@
+/*****************************************************************************
+* \file      bench_reader.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Benchmark of bstr_reader_t backends against fgets
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE //fileno
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bstr_reader.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define BENCH_FILE_NAME "bstr_bench_reader.tmp"
+#define NUM_LINES 2000000
+#define NUM_ROUNDS 5
+#define MAX_LINE_LENGTH 256
+
+#if defined(_WIN32)
+#define fileno _fileno
+#endif
+
+typedef size_t (*read_func_t)(uint32_t flags);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static size_t generate_file(void);
+static size_t read_fgets(uint32_t flags);
+static size_t read_reader(uint32_t flags);
+static size_t count_fields(const uint8_t *pBegin, const uint8_t *pEnd);
+static void run(const char *name, read_func_t func, uint32_t flags, size_t length);
+static double now(void);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(void)
+{
+   size_t length = generate_file();
+   if (length == 0u)
+   {
+      return 1;
+   }
+   printf("%u lines, %u bytes (warm page cache)\n", (unsigned) NUM_LINES, (unsigned) length);
+   run("fgets", read_fgets, 0u, length);
+   run("bstr_reader", read_reader, 0u, length);
+   run("  ring", read_reader, BSTR_READER_RING, length);
+   run("  io_uring", read_reader, BSTR_READER_IO_URING, length);
+   run("  ring+io_uring", read_reader, BSTR_READER_RING | BSTR_READER_IO_URING, length);
+   (void) remove(BENCH_FILE_NAME);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes NUM_LINES lines of newline-delimited JSON and returns the file size, 0 on failure.
+ */
+static size_t generate_file(void)
+{
+   FILE *fh = fopen(BENCH_FILE_NAME, "wb");
+   size_t length = 0u;
+   int i;
+   if (fh == 0)
+   {
+      return 0u;
+   }
+   for (i = 0; i < NUM_LINES; i++)
+   {
+      int len = fprintf(fh, "{\"id\":%d,\"level\":\"%s\",\"message\":\"request %d took %d ms\",\"score\":%d.%03d}\n",
+                        i, ((i % 7) == 0) ? "warn" : "info", i * 7, i % 1000, i % 100, i % 1000);
+      length += (len > 0) ? (size_t) len : 0u;
+   }
+   return (fclose(fh) == 0) ? length : 0u;
+}
+
+static size_t read_fgets(uint32_t flags)
+{
+   FILE *fh = fopen(BENCH_FILE_NAME, "rb");
+   char line[MAX_LINE_LENGTH];
+   size_t count = 0u;
+   (void) flags;
+   if (fh == 0)
+   {
+      return 0u;
+   }
+   while (fgets(line, (int) sizeof(line), fh) != 0)
+   {
+      count += count_fields((const uint8_t*) line, (const uint8_t*) line + strlen(line));
+   }
+   (void) fclose(fh);
+   return count;
+}
+
+static size_t read_reader(uint32_t flags)
+{
+   FILE *fh = fopen(BENCH_FILE_NAME, "rb");
+   bstr_reader_t reader;
+   size_t count = 0u;
+   if (fh == 0)
+   {
+      return 0u;
+   }
+   if (bstr_reader_create(&reader, fileno(fh), 0u, flags, 0) == BSTR_NO_ERROR)
+   {
+      const uint8_t *pBegin;
+      const uint8_t *pEnd;
+      if ( (reader.flags & flags) != flags )
+      {
+         printf("   (unavailable, using flags 0x%x)\n", (unsigned) reader.flags);
+      }
+      while (bstr_reader_next_line(&reader, &pBegin, &pEnd))
+      {
+         count += count_fields(pBegin, pEnd);
+      }
+      bstr_reader_destroy(&reader);
+   }
+   (void) fclose(fh);
+   return count;
+}
+
+/**
+ * Some work per line so that there is parsing to overlap with reading.
+ */
+static size_t count_fields(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   size_t count = 0u;
+   const uint8_t *pNext = pBegin;
+   while (pNext < pEnd)
+   {
+      const uint8_t *pFound = bstr_search_val(pNext, pEnd, (uint8_t) ':');
+      if ( (pFound == pEnd) || (*pFound != (uint8_t) ':') )
+      {
+         break;
+      }
+      count++;
+      pNext = pFound + 1;
+   }
+   return count;
+}
+
+/**
+ * Prints the best time out of NUM_ROUNDS runs.
+ */
+static void run(const char *name, read_func_t func, uint32_t flags, size_t length)
+{
+   double best = 0.0;
+   size_t count = 0u;
+   int round;
+   for (round = 0; round < NUM_ROUNDS; round++)
+   {
+      double start = now();
+      double seconds;
+      count = func(flags);
+      seconds = now() - start;
+      if ( (round == 0) || (seconds < best) )
+      {
+         best = seconds;
+      }
+   }
+   printf("   %-18s %8.1f MB/s %u fields\n", name, (double) length / best / 1e6, (unsigned) count);
+}
+
+/**
+ * Wall-clock time, clock() doesn't count time spent waiting for I/O.
+ */
+static double now(void)
+{
+   struct timespec ts;
+   (void) timespec_get(&ts, TIME_UTC);
+   return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
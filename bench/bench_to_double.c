@@ -0,0 +1,210 @@
+/*****************************************************************************
+* \file      bench_to_double.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Throughput of bstr_to_double compared with copying into a buffer and calling strtod
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_VALUES 200000
+#define NUM_ROUNDS 10
+#define MAX_NUMBER_SIZE 32
+
+typedef size_t (*parse_func_t)(const uint8_t *pBegin, const uint8_t *pEnd, double *sum);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t *generate_input(int kind, size_t *length);
+static size_t parse_bstr(const uint8_t *pBegin, const uint8_t *pEnd, double *sum);
+static size_t parse_strtod(const uint8_t *pBegin, const uint8_t *pEnd, double *sum);
+static const uint8_t *strtod_bounded(const uint8_t *pBegin, const uint8_t *pEnd, double *data);
+static double run(parse_func_t func, const uint8_t *pBegin, const uint8_t *pEnd, size_t *count, double *sum);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_kindNames[3] = {"random doubles (%.17g)", "fixed point (%.3f)", "integers"};
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(void)
+{
+   int kind;
+   for (kind = 0; kind < 3; kind++)
+   {
+      size_t length;
+      size_t count;
+      double sumBstr = 0.0;
+      double sumStrtod = 0.0;
+      double secondsBstr;
+      double secondsStrtod;
+      uint8_t *input = generate_input(kind, &length);
+      if (input == 0)
+      {
+         return 1;
+      }
+      secondsBstr = run(parse_bstr, input, input + length, &count, &sumBstr);
+      secondsStrtod = run(parse_strtod, input, input + length, &count, &sumStrtod);
+      printf("%s: %u numbers, %u bytes\n", m_kindNames[kind], (unsigned) count, (unsigned) length);
+      printf("   bstr_to_double: %8.1f MB/s %6.1f ns/number\n", (double) length * NUM_ROUNDS / secondsBstr / 1e6, secondsBstr * 1e9 / ((double) count * NUM_ROUNDS));
+      printf("   strtod:         %8.1f MB/s %6.1f ns/number\n", (double) length * NUM_ROUNDS / secondsStrtod / 1e6, secondsStrtod * 1e9 / ((double) count * NUM_ROUNDS));
+      if (sumBstr != sumStrtod)
+      {
+         printf("   results differ\n");
+      }
+      free(input);
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns NUM_VALUES comma separated numbers.
+ */
+static uint8_t *generate_input(int kind, size_t *length)
+{
+   uint8_t *input = (uint8_t*) malloc((size_t) NUM_VALUES * (MAX_NUMBER_SIZE + 1));
+   size_t offset = 0u;
+   int i;
+   if (input == 0)
+   {
+      return 0;
+   }
+   srand(1234);
+   for (i = 0; i < NUM_VALUES; i++)
+   {
+      double value = ((double) rand() / RAND_MAX) * 1000.0 - 500.0;
+      char tmp[64];
+      if (kind == 0)
+      {
+         value *= 1e-6 * (double) (rand() % 1000000);
+         sprintf(tmp, "%.17g", value);
+      }
+      else if (kind == 1)
+      {
+         sprintf(tmp, "%.3f", value);
+      }
+      else
+      {
+         sprintf(tmp, "%d", rand());
+      }
+      memcpy(&input[offset], tmp, strlen(tmp));
+      offset += strlen(tmp);
+      input[offset++] = (uint8_t) ',';
+   }
+   *length = offset;
+   return input;
+}
+
+static size_t parse_bstr(const uint8_t *pBegin, const uint8_t *pEnd, double *sum)
+{
+   const uint8_t *pNext = pBegin;
+   size_t count = 0u;
+   while (pNext < pEnd)
+   {
+      double value;
+      const uint8_t *pResult = bstr_to_double(pNext, pEnd, &value);
+      if ( (pResult == 0) || (pResult == pNext) )
+      {
+         break;
+      }
+      *sum += value;
+      count++;
+      pNext = pResult + 1; //skip ','
+   }
+   return count;
+}
+
+static size_t parse_strtod(const uint8_t *pBegin, const uint8_t *pEnd, double *sum)
+{
+   const uint8_t *pNext = pBegin;
+   size_t count = 0u;
+   while (pNext < pEnd)
+   {
+      double value;
+      const uint8_t *pResult = strtod_bounded(pNext, pEnd, &value);
+      if (pResult == pNext)
+      {
+         break;
+      }
+      *sum += value;
+      count++;
+      pNext = pResult + 1;
+   }
+   return count;
+}
+
+/**
+ * The previous implementation of bstr_to_double: copy into a null-terminated buffer and call strtod.
+ */
+static const uint8_t *strtod_bounded(const uint8_t *pBegin, const uint8_t *pEnd, double *data)
+{
+   char tmp[MAX_NUMBER_SIZE + 1];
+   char *parseEnd = 0;
+   size_t size = (size_t) (pEnd - pBegin);
+   if (size > MAX_NUMBER_SIZE)
+   {
+      size = MAX_NUMBER_SIZE;
+   }
+   memcpy(&tmp[0], pBegin, size);
+   tmp[size] = '\0';
+   *data = strtod(&tmp[0], &parseEnd);
+   return pBegin + (parseEnd - &tmp[0]);
+}
+
+/**
+ * Returns the best time in seconds out of NUM_ROUNDS runs multiplied by NUM_ROUNDS.
+ */
+static double run(parse_func_t func, const uint8_t *pBegin, const uint8_t *pEnd, size_t *count, double *sum)
+{
+   double best = 0.0;
+   int round;
+   for (round = 0; round < NUM_ROUNDS; round++)
+   {
+      double roundSum = 0.0;
+      clock_t start = clock();
+      double seconds;
+      *count = func(pBegin, pEnd, &roundSum);
+      seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+      if ( (round == 0) || (seconds < best) )
+      {
+         best = seconds;
+      }
+      *sum = roundSum;
+   }
+   return best * NUM_ROUNDS;
+}
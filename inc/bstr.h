@@ -45,17 +45,32 @@
 //////////////////////////////////////////////////////////////////////////////
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "adt_str.h"
 
 //////////////////////////////////////////////////////////////////////////////
 // PUBLIC CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
 
+#define BSTR_NUMBER_NONE   0u  //nothing was parsed
+#define BSTR_NUMBER_INT64  1u  //value.i64, integers in the range INT64_MIN..INT64_MAX
+#define BSTR_NUMBER_UINT64 2u  //value.u64, integers in the range INT64_MAX+1..UINT64_MAX
+#define BSTR_NUMBER_DOUBLE 3u  //value.f64, numbers with fraction or exponent and integers outside 64-bit range
+
+/**
+ * Result of bstr_parse_json_number. type tells which member of value holds the number.
+ */
 typedef struct bstr_number_tag
 {
-   uint32_t integer;
-   int32_t fraction;
-   int32_t exponent;
+   union
+   {
+      int64_t i64;
+      uint64_t u64;
+      double f64;
+   } value;
+   uint64_t integer;  //magnitude of the integer part, saturated at UINT64_MAX
+   int32_t exponent;  //value after 'e' or 'E', saturated at INT32_MIN/INT32_MAX
+   uint8_t type;      //BSTR_NUMBER_*
    bool hasInteger;
    bool hasFraction;
    bool hasExponent;
@@ -69,23 +84,218 @@ typedef int32_t bstr_error_t;
 #define BSTR_PREMATURE_END_OF_BUFFER_ERROR  ((bstr_error_t) 3)
 #define BSTR_INVALID_CHARACTER_ERROR        ((bstr_error_t) 4)
 #define BSTR_MEM_ERROR                      ((bstr_error_t) 5)
+#define BSTR_INVALID_ARGUMENT_ERROR         ((bstr_error_t) 6)
+#define BSTR_IO_ERROR                       ((bstr_error_t) 7)
+
 
+typedef void *(*bstr_alloc_func_t)(void *arg, size_t size);
+typedef void *(*bstr_realloc_func_t)(void *arg, void *ptr, size_t oldSize, size_t newSize);
+typedef void (*bstr_free_func_t)(void *arg, void *ptr, size_t size);
+
+/**
+ * Memory allocator used by the _a variants of the allocating functions. A NULL allocator selects malloc/realloc/free.
+ * The size of a block is passed back when it is resized or freed, which lets allocators without block headers
+ * (see bstr_alloc.h) find the size class of the block.
+ */
+typedef struct bstr_allocator_tag
+{
+   bstr_alloc_func_t allocFunc;
+   bstr_realloc_func_t reallocFunc;
+   bstr_free_func_t freeFunc;
+   void *arg;                 //first argument to the functions above
+} bstr_allocator_t;
 
 typedef struct bstr_context_tag
 {
    bstr_error_t lastError;
+   const bstr_allocator_t *allocator;       //used by the _buf parsers for buffers without an allocator, NULL selects the default
+   const bstr_allocator_t *ownerAllocator;  //allocator the context itself was allocated with by bstr_context_new_a
 } bstr_context_t;
 
+#define BSTR_BUF_INLINE_SIZE 24u  //strings up to BSTR_BUF_INLINE_SIZE-1 bytes are stored without allocating
+
+/**
+ * Owned byte string with small string optimization. Short strings are stored inside the struct, longer ones in a
+ * block from allocator which grows geometrically. The content is always followed by a null terminator.
+ * Use the bstr_buf_* functions to access it, the location of the data changes when the string moves out of the struct.
+ */
+typedef struct bstr_buf_tag
+{
+   union
+   {
+      uint8_t *pHeap;
+      uint8_t inlineData[BSTR_BUF_INLINE_SIZE];
+   } data;
+   size_t length;
+   size_t capacity;    //maximum length without reallocating, BSTR_BUF_INLINE_SIZE-1 while the data is inline
+   const bstr_allocator_t *allocator;
+} bstr_buf_t;
+
+/**
+ * A compiled set of byte values. Besides the plain 256-bit membership set it holds nibble lookup tables
+ * which lets the SIMD kernels classify 16-64 bytes per instruction. Create it using bstr_byteset_create.
+ */
+typedef struct bstr_byteset_tag
+{
+   uint8_t lo[2][16];
+   uint8_t hi[2][16];
+   uint32_t bits[8];
+   uint8_t numTables;
+} bstr_byteset_t;
+
+/**
+ * A precompiled substring for repeated searches using bstr_find_needle.
+ * The needle refers to the bytes it was created from (they are not copied) so they must outlive the needle.
+ */
+typedef struct bstr_needle_tag
+{
+   const uint8_t *pStrBegin;
+   const uint8_t *pStrEnd;
+   size_t length;
+   size_t critPos;        //critical factorization used by the Two-Way algorithm
+   size_t period;
+   bool isPeriodic;
+   uint32_t shift[256];   //bad character shift for the last byte of the needle
+   const bstr_allocator_t *allocator; //allocator the needle was allocated with by bstr_needle_new_a
+} bstr_needle_t;
+
+/**
+ * A character class for bstr_while_class and bstr_while_class_reverse. Besides the members it keeps the complement
+ * which is what the SIMD kernels search for to find the end of a run. Create it using bstr_charclass_create.
+ */
+typedef struct bstr_charclass_tag
+{
+   bstr_byteset_t members;
+   bstr_byteset_t others;
+} bstr_charclass_t;
+
+/* bstr_line_index_t flags */
+#define BSTR_LINE_INDEX_CRLF                ((uint32_t) 0x01u) //exclude '\r' preceding '\n' from the line
+
+typedef struct bstr_line_span_tag
+{
+   size_t begin;  //offset of first character of the line
+   size_t end;    //offset just after last character of the line (line terminator not included)
+} bstr_line_span_t;
+
+/**
+ * Line index built by bstr_index_lines. Offsets are counted from the first byte given to the index,
+ * which allows a stream to be indexed one chunk at a time.
+ */
+typedef struct bstr_line_index_tag
+{
+   bstr_line_span_t *lines;
+   size_t numLines;
+   size_t capacity;
+   size_t streamOffset;   //offset of the next byte to be indexed
+   size_t lineBegin;      //offset where the current (not yet terminated) line begins
+   uint32_t flags;
+   bool isGrowable;       //lines is owned by the index and grows as needed
+   bool lastWasCR;
+   const bstr_allocator_t *allocator; //used when isGrowable is set
+} bstr_line_index_t;
+
+/**
+ * A pair of bounds into a caller's buffer.
+ */
+typedef struct bstr_view_tag
+{
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+} bstr_view_t;
+
+#define BSTR_SPLIT_BATCH_SIZE               64u  //separator candidates located per vectorized scan
+
+/* bstr_split_iter_t flags */
+#define BSTR_SPLIT_STRIP                    ((uint32_t) 0x01u) //strip whitespace from both ends of each field
+
+/**
+ * Iterator over the fields of a buffer separated by a byte, any byte of a set or a multi-byte separator.
+ * The separators are located BSTR_SPLIT_BATCH_SIZE at a time by a single vectorized scan and the fields are handed
+ * out from that batch, nothing is allocated. Like Python's str.split with a separator, n separators always give n+1
+ * fields, some of which may be empty. Create it using one of the bstr_split_iter_create functions.
+ * The members are private to the implementation.
+ */
+typedef struct bstr_split_iter_tag
+{
+   const uint8_t *pField;     //start of the next field, NULL when all fields have been returned
+   const uint8_t *pEnd;
+   const uint8_t *pScan;      //first byte not yet scanned for separators
+   const uint8_t *pBatch;     //positions are relative to this
+   const uint8_t *pSep;       //multi-byte separator
+   size_t sepLen;
+   const bstr_byteset_t *set; //separator set, NULL unless created by bstr_split_iter_create_set
+   size_t numPositions;
+   size_t nextPosition;
+   size_t positions[BSTR_SPLIT_BATCH_SIZE];
+   uint32_t flags;
+   uint8_t sepVal;            //single separator byte or first byte of pSep
+} bstr_split_iter_t;
+
+/**
+ * Structural masks for one 64-byte block of a JSON document, bit i refers to byte i of the block.
+ */
+typedef struct bstr_json_index_block_tag
+{
+   uint64_t quotes;  //'"' not escaped by a backslash
+   uint64_t opens;   //'{' and '[' outside of strings
+   uint64_t closes;  //'}' and ']' outside of strings
+} bstr_json_index_block_t;
+
+/**
+ * Structural index of a JSON document used by bstr_match_pair_indexed. It is built in a single vectorized pass
+ * and can be reused for any number of lookups as long as the document is unchanged.
+ */
+typedef struct bstr_json_index_tag
+{
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   bstr_json_index_block_t *blocks;
+   size_t numBlocks;
+   const bstr_allocator_t *allocator;
+} bstr_json_index_t;
+
+/* Prebuilt byte sets */
+extern const bstr_byteset_t bstr_json_structural_chars;      // { } [ ] , : "
+extern const bstr_byteset_t bstr_json_string_special_chars;  // '"', '\\' and control characters
+
+/* Prebuilt character classes matching the bstr_pred_is_* predicates */
+extern const bstr_charclass_t bstr_class_horizontal_space;
+extern const bstr_charclass_t bstr_class_whitespace;
+extern const bstr_charclass_t bstr_class_digit;
+extern const bstr_charclass_t bstr_class_hex_digit;
+extern const bstr_charclass_t bstr_class_one_nine;
+extern const bstr_charclass_t bstr_class_control_char;
+extern const bstr_charclass_t bstr_class_not_zero;
+
+/* CPU features used by the SIMD code paths, see bstr_simd_get_features */
+#define BSTR_SIMD_SSE2                      ((uint32_t) 0x01u)
+#define BSTR_SIMD_SSSE3                     ((uint32_t) 0x02u)
+#define BSTR_SIMD_SSE42                     ((uint32_t) 0x04u)
+#define BSTR_SIMD_AVX2                      ((uint32_t) 0x08u)
+#define BSTR_SIMD_AVX512BW                  ((uint32_t) 0x10u)
+#define BSTR_SIMD_PCLMUL                    ((uint32_t) 0x20u)
+#define BSTR_SIMD_BMI2                      ((uint32_t) 0x40u)
+
 
 //////////////////////////////////////////////////////////////////////////////
 // PUBLIC FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 void bstr_context_create(bstr_context_t *self);
 bstr_context_t *bstr_context_new(void);
+bstr_context_t *bstr_context_new_a(const bstr_allocator_t *allocator);
 void bstr_context_delete(bstr_context_t *self);
+void bstr_context_set_allocator(bstr_context_t *self, const bstr_allocator_t *allocator);
 char* bstr_make_cstr(const uint8_t *pBegin, const uint8_t *pEnd);
+char* bstr_make_cstr_a(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_allocator_t *allocator);
 char* bstr_make_cstr_x(const uint8_t *pBegin, const uint8_t *pEnd, uint16_t startOffset, uint16_t endOffset);
+char* bstr_make_cstr_x_a(const uint8_t *pBegin, const uint8_t *pEnd, uint16_t startOffset, uint16_t endOffset, const bstr_allocator_t *allocator);
 const uint8_t *bstr_search_val(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val);
+const uint8_t *bstr_search_any(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+const uint8_t *bstr_search_any_reverse(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+const uint8_t *bstr_find_bstr(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pStrBegin, const uint8_t *pStrEnd);
+const uint8_t *bstr_find_cstr(const uint8_t *pBegin, const uint8_t *pEnd, const char *cstr);
+const uint8_t *bstr_find_needle(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_needle_t *needle);
 const uint8_t *bstr_match_pair(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t left, uint8_t right, uint8_t escapeChar);
 const uint8_t *bstr_match_bstr(const uint8_t *pBegin, const uint8_t *pEnd,const uint8_t *pStrBegin, const uint8_t *pStrEnd);
 const uint8_t *bstr_match_cstr(const uint8_t *pBegin, const uint8_t *pEnd, const char *cstr);
@@ -96,15 +306,40 @@ const uint8_t *bstr_to_unsigned_long(const uint8_t *pBegin, const uint8_t *pEnd,
 const uint8_t* bstr_to_unsigned_long_long(const uint8_t* pBegin, const uint8_t* pEnd, uint8_t base, unsigned long long* data);
 const uint8_t *bstr_parse_json_number(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, bstr_number_t *number);
 const uint8_t *bstr_parse_json_string_literal(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, adt_str_t *str);
+const uint8_t *bstr_parse_json_string_view(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppStrBegin, const uint8_t **ppStrEnd, adt_str_t *str, bool *isView);
+const uint8_t *bstr_parse_json_string_literal_buf(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *buf);
+const uint8_t *bstr_parse_json_string_view_buf(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppStrBegin, const uint8_t **ppStrEnd, bstr_buf_t *buf, bool *isView);
+const uint8_t *bstr_unescape_json_inplace(bstr_context_t *ctx, uint8_t *pBegin, uint8_t *pEnd, uint8_t **ppStrBegin, uint8_t **ppStrEnd);
 const uint8_t *bstr_line(const uint8_t *pBegin, const uint8_t *pEnd);
 const uint8_t *bstr_while_predicate(const uint8_t *pBegin, const uint8_t *pEnd, int (*pred)(int c));
 const uint8_t *bstr_while_predicate_reverse(const uint8_t *pBegin, const uint8_t *pEnd, int (*pred_func)(int c) );
+const uint8_t *bstr_while_class(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_charclass_t *cls);
+const uint8_t *bstr_while_class_reverse(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_charclass_t *cls);
 const uint8_t *bstr_lstrip(const uint8_t *pBegin, const uint8_t *pEnd);
 const uint8_t *bstr_rstrip(const uint8_t *pBegin, const uint8_t *pEnd);
 void bstr_strip(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **strippedBegin, const uint8_t **strippedEnd);
 bstr_error_t bstr_get_last_error(bstr_context_t *ctx);
 void bstr_clear_error(bstr_context_t *ctx);
 
+/*************** allocators ***************/
+const bstr_allocator_t *bstr_allocator_default(void);
+void *bstr_allocator_alloc(const bstr_allocator_t *allocator, size_t size);
+void *bstr_allocator_realloc(const bstr_allocator_t *allocator, void *ptr, size_t oldSize, size_t newSize);
+void bstr_allocator_free(const bstr_allocator_t *allocator, void *ptr, size_t size);
+
+/*************** owned strings ***************/
+void bstr_buf_create(bstr_buf_t *self, const bstr_allocator_t *allocator);
+void bstr_buf_destroy(bstr_buf_t *self);
+void bstr_buf_clear(bstr_buf_t *self);
+bstr_error_t bstr_buf_reserve(bstr_buf_t *self, size_t capacity);
+bstr_error_t bstr_buf_append_bstr(bstr_buf_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+bstr_error_t bstr_buf_append_cstr(bstr_buf_t *self, const char *cstr);
+bstr_error_t bstr_buf_push(bstr_buf_t *self, uint8_t c);
+uint8_t *bstr_buf_data(bstr_buf_t *self);
+const char *bstr_buf_cstr(const bstr_buf_t *self);
+size_t bstr_buf_length(const bstr_buf_t *self);
+void bstr_buf_view(const bstr_buf_t *self, const uint8_t **ppBegin, const uint8_t **ppEnd);
+
 /*************** predicate functions ***************/
 int bstr_pred_is_horizontal_space(int c);
 int bstr_pred_is_whitespace(int c);
@@ -114,4 +349,52 @@ int bstr_pred_is_one_nine(int c);
 int bstr_pred_is_control_char(int c);
 int bstr_pred_is_not_zero(int c);
 
+/*************** byte sets ***************/
+void bstr_byteset_create(bstr_byteset_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+void bstr_byteset_create_cstr(bstr_byteset_t *self, const char *cstr);
+void bstr_byteset_add(bstr_byteset_t *self, uint8_t c);
+void bstr_byteset_add_range(bstr_byteset_t *self, uint8_t first, uint8_t last);
+void bstr_byteset_invert(bstr_byteset_t *self);
+bool bstr_byteset_contains(const bstr_byteset_t *self, uint8_t c);
+
+/*************** character classes ***************/
+void bstr_charclass_create(bstr_charclass_t *self, const bstr_byteset_t *members);
+void bstr_charclass_create_predicate(bstr_charclass_t *self, int (*pred_func)(int c));
+bool bstr_charclass_contains(const bstr_charclass_t *self, uint8_t c);
+
+/*************** needles ***************/
+bstr_error_t bstr_needle_create(bstr_needle_t *self, const uint8_t *pStrBegin, const uint8_t *pStrEnd);
+bstr_needle_t *bstr_needle_new(const uint8_t *pStrBegin, const uint8_t *pStrEnd);
+bstr_needle_t *bstr_needle_new_a(const uint8_t *pStrBegin, const uint8_t *pStrEnd, const bstr_allocator_t *allocator);
+void bstr_needle_delete(bstr_needle_t *self);
+
+/*************** line index ***************/
+void bstr_line_index_create(bstr_line_index_t *self, uint32_t flags);
+void bstr_line_index_create_a(bstr_line_index_t *self, uint32_t flags, const bstr_allocator_t *allocator);
+void bstr_line_index_create_fixed(bstr_line_index_t *self, bstr_line_span_t *lines, size_t capacity, uint32_t flags);
+void bstr_line_index_destroy(bstr_line_index_t *self);
+void bstr_line_index_clear(bstr_line_index_t *self);
+const uint8_t *bstr_index_lines(bstr_line_index_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+bstr_error_t bstr_line_index_finish(bstr_line_index_t *self);
+
+/*************** split iterator ***************/
+void bstr_split_iter_create(bstr_split_iter_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint8_t sep, uint32_t flags);
+void bstr_split_iter_create_set(bstr_split_iter_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, uint32_t flags);
+bstr_error_t bstr_split_iter_create_bstr(bstr_split_iter_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pSepBegin, const uint8_t *pSepEnd, uint32_t flags);
+bool bstr_split_next(bstr_split_iter_t *self, const uint8_t **ppFieldBegin, const uint8_t **ppFieldEnd);
+size_t bstr_split_next_batch(bstr_split_iter_t *self, bstr_view_t *fields, size_t maxFields);
+
+/*************** JSON structural index ***************/
+bstr_error_t bstr_json_index_create(bstr_json_index_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+bstr_error_t bstr_json_index_create_a(bstr_json_index_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const bstr_allocator_t *allocator);
+void bstr_json_index_destroy(bstr_json_index_t *self);
+bstr_json_index_t *bstr_json_index_new(const uint8_t *pBegin, const uint8_t *pEnd);
+bstr_json_index_t *bstr_json_index_new_a(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_allocator_t *allocator);
+void bstr_json_index_delete(bstr_json_index_t *self);
+const uint8_t *bstr_match_pair_indexed(const bstr_json_index_t *index, const uint8_t *pBegin, const uint8_t *pEnd);
+
+/*************** SIMD dispatch ***************/
+uint32_t bstr_simd_get_features(void);
+uint32_t bstr_simd_set_features(uint32_t features);
+
 #endif //BSTR_H
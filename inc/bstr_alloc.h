@@ -0,0 +1,103 @@
+/*****************************************************************************
+* \file      bstr_alloc.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Arena and pool allocators implementing bstr_allocator_t
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_ALLOC_H
+#define BSTR_ALLOC_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+#define BSTR_ARENA_ALIGNMENT        16u
+#define BSTR_ARENA_DEFAULT_CHUNK    65536u
+#define BSTR_POOL_MIN_CLASS         16u     //smallest size class, classes double up to BSTR_POOL_MAX_CLASS
+#define BSTR_POOL_MAX_CLASS         2048u
+#define BSTR_POOL_NUM_CLASSES       8u
+#define BSTR_POOL_DEFAULT_SLAB      65536u
+
+struct bstr_alloc_chunk_tag;
+
+/**
+ * Bump-pointer arena. Allocations are carved from large chunks and are released all at once by
+ * bstr_arena_reset or bstr_arena_destroy. Only the most recent allocation can be grown or freed in place,
+ * freeing any other block is a no-op. The members are private to the implementation.
+ */
+typedef struct bstr_arena_tag
+{
+   bstr_allocator_t allocator;            //returned by bstr_arena_allocator
+   const bstr_allocator_t *backing;       //chunks are allocated from here
+   struct bstr_alloc_chunk_tag *chunks;   //current chunk first
+   uint8_t *pBase;                        //start of the current chunk (or fixed buffer)
+   uint8_t *pNext;
+   uint8_t *pLimit;
+   uint8_t *pLast;                        //most recent allocation
+   size_t chunkSize;                      //0 for arenas over a fixed buffer
+} bstr_arena_t;
+
+/**
+ * Pool of fixed size classes (16, 32, ... 2048 bytes). Freed blocks are kept in one free list per class and reused
+ * by later allocations of the same class, so memory is recycled without fragmentation. Blocks larger than
+ * BSTR_POOL_MAX_CLASS are passed through to the backing allocator. The members are private to the implementation.
+ */
+typedef struct bstr_pool_tag
+{
+   bstr_allocator_t allocator;            //returned by bstr_pool_allocator
+   const bstr_allocator_t *backing;       //slabs and large blocks are allocated from here
+   struct bstr_alloc_chunk_tag *slabs;    //current slab first
+   void *freeLists[BSTR_POOL_NUM_CLASSES];
+   uint8_t *pNext;                        //unused part of the current slab
+   uint8_t *pLimit;
+   size_t slabSize;
+} bstr_pool_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+
+/*************** arena ***************/
+void bstr_arena_create(bstr_arena_t *self, size_t chunkSize, const bstr_allocator_t *backing);
+void bstr_arena_create_fixed(bstr_arena_t *self, void *buffer, size_t size);
+void bstr_arena_destroy(bstr_arena_t *self);
+void bstr_arena_reset(bstr_arena_t *self);
+void *bstr_arena_alloc(bstr_arena_t *self, size_t size);
+const bstr_allocator_t *bstr_arena_allocator(bstr_arena_t *self);
+
+/*************** pool ***************/
+void bstr_pool_create(bstr_pool_t *self, size_t slabSize, const bstr_allocator_t *backing);
+void bstr_pool_destroy(bstr_pool_t *self);
+void bstr_pool_reset(bstr_pool_t *self);
+void *bstr_pool_alloc(bstr_pool_t *self, size_t size);
+void bstr_pool_free(bstr_pool_t *self, void *ptr, size_t size);
+const bstr_allocator_t *bstr_pool_allocator(bstr_pool_t *self);
+
+#endif //BSTR_ALLOC_H
@@ -0,0 +1,91 @@
+/*****************************************************************************
+* \file      bstr_csv.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     RFC 4180 CSV/TSV reader producing views into the input
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_CSV_H
+#define BSTR_CSV_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+#define BSTR_CSV_BATCH_BLOCKS 16u
+
+/* bstr_csv_reader_create flags */
+#define BSTR_CSV_PARTIAL ((uint32_t) 0x01u) //input ends in the middle of a stream, an unterminated last record is left for the next chunk
+
+typedef struct bstr_csv_field_tag
+{
+   const uint8_t *pBegin;  //field content, without the surrounding quotes of a quoted field
+   const uint8_t *pEnd;
+   bool isQuoted;
+   bool hasEscapes;        //content contains doubled quotes, use bstr_csv_field_unescape to get the value
+} bstr_csv_field_t;
+
+typedef struct bstr_csv_block_tag
+{
+   uint64_t separators;    //delimiters and '\n' outside of quotes
+   uint64_t quotes;
+} bstr_csv_block_t;
+
+/**
+ * Record reader over a buffer of CSV (or TSV) data.
+ * The input is indexed BSTR_CSV_BATCH_BLOCKS 64-byte blocks at a time, quoted regions are found with a prefix xor
+ * over the quote mask so delimiters and newlines inside quotes never need to be looked at.
+ * The members are private to the implementation.
+ */
+typedef struct bstr_csv_reader_tag
+{
+   const uint8_t *pEnd;
+   const uint8_t *pRecord;    //start of the next record
+   const uint8_t *pScan;      //first byte not yet indexed
+   const uint8_t *pBlock;     //start of the current block
+   bstr_csv_block_t blocks[BSTR_CSV_BATCH_BLOCKS];
+   uint32_t numBlocks;
+   uint32_t nextBlock;
+   uint64_t separators;       //separators of the current block not yet consumed
+   uint64_t quotes;           //quotes of the current block not yet consumed
+   uint64_t prevInQuote;      //all ones when the next block to index starts inside quotes
+   uint32_t flags;
+   uint8_t delimiter;
+   bstr_error_t lastError;
+} bstr_csv_reader_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void bstr_csv_reader_create(bstr_csv_reader_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint8_t delimiter, uint32_t flags);
+bstr_error_t bstr_csv_next_record(bstr_csv_reader_t *self, bstr_csv_field_t *fields, size_t maxFields, size_t *numFields);
+const uint8_t *bstr_csv_reader_rest(const bstr_csv_reader_t *self);
+bstr_error_t bstr_csv_field_unescape(const bstr_csv_field_t *field, bstr_buf_t *buf);
+
+#endif //BSTR_CSV_H
@@ -0,0 +1,81 @@
+/*****************************************************************************
+* \file      bstr_file.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Memory-mapped files exposed as bounded strings
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_FILE_H
+#define BSTR_FILE_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+/* bstr_file_t flags, the kernel is free to ignore them */
+#define BSTR_FILE_SEQUENTIAL  0x01u   //front-to-back reading: aggressive read-ahead (MADV_SEQUENTIAL)
+#define BSTR_FILE_RANDOM      0x02u   //scattered reading: no read-ahead (MADV_RANDOM)
+#define BSTR_FILE_POPULATE    0x04u   //read the mapped pages in before returning (MAP_POPULATE, MADV_WILLNEED elsewhere)
+#define BSTR_FILE_HUGE_PAGES  0x08u   //transparent huge pages where the file system supports them (MADV_HUGEPAGE)
+
+/**
+ * Read-only memory mapping of a file. pBegin..pEnd is the current view, which is the whole file unless the file was
+ * opened with a window. Views into the page cache are shared with other processes mapping or reading the same file.
+ * Don't change the other members.
+ */
+typedef struct bstr_file_tag
+{
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   uint64_t size;                //size of the file when it was opened
+   uint64_t offset;              //file offset of pBegin
+   size_t windowSize;            //maximum view length, 0 when the whole file is mapped
+   uint32_t flags;               //BSTR_FILE_*
+   void *mapping;                //start of the mapped region (aligned down from pBegin), NULL when nothing is mapped
+   size_t mappingLength;
+#if defined(_WIN32)
+   void *fileHandle;
+   void *mappingHandle;
+#else
+   int fd;
+#endif
+} bstr_file_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+bstr_error_t bstr_file_open(bstr_file_t *self, const char *path, uint32_t flags);
+bstr_error_t bstr_file_open_window(bstr_file_t *self, const char *path, size_t windowSize, uint32_t flags);
+void bstr_file_close(bstr_file_t *self);
+bstr_error_t bstr_file_advise(bstr_file_t *self, uint32_t flags);
+bstr_error_t bstr_file_seek(bstr_file_t *self, uint64_t offset);
+bstr_error_t bstr_file_advance(bstr_file_t *self, const uint8_t *pNext);
+bool bstr_file_at_end(const bstr_file_t *self);
+
+#endif //BSTR_FILE_H
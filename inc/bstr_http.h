@@ -0,0 +1,85 @@
+/*****************************************************************************
+* \file      bstr_http.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Zero-copy HTTP/1.x request, response and header parser
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_HTTP_H
+#define BSTR_HTTP_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Name/value pair used both for header fields and for key=value parameters.
+ * The value does not include leading or trailing whitespace.
+ */
+typedef struct bstr_http_header_tag
+{
+   const uint8_t *pNameBegin;
+   const uint8_t *pNameEnd;
+   const uint8_t *pValueBegin;
+   const uint8_t *pValueEnd;
+   uint32_t nameHash;         //case-insensitive hash of the name, see bstr_http_name_hash
+} bstr_http_header_t;
+
+/**
+ * Parser state and result of parsing one message head. The headers are stored in an array given by the caller.
+ * When the input is incomplete the parser remembers how much of it has been seen, and the next call with the
+ * same (but longer) input only has to scan the new bytes until the blank line ending the head has arrived.
+ */
+typedef struct bstr_http_parser_tag
+{
+   bstr_http_header_t *headers;
+   size_t maxHeaders;
+   size_t numHeaders;         //number of headers in the message, can be larger than maxHeaders
+   bstr_view_t method;        //request only
+   bstr_view_t target;        //request only
+   bstr_view_t reason;        //response only
+   uint16_t status;           //response only
+   uint8_t versionMinor;      //x in HTTP/1.x
+   size_t scannedLen;         //input length seen by the previous incomplete call
+} bstr_http_parser_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void bstr_http_parser_create(bstr_http_parser_t *self, bstr_http_header_t *headers, size_t maxHeaders);
+void bstr_http_parser_reset(bstr_http_parser_t *self);
+bstr_error_t bstr_http_parse_request(bstr_http_parser_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppNext);
+bstr_error_t bstr_http_parse_response(bstr_http_parser_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppNext);
+bstr_error_t bstr_http_parse_headers(bstr_http_parser_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppNext);
+const bstr_http_header_t *bstr_http_find_header(const bstr_http_parser_t *self, const bstr_http_header_t *prev, const char *name, uint32_t nameHash);
+uint32_t bstr_http_name_hash(const uint8_t *pBegin, const uint8_t *pEnd);
+uint32_t bstr_http_name_hash_cstr(const char *name);
+size_t bstr_http_parse_params(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t pairSep, uint8_t assign, bstr_http_header_t *params, size_t maxParams);
+
+#endif //BSTR_HTTP_H
@@ -0,0 +1,147 @@
+/*****************************************************************************
+* \file      bstr_json.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     JSON documents: two-stage parser producing a flat tape of 64-bit entries and a lazy cursor
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_JSON_H
+#define BSTR_JSON_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+#define BSTR_JSON_MAX_DEPTH 1024u
+
+//value types, the same characters are used as type byte of the tape entries
+#define BSTR_JSON_NONE   ((uint8_t) 0u)   //not a value (end of container, failed parse)
+#define BSTR_JSON_OBJECT ((uint8_t) '{')
+#define BSTR_JSON_ARRAY  ((uint8_t) '[')
+#define BSTR_JSON_STRING ((uint8_t) '"')
+#define BSTR_JSON_INT64  ((uint8_t) 'l')
+#define BSTR_JSON_UINT64 ((uint8_t) 'u')  //integers in the range INT64_MAX+1..UINT64_MAX
+#define BSTR_JSON_DOUBLE ((uint8_t) 'd')
+#define BSTR_JSON_TRUE   ((uint8_t) 't')
+#define BSTR_JSON_FALSE  ((uint8_t) 'f')
+#define BSTR_JSON_NULL   ((uint8_t) 'n')
+#define BSTR_JSON_NUMBER ((uint8_t) '0')  //number not yet converted, only reported by bstr_json_cursor_type
+
+/**
+ * Parsed JSON document. bstr_json_document_parse runs in two stages: a vectorized pass over the input which records
+ * the position of every structural byte, followed by a pass over those positions which validates the grammar and
+ * writes the tape. Each tape entry is 64 bits with the type character in the top byte:
+ *   'r'       first and last entry, the first one holds the index of the last one
+ *   '{' '['   index after the matching close in the low 32 bits, number of members (saturated) in bits 32..55
+ *   '}' ']'   index of the matching open
+ *   '"'       offset of the string, in the input or (bit 55 set) in strings, followed by an entry holding the length
+ *   'l' 'u' 'd' followed by an entry holding the int64_t, uint64_t or double bits
+ *   't' 'f' 'n'
+ * Strings without escapes are views into the input, which must outlive the document. All buffers are kept between
+ * parses so that parsing documents of similar size does not allocate. The members are private to the implementation.
+ */
+typedef struct bstr_json_document_tag
+{
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   const uint8_t *pError;        //position of the first error in the input, NULL after a successful parse
+   uint32_t *structurals;        //input offsets found by the first stage
+   size_t numStructurals;
+   size_t structuralsCapacity;
+   uint64_t *tape;
+   size_t tapeLen;
+   size_t tapeCapacity;
+   uint32_t *stack;              //tape index and member count of each open container
+   bstr_buf_t strings;           //unescaped strings
+   const bstr_allocator_t *allocator;
+   bstr_error_t lastError;
+} bstr_json_document_t;
+
+/**
+ * Handle to a value on the tape of a document. Handles stay valid until the document is parsed again or destroyed.
+ */
+typedef struct bstr_json_value_tag
+{
+   const bstr_json_document_t *document;
+   size_t index;
+} bstr_json_value_t;
+
+/**
+ * Lazy cursor over a JSON document which is never parsed as a whole. Moving to a member or element only looks at the
+ * bytes before it: containers in between are skipped with a vectorized bracket scan that ignores brackets inside
+ * strings, and strings and numbers are only converted by the get functions. Skipped values are not validated.
+ * Cursors are plain values, copy one to remember a position.
+ */
+typedef struct bstr_json_cursor_tag
+{
+   const uint8_t *pValue;     //first byte of the current value, NULL when there is none
+   const uint8_t *pEnd;       //end of the document
+   const uint8_t *pKeyBegin;  //content of the key when the current value is an object member, escapes are not decoded
+   const uint8_t *pKeyEnd;
+   uint8_t container;         //'{' or '[' when the current value is a member or element, 0 for the top-level value
+   bool keyHasEscapes;
+   bstr_error_t lastError;
+} bstr_json_cursor_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void bstr_json_document_create(bstr_json_document_t *self, const bstr_allocator_t *allocator);
+void bstr_json_document_destroy(bstr_json_document_t *self);
+bstr_error_t bstr_json_document_parse(bstr_json_document_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+bstr_json_value_t bstr_json_document_root(const bstr_json_document_t *self);
+uint8_t bstr_json_value_type(bstr_json_value_t value);
+size_t bstr_json_value_count(bstr_json_value_t value);
+bool bstr_json_value_child(bstr_json_value_t value, bstr_json_value_t *child);
+bool bstr_json_value_next(bstr_json_value_t *value);
+bool bstr_json_value_at(bstr_json_value_t array, size_t index, bstr_json_value_t *element);
+bool bstr_json_value_find_bstr(bstr_json_value_t object, const uint8_t *pKeyBegin, const uint8_t *pKeyEnd, bstr_json_value_t *member);
+bool bstr_json_value_find_cstr(bstr_json_value_t object, const char *key, bstr_json_value_t *member);
+bool bstr_json_value_get_string(bstr_json_value_t value, const uint8_t **ppBegin, const uint8_t **ppEnd);
+bool bstr_json_value_get_int64(bstr_json_value_t value, int64_t *result);
+bool bstr_json_value_get_uint64(bstr_json_value_t value, uint64_t *result);
+bool bstr_json_value_get_double(bstr_json_value_t value, double *result);
+bool bstr_json_value_get_bool(bstr_json_value_t value, bool *result);
+void bstr_json_cursor_create(bstr_json_cursor_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+uint8_t bstr_json_cursor_type(const bstr_json_cursor_t *self);
+bool bstr_json_cursor_child(bstr_json_cursor_t *self);
+bool bstr_json_cursor_next(bstr_json_cursor_t *self);
+bool bstr_json_cursor_find_bstr(bstr_json_cursor_t *self, const uint8_t *pKeyBegin, const uint8_t *pKeyEnd);
+bool bstr_json_cursor_find_cstr(bstr_json_cursor_t *self, const char *key);
+bool bstr_json_cursor_at(bstr_json_cursor_t *self, size_t index);
+bool bstr_json_cursor_pointer(bstr_json_cursor_t *self, const char *pointer);
+bool bstr_json_cursor_get_key(bstr_json_cursor_t *self, bstr_buf_t *buf, const uint8_t **ppBegin, const uint8_t **ppEnd);
+bool bstr_json_cursor_get_raw(bstr_json_cursor_t *self, const uint8_t **ppBegin, const uint8_t **ppEnd);
+bool bstr_json_cursor_get_string(bstr_json_cursor_t *self, bstr_buf_t *buf, const uint8_t **ppBegin, const uint8_t **ppEnd);
+bool bstr_json_cursor_get_number(bstr_json_cursor_t *self, bstr_number_t *number);
+bool bstr_json_cursor_get_int64(bstr_json_cursor_t *self, int64_t *result);
+bool bstr_json_cursor_get_double(bstr_json_cursor_t *self, double *result);
+bool bstr_json_cursor_get_bool(bstr_json_cursor_t *self, bool *result);
+
+#endif //BSTR_JSON_H
@@ -0,0 +1,111 @@
+/*****************************************************************************
+* \file      bstr_matcher.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Multi-pattern matching over bounded strings
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_MATCHER_H
+#define BSTR_MATCHER_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+#define BSTR_TEDDY_MAX_PATTERNS 32u
+#define BSTR_TEDDY_MAX_FINGERPRINT 3u
+
+typedef struct bstr_match_tag
+{
+   const uint8_t *pBegin;  //start of match in the searched buffer
+   const uint8_t *pEnd;    //end of match in the searched buffer
+   uint32_t patternId;     //id given to bstr_matcher_add_bstr/bstr_matcher_add_cstr
+} bstr_match_t;
+
+/**
+ * Match callback. Return true to continue scanning or false to stop.
+ */
+typedef bool (*bstr_match_func_t)(void *arg, const bstr_match_t *match);
+
+typedef struct bstr_matcher_pattern_tag
+{
+   size_t offset;          //offset into patternData
+   size_t length;
+   uint32_t id;
+} bstr_matcher_pattern_t;
+
+/**
+ * Compile-once matcher for a set of fixed strings.
+ * An Aho-Corasick DFA over compressed byte classes is always built. Small pattern sets additionally get
+ * Teddy tables (nibble fingerprints of the last 1-3 bytes of each pattern) which are used when SSSE3 is available.
+ * The members are private to the implementation.
+ */
+typedef struct bstr_matcher_tag
+{
+   uint8_t *patternData;
+   size_t patternDataLen;
+   size_t patternDataCapacity;
+   bstr_matcher_pattern_t *patterns;
+   uint32_t numPatterns;
+   uint32_t patternsCapacity;
+   bool isCompiled;
+   const bstr_allocator_t *allocator;
+   //Aho-Corasick
+   uint8_t classMap[256];
+   uint32_t numClasses;
+   uint32_t numStates;
+   uint32_t *transitions;     //numStates*numClasses entries, each entry is the next state premultiplied by numClasses
+   size_t transitionsLen;     //number of allocated entries in transitions
+   uint32_t *outputStart;     //numStates+1 entries, indexed by state number
+   uint32_t *outputs;         //pattern indices, longest pattern first
+   //Teddy
+   bool hasTeddy;
+   uint8_t teddyLen;
+   uint8_t teddyLo[BSTR_TEDDY_MAX_FINGERPRINT][16];
+   uint8_t teddyHi[BSTR_TEDDY_MAX_FINGERPRINT][16];
+   uint8_t teddyBucket[BSTR_TEDDY_MAX_PATTERNS];
+   uint32_t teddyOrder[BSTR_TEDDY_MAX_PATTERNS]; //pattern indices, longest pattern first
+} bstr_matcher_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void bstr_matcher_create(bstr_matcher_t *self);
+void bstr_matcher_create_a(bstr_matcher_t *self, const bstr_allocator_t *allocator);
+void bstr_matcher_destroy(bstr_matcher_t *self);
+bstr_matcher_t *bstr_matcher_new(void);
+bstr_matcher_t *bstr_matcher_new_a(const bstr_allocator_t *allocator);
+void bstr_matcher_delete(bstr_matcher_t *self);
+bstr_error_t bstr_matcher_add_bstr(bstr_matcher_t *self, const uint8_t *pStrBegin, const uint8_t *pStrEnd, uint32_t patternId);
+bstr_error_t bstr_matcher_add_cstr(bstr_matcher_t *self, const char *cstr, uint32_t patternId);
+bstr_error_t bstr_matcher_compile(bstr_matcher_t *self);
+size_t bstr_matcher_scan(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_func_t func, void *arg);
+const uint8_t *bstr_matcher_find(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_t *match);
+
+#endif //BSTR_MATCHER_H
@@ -0,0 +1,67 @@
+/*****************************************************************************
+* \file      bstr_parallel.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Parallel processing of line-oriented input such as NDJSON on a work-stealing thread pool
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_PARALLEL_H
+#define BSTR_PARALLEL_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define BSTR_PARALLEL_MAX_THREADS         256u
+#define BSTR_PARALLEL_CHUNKS_PER_THREAD   8u          //initial chunks per worker, the surplus is what idle workers steal
+#define BSTR_PARALLEL_DEFAULT_MIN_CHUNK   65536u
+
+/**
+ * Line callback. pBegin..pEnd is the line without its '\n' (a '\r' before it is kept), worker is the index of the
+ * calling worker in 0..bstr_parallel_num_threads()-1 and can be used to keep per-worker results without locking.
+ * In ordered mode out is the output buffer of the chunk holding the line, otherwise it's NULL.
+ * Return false to stop processing.
+ */
+typedef bool (*bstr_parallel_line_func_t)(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out);
+
+typedef struct bstr_parallel_options_tag
+{
+   unsigned numThreads;                   //0 selects one thread per online processor
+   size_t minChunkSize;                   //chunks are not made smaller than this, 0 selects BSTR_PARALLEL_DEFAULT_MIN_CHUNK
+   const bstr_allocator_t *allocator;     //used by all workers so it must be thread safe, NULL selects the default allocator
+} bstr_parallel_options_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void bstr_parallel_options_create(bstr_parallel_options_t *self);
+unsigned bstr_parallel_num_processors(void);
+unsigned bstr_parallel_num_threads(const bstr_parallel_options_t *options);
+bstr_error_t bstr_parallel_lines(const uint8_t *pBegin, const uint8_t *pEnd, bstr_parallel_line_func_t func, void *arg, const bstr_parallel_options_t *options, bstr_buf_t *output);
+
+#endif //BSTR_PARALLEL_H
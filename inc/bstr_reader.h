@@ -0,0 +1,83 @@
+/*****************************************************************************
+* \file      bstr_reader.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Buffered reader handing out line and token views from a file descriptor
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_READER_H
+#define BSTR_READER_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define BSTR_READER_DEFAULT_CAPACITY 65536u
+
+/* bstr_reader_t flags, unavailable features are dropped by bstr_reader_create */
+#define BSTR_READER_RING      0x01u   //double-mapped ring buffer (Linux): data is never moved once it has been read
+#define BSTR_READER_IO_URING  0x02u   //read through io_uring (Linux builds with BSTR_HAVE_IO_URING): the next read is
+                                      //in flight while the caller works on the views it was given
+
+/**
+ * Reads from a file descriptor (pipe, socket or file) into a buffer and hands out views of complete lines or tokens,
+ * which never straddle the end of the buffer. A view stays valid until the next call to bstr_reader_next_line or
+ * bstr_reader_next_token unless it's pinned. Buffer positions are counted in bytes from the start of the stream.
+ * The members are private to the implementation.
+ */
+typedef struct bstr_reader_tag
+{
+   uint8_t *buffer;
+   size_t capacity;
+   uint64_t bufferPos;        //stream position of buffer[0], unused by ring buffers where it's position % capacity
+   uint64_t pinPos;           //start of the pinned data
+   uint64_t viewPos;          //start of the last view
+   uint64_t nextPos;          //first byte not handed out
+   uint64_t endPos;           //end of the data read so far
+   uint64_t pendingPos;       //end of the read in flight (io_uring), equal to endPos when there is none
+   int fd;
+   uint32_t flags;            //BSTR_READER_* in use
+   bool isPinned;
+   bool isEof;
+   bstr_error_t lastError;
+   const bstr_allocator_t *allocator;
+   void *uring;               //io_uring state, NULL unless BSTR_READER_IO_URING is in use
+} bstr_reader_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+bstr_error_t bstr_reader_create(bstr_reader_t *self, int fd, size_t capacity, uint32_t flags, const bstr_allocator_t *allocator);
+void bstr_reader_destroy(bstr_reader_t *self);
+bool bstr_reader_next_line(bstr_reader_t *self, const uint8_t **ppBegin, const uint8_t **ppEnd);
+bool bstr_reader_next_token(bstr_reader_t *self, const bstr_byteset_t *separators, const uint8_t **ppBegin, const uint8_t **ppEnd);
+void bstr_reader_pin(bstr_reader_t *self);
+void bstr_reader_unpin(bstr_reader_t *self);
+bool bstr_reader_eof(const bstr_reader_t *self);
+
+#endif //BSTR_READER_H
@@ -0,0 +1,102 @@
+/*****************************************************************************
+* \file      bstr_tokenizer.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Resumable JSON tokenizer for input arriving in chunks
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_TOKENIZER_H
+#define BSTR_TOKENIZER_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bstr.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+/* bstr_token_t types */
+#define BSTR_TOKEN_NEED_MORE        0u  //the chunk is consumed, give the next one to bstr_tokenizer_feed
+#define BSTR_TOKEN_END              1u  //end of input after bstr_tokenizer_finish
+#define BSTR_TOKEN_BEGIN_OBJECT     2u  // {
+#define BSTR_TOKEN_END_OBJECT       3u  // }
+#define BSTR_TOKEN_BEGIN_ARRAY      4u  // [
+#define BSTR_TOKEN_END_ARRAY        5u  // ]
+#define BSTR_TOKEN_NAME_SEPARATOR   6u  // :
+#define BSTR_TOKEN_VALUE_SEPARATOR  7u  // ,
+#define BSTR_TOKEN_STRING           8u
+#define BSTR_TOKEN_NUMBER           9u
+#define BSTR_TOKEN_TRUE             10u
+#define BSTR_TOKEN_FALSE            11u
+#define BSTR_TOKEN_NULL             12u
+
+/**
+ * A token returned by bstr_tokenizer_next. For strings [pBegin, pEnd) is the unescaped content, for all other tokens
+ * it is the text of the token. When isView is set the bytes are in the chunk given to bstr_tokenizer_feed, otherwise
+ * they are owned by the tokenizer and valid until the next call to bstr_tokenizer_next.
+ */
+typedef struct bstr_token_tag
+{
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   bstr_number_t number;   //value of BSTR_TOKEN_NUMBER
+   uint8_t type;           //BSTR_TOKEN_*
+   bool isView;
+} bstr_token_t;
+
+/**
+ * Pull tokenizer for JSON text arriving in chunks (from a socket for example). A token which is cut by the end of
+ * a chunk is suspended and completed from the following chunks, the work is linear in the input with each byte
+ * scanned at most twice (a suspended string is unescaped again once it is complete). Only such tokens are copied
+ * into the spill buffer, all others are returned as views into the chunk.
+ * The tokenizer does not check the grammar, it only splits the input into tokens.
+ * The members are private to the implementation.
+ */
+typedef struct bstr_tokenizer_tag
+{
+   bstr_context_t ctx;        //holds the error, which is sticky until bstr_tokenizer_reset
+   const uint8_t *pNext;      //unread part of the current chunk
+   const uint8_t *pEnd;
+   bstr_buf_t spill;          //suspended token
+   const char *literal;       //true, false or null while a literal is suspended
+   uint8_t literalPos;        //number of bytes of literal matched so far
+   uint8_t literalType;
+   uint8_t state;
+   bool isEscapePending;      //suspended string ends with the backslash of an escape
+   bool isFinal;              //set by bstr_tokenizer_finish
+} bstr_tokenizer_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void bstr_tokenizer_create(bstr_tokenizer_t *self, const bstr_allocator_t *allocator);
+void bstr_tokenizer_destroy(bstr_tokenizer_t *self);
+void bstr_tokenizer_reset(bstr_tokenizer_t *self);
+bstr_error_t bstr_tokenizer_feed(bstr_tokenizer_t *self, const uint8_t *pBegin, const uint8_t *pEnd);
+void bstr_tokenizer_finish(bstr_tokenizer_t *self);
+bstr_error_t bstr_tokenizer_next(bstr_tokenizer_t *self, bstr_token_t *token);
+
+#endif //BSTR_TOKENIZER_H
@@ -33,7 +33,11 @@
 #include <assert.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <limits.h>
+#include <math.h>
 #include "bstr.h"
+#include "bstr_simd.h"
+#include "bstr_float.h"
 
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
@@ -42,36 +46,250 @@
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
-#define MAX_NUMBER_SIZE 32
+#define SHORT_NEEDLE_MAX 32u  //longer needles go directly to Two-Way
+#define CHARCLASS_SCALAR_PREFIX 16  //runs shorter than this are checked without the SIMD kernels
+#define LINE_INDEX_BATCH_SIZE 256u
+#define LINE_INDEX_INITIAL_CAPACITY 64u
+#define BUF_INLINE_CAPACITY (BSTR_BUF_INLINE_SIZE - 1u)
 
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 static void bstr_set_error(bstr_context_t *ctx, bstr_error_t errorCode);
-static const uint8_t *bstr_parse_number_int(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, bstr_number_t *number);
+static bool bstr_json_integer_part(const bstr_decimal_t *decimal, uint64_t *value);
+static const uint8_t *bstr_json_string_view(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppStrBegin, const uint8_t **ppStrEnd, adt_str_t *str, bstr_buf_t *buf, bool *isView);
+static const uint8_t *bstr_json_string_decode(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pSpecial, adt_str_t *str, bstr_buf_t *buf);
+static bool bstr_json_string_reserve(adt_str_t *str, bstr_buf_t *buf, size_t len);
+static bool bstr_json_string_append(adt_str_t *str, bstr_buf_t *buf, const uint8_t *pBegin, const uint8_t *pEnd);
+static const uint8_t *bstr_json_string_end(const uint8_t *pString, const uint8_t *pNext, const uint8_t *pEnd);
+static const uint8_t *bstr_json_unescape(bstr_context_t *ctx, const uint8_t *pBackslash, const uint8_t *pEnd, uint8_t *buf, size_t *len);
+static bool bstr_json_is_hex_prefix(const uint8_t *pBegin, const uint8_t *pEnd);
+static size_t bstr_utf8_encode(uint32_t codePoint, uint8_t *buf);
+static void *bstr_default_alloc(void *arg, size_t size);
+static void *bstr_default_realloc(void *arg, void *ptr, size_t oldSize, size_t newSize);
+static void bstr_default_free(void *arg, void *ptr, size_t size);
+static bstr_error_t bstr_buf_expand(bstr_buf_t *self, size_t len);
+static void bstr_buf_adopt_allocator(bstr_buf_t *self, const bstr_context_t *ctx);
+static bstr_error_t bstr_buf_realloc(bstr_buf_t *self, size_t capacity);
+static void bstr_byteset_compile(bstr_byteset_t *self);
+static size_t bstr_critical_factorization(const uint8_t *pNeedle, size_t needleLen, size_t *period);
+static const uint8_t *bstr_two_way(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_needle_t *needle);
+static const uint8_t *bstr_find_internal(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pStrBegin, size_t needleLen, const bstr_needle_t *needle);
+static bstr_error_t bstr_line_index_grow(bstr_line_index_t *self);
+static void bstr_split_iter_init(bstr_split_iter_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t flags);
+static const uint8_t *bstr_split_find(bstr_split_iter_t *self);
+static const uint8_t *bstr_parse_integer(const uint8_t *pBegin, const uint8_t *pEnd, uint32_t base, uint64_t *magnitude, bool *isNegative, bool *isOverflow);
+static const uint8_t *bstr_parse_digits_base10(const uint8_t *pBegin, const uint8_t *pEnd, uint64_t *value, bool *isOverflow);
+static const uint8_t *bstr_parse_digits_base16(const uint8_t *pBegin, const uint8_t *pEnd, uint64_t *value, bool *isOverflow);
+static const uint8_t *bstr_parse_digits(const uint8_t *pBegin, const uint8_t *pEnd, uint32_t base, uint64_t *value, bool *isOverflow);
+static uint32_t bstr_digit_value(uint8_t c);
+static long long bstr_integer_to_signed(uint64_t magnitude, bool isNegative, bool isOverflow, long long maxValue);
+static unsigned long long bstr_integer_to_unsigned(uint64_t magnitude, bool isNegative, bool isOverflow, unsigned long long maxValue);
+static const uint8_t *bstr_parse_special_double(const uint8_t *pBegin, const uint8_t *pEnd, double *data);
+static bool bstr_match_cstr_nocase(const uint8_t *pBegin, const uint8_t *pEnd, const char *cstr);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//Tables below are the output of bstr_byteset_create for the listed characters
+
+/* { } [ ] , : " */
+const bstr_byteset_t bstr_json_structural_chars =
+{
+   {{0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x04, 0x01, 0x04, 0x00, 0x00},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+   {{0x00, 0x00, 0x01, 0x02, 0x00, 0x04, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+   {0x00000000u, 0x04001004u, 0x28000000u, 0x28000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+   1u
+};
+
+/* '"', '\\' and control characters 0x00-0x1F */
+const bstr_byteset_t bstr_json_string_special_chars =
+{
+   {{0x01, 0x01, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x01, 0x01, 0x01},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+   {{0x01, 0x01, 0x02, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+   {0xFFFFFFFFu, 0x00000004u, 0x10000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+   1u
+};
+
+/* '\t' and ' ' */
+const bstr_charclass_t bstr_class_horizontal_space =
+{
+   {
+      {{0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0x00000200u, 0x00000001u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+      1u
+   },
+   {
+      {{0x03, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x06, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x02, 0x04, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0xFFFFFDFFu, 0xFFFFFFFEu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu},
+      1u
+   }
+};
+
+/* '\t', '\n', '\r' and ' ' */
+const bstr_charclass_t bstr_class_whitespace =
+{
+   {
+      {{0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0x00002600u, 0x00000001u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+      1u
+   },
+   {
+      {{0x03, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x06, 0x06, 0x07, 0x07, 0x06, 0x07, 0x07},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x02, 0x04, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0xFFFFD9FFu, 0xFFFFFFFEu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu},
+      1u
+   }
+};
+
+/* '0'-'9' */
+const bstr_charclass_t bstr_class_digit =
+{
+   {
+      {{0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0x00000000u, 0x03FF0000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+      1u
+   },
+   {
+      {{0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x01, 0x01, 0x02, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0xFFFFFFFFu, 0xFC00FFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu},
+      1u
+   }
+};
+
+/* '0'-'9', 'a'-'f' and 'A'-'F' */
+const bstr_charclass_t bstr_class_hex_digit =
+{
+   {
+      {{0x01, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x00, 0x00, 0x00, 0x01, 0x02, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0x00000000u, 0x03FF0000u, 0x0000007Eu, 0x0000007Eu, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+      1u
+   },
+   {
+      {{0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x05, 0x05, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x01, 0x01, 0x02, 0x04, 0x01, 0x04, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0xFFFFFFFFu, 0xFC00FFFFu, 0xFFFFFF81u, 0xFFFFFF81u, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu},
+      1u
+   }
+};
+
+/* '1'-'9' */
+const bstr_charclass_t bstr_class_one_nine =
+{
+   {
+      {{0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0x00000000u, 0x03FE0000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+      1u
+   },
+   {
+      {{0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x01, 0x01, 0x02, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0xFFFFFFFFu, 0xFC01FFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu},
+      1u
+   }
+};
+
+/* 0x00-0x1F */
+const bstr_charclass_t bstr_class_control_char =
+{
+   {
+      {{0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0xFFFFFFFFu, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+      1u
+   },
+   {
+      {{0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0x00000000u, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu},
+      1u
+   }
+};
+
+/* 0x01-0xFF */
+const bstr_charclass_t bstr_class_not_zero =
+{
+   {
+      {{0x02, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0xFFFFFFFEu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu},
+      1u
+   },
+   {
+      {{0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {{0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {0x00000001u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+      1u
+   }
+};
 
 //////////////////////////////////////////////////////////////////////////////
 // PRIVATE VARIABLES
 //////////////////////////////////////////////////////////////////////////////
-static const int ASCIIHexToInt[256] =
-{
-    // ASCII
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
-    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+static const bstr_allocator_t m_defaultAllocator = {bstr_default_alloc, bstr_default_realloc, bstr_default_free, 0};
+
+/**
+ * Maps the character following a backslash in a JSON string to the character it stands for, 0 for invalid escapes.
+ * \u is handled separately.
+ */
+static const uint8_t m_jsonEscapeChar[256] =
+{
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,  '"',    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  '/',
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, '\\',    0,    0,    0,
+      0,    0, '\b',    0,    0,    0, '\f',    0,    0,    0,    0,    0,    0,    0, '\n',    0,
+      0,    0, '\r',    0, '\t',    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -86,15 +304,27 @@ void bstr_context_create(bstr_context_t *self)
    if (self != 0)
    {
       self->lastError = BSTR_NO_ERROR;
+      self->allocator = 0;
+      self->ownerAllocator = 0;
    }
 }
 
 bstr_context_t *bstr_context_new(void)
 {
-   bstr_context_t *self = (bstr_context_t*) malloc(sizeof(bstr_context_t));
+   return bstr_context_new_a(0);
+}
+
+/**
+ * Allocates the context using allocator, which is also selected as the context allocator.
+ */
+bstr_context_t *bstr_context_new_a(const bstr_allocator_t *allocator)
+{
+   bstr_context_t *self = (bstr_context_t*) bstr_allocator_alloc(allocator, sizeof(bstr_context_t));
    if (self != 0)
    {
       bstr_context_create(self);
+      self->allocator = allocator;
+      self->ownerAllocator = allocator;
    }
    return self;
 }
@@ -103,7 +333,19 @@ void bstr_context_delete(bstr_context_t *self)
 {
    if (self != 0)
    {
-      free(self);
+      bstr_allocator_free(self->ownerAllocator, self, sizeof(bstr_context_t));
+   }
+}
+
+/**
+ * Selects the allocator used by parsers taking this context. The _buf parsers allocate from it for buffers created
+ * with the default allocator. NULL selects the default allocator.
+ */
+void bstr_context_set_allocator(bstr_context_t *self, const bstr_allocator_t *allocator)
+{
+   if (self != 0)
+   {
+      self->allocator = allocator;
    }
 }
 
@@ -114,9 +356,17 @@ void bstr_context_delete(bstr_context_t *self)
  * by calling free on the returned pointer.
  */
 char* bstr_make_cstr(const uint8_t *pBegin, const uint8_t *pEnd){
+   return bstr_make_cstr_a(pBegin, pEnd, 0);
+}
+
+/**
+ * Same as bstr_make_cstr but allocates from allocator. The string is freed by calling bstr_allocator_free
+ * with size set to the string length plus one.
+ */
+char* bstr_make_cstr_a(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_allocator_t *allocator){
    if( (pBegin != 0) && (pEnd != 0) && (pBegin<pEnd)){
       uint32_t len = (uint32_t) (pEnd-pBegin);
-      uint8_t *str = (uint8_t*) malloc(len+1);
+      uint8_t *str = (uint8_t*) bstr_allocator_alloc(allocator, len+1);
       if(str != 0){
          memcpy(str,pBegin,len);
          str[len]=0;
@@ -134,12 +384,20 @@ char* bstr_make_cstr(const uint8_t *pBegin, const uint8_t *pEnd){
  * it behaves identical to calling bstr_make_cstr directly
  */
 char *bstr_make_cstr_x(const uint8_t *pBegin, const uint8_t *pEnd, uint16_t beginOffset, uint16_t endOffset){
+   return bstr_make_cstr_x_a(pBegin, pEnd, beginOffset, endOffset, 0);
+}
+
+/**
+ * Same as bstr_make_cstr_x but allocates from allocator. The size of the allocation is the string length plus
+ * beginOffset, endOffset and one.
+ */
+char *bstr_make_cstr_x_a(const uint8_t *pBegin, const uint8_t *pEnd, uint16_t beginOffset, uint16_t endOffset, const bstr_allocator_t *allocator){
    if( (pBegin != 0) && (pEnd != 0) && (pBegin)){
       uint8_t *str;
       uint32_t allocLen;
       uint32_t strLen = (uint32_t) (pEnd-pBegin);
       allocLen = strLen+beginOffset+endOffset+1;
-      str = (uint8_t*) malloc(allocLen);
+      str = (uint8_t*) bstr_allocator_alloc(allocator, allocLen);
       if(str != 0){
          memcpy(str+beginOffset,pBegin,strLen);
          str[allocLen-1]=(uint8_t)0;
@@ -155,19 +413,84 @@ char *bstr_make_cstr_x(const uint8_t *pBegin, const uint8_t *pEnd, uint16_t begi
  * On failure it returns \par pBegin if not found or NULL if invalid arguments was given.
  */
 const uint8_t *bstr_search_val(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val){
-   const uint8_t *pNext = pBegin;
-   if (pNext > pEnd)
+   const uint8_t *pResult;
+   if (pBegin > pEnd)
    {
       return 0; //invalid arguments
    }
-   while(pNext < pEnd){
-      uint8_t c = *pNext;
-      if(c == val){
-         return pNext;
-      }
-      pNext++;
+   pResult = bstr_simd_ops()->search_val(pBegin, pEnd, val);
+   return (pResult < pEnd)? pResult : pBegin; //pBegin when val was not found before pEnd was reached
+}
+
+/**
+ * scans for the first byte between \par pBegin and \par pEnd which is a member of \par set.
+ * Uses the same return convention as bstr_search_val: On success it returns the pointer to the found byte.
+ * On failure it returns \par pBegin if not found or NULL if invalid arguments was given.
+ */
+const uint8_t *bstr_search_any(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   const uint8_t *pResult;
+   if ( (pBegin > pEnd) || (set == 0) )
+   {
+      return 0; //invalid arguments
+   }
+   pResult = bstr_simd_ops()->search_any(pBegin, pEnd, set);
+   return (pResult < pEnd)? pResult : pBegin;
+}
+
+/**
+ * scans backwards from \par pEnd for the last byte which is a member of \par set.
+ * On success it returns the pointer to the found byte.
+ * On failure it returns \par pEnd if not found or NULL if invalid arguments was given.
+ */
+const uint8_t *bstr_search_any_reverse(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   if ( (pBegin > pEnd) || (set == 0) )
+   {
+      return 0; //invalid arguments
+   }
+   return bstr_simd_ops()->search_any_reverse(pBegin, pEnd, set);
+}
+
+/**
+ * Searches for the first occurrence of the string bounded by \par pStrBegin and \par pStrEnd.
+ * Short strings are located using SIMD first/last byte filtering, long strings (or inputs where the filter
+ * performs poorly) using the Two-Way algorithm. Worst case running time is linear in the buffer length.
+ * Uses the same return convention as bstr_search_val: On success it returns the pointer to the start of the match.
+ * It returns \par pBegin if not found or NULL if invalid arguments was given. An empty string matches at \par pBegin.
+ */
+const uint8_t *bstr_find_bstr(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pStrBegin, const uint8_t *pStrEnd)
+{
+   if ( (pBegin > pEnd) || (pStrBegin > pStrEnd) || (pStrBegin == 0) )
+   {
+      errno = EINVAL; //invalid arguments
+      return 0;
+   }
+   return bstr_find_internal(pBegin, pEnd, pStrBegin, (size_t) (pStrEnd - pStrBegin), 0);
+}
+
+const uint8_t *bstr_find_cstr(const uint8_t *pBegin, const uint8_t *pEnd, const char *cstr)
+{
+   const uint8_t *pStrBegin = (const uint8_t*) cstr;
+   if ( (pBegin > pEnd) || (cstr == 0) )
+   {
+      errno = EINVAL; //invalid arguments
+      return 0;
+   }
+   return bstr_find_internal(pBegin, pEnd, pStrBegin, strlen(cstr), 0);
+}
+
+/**
+ * Same as bstr_find_bstr but uses a needle prepared by bstr_needle_create.
+ */
+const uint8_t *bstr_find_needle(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_needle_t *needle)
+{
+   if ( (pBegin > pEnd) || (needle == 0) )
+   {
+      errno = EINVAL; //invalid arguments
+      return 0;
    }
-   return pBegin; //val was not found before pEnd was reached
+   return bstr_find_internal(pBegin, pEnd, needle->pStrBegin, needle->length, needle);
 }
 
 /**
@@ -295,335 +618,371 @@ const uint8_t *bstr_match_cstr(const uint8_t *pBegin, const uint8_t *pEnd, const
    return bstr_match_bstr(pBegin, pEnd, pStrBegin, pStrEnd);
 }
 
+/**
+ * Parses a floating point number like strtod but without depending on the current locale (the decimal separator is always '.').
+ * Accepts leading whitespace, an optional sign, decimal digits with an optional fraction and exponent, "inf", "infinity" and "nan".
+ * Hexadecimal floating point is not supported. The result is correctly rounded: Eisel-Lemire handles nearly all inputs and
+ * long mantissas whose rounding it cannot decide fall back to big integer arithmetic.
+ * On overflow the result is +-HUGE_VAL, on underflow to zero it is +-0.0. In both cases errno is set to ERANGE.
+ * Returns pointer to the first character after the number, pBegin when no number was found
+ * or NULL on invalid arguments.
+ */
 const uint8_t* bstr_to_double(const uint8_t* pBegin, const uint8_t* pEnd, double* data)
 {
-   char tmp[MAX_NUMBER_SIZE+1];   
-   char* parse_end = NULL;
-   size_t size = pEnd - pBegin;
-   if (size > MAX_NUMBER_SIZE)
+   const uint8_t *pNext = pBegin;
+   const uint8_t *pResult;
+   bstr_decimal_t decimal;
+   if ( (pBegin == 0) || (pEnd == 0) || (data == 0) || (pBegin > pEnd) )
+   {
+      errno = EINVAL; //invalid arguments
+      return 0;
+   }
+   while ( (pNext < pEnd) && ( (*pNext == (uint8_t) ' ') || ((*pNext >= (uint8_t) '\t') && (*pNext <= (uint8_t) '\r')) ) )
    {
-      size = MAX_NUMBER_SIZE;
+      pNext++;
    }
-   memcpy(&tmp[0], pBegin, size);
-   tmp[size]='\0';
-   *data = strtod(&tmp[0], &parse_end);
-   if (parse_end > &tmp[0] )
+   pResult = bstr_decimal_parse(pNext, pEnd, 0u, &decimal);
+   if (pResult == pNext)
    {
-      size_t delta = parse_end - &tmp[0];
-      const uint8_t* retval = pBegin + delta;
-      if (retval <= pEnd)
-      {
-         return retval;
-      }   
+      pResult = bstr_parse_special_double(pNext, pEnd, data);
+      return (pResult != pNext)? pResult : pBegin;
    }
-   else if (parse_end == &tmp[0])
+   *data = bstr_decimal_to_double(&decimal);
+   if ( (*data == HUGE_VAL) || (*data == -HUGE_VAL) || ((*data == 0.0) && (decimal.mantissa != 0u)) )
    {
-      return pBegin; //Not a number
+      errno = ERANGE;
    }
-   return NULL;
+   return pResult;
 }
 
+/**
+ * Parses a signed integer like strtol using base 0 (a "0x" prefix selects hexadecimal and a leading '0' octal).
+ * The bounded string is parsed in place, without copying, and digits are converted eight at a time.
+ * On overflow the result saturates to LONG_MAX or LONG_MIN and errno is set to ERANGE.
+ * Returns pointer to the first character after the number, pBegin when no number was found
+ * or NULL on invalid arguments.
+ */
 const uint8_t *bstr_to_long(const uint8_t *pBegin, const uint8_t *pEnd, long *data)
 {
-   char tmp[MAX_NUMBER_SIZE+1];   
-   char* parse_end = NULL;
-   size_t size = pEnd - pBegin;
-   if (size > MAX_NUMBER_SIZE)
-   {
-      size = MAX_NUMBER_SIZE;
-   }
-   memcpy(&tmp[0], pBegin, size);
-   tmp[size]='\0';
-   *data = strtol(&tmp[0], &parse_end, 0);   
-   if (parse_end > &tmp[0] )
-   {
-      size_t delta = parse_end - &tmp[0];
-      const uint8_t* retval = pBegin + delta;
-      if (retval <= pEnd)
-      {
-         return retval;
-      }   
-   }
-   else if (parse_end == &tmp[0])
+   const uint8_t *pResult;
+   uint64_t magnitude;
+   bool isNegative;
+   bool isOverflow;
+   if ( (pBegin == 0) || (pEnd == 0) || (data == 0) || (pBegin > pEnd) )
    {
-      return pBegin; //Not a number
+      errno = EINVAL; //invalid arguments
+      return 0;
    }
-   return NULL;
+   pResult = bstr_parse_integer(pBegin, pEnd, 0u, &magnitude, &isNegative, &isOverflow);
+   *data = (pResult != pBegin)? (long) bstr_integer_to_signed(magnitude, isNegative, isOverflow, LONG_MAX) : 0;
+   return pResult;
 }
 
+/**
+ * Same as bstr_to_long but for long long.
+ */
 const uint8_t* bstr_to_long_long(const uint8_t* pBegin, const uint8_t* pEnd, long long* data)
 {
-   char tmp[MAX_NUMBER_SIZE+1];   
-   char* parse_end = NULL;
-   size_t size = pEnd - pBegin;
-   if (size > MAX_NUMBER_SIZE)
-   {
-      size = MAX_NUMBER_SIZE;
-   }
-   memcpy(&tmp[0], pBegin, size);
-   tmp[size]='\0';
-   *data = strtoll(&tmp[0], &parse_end, 0);   
-   if (parse_end > &tmp[0])
-   {
-      size_t delta = parse_end - &tmp[0];
-      const uint8_t* retval = pBegin + delta;
-      if (retval <= pEnd)
-      {
-         return retval;
-      }
-   }
-   else if (parse_end == &tmp[0])
+   const uint8_t *pResult;
+   uint64_t magnitude;
+   bool isNegative;
+   bool isOverflow;
+   if ( (pBegin == 0) || (pEnd == 0) || (data == 0) || (pBegin > pEnd) )
    {
-      return pBegin; //Not a number
+      errno = EINVAL; //invalid arguments
+      return 0;
    }
-   return NULL;
+   pResult = bstr_parse_integer(pBegin, pEnd, 0u, &magnitude, &isNegative, &isOverflow);
+   *data = (pResult != pBegin)? bstr_integer_to_signed(magnitude, isNegative, isOverflow, LLONG_MAX) : 0;
+   return pResult;
 }
 
-
+/**
+ * Parses an unsigned integer like strtoul. \par base is 0 or 2-36, bases 10 and 16 have dedicated fast paths.
+ * On overflow the result saturates to ULONG_MAX and errno is set to ERANGE.
+ * Returns pointer to the first character after the number, pBegin when no number was found
+ * or NULL on invalid arguments (including an unsupported base).
+ */
 const uint8_t *bstr_to_unsigned_long(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t base, unsigned long *data)
 {
-   char tmp[MAX_NUMBER_SIZE+1];   
-   char* parse_end = NULL;
-   size_t size = pEnd - pBegin;
-   if (size > MAX_NUMBER_SIZE)
-   {
-      size = MAX_NUMBER_SIZE;
-   }
-   memcpy(&tmp[0], pBegin, size);
-   tmp[size]='\0';
-   *data = strtoul(&tmp[0], &parse_end, base);   
-   if (parse_end > &tmp[0] )
+   const uint8_t *pResult;
+   uint64_t magnitude;
+   bool isNegative;
+   bool isOverflow;
+   if ( (pBegin == 0) || (pEnd == 0) || (data == 0) || (pBegin > pEnd) )
    {
-      size_t delta = parse_end - &tmp[0];
-      const uint8_t* retval = pBegin + delta;
-      if (retval <= pEnd)
-      {
-         return retval;
-      }
+      errno = EINVAL; //invalid arguments
+      return 0;
    }
-   else if (parse_end == &tmp[0])
+   pResult = bstr_parse_integer(pBegin, pEnd, base, &magnitude, &isNegative, &isOverflow);
+   if (pResult != 0)
    {
-      return pBegin; //Not a number
+      *data = (pResult != pBegin)? (unsigned long) bstr_integer_to_unsigned(magnitude, isNegative, isOverflow, ULONG_MAX) : 0u;
    }
-   return NULL;
+   return pResult;
 }
 
+/**
+ * Same as bstr_to_unsigned_long but for unsigned long long.
+ */
 const uint8_t* bstr_to_unsigned_long_long(const uint8_t* pBegin, const uint8_t* pEnd, uint8_t base, unsigned long long* data)
 {
-   char tmp[MAX_NUMBER_SIZE+1];   
-   char* parse_end = NULL;
-   size_t size = pEnd - pBegin;
-   if (size > MAX_NUMBER_SIZE)
-   {
-      size = MAX_NUMBER_SIZE;
-   }
-   memcpy(&tmp[0], pBegin, size);
-   tmp[size]='\0';
-   *data = strtoull(&tmp[0], &parse_end, base);   
-   if (parse_end > &tmp[0] )
+   const uint8_t *pResult;
+   uint64_t magnitude;
+   bool isNegative;
+   bool isOverflow;
+   if ( (pBegin == 0) || (pEnd == 0) || (data == 0) || (pBegin > pEnd) )
    {
-      size_t delta = parse_end - &tmp[0];
-      const uint8_t* retval = pBegin + delta;
-      if (retval <= pEnd)
-      {
-         return retval;
-      }
+      errno = EINVAL; //invalid arguments
+      return 0;
    }
-   else if (parse_end == &tmp[0])
+   pResult = bstr_parse_integer(pBegin, pEnd, base, &magnitude, &isNegative, &isOverflow);
+   if (pResult != 0)
    {
-      return pBegin; //Not a number
+      *data = (pResult != pBegin)? bstr_integer_to_unsigned(magnitude, isNegative, isOverflow, ULLONG_MAX) : 0u;
    }
-   return NULL;
+   return pResult;
 }
 
 /**
- * Parses a number from a bounded string using JSON number format
+ * Parses a number from a bounded string using JSON number format, in a single pass.
+ * Numbers without fraction and exponent that fit in 64 bits are stored as BSTR_NUMBER_INT64 (or BSTR_NUMBER_UINT64
+ * above INT64_MAX), all others as a correctly rounded BSTR_NUMBER_DOUBLE.
+ * Returns pointer to the first byte after the number or pEnd for an empty string.
+ * On malformed numbers NULL is returned and the error is BSTR_PARSE_ERROR, numbers outside double range give
+ * BSTR_NUMBER_TOO_LARGE_ERROR.
  */
 const uint8_t *bstr_parse_json_number(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, bstr_number_t *number)
 {
    const uint8_t *pResult;
-   const uint8_t *pNext = pBegin;
+   bstr_decimal_t decimal;
+   bool isInteger;
    if ( (ctx == 0) || (pBegin == 0) || (pEnd == 0) || (number == 0) || (pBegin > pEnd) )
    {
       errno = EINVAL; //invalid arguments
       return 0;
    }
+   number->type = BSTR_NUMBER_NONE;
+   number->integer = 0u;
+   number->exponent = 0;
    number->hasInteger = false;
    number->hasFraction = false;
    number->hasExponent = false;
    number->isNegative = false;
-   if (pNext < pEnd)
+   if (pBegin == pEnd)
    {
-      pResult = bstr_parse_number_int(ctx, pNext, pEnd, number);
-      pNext = pResult;
+      return pEnd; //empty string
    }
-   else
+   pResult = bstr_decimal_parse(pBegin, pEnd, BSTR_DECIMAL_JSON, &decimal);
+   if ( (pResult == 0) || (pResult == pBegin) )
    {
-      //empty string
+      bstr_set_error(ctx, BSTR_PARSE_ERROR);
+      return 0;
    }
-   return pNext;
+   number->isNegative = decimal.isNegative;
+   number->hasInteger = true;
+   number->hasFraction = (decimal.pFracEnd != decimal.pFracBegin);
+   number->hasExponent = (pResult != (number->hasFraction? decimal.pFracEnd : decimal.pIntEnd));
+   number->exponent = (decimal.explicitExponent > INT32_MAX)? INT32_MAX :
+                      (decimal.explicitExponent < INT32_MIN)? INT32_MIN : (int32_t) decimal.explicitExponent;
+   isInteger = bstr_json_integer_part(&decimal, &number->integer) && (!number->hasFraction) && (!number->hasExponent);
+   if (isInteger)
+   {
+      if (!decimal.isNegative)
+      {
+         number->type = (number->integer <= (uint64_t) INT64_MAX)? BSTR_NUMBER_INT64 : BSTR_NUMBER_UINT64;
+         number->value.u64 = number->integer;
+         return pResult;
+      }
+      if (number->integer <= (uint64_t) INT64_MAX + 1u)
+      {
+         number->type = BSTR_NUMBER_INT64;
+         number->value.i64 = (number->integer == (uint64_t) INT64_MAX + 1u)? INT64_MIN : -(int64_t) number->integer;
+         return pResult;
+      }
+   }
+   number->type = BSTR_NUMBER_DOUBLE;
+   number->value.f64 = bstr_decimal_to_double(&decimal);
+   if ( (number->value.f64 == HUGE_VAL) || (number->value.f64 == -HUGE_VAL) )
+   {
+      bstr_set_error(ctx, BSTR_NUMBER_TOO_LARGE_ERROR);
+      return 0;
+   }
+   return pResult;
 }
 
 /**
  * Using the JSON definition, this function parses a double-quoted string literal.
- * The parsed string (not including the the quotation marks) will be stored in the str parameter
+ * The parsed string (not including the the quotation marks) will be stored in the str parameter.
+ * Runs without escapes are found with a vectorized scan and appended with a single copy. The same scan validates
+ * the literal as UTF-8. \\u escapes (including surrogate pairs) are stored as UTF-8.
+ * Returns pointer to the first byte after the closing quotation mark, pBegin when there is no string literal
+ * (or it isn't terminated) and NULL on invalid characters, invalid UTF-8 and invalid escapes.
  */
 const uint8_t *bstr_parse_json_string_literal(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, adt_str_t *str)
 {
-#define NUM_ESCAPE_CHARS 8
-   const uint8_t quotationMark = '"';
-   const uint8_t backslash = '\\';
-   const uint8_t frontslash = '/';
-   const uint8_t backspace = '\b';
-   const uint8_t formfeed = '\f';
-   const uint8_t linefeed = '\n';
-   const uint8_t carriageReturn = '\r';
-   const uint8_t horizontalTab = '\t';
-   const uint8_t validEscapeChars[NUM_ESCAPE_CHARS] = {
-         quotationMark,
-         backslash,
-         frontslash,
-         'b',
-         'f',
-         'n',
-         'r',
-         't'
-   };
-   const uint8_t escapeCharMap[NUM_ESCAPE_CHARS] = {
-         quotationMark,
-         backslash,
-         frontslash,
-         backspace,
-         formfeed,
-         linefeed,
-         carriageReturn,
-         horizontalTab,
-   };
-
    if ( (ctx == 0) || (pBegin == 0) || (pEnd == 0) || (str == 0) || (pEnd < pBegin) )
    {
       errno = EINVAL;
       return (const uint8_t*) 0;
    }
-   if (pBegin < pEnd)
+   if ( (pBegin == pEnd) || (*pBegin != (uint8_t) '"') )
    {
-      uint8_t firstChar = *pBegin;
-      if (firstChar == quotationMark)
-      {
-         const uint8_t *pNext = pBegin+1;
-         bool isEscapeSequence = false;
-         uint8_t escapeType = 0u;
-         uint8_t numDigits = 0u;
-         uint32_t value = 0u;
-         while(pNext < pEnd)
-         {
-            uint8_t c = *pNext++;
-            if (isEscapeSequence)
-            {
-               if (escapeType == 'u')
-               {
-                  if (numDigits<4)
-                  {
-                     value<<=4;
-                     value|=ASCIIHexToInt[c];
-                     numDigits++;
-                  }
-                  if (numDigits==4)
-                  {
-                     //TODO: adt_str_push does not yet support unicode, will need to fix that.
-                     //TODO: JSON can contain two \u sequences in a row to allow large code points. Will implement that later.
-                     adt_str_push(str, (int) value);
-                     escapeType = 0u;
-                     numDigits = 0u;
-                     value = 0u;
-                  }
-               }
-               else
-               {
-                  if (c == 'u')
-                  {
-                     escapeType = c;
-                  }
-                  else
-                  {
-                     int32_t i;
-                     for (i=0; i<NUM_ESCAPE_CHARS; i++)
-                     {
-                        if (c==validEscapeChars[i])
-                        {
-                           break;
-                        }
-                     }
-                     if (i < NUM_ESCAPE_CHARS)
-                     {
-                        adt_str_push(str, escapeCharMap[i]);
-                        isEscapeSequence = false;
-                     }
-                     else
-                     {
-                        bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
-                        return (const uint8_t*) 0;
-                     }
-                  }
-               }
-            }
-            else
-            {
-               if (c == quotationMark)
-               {
-                  return pNext;
-               }
-               else if (c == backslash)
-               {
-                  isEscapeSequence = true;
-               }
-               else if (bstr_pred_is_control_char(c))
-               {
-                  bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
-                  return (const uint8_t*) 0;
-               }
-               else
-               {
-                  adt_error_t result = adt_str_push(str, c);
-                  if (result != ADT_NO_ERROR)
-                  {
-                     bstr_set_error(ctx, BSTR_MEM_ERROR);
-                     return (const uint8_t*) 0;
-                  }
-               }
-            }
-         }
-      }
+      return pBegin;
    }
-   return pBegin;
-#undef NUM_ESCAPE_CHARS
+   return bstr_json_string_decode(ctx, pBegin, pEnd, bstr_simd_ops()->json_string(pBegin + 1, pEnd), str, 0);
 }
 
 /**
- * searches for next line ending '\n'. returns where it encountered the line ending
+ * Same as bstr_parse_json_string_literal but the string is appended to buf. Keys and other short strings stay
+ * in the inline storage of buf and don't allocate. A buf created with the default allocator which has no heap
+ * storage yet allocates from the context allocator.
  */
-const uint8_t *bstr_line(const uint8_t *pBegin, const uint8_t *pEnd)
+const uint8_t *bstr_parse_json_string_literal_buf(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *buf)
 {
-   return bstr_search_val(pBegin, pEnd, (uint8_t) '\n');
+   if ( (ctx == 0) || (pBegin == 0) || (pEnd == 0) || (buf == 0) || (pEnd < pBegin) )
+   {
+      errno = EINVAL;
+      return (const uint8_t*) 0;
+   }
+   bstr_buf_adopt_allocator(buf, ctx);
+   if ( (pBegin == pEnd) || (*pBegin != (uint8_t) '"') )
+   {
+      return pBegin;
+   }
+   return bstr_json_string_decode(ctx, pBegin, pEnd, bstr_simd_ops()->json_string(pBegin + 1, pEnd), 0, buf);
 }
 
-const uint8_t *bstr_while_predicate(const uint8_t *pBegin, const uint8_t *pEnd, int (*pred_func)(int c) )
+/**
+ * Zero-copy variant of bstr_parse_json_string_literal.
+ * When the literal has no escapes *isView is set to true and [*ppStrBegin, *ppStrEnd) points into the source buffer,
+ * str is not touched. Otherwise the unescaped string is appended to str, *isView is set to false and
+ * [*ppStrBegin, *ppStrEnd) points to the appended part inside str (valid until str is modified).
+ * Return values are the same as for bstr_parse_json_string_literal.
+ */
+const uint8_t *bstr_parse_json_string_view(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppStrBegin, const uint8_t **ppStrEnd, adt_str_t *str, bool *isView)
 {
-   const uint8_t *pNext = pBegin;
-   while (pNext < pEnd)
+   if ( (ctx == 0) || (pBegin == 0) || (pEnd == 0) || (ppStrBegin == 0) || (ppStrEnd == 0) || (str == 0) || (isView == 0) || (pEnd < pBegin) )
    {
-      int c = (int) *pNext;
-      if (!pred_func(c)){
-         break;
-      }
-      pNext++;
+      errno = EINVAL;
+      return (const uint8_t*) 0;
    }
-   return pNext;
+   return bstr_json_string_view(ctx, pBegin, pEnd, ppStrBegin, ppStrEnd, str, 0, isView);
 }
 
-const uint8_t *bstr_while_predicate_reverse(const uint8_t *pBegin, const uint8_t *pEnd, int (*pred_func)(int c) )
+/**
+ * Same as bstr_parse_json_string_view but a literal with escapes is appended to buf. buf takes the context allocator
+ * like in bstr_parse_json_string_literal_buf.
+ */
+const uint8_t *bstr_parse_json_string_view_buf(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppStrBegin, const uint8_t **ppStrEnd, bstr_buf_t *buf, bool *isView)
 {
-   if (pBegin < pEnd)
+   if ( (ctx == 0) || (pBegin == 0) || (pEnd == 0) || (ppStrBegin == 0) || (ppStrEnd == 0) || (buf == 0) || (isView == 0) || (pEnd < pBegin) )
+   {
+      errno = EINVAL;
+      return (const uint8_t*) 0;
+   }
+   bstr_buf_adopt_allocator(buf, ctx);
+   return bstr_json_string_view(ctx, pBegin, pEnd, ppStrBegin, ppStrEnd, 0, buf, isView);
+}
+
+/**
+ * In-place variant of bstr_parse_json_string_literal for mutable buffers.
+ * Escapes are decoded by moving the content towards the opening quotation mark, the unescaped string is never longer
+ * than the literal. On success [*ppStrBegin, *ppStrEnd) holds the unescaped string inside the literal.
+ * The buffer is only modified when the literal is terminated and contains escapes, an unterminated literal
+ * (return value pBegin) is left untouched so it can be parsed again once more data has arrived.
+ * After an error (return value NULL) the content of the literal is unspecified.
+ */
+const uint8_t *bstr_unescape_json_inplace(bstr_context_t *ctx, uint8_t *pBegin, uint8_t *pEnd, uint8_t **ppStrBegin, uint8_t **ppStrEnd)
+{
+   const bstr_simd_ops_t *ops;
+   const uint8_t *pRun;
+   const uint8_t *pSpecial;
+   uint8_t *pWrite;
+   if ( (ctx == 0) || (pBegin == 0) || (pEnd == 0) || (ppStrBegin == 0) || (ppStrEnd == 0) || (pEnd < pBegin) )
+   {
+      errno = EINVAL;
+      return (const uint8_t*) 0;
+   }
+   if ( (pBegin == pEnd) || (*pBegin != (uint8_t) '"') )
+   {
+      return pBegin;
+   }
+   ops = bstr_simd_ops();
+   pRun = pBegin + 1;
+   pWrite = pBegin + 1;
+   pSpecial = ops->json_string(pRun, pEnd);
+   if ( (pSpecial < pEnd) && (*pSpecial == (uint8_t) '\\') && (bstr_json_string_end(pRun, pSpecial, pEnd) == pEnd) )
+   {
+      return pBegin; //don't touch the buffer before it's known that the literal is complete
+   }
+   for (;;)
+   {
+      uint8_t decoded[4];
+      size_t decodedLen;
+      uint8_t c;
+      if (pSpecial == pEnd)
+      {
+         return pBegin; //missing closing quotation mark
+      }
+      c = *pSpecial;
+      if ( (c != (uint8_t) '"') && (c != (uint8_t) '\\') )
+      {
+         bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
+         return (const uint8_t*) 0;
+      }
+      if (pWrite != pRun)
+      {
+         memmove(pWrite, pRun, (size_t) (pSpecial - pRun));
+      }
+      pWrite += pSpecial - pRun;
+      if (c == (uint8_t) '"')
+      {
+         *ppStrBegin = pBegin + 1;
+         *ppStrEnd = pWrite;
+         return pSpecial + 1;
+      }
+      pRun = bstr_json_unescape(ctx, pSpecial, pEnd, decoded, &decodedLen);
+      if (pRun == 0)
+      {
+         return (const uint8_t*) 0;
+      }
+      if (pRun == pSpecial)
+      {
+         bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR); //the closing quotation mark is inside the escape sequence
+         return (const uint8_t*) 0;
+      }
+      memcpy(pWrite, decoded, decodedLen);
+      pWrite += decodedLen;
+      pSpecial = ops->json_string(pRun, pEnd);
+   }
+}
+
+/**
+ * searches for next line ending '\n'. returns where it encountered the line ending
+ */
+const uint8_t *bstr_line(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   return bstr_search_val(pBegin, pEnd, (uint8_t) '\n');
+}
+
+const uint8_t *bstr_while_predicate(const uint8_t *pBegin, const uint8_t *pEnd, int (*pred_func)(int c) )
+{
+   const uint8_t *pNext = pBegin;
+   while (pNext < pEnd)
+   {
+      int c = (int) *pNext;
+      if (!pred_func(c)){
+         break;
+      }
+      pNext++;
+   }
+   return pNext;
+}
+
+const uint8_t *bstr_while_predicate_reverse(const uint8_t *pBegin, const uint8_t *pEnd, int (*pred_func)(int c) )
+{
+   if (pBegin < pEnd)
    {
       const uint8_t *pNext = pEnd;
       while (pNext > pBegin)
@@ -640,12 +999,79 @@ const uint8_t *bstr_while_predicate_reverse(const uint8_t *pBegin, const uint8_t
    return pBegin;
 }
 
+/**
+ * Returns pointer to the first character in the string which is not a member of \par cls (or pEnd).
+ * Runs longer than a few characters are scanned with the SIMD kernels.
+ */
+const uint8_t *bstr_while_class(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_charclass_t *cls)
+{
+   const uint8_t *pNext = pBegin;
+   const uint8_t *pPrefixEnd;
+   if (cls == 0)
+   {
+      errno = EINVAL; //invalid arguments
+      return 0;
+   }
+   if ( (pBegin == 0) || (pEnd == 0) || (pBegin >= pEnd) )
+   {
+      return pBegin;
+   }
+   pPrefixEnd = (pEnd - pBegin > CHARCLASS_SCALAR_PREFIX)? pBegin + CHARCLASS_SCALAR_PREFIX : pEnd;
+   while (pNext < pPrefixEnd)
+   {
+      if (!bstr_byteset_has(&cls->members, *pNext))
+      {
+         return pNext;
+      }
+      pNext++;
+   }
+   if (pNext == pEnd)
+   {
+      return pEnd;
+   }
+   return bstr_simd_ops()->search_any(pNext, pEnd, &cls->others);
+}
+
+/**
+ * Returns pointer just after the last character in the string which is not a member of \par cls (or pBegin).
+ */
+const uint8_t *bstr_while_class_reverse(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_charclass_t *cls)
+{
+   const uint8_t *pNext = pEnd;
+   const uint8_t *pPrefixBegin;
+   const uint8_t *pFound;
+   if (cls == 0)
+   {
+      errno = EINVAL; //invalid arguments
+      return 0;
+   }
+   if ( (pBegin == 0) || (pEnd == 0) || (pBegin >= pEnd) )
+   {
+      return pBegin;
+   }
+   pPrefixBegin = (pEnd - pBegin > CHARCLASS_SCALAR_PREFIX)? pEnd - CHARCLASS_SCALAR_PREFIX : pBegin;
+   while (pNext > pPrefixBegin)
+   {
+      if (!bstr_byteset_has(&cls->members, pNext[-1]))
+      {
+         return pNext;
+      }
+      pNext--;
+   }
+   if (pNext == pBegin)
+   {
+      return pBegin;
+   }
+   pFound = bstr_simd_ops()->search_any_reverse(pBegin, pNext, &cls->others);
+   return (pFound == pNext)? pBegin : pFound + 1;
+}
+
 /**
  * Strips any whitespace from beginning of string, returns a new pBegin where first non-whitespace charactes is found
  */
 const uint8_t *bstr_lstrip(const uint8_t *pBegin, const uint8_t *pEnd)
 {
-   return bstr_while_predicate(pBegin, pEnd, bstr_pred_is_whitespace);
+   return bstr_while_class(pBegin, pEnd, &bstr_class_whitespace);
 }
 
 /**
@@ -653,7 +1079,7 @@ const uint8_t *bstr_lstrip(const uint8_t *pBegin, const uint8_t *pEnd)
  */
 const uint8_t *bstr_rstrip(const uint8_t *pBegin, const uint8_t *pEnd)
 {
-   return bstr_while_predicate_reverse(pBegin, pEnd, bstr_pred_is_whitespace);
+   return bstr_while_class_reverse(pBegin, pEnd, &bstr_class_whitespace);
 }
 
 void bstr_strip(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **strippedBegin, const uint8_t **strippedEnd)
@@ -672,110 +1098,1901 @@ void bstr_clear_error(bstr_context_t *ctx)
    ctx->lastError = BSTR_NO_ERROR;
 }
 
-/*************** predicate functions ***************/
-int bstr_pred_is_horizontal_space(int c)
+/*************** allocators ***************/
+
+/**
+ * Returns the allocator built on malloc, realloc and free which is used wherever an allocator is NULL.
+ */
+const bstr_allocator_t *bstr_allocator_default(void)
 {
-   return (c == (int) '\t') || (c == (int) ' ');
+   return &m_defaultAllocator;
 }
 
-int bstr_pred_is_whitespace(int c)
+void *bstr_allocator_alloc(const bstr_allocator_t *allocator, size_t size)
 {
-   return (c == (int) '\t') || (c == (int) '\n') || (c == (int) '\r') || (c == (int) ' ');
+   if (allocator == 0)
+   {
+      allocator = &m_defaultAllocator;
+   }
+   return allocator->allocFunc(allocator->arg, size);
 }
 
-int bstr_pred_is_digit(int c)
+/**
+ * Resizes a block from allocator. Like realloc a NULL ptr allocates a new block and the old block is kept on failure.
+ */
+void *bstr_allocator_realloc(const bstr_allocator_t *allocator, void *ptr, size_t oldSize, size_t newSize)
 {
-   return (c >= '0') && (c <= '9');
+   if (allocator == 0)
+   {
+      allocator = &m_defaultAllocator;
+   }
+   if (ptr == 0)
+   {
+      return allocator->allocFunc(allocator->arg, newSize);
+   }
+   return allocator->reallocFunc(allocator->arg, ptr, oldSize, newSize);
 }
 
-int bstr_pred_is_hex_digit(int c)
+void bstr_allocator_free(const bstr_allocator_t *allocator, void *ptr, size_t size)
 {
-   return ((c >= '0') && (c <= '9') ) || ((c >= 'a') && (c <= 'f')) || ((c >= 'A') && (c <= 'F'));
+   if (ptr != 0)
+   {
+      if (allocator == 0)
+      {
+         allocator = &m_defaultAllocator;
+      }
+      allocator->freeFunc(allocator->arg, ptr, size);
+   }
 }
 
-int bstr_pred_is_one_nine(int c)
+/*************** owned strings ***************/
+
+/**
+ * Creates an empty string. Strings longer than the inline storage are allocated from allocator, NULL selects the
+ * default allocator.
+ */
+void bstr_buf_create(bstr_buf_t *self, const bstr_allocator_t *allocator)
 {
-   return (c >= '1') && (c <= '9');
+   if (self != 0)
+   {
+      self->data.inlineData[0] = 0u;
+      self->length = 0u;
+      self->capacity = BUF_INLINE_CAPACITY;
+      self->allocator = allocator;
+   }
 }
 
-int bstr_pred_is_control_char(int c)
+/**
+ * Frees the heap storage. The string is left empty and can be used again.
+ */
+void bstr_buf_destroy(bstr_buf_t *self)
 {
-   return (c < 32);
+   if (self != 0)
+   {
+      if (self->capacity > BUF_INLINE_CAPACITY)
+      {
+         bstr_allocator_free(self->allocator, self->data.pHeap, self->capacity + 1u);
+      }
+      bstr_buf_create(self, self->allocator);
+   }
 }
 
-int bstr_pred_is_not_zero(int c)
+/**
+ * Sets the length to 0 but keeps the storage.
+ */
+void bstr_buf_clear(bstr_buf_t *self)
 {
-   return c != 0u;
+   if (self != 0)
+   {
+      self->length = 0u;
+      bstr_buf_data(self)[0] = 0u;
+   }
 }
 
-//////////////////////////////////////////////////////////////////////////////
-// PRIVATE FUNCTIONS
-//////////////////////////////////////////////////////////////////////////////
-void bstr_set_error(bstr_context_t *ctx, bstr_error_t errorCode)
+/**
+ * Makes room for a string of capacity bytes (not counting the null terminator) without further reallocations.
+ */
+bstr_error_t bstr_buf_reserve(bstr_buf_t *self, size_t capacity)
 {
-   ctx->lastError = errorCode;
+   if (self == 0)
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   if (capacity <= self->capacity)
+   {
+      return BSTR_NO_ERROR;
+   }
+   return bstr_buf_realloc(self, capacity);
 }
 
-const uint8_t *bstr_parse_number_int(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, bstr_number_t *number)
+/**
+ * Appends the string pBegin..pEnd, which may be a view of self.
+ */
+bstr_error_t bstr_buf_append_bstr(bstr_buf_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
 {
-   const uint8_t *pNext = pBegin;
-   const int32_t base = 10;
+   uint8_t *pData;
+   size_t len;
+   if ( (self == 0) || (pBegin == 0) || (pEnd == 0) || (pEnd < pBegin) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   len = (size_t) (pEnd - pBegin);
+   if (len > (self->capacity - self->length))
+   {
+      bstr_error_t result;
+      const uint8_t *pOldData = bstr_buf_data(self);
+      bool isAliased = (pBegin >= pOldData) && (pBegin <= pOldData + self->length);
+      size_t offset = isAliased ? (size_t) (pBegin - pOldData) : 0u;
+      result = bstr_buf_expand(self, len);
+      if (result != BSTR_NO_ERROR)
+      {
+         return result;
+      }
+      if (isAliased)
+      {
+         pBegin = bstr_buf_data(self) + offset; //the source moved along with the buffer
+      }
+   }
+   pData = bstr_buf_data(self);
+   memcpy(pData + self->length, pBegin, len);
+   self->length += len;
+   pData[self->length] = 0u;
+   return BSTR_NO_ERROR;
+}
+
+bstr_error_t bstr_buf_append_cstr(bstr_buf_t *self, const char *cstr)
+{
+   if (cstr == 0)
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   return bstr_buf_append_bstr(self, (const uint8_t*) cstr, (const uint8_t*) cstr + strlen(cstr));
+}
 
-   if (pNext < pEnd)
+bstr_error_t bstr_buf_push(bstr_buf_t *self, uint8_t c)
+{
+   uint8_t *pData;
+   if (self == 0)
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   if (self->length == self->capacity)
    {
-      char c =  (char) *pNext;
-      if (c == '-')
+      bstr_error_t result = bstr_buf_expand(self, 1u);
+      if (result != BSTR_NO_ERROR)
       {
-         number->isNegative = true;
-         ++pNext;
-         if (pNext < pEnd)
-         {
-            c =  (char) *pNext;
-         }
-         else
-         {
-            bstr_set_error(ctx, BSTR_PARSE_ERROR);
-            return (const uint8_t *) 0;
-         }
+         return result;
       }
-      if (c == '0')
+   }
+   pData = bstr_buf_data(self);
+   pData[self->length++] = c;
+   pData[self->length] = 0u;
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Returns the string data. The pointer is invalidated by any function which makes the string grow.
+ */
+uint8_t *bstr_buf_data(bstr_buf_t *self)
+{
+   return (self->capacity > BUF_INLINE_CAPACITY)? self->data.pHeap : self->data.inlineData;
+}
+
+const char *bstr_buf_cstr(const bstr_buf_t *self)
+{
+   return (const char*) ((self->capacity > BUF_INLINE_CAPACITY)? self->data.pHeap : self->data.inlineData);
+}
+
+size_t bstr_buf_length(const bstr_buf_t *self)
+{
+   return self->length;
+}
+
+/**
+ * Returns the string as [*ppBegin, *ppEnd). The view is invalidated by any function which makes the string grow.
+ */
+void bstr_buf_view(const bstr_buf_t *self, const uint8_t **ppBegin, const uint8_t **ppEnd)
+{
+   const uint8_t *pData = (const uint8_t*) bstr_buf_cstr(self);
+   *ppBegin = pData;
+   *ppEnd = pData + self->length;
+}
+
+/*************** byte sets ***************/
+
+/**
+ * Creates a byte set containing every byte found in the bounded string. An empty string gives an empty set.
+ */
+void bstr_byteset_create(bstr_byteset_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   if (self != 0)
+   {
+      const uint8_t *pNext = pBegin;
+      memset(self, 0, sizeof(bstr_byteset_t));
+      while ( (pNext != 0) && (pNext < pEnd) )
       {
-         number->integer = 0;
-         number->hasInteger = true;
-         ++pNext;
+         uint8_t c = *pNext++;
+         self->bits[c >> 5] |= 1u << (c & 31u);
       }
-      else if (bstr_pred_is_one_nine(c))
+      bstr_byteset_compile(self);
+   }
+}
+
+void bstr_byteset_create_cstr(bstr_byteset_t *self, const char *cstr)
+{
+   const uint8_t *pBegin = (const uint8_t*) cstr;
+   bstr_byteset_create(self, pBegin, (cstr != 0)? pBegin + strlen(cstr) : pBegin);
+}
+
+void bstr_byteset_add(bstr_byteset_t *self, uint8_t c)
+{
+   bstr_byteset_add_range(self, c, c);
+}
+
+/**
+ * Adds all bytes from \par first to \par last (inclusive)
+ */
+void bstr_byteset_add_range(bstr_byteset_t *self, uint8_t first, uint8_t last)
+{
+   if ( (self != 0) && (first <= last) )
+   {
+      uint32_t c;
+      for (c = first; c <= last; c++)
       {
-         int64_t intPart = ASCIIHexToInt[(int) c];
-         pNext++;
-         while(pNext < pEnd)
-         {
-            int tmp =  (int) *pNext;
-            if (bstr_pred_is_digit(tmp))
-            {
-               intPart *= base;
-               intPart += ASCIIHexToInt[tmp];
-               if (intPart > UINT32_MAX)
-               {
-                  bstr_set_error(ctx, BSTR_NUMBER_TOO_LARGE_ERROR);
-                  return (const uint8_t *) 0;
-               }
-               pNext++;
-            }
-            else
-            {
-               break; //possible start of fraction
-            }
-         }
-         number->hasInteger = true;
-         number->integer = (uint32_t) intPart;
+         self->bits[c >> 5] |= 1u << (c & 31u);
       }
-      else
+      bstr_byteset_compile(self);
+   }
+}
+
+/**
+ * Replaces the set with its complement.
+ */
+void bstr_byteset_invert(bstr_byteset_t *self)
+{
+   if (self != 0)
+   {
+      int32_t i;
+      for (i = 0; i < 8; i++)
       {
-         bstr_set_error(ctx, BSTR_PARSE_ERROR);
-         pNext = 0;
+         self->bits[i] = ~self->bits[i];
       }
+      bstr_byteset_compile(self);
+   }
+}
+
+bool bstr_byteset_contains(const bstr_byteset_t *self, uint8_t c)
+{
+   return (self->bits[c >> 5] & (1u << (c & 31u))) != 0u;
+}
+
+/*************** character classes ***************/
+
+/**
+ * Creates a character class with the same members as the given byte set.
+ */
+void bstr_charclass_create(bstr_charclass_t *self, const bstr_byteset_t *members)
+{
+   if ( (self != 0) && (members != 0) )
+   {
+      self->members = *members;
+      self->others = *members;
+      bstr_byteset_invert(&self->others);
    }
-   return pNext;
 }
 
+/**
+ * Creates a character class containing every byte value for which \par pred_func returns non-zero.
+ * This turns any of the bstr_pred_is_* functions (or a user predicate) into a class usable with bstr_while_class.
+ */
+void bstr_charclass_create_predicate(bstr_charclass_t *self, int (*pred_func)(int c))
+{
+   if ( (self != 0) && (pred_func != 0) )
+   {
+      bstr_byteset_t members;
+      uint32_t c;
+      bstr_byteset_create(&members, 0, 0);
+      for (c = 0u; c < 256u; c++)
+      {
+         if (pred_func((int) c))
+         {
+            members.bits[c >> 5] |= 1u << (c & 31u);
+         }
+      }
+      bstr_byteset_compile(&members);
+      bstr_charclass_create(self, &members);
+   }
+}
+
+bool bstr_charclass_contains(const bstr_charclass_t *self, uint8_t c)
+{
+   return (self != 0)? bstr_byteset_has(&self->members, c) : false;
+}
+
+/*************** needles ***************/
+
+/**
+ * Prepares the string bounded by \par pStrBegin and \par pStrEnd for repeated searching.
+ * The bytes are not copied, they must remain valid for as long as the needle is used.
+ */
+bstr_error_t bstr_needle_create(bstr_needle_t *self, const uint8_t *pStrBegin, const uint8_t *pStrEnd)
+{
+   size_t i;
+   if ( (self == 0) || (pStrBegin == 0) || (pStrEnd == 0) || (pStrBegin > pStrEnd) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   self->pStrBegin = pStrBegin;
+   self->pStrEnd = pStrEnd;
+   self->length = (size_t) (pStrEnd - pStrBegin);
+   self->critPos = 0u;
+   self->period = 1u;
+   self->isPeriodic = false;
+   self->allocator = 0;
+   for (i = 0u; i < 256u; i++)
+   {
+      self->shift[i] = (self->length < UINT32_MAX)? (uint32_t) self->length : UINT32_MAX;
+   }
+   if (self->length > 0u)
+   {
+      for (i = 0u; i < self->length; i++)
+      {
+         size_t shift = self->length - i - 1u;
+         self->shift[pStrBegin[i]] = (shift < UINT32_MAX)? (uint32_t) shift : UINT32_MAX;
+      }
+      self->critPos = bstr_critical_factorization(pStrBegin, self->length, &self->period);
+      self->isPeriodic = (memcmp(pStrBegin, pStrBegin + self->period, self->critPos) == 0);
+      if (!self->isPeriodic)
+      {
+         size_t rightLen = self->length - self->critPos;
+         self->period = ((self->critPos > rightLen)? self->critPos : rightLen) + 1u;
+      }
+   }
+   return BSTR_NO_ERROR;
+}
+
+bstr_needle_t *bstr_needle_new(const uint8_t *pStrBegin, const uint8_t *pStrEnd)
+{
+   return bstr_needle_new_a(pStrBegin, pStrEnd, 0);
+}
+
+bstr_needle_t *bstr_needle_new_a(const uint8_t *pStrBegin, const uint8_t *pStrEnd, const bstr_allocator_t *allocator)
+{
+   bstr_needle_t *self = (bstr_needle_t*) bstr_allocator_alloc(allocator, sizeof(bstr_needle_t));
+   if (self != 0)
+   {
+      if (bstr_needle_create(self, pStrBegin, pStrEnd) != BSTR_NO_ERROR)
+      {
+         bstr_allocator_free(allocator, self, sizeof(bstr_needle_t));
+         self = 0;
+      }
+      else
+      {
+         self->allocator = allocator;
+      }
+   }
+   return self;
+}
+
+void bstr_needle_delete(bstr_needle_t *self)
+{
+   if (self != 0)
+   {
+      bstr_allocator_free(self->allocator, self, sizeof(bstr_needle_t));
+   }
+}
+
+/*************** line index ***************/
+
+/**
+ * Creates a line index which allocates its line array on the heap and grows it as needed.
+ * flags is a combination of BSTR_LINE_INDEX_* values.
+ */
+void bstr_line_index_create(bstr_line_index_t *self, uint32_t flags)
+{
+   bstr_line_index_create_a(self, flags, 0);
+}
+
+/**
+ * Same as bstr_line_index_create but the line array is allocated from allocator.
+ */
+void bstr_line_index_create_a(bstr_line_index_t *self, uint32_t flags, const bstr_allocator_t *allocator)
+{
+   bstr_line_index_create_fixed(self, 0, 0u, flags);
+   if (self != 0)
+   {
+      self->isGrowable = true;
+      self->allocator = allocator;
+   }
+}
+
+/**
+ * Creates a line index over a caller-supplied array. bstr_index_lines stops when the array is full,
+ * use bstr_line_index_clear to drain it before continuing.
+ */
+void bstr_line_index_create_fixed(bstr_line_index_t *self, bstr_line_span_t *lines, size_t capacity, uint32_t flags)
+{
+   if (self != 0)
+   {
+      self->lines = lines;
+      self->numLines = 0u;
+      self->capacity = (lines != 0)? capacity : 0u;
+      self->streamOffset = 0u;
+      self->lineBegin = 0u;
+      self->flags = flags;
+      self->isGrowable = false;
+      self->lastWasCR = false;
+      self->allocator = 0;
+   }
+}
+
+void bstr_line_index_destroy(bstr_line_index_t *self)
+{
+   if (self != 0)
+   {
+      if ( (self->isGrowable) && (self->lines != 0) )
+      {
+         bstr_allocator_free(self->allocator, self->lines, self->capacity * sizeof(bstr_line_span_t));
+      }
+      self->lines = 0;
+      self->numLines = 0u;
+      self->capacity = 0u;
+   }
+}
+
+/**
+ * Removes all lines from the index while keeping its position in the stream.
+ */
+void bstr_line_index_clear(bstr_line_index_t *self)
+{
+   if (self != 0)
+   {
+      self->numLines = 0u;
+   }
+}
+
+/**
+ * Indexes every line terminated by '\n' in the next chunk of the stream using a single vectorized pass.
+ * The chunk must directly follow the bytes given in previous calls. A line that is not terminated within the
+ * chunk is continued by the next call (or completed by bstr_line_index_finish).
+ * Returns pEnd when the whole chunk was indexed. For a fixed size index the return value is where indexing
+ * stopped because the line array became full, call again from there after draining it.
+ * Returns NULL on invalid arguments (errno = EINVAL) or allocation failure (errno = ENOMEM).
+ */
+const uint8_t *bstr_index_lines(bstr_line_index_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const bstr_simd_ops_t *ops;
+   const uint8_t *pNext;
+   size_t positions[LINE_INDEX_BATCH_SIZE];
+   if ( (self == 0) || (pBegin == 0) || (pEnd == 0) || (pBegin > pEnd) )
+   {
+      errno = EINVAL; //invalid arguments
+      return 0;
+   }
+   ops = bstr_simd_ops();
+   pNext = pBegin;
+   while (pNext < pEnd)
+   {
+      const uint8_t *pBatch = pNext;
+      size_t maxPositions;
+      size_t numPositions;
+      size_t i;
+      if (self->numLines == self->capacity)
+      {
+         if (!self->isGrowable)
+         {
+            break;
+         }
+         if (bstr_line_index_grow(self) != BSTR_NO_ERROR)
+         {
+            errno = ENOMEM;
+            return 0;
+         }
+      }
+      maxPositions = self->capacity - self->numLines;
+      if (maxPositions > LINE_INDEX_BATCH_SIZE)
+      {
+         maxPositions = LINE_INDEX_BATCH_SIZE;
+      }
+      numPositions = ops->index_val(pBatch, pEnd, (uint8_t) '\n', positions, maxPositions, &pNext);
+      if (numPositions > 0u)
+      {
+         //work on local copies, stores into the line array could otherwise alias the members of self
+         bstr_line_span_t *line = &self->lines[self->numLines];
+         size_t lineBegin = self->lineBegin;
+         size_t streamOffset = self->streamOffset;
+         bool isCRLF = (self->flags & BSTR_LINE_INDEX_CRLF) != 0u;
+         for (i = 0u; i < numPositions; i++)
+         {
+            size_t newline = streamOffset + positions[i];
+            line[i].begin = lineBegin;
+            line[i].end = newline;
+            if ( isCRLF && (newline > lineBegin) )
+            {
+               bool isCR = (positions[i] > 0u)? (pBatch[positions[i] - 1u] == (uint8_t) '\r') : self->lastWasCR;
+               if (isCR)
+               {
+                  line[i].end--;
+               }
+            }
+            lineBegin = newline + 1u;
+         }
+         self->numLines += numPositions;
+         self->lineBegin = lineBegin;
+      }
+      if (pNext > pBatch)
+      {
+         self->streamOffset += (size_t) (pNext - pBatch);
+         self->lastWasCR = (pNext[-1] == (uint8_t) '\r');
+      }
+   }
+   return pNext;
+}
+
+/**
+ * Adds the final line of the stream if it was not terminated by '\n'.
+ */
+bstr_error_t bstr_line_index_finish(bstr_line_index_t *self)
+{
+   if (self == 0)
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   if (self->lineBegin < self->streamOffset)
+   {
+      if (self->numLines == self->capacity)
+      {
+         if (!self->isGrowable)
+         {
+            return BSTR_MEM_ERROR;
+         }
+         if (bstr_line_index_grow(self) != BSTR_NO_ERROR)
+         {
+            return BSTR_MEM_ERROR;
+         }
+      }
+      self->lines[self->numLines].begin = self->lineBegin;
+      self->lines[self->numLines].end = self->streamOffset;
+      self->numLines++;
+      self->lineBegin = self->streamOffset;
+   }
+   return BSTR_NO_ERROR;
+}
+
+/*************** split iterator ***************/
+
+/**
+ * Splits [pBegin, pEnd) on every occurrence of sep. BSTR_SPLIT_STRIP in flags strips whitespace from each field.
+ */
+void bstr_split_iter_create(bstr_split_iter_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint8_t sep, uint32_t flags)
+{
+   if (self != 0)
+   {
+      bstr_split_iter_init(self, pBegin, pEnd, flags);
+      self->sepVal = sep;
+   }
+}
+
+/**
+ * Splits on every byte that is a member of set. The set is not copied and must outlive the iterator.
+ */
+void bstr_split_iter_create_set(bstr_split_iter_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, uint32_t flags)
+{
+   if (self != 0)
+   {
+      bstr_split_iter_init(self, pBegin, pEnd, flags);
+      self->set = set;
+   }
+}
+
+/**
+ * Splits on every non-overlapping occurrence of the separator, found from left to right. The separator is not copied
+ * and must outlive the iterator. Candidates are located by their first byte and verified.
+ */
+bstr_error_t bstr_split_iter_create_bstr(bstr_split_iter_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pSepBegin, const uint8_t *pSepEnd, uint32_t flags)
+{
+   if ( (self == 0) || (pSepBegin == 0) || (pSepEnd == 0) || (pSepEnd <= pSepBegin) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   bstr_split_iter_init(self, pBegin, pEnd, flags);
+   self->pSep = pSepBegin;
+   self->sepLen = (size_t) (pSepEnd - pSepBegin);
+   self->sepVal = *pSepBegin;
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Returns the next field in [*ppFieldBegin, *ppFieldEnd) or false when all fields have been returned.
+ */
+bool bstr_split_next(bstr_split_iter_t *self, const uint8_t **ppFieldBegin, const uint8_t **ppFieldEnd)
+{
+   const uint8_t *pSep;
+   const uint8_t *pField;
+   if ( (self == 0) || (ppFieldBegin == 0) || (ppFieldEnd == 0) || (self->pField == 0) )
+   {
+      return false;
+   }
+   pField = self->pField;
+   pSep = bstr_split_find(self);
+   self->pField = (pSep < self->pEnd)? pSep + self->sepLen : 0;
+   if ( (self->flags & BSTR_SPLIT_STRIP) != 0u )
+   {
+      bstr_strip(pField, pSep, ppFieldBegin, ppFieldEnd);
+   }
+   else
+   {
+      *ppFieldBegin = pField;
+      *ppFieldEnd = pSep;
+   }
+   return true;
+}
+
+/**
+ * Stores up to maxFields fields in fields. Returns the number of fields stored, 0 when all fields have been returned.
+ */
+size_t bstr_split_next_batch(bstr_split_iter_t *self, bstr_view_t *fields, size_t maxFields)
+{
+   size_t count = 0u;
+   if (fields == 0)
+   {
+      return 0u;
+   }
+   while ( (count < maxFields) && bstr_split_next(self, &fields[count].pBegin, &fields[count].pEnd) )
+   {
+      count++;
+   }
+   return count;
+}
+
+/*************** JSON structural index ***************/
+
+/**
+ * Builds the structural index of the JSON document between pBegin and pEnd.
+ * The document is not copied so it must outlive the index.
+ */
+bstr_error_t bstr_json_index_create(bstr_json_index_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   return bstr_json_index_create_a(self, pBegin, pEnd, 0);
+}
+
+/**
+ * Same as bstr_json_index_create but the index is allocated from allocator.
+ */
+bstr_error_t bstr_json_index_create_a(bstr_json_index_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const bstr_allocator_t *allocator)
+{
+   const bstr_simd_ops_t *ops;
+   bstr_json_scan_state_t state;
+   size_t length;
+   size_t numFullBlocks;
+   if ( (self == 0) || (pBegin == 0) || (pEnd == 0) || (pBegin > pEnd) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   length = (size_t) (pEnd - pBegin);
+   self->pBegin = pBegin;
+   self->pEnd = pEnd;
+   self->numBlocks = (length + 63u) / 64u;
+   self->blocks = 0;
+   self->allocator = allocator;
+   if (self->numBlocks == 0u)
+   {
+      return BSTR_NO_ERROR;
+   }
+   self->blocks = (bstr_json_index_block_t*) bstr_allocator_alloc(allocator, self->numBlocks * sizeof(bstr_json_index_block_t));
+   if (self->blocks == 0)
+   {
+      self->numBlocks = 0u;
+      return BSTR_MEM_ERROR;
+   }
+   ops = bstr_simd_ops();
+   state.prevEscaped = 0u;
+   state.prevInString = 0u;
+   state.prevScalar = 0u;
+   numFullBlocks = length / 64u;
+   ops->json_index(pBegin, numFullBlocks, self->blocks, &state);
+   if (numFullBlocks < self->numBlocks)
+   {
+      //the last partial block is padded with whitespace which has no structural meaning
+      uint8_t tail[64];
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, pBegin + numFullBlocks * 64u, length - numFullBlocks * 64u);
+      ops->json_index(tail, 1u, &self->blocks[numFullBlocks], &state);
+   }
+   return BSTR_NO_ERROR;
+}
+
+void bstr_json_index_destroy(bstr_json_index_t *self)
+{
+   if (self != 0)
+   {
+      if (self->blocks != 0)
+      {
+         bstr_allocator_free(self->allocator, self->blocks, self->numBlocks * sizeof(bstr_json_index_block_t));
+      }
+      self->blocks = 0;
+      self->numBlocks = 0u;
+   }
+}
+
+bstr_json_index_t *bstr_json_index_new(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   return bstr_json_index_new_a(pBegin, pEnd, 0);
+}
+
+bstr_json_index_t *bstr_json_index_new_a(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_allocator_t *allocator)
+{
+   bstr_json_index_t *self = (bstr_json_index_t*) bstr_allocator_alloc(allocator, sizeof(bstr_json_index_t));
+   if (self != 0)
+   {
+      if (bstr_json_index_create_a(self, pBegin, pEnd, allocator) != BSTR_NO_ERROR)
+      {
+         bstr_allocator_free(allocator, self, sizeof(bstr_json_index_t));
+         self = 0;
+      }
+   }
+   return self;
+}
+
+void bstr_json_index_delete(bstr_json_index_t *self)
+{
+   if (self != 0)
+   {
+      const bstr_allocator_t *allocator = self->allocator;
+      bstr_json_index_destroy(self);
+      bstr_allocator_free(allocator, self, sizeof(bstr_json_index_t));
+   }
+}
+
+/**
+ * Indexed variant of bstr_match_pair for JSON documents. pBegin must point at a '{', '[' or '"' inside the
+ * document covered by index. Returns a pointer to the matching '}', ']' or closing '"'.
+ * Brackets inside strings are ignored and blocks that cannot contain the match (fewer closing brackets than
+ * the current depth) are skipped as a whole using population counts.
+ * Returns pBegin when no match is found before pEnd (or the brackets in between are not balanced) and
+ * NULL when pBegin does not start with an opening character outside of a string.
+ */
+const uint8_t *bstr_match_pair_indexed(const bstr_json_index_t *index, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const bstr_json_index_block_t *blocks;
+   size_t offset;
+   size_t endOffset;
+   size_t blockIndex;
+   size_t lastBlock;
+   uint64_t firstBit;
+   uint64_t afterMask;
+   size_t result;
+   if ( (index == 0) || (pBegin == 0) || (pEnd == 0) || (pBegin < index->pBegin) || (pEnd > index->pEnd) || (pBegin > pEnd) )
+   {
+      errno = EINVAL; //invalid arguments
+      return 0;
+   }
+   if (pBegin == pEnd)
+   {
+      return pBegin;
+   }
+   blocks = index->blocks;
+   offset = (size_t) (pBegin - index->pBegin);
+   endOffset = (size_t) (pEnd - index->pBegin);
+   blockIndex = offset / 64u;
+   lastBlock = (endOffset - 1u) / 64u;
+   firstBit = (uint64_t) 1u << (offset % 64u);
+   afterMask = ~((firstBit << 1) - 1u);
+   if (*pBegin == (uint8_t) '"')
+   {
+      uint64_t quotes;
+      if ( (blocks[blockIndex].quotes & firstBit) == 0u )
+      {
+         return 0;
+      }
+      quotes = blocks[blockIndex].quotes & afterMask;
+      while (quotes == 0u)
+      {
+         if (++blockIndex > lastBlock)
+         {
+            return pBegin;
+         }
+         quotes = blocks[blockIndex].quotes;
+      }
+      result = blockIndex * 64u + bstr_ctz64(quotes);
+      return (result < endOffset)? index->pBegin + result : pBegin;
+   }
+   else if ( (*pBegin == (uint8_t) '{') || (*pBegin == (uint8_t) '[') )
+   {
+      uint8_t right = (*pBegin == (uint8_t) '{')? (uint8_t) '}' : (uint8_t) ']';
+      size_t depth = 1u;
+      uint64_t opens;
+      uint64_t closes;
+      if ( (blocks[blockIndex].opens & firstBit) == 0u )
+      {
+         return 0;
+      }
+      opens = blocks[blockIndex].opens & afterMask;
+      closes = blocks[blockIndex].closes & afterMask;
+      for (;;)
+      {
+         uint32_t numCloses = bstr_popcount64(closes);
+         if (numCloses >= depth)
+         {
+            uint64_t mask = opens | closes;
+            while (mask != 0u)
+            {
+               uint64_t lowest = mask & (0u - mask);
+               if ( (closes & lowest) != 0u )
+               {
+                  if (--depth == 0u)
+                  {
+                     result = blockIndex * 64u + bstr_ctz64(lowest);
+                     if ( (result >= endOffset) || (index->pBegin[result] != right) )
+                     {
+                        return pBegin;
+                     }
+                     return index->pBegin + result;
+                  }
+               }
+               else
+               {
+                  depth++;
+               }
+               mask ^= lowest;
+            }
+         }
+         else
+         {
+            depth = depth + bstr_popcount64(opens) - numCloses;
+         }
+         if (++blockIndex > lastBlock)
+         {
+            return pBegin;
+         }
+         opens = blocks[blockIndex].opens;
+         closes = blocks[blockIndex].closes;
+      }
+   }
+   return 0;
+}
+
+/*************** predicate functions ***************/
+int bstr_pred_is_horizontal_space(int c)
+{
+   return (c == (int) '\t') || (c == (int) ' ');
+}
+
+int bstr_pred_is_whitespace(int c)
+{
+   return (c == (int) '\t') || (c == (int) '\n') || (c == (int) '\r') || (c == (int) ' ');
+}
+
+int bstr_pred_is_digit(int c)
+{
+   return (c >= '0') && (c <= '9');
+}
+
+int bstr_pred_is_hex_digit(int c)
+{
+   return ((c >= '0') && (c <= '9') ) || ((c >= 'a') && (c <= 'f')) || ((c >= 'A') && (c <= 'F'));
+}
+
+int bstr_pred_is_one_nine(int c)
+{
+   return (c >= '1') && (c <= '9');
+}
+
+int bstr_pred_is_control_char(int c)
+{
+   return (c < 32);
+}
+
+int bstr_pred_is_not_zero(int c)
+{
+   return c != 0u;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+void bstr_set_error(bstr_context_t *ctx, bstr_error_t errorCode)
+{
+   ctx->lastError = errorCode;
+}
+
+/**
+ * Builds the nibble lookup tables from the membership bits. All bytes sharing the same high nibble
+ * share a bucket, high nibbles with identical rows of low nibbles are merged into the same bucket.
+ * Since there are only 16 possible high nibbles the 16 buckets of two table pairs always suffice.
+ */
+static void bstr_byteset_compile(bstr_byteset_t *self)
+{
+   uint16_t bucketMasks[16];
+   uint32_t numBuckets = 0u;
+   uint32_t high;
+   memset(self->lo, 0, sizeof(self->lo));
+   memset(self->hi, 0, sizeof(self->hi));
+   for (high = 0u; high < 16u; high++)
+   {
+      uint16_t rowMask = (uint16_t) ((self->bits[high >> 1] >> ((high & 1u) * 16u)) & 0xFFFFu);
+      uint32_t bucket;
+      uint32_t low;
+      if (rowMask == 0u)
+      {
+         continue;
+      }
+      for (bucket = 0u; bucket < numBuckets; bucket++)
+      {
+         if (bucketMasks[bucket] == rowMask)
+         {
+            break;
+         }
+      }
+      if (bucket == numBuckets)
+      {
+         bucketMasks[numBuckets++] = rowMask;
+      }
+      self->hi[bucket >> 3][high] = (uint8_t) (1u << (bucket & 7u));
+      for (low = 0u; low < 16u; low++)
+      {
+         if (rowMask & (1u << low))
+         {
+            self->lo[bucket >> 3][low] |= (uint8_t) (1u << (bucket & 7u));
+         }
+      }
+   }
+   self->numTables = (numBuckets > 8u)? 2u : 1u;
+}
+
+/**
+ * Computes the critical factorization of the needle (Crochemore-Perrin) from the maximal suffixes under
+ * both the normal and the reversed byte ordering. Returns the critical position and stores the period of
+ * the corresponding maximal suffix in *period.
+ */
+static size_t bstr_critical_factorization(const uint8_t *pNeedle, size_t needleLen, size_t *period)
+{
+   size_t maxSuffix = SIZE_MAX; //wraps around to -1
+   size_t maxSuffixRev = SIZE_MAX;
+   size_t j = 0u;
+   size_t k = 1u;
+   size_t p = 1u;
+   while (j + k < needleLen)
+   {
+      uint8_t a = pNeedle[j + k];
+      uint8_t b = pNeedle[maxSuffix + k];
+      if (a < b)
+      {
+         j += k;
+         k = 1u;
+         p = j - maxSuffix;
+      }
+      else if (a == b)
+      {
+         if (k != p)
+         {
+            k++;
+         }
+         else
+         {
+            j += p;
+            k = 1u;
+         }
+      }
+      else
+      {
+         maxSuffix = j++;
+         k = p = 1u;
+      }
+   }
+   *period = p;
+   j = 0u;
+   k = p = 1u;
+   while (j + k < needleLen)
+   {
+      uint8_t a = pNeedle[j + k];
+      uint8_t b = pNeedle[maxSuffixRev + k];
+      if (b < a)
+      {
+         j += k;
+         k = 1u;
+         p = j - maxSuffixRev;
+      }
+      else if (a == b)
+      {
+         if (k != p)
+         {
+            k++;
+         }
+         else
+         {
+            j += p;
+            k = 1u;
+         }
+      }
+      else
+      {
+         maxSuffixRev = j++;
+         k = p = 1u;
+      }
+   }
+   if (maxSuffixRev + 1u < maxSuffix + 1u)
+   {
+      return maxSuffix + 1u;
+   }
+   *period = p;
+   return maxSuffixRev + 1u;
+}
+
+/**
+ * Two-Way string matching combined with a bad character shift on the last byte of each window.
+ * Returns pointer to the match or pEnd when not found.
+ */
+static const uint8_t *bstr_two_way(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_needle_t *needle)
+{
+   const uint8_t *pNeedle = needle->pStrBegin;
+   const size_t needleLen = needle->length;
+   const size_t critPos = needle->critPos;
+   const size_t period = needle->period;
+   size_t hayLen = (size_t) (pEnd - pBegin);
+   size_t j = 0u;
+   if (hayLen < needleLen)
+   {
+      return pEnd;
+   }
+   if (needle->isPeriodic)
+   {
+      size_t memory = 0u;
+      while (j <= hayLen - needleLen)
+      {
+         size_t i;
+         size_t shift = needle->shift[pBegin[j + needleLen - 1u]];
+         if (shift > 0u)
+         {
+            if ( (memory != 0u) && (shift < period) )
+            {
+               shift = needleLen - period;
+            }
+            memory = 0u;
+            j += shift;
+            continue;
+         }
+         i = (critPos > memory)? critPos : memory;
+         while ( (i < needleLen - 1u) && (pNeedle[i] == pBegin[i + j]) )
+         {
+            i++;
+         }
+         if (needleLen - 1u <= i)
+         {
+            i = critPos - 1u;
+            while ( (memory < i + 1u) && (pNeedle[i] == pBegin[i + j]) )
+            {
+               i--;
+            }
+            if (i + 1u < memory + 1u)
+            {
+               return pBegin + j;
+            }
+            j += period;
+            memory = needleLen - period;
+         }
+         else
+         {
+            j += i - critPos + 1u;
+            memory = 0u;
+         }
+      }
+   }
+   else
+   {
+      while (j <= hayLen - needleLen)
+      {
+         size_t i;
+         size_t shift = needle->shift[pBegin[j + needleLen - 1u]];
+         if (shift > 0u)
+         {
+            j += shift;
+            continue;
+         }
+         i = critPos;
+         while ( (i < needleLen - 1u) && (pNeedle[i] == pBegin[i + j]) )
+         {
+            i++;
+         }
+         if (needleLen - 1u <= i)
+         {
+            i = critPos - 1u;
+            while ( (i != SIZE_MAX) && (pNeedle[i] == pBegin[i + j]) )
+            {
+               i--;
+            }
+            if (i == SIZE_MAX)
+            {
+               return pBegin + j;
+            }
+            j += period;
+         }
+         else
+         {
+            j += i - critPos + 1u;
+         }
+      }
+   }
+   return pEnd;
+}
+
+/**
+ * Common implementation of the bstr_find_* functions. The needle argument is optional, when it's NULL
+ * and Two-Way is needed a temporary needle is prepared on the stack.
+ */
+static const uint8_t *bstr_find_internal(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pStrBegin, size_t needleLen, const bstr_needle_t *needle)
+{
+   const uint8_t *pResult = pEnd;
+   const uint8_t *pStart = pBegin;
+   bstr_needle_t tmp;
+   if (needleLen == 0u)
+   {
+      return pBegin;
+   }
+   if (needleLen > (size_t) (pEnd - pBegin))
+   {
+      return pBegin;
+   }
+   if (needleLen == 1u)
+   {
+      pResult = bstr_simd_ops()->search_val(pBegin, pEnd, pStrBegin[0]);
+      return (pResult < pEnd)? pResult : pBegin;
+   }
+   if (needleLen <= SHORT_NEEDLE_MAX)
+   {
+      const uint8_t *pStop = 0;
+      pResult = bstr_simd_ops()->find_short(pBegin, pEnd, pStrBegin, needleLen, &pStop);
+      if ( (pResult < pEnd) || (pStop == 0) )
+      {
+         return (pResult < pEnd)? pResult : pBegin;
+      }
+      pStart = pStop; //the filter found too many false candidates, continue with Two-Way from here
+   }
+   if (needle == 0)
+   {
+      (void) bstr_needle_create(&tmp, pStrBegin, pStrBegin + needleLen);
+      needle = &tmp;
+   }
+   pResult = bstr_two_way(pStart, pEnd, needle);
+   return (pResult < pEnd)? pResult : pBegin;
+}
+
+static bstr_error_t bstr_line_index_grow(bstr_line_index_t *self)
+{
+   size_t capacity = (self->capacity == 0u)? LINE_INDEX_INITIAL_CAPACITY : self->capacity * 2u;
+   bstr_line_span_t *lines;
+   if (capacity > SIZE_MAX / sizeof(bstr_line_span_t))
+   {
+      return BSTR_MEM_ERROR;
+   }
+   lines = (bstr_line_span_t*) bstr_allocator_realloc(self->allocator, self->lines, self->capacity * sizeof(bstr_line_span_t), capacity * sizeof(bstr_line_span_t));
+   if (lines == 0)
+   {
+      return BSTR_MEM_ERROR;
+   }
+   self->lines = lines;
+   self->capacity = capacity;
+   return BSTR_NO_ERROR;
+}
+
+static void bstr_split_iter_init(bstr_split_iter_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t flags)
+{
+   if ( (pBegin == 0) || (pEnd == 0) || (pEnd < pBegin) )
+   {
+      pBegin = 0; //no fields
+      pEnd = 0;
+   }
+   self->pField = pBegin;
+   self->pEnd = pEnd;
+   self->pScan = pBegin;
+   self->pBatch = pBegin;
+   self->pSep = 0;
+   self->sepLen = 1u;
+   self->set = 0;
+   self->numPositions = 0u;
+   self->nextPosition = 0u;
+   self->flags = flags;
+   self->sepVal = 0u;
+}
+
+/**
+ * Returns the first separator at or after self->pField, or pEnd. A new batch of candidates is located when the
+ * current one runs out. Candidates overlapping the previous multi-byte separator are skipped.
+ */
+static const uint8_t *bstr_split_find(bstr_split_iter_t *self)
+{
+   for (;;)
+   {
+      while (self->nextPosition < self->numPositions)
+      {
+         const uint8_t *pCandidate = self->pBatch + self->positions[self->nextPosition++];
+         if (self->pSep == 0)
+         {
+            return pCandidate;
+         }
+         if ( (pCandidate >= self->pField) && (self->sepLen <= (size_t) (self->pEnd - pCandidate)) &&
+              (memcmp(pCandidate, self->pSep, self->sepLen) == 0) )
+         {
+            return pCandidate;
+         }
+      }
+      if (self->pScan == self->pEnd)
+      {
+         return self->pEnd;
+      }
+      self->pBatch = self->pScan;
+      self->nextPosition = 0u;
+      if (self->set != 0)
+      {
+         self->numPositions = bstr_simd_ops()->index_any(self->pBatch, self->pEnd, self->set, self->positions, BSTR_SPLIT_BATCH_SIZE, &self->pScan);
+      }
+      else
+      {
+         self->numPositions = bstr_simd_ops()->index_val(self->pBatch, self->pEnd, self->sepVal, self->positions, BSTR_SPLIT_BATCH_SIZE, &self->pScan);
+      }
+   }
+}
+
+/**
+ * Parses an integer with the syntax accepted by strtol: leading whitespace, an optional sign, an optional "0x" prefix
+ * (base 0 and 16) followed by digits. Base 0 selects 16, 8 or 10 from the prefix. The magnitude is returned separately
+ * from the sign so that each public function can apply the range of its own type.
+ * Returns pointer after the last digit, pBegin when there are no digits or NULL when the base is not supported.
+ */
+static const uint8_t *bstr_parse_integer(const uint8_t *pBegin, const uint8_t *pEnd, uint32_t base, uint64_t *magnitude, bool *isNegative, bool *isOverflow)
+{
+   const uint8_t *pNext = pBegin;
+   const uint8_t *pDigits;
+   const uint8_t *pResult;
+   *magnitude = 0u;
+   *isNegative = false;
+   *isOverflow = false;
+   if ( (base == 1u) || (base > 36u) )
+   {
+      errno = EINVAL; //invalid arguments
+      return 0;
+   }
+   while ( (pNext < pEnd) && ( (*pNext == (uint8_t) ' ') || ((*pNext >= (uint8_t) '\t') && (*pNext <= (uint8_t) '\r')) ) )
+   {
+      pNext++;
+   }
+   if ( (pNext < pEnd) && ((*pNext == (uint8_t) '-') || (*pNext == (uint8_t) '+')) )
+   {
+      *isNegative = (*pNext == (uint8_t) '-');
+      pNext++;
+   }
+   if ( ((base == 0u) || (base == 16u)) && (pEnd - pNext >= 3) && (pNext[0] == (uint8_t) '0') &&
+        ((pNext[1] | 0x20u) == (uint8_t) 'x') && (bstr_digit_value(pNext[2]) < 16u) )
+   {
+      pNext += 2;
+      base = 16u;
+   }
+   else if (base == 0u)
+   {
+      base = ( (pNext < pEnd) && (*pNext == (uint8_t) '0') )? 8u : 10u;
+   }
+   pDigits = pNext;
+   if (base == 10u)
+   {
+      pResult = bstr_parse_digits_base10(pDigits, pEnd, magnitude, isOverflow);
+   }
+   else if (base == 16u)
+   {
+      pResult = bstr_parse_digits_base16(pDigits, pEnd, magnitude, isOverflow);
+   }
+   else
+   {
+      pResult = bstr_parse_digits(pDigits, pEnd, base, magnitude, isOverflow);
+   }
+   return (pResult > pDigits)? pResult : pBegin;
+}
+
+static const uint8_t *bstr_parse_digits_base10(const uint8_t *pBegin, const uint8_t *pEnd, uint64_t *value, bool *isOverflow)
+{
+   const uint8_t *pNext = pBegin;
+   const uint8_t *pSignificant;
+   uint64_t result = 0u;
+   //leading zeros do not count towards the 20 digits that fit in 64 bits
+   while ( (pNext < pEnd) && (*pNext == (uint8_t) '0') )
+   {
+      pNext++;
+   }
+   pSignificant = pNext;
+#ifdef BSTR_LITTLE_ENDIAN
+   //16 digits never overflow so the chunks need no range check
+   while ( (pEnd - pNext >= 8) && (pNext - pSignificant < 16) )
+   {
+      uint64_t chunk = bstr_load_u64(pNext);
+      if (!bstr_swar_is_eight_digits(chunk))
+      {
+         break;
+      }
+      result = result * 100000000u + bstr_swar_parse_eight_digits(chunk);
+      pNext += 8;
+   }
+#endif
+   while ( (pNext < pEnd) && ((uint8_t) (*pNext - (uint8_t) '0') <= 9u) && (pNext - pSignificant < 19) )
+   {
+      result = result * 10u + (uint32_t) (*pNext - (uint8_t) '0');
+      pNext++;
+   }
+   while ( (pNext < pEnd) && ((uint8_t) (*pNext - (uint8_t) '0') <= 9u) )
+   {
+      uint32_t digit = (uint32_t) (*pNext - (uint8_t) '0');
+      if ( (result > UINT64_MAX / 10u) || ((result == UINT64_MAX / 10u) && (digit > UINT64_MAX % 10u)) )
+      {
+         *isOverflow = true;
+      }
+      else
+      {
+         result = result * 10u + digit;
+      }
+      pNext++;
+   }
+   *value = result;
+   return pNext;
+}
+
+static const uint8_t *bstr_parse_digits_base16(const uint8_t *pBegin, const uint8_t *pEnd, uint64_t *value, bool *isOverflow)
+{
+   const uint8_t *pNext = pBegin;
+   const uint8_t *pSignificant;
+   uint64_t result = 0u;
+   while ( (pNext < pEnd) && (*pNext == (uint8_t) '0') )
+   {
+      pNext++;
+   }
+   pSignificant = pNext;
+#ifdef BSTR_LITTLE_ENDIAN
+   while ( (pEnd - pNext >= 8) && (pNext - pSignificant < 16) )
+   {
+      uint32_t chunkValue;
+      if (!bstr_swar_parse_eight_hex_digits(bstr_load_u64(pNext), &chunkValue))
+      {
+         break;
+      }
+      result = (result << 32) | chunkValue;
+      pNext += 8;
+   }
+#endif
+   while (pNext < pEnd)
+   {
+      uint32_t digit = bstr_digit_value(*pNext);
+      if (digit >= 16u)
+      {
+         break;
+      }
+      if (result > (UINT64_MAX >> 4))
+      {
+         *isOverflow = true;
+      }
+      else
+      {
+         result = (result << 4) | digit;
+      }
+      pNext++;
+   }
+   *value = result;
+   return pNext;
+}
+
+static const uint8_t *bstr_parse_digits(const uint8_t *pBegin, const uint8_t *pEnd, uint32_t base, uint64_t *value, bool *isOverflow)
+{
+   const uint8_t *pNext = pBegin;
+   const uint64_t maxPrefix = UINT64_MAX / base;
+   const uint32_t maxLast = (uint32_t) (UINT64_MAX % base);
+   uint64_t result = 0u;
+   while (pNext < pEnd)
+   {
+      uint32_t digit = bstr_digit_value(*pNext);
+      if (digit >= base)
+      {
+         break;
+      }
+      if ( (result > maxPrefix) || ((result == maxPrefix) && (digit > maxLast)) )
+      {
+         *isOverflow = true;
+      }
+      else
+      {
+         result = result * base + digit;
+      }
+      pNext++;
+   }
+   *value = result;
+   return pNext;
+}
+
+/**
+ * Returns the value of c as a digit in base 36 or 36 and above when it is not a digit.
+ */
+static uint32_t bstr_digit_value(uint8_t c)
+{
+   if ( (c >= (uint8_t) '0') && (c <= (uint8_t) '9') )
+   {
+      return (uint32_t) (c - (uint8_t) '0');
+   }
+   c = (uint8_t) (c | 0x20u);
+   if ( (c >= (uint8_t) 'a') && (c <= (uint8_t) 'z') )
+   {
+      return (uint32_t) (c - (uint8_t) 'a') + 10u;
+   }
+   return 36u;
+}
+
+/**
+ * Applies sign and range of a signed type with the given maximum to a parsed magnitude, saturating like strtol.
+ */
+static long long bstr_integer_to_signed(uint64_t magnitude, bool isNegative, bool isOverflow, long long maxValue)
+{
+   uint64_t limit = (uint64_t) maxValue + (isNegative? 1u : 0u);
+   if ( isOverflow || (magnitude > limit) )
+   {
+      errno = ERANGE;
+      return isNegative? -maxValue - 1 : maxValue;
+   }
+   if (isNegative)
+   {
+      return (magnitude == limit)? -maxValue - 1 : -(long long) magnitude;
+   }
+   return (long long) magnitude;
+}
+
+/**
+ * Same as bstr_integer_to_signed for unsigned types. Like strtoul a negative number is negated in the unsigned type.
+ */
+static unsigned long long bstr_integer_to_unsigned(uint64_t magnitude, bool isNegative, bool isOverflow, unsigned long long maxValue)
+{
+   if ( isOverflow || (magnitude > maxValue) )
+   {
+      errno = ERANGE;
+      return maxValue;
+   }
+   return isNegative? ((0u - magnitude) & maxValue) : magnitude;
+}
+
+/**
+ * Parses [+-](inf|infinity|nan) ignoring case. Returns pBegin when neither is found.
+ * *data is always written, 0.0 when nothing was parsed.
+ */
+static const uint8_t *bstr_parse_special_double(const uint8_t *pBegin, const uint8_t *pEnd, double *data)
+{
+   const uint8_t *pNext = pBegin;
+   bool isNegative = false;
+   *data = 0.0;
+   if ( (pNext < pEnd) && ((*pNext == (uint8_t) '-') || (*pNext == (uint8_t) '+')) )
+   {
+      isNegative = (*pNext == (uint8_t) '-');
+      pNext++;
+   }
+   if (bstr_match_cstr_nocase(pNext, pEnd, "inf"))
+   {
+      *data = isNegative? -HUGE_VAL : HUGE_VAL;
+      return bstr_match_cstr_nocase(pNext, pEnd, "infinity")? pNext + 8 : pNext + 3;
+   }
+   if (bstr_match_cstr_nocase(pNext, pEnd, "nan"))
+   {
+      *data = isNegative? -NAN : NAN;
+      return pNext + 3;
+   }
+   return pBegin;
+}
+
+/**
+ * Returns true when the bounded string starts with cstr. cstr must be lower case.
+ */
+static bool bstr_match_cstr_nocase(const uint8_t *pBegin, const uint8_t *pEnd, const char *cstr)
+{
+   const uint8_t *pNext = pBegin;
+   while (*cstr != '\0')
+   {
+      if ( (pNext == pEnd) || ((*pNext | 0x20u) != (uint8_t) *cstr) )
+      {
+         return false;
+      }
+      pNext++;
+      cstr++;
+   }
+   return true;
+}
+
+/**
+ * Stores the magnitude of the integer digits, saturated at UINT64_MAX. Returns false when it doesn't fit.
+ * JSON integers have no leading zeros so up to 19 digits always fit and the accumulated value only needs checking at 20 digits.
+ */
+static bool bstr_json_integer_part(const bstr_decimal_t *decimal, uint64_t *value)
+{
+   const size_t numDigits = (size_t) (decimal->pIntEnd - decimal->pIntBegin);
+   uint64_t result = 0u;
+   const uint8_t *pNext;
+   *value = UINT64_MAX;
+   if (numDigits < 20u)
+   {
+      *value = decimal->intMantissa;
+      return true;
+   }
+   if (numDigits > 20u)
+   {
+      return false;
+   }
+   for (pNext = decimal->pIntBegin; pNext < decimal->pIntEnd; pNext++)
+   {
+      uint32_t digit = (uint32_t) (*pNext - (uint8_t) '0');
+      if ( (result > UINT64_MAX / 10u) || ((result == UINT64_MAX / 10u) && (digit > UINT64_MAX % 10u)) )
+      {
+         return false;
+      }
+      result = result * 10u + digit;
+   }
+   *value = result;
+   return true;
+}
+
+/**
+ * Common part of bstr_parse_json_string_view and bstr_parse_json_string_view_buf, exactly one of str and buf is set.
+ */
+static const uint8_t *bstr_json_string_view(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppStrBegin, const uint8_t **ppStrEnd, adt_str_t *str, bstr_buf_t *buf, bool *isView)
+{
+   const uint8_t *pSpecial;
+   const uint8_t *pResult;
+   size_t offset;
+   *isView = false;
+   if ( (pBegin == pEnd) || (*pBegin != (uint8_t) '"') )
+   {
+      return pBegin;
+   }
+   pSpecial = bstr_simd_ops()->json_string(pBegin + 1, pEnd);
+   if ( (pSpecial < pEnd) && (*pSpecial == (uint8_t) '"') )
+   {
+      *ppStrBegin = pBegin + 1;
+      *ppStrEnd = pSpecial;
+      *isView = true;
+      return pSpecial + 1;
+   }
+   offset = (buf != 0)? buf->length : (size_t) adt_str_length(str);
+   pResult = bstr_json_string_decode(ctx, pBegin, pEnd, pSpecial, str, buf);
+   if ( (pResult != 0) && (pResult != pBegin) )
+   {
+      const uint8_t *pData;
+      size_t length;
+      if (buf != 0)
+      {
+         pData = bstr_buf_data(buf);
+         length = buf->length;
+      }
+      else
+      {
+         pData = (const uint8_t*) adt_str_cstr(str);
+         length = (size_t) adt_str_length(str);
+         if (pData == 0)
+         {
+            bstr_set_error(ctx, BSTR_MEM_ERROR);
+            return (const uint8_t*) 0;
+         }
+      }
+      *ppStrBegin = pData + offset;
+      *ppStrEnd = pData + length;
+   }
+   return pResult;
+}
+
+/**
+ * Appends the unescaped content of the string literal at pBegin to str or buf (the other one is NULL). pSpecial is the first '"', '\\' or control
+ * character after the opening quotation mark (or pEnd).
+ */
+static const uint8_t *bstr_json_string_decode(bstr_context_t *ctx, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pSpecial, adt_str_t *str, bstr_buf_t *buf)
+{
+   const bstr_simd_ops_t *ops = bstr_simd_ops();
+   const uint8_t *pRun = pBegin + 1;
+   bool isReserved = false;
+   for (;;)
+   {
+      uint8_t decoded[4];
+      size_t decodedLen;
+      uint8_t c;
+      if (pSpecial == pEnd)
+      {
+         return pBegin; //missing closing quotation mark
+      }
+      c = *pSpecial;
+      if ( (c != (uint8_t) '"') && (c != (uint8_t) '\\') )
+      {
+         //control character or invalid UTF-8
+         bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
+         return (const uint8_t*) 0;
+      }
+      if ( (c == (uint8_t) '\\') && !isReserved )
+      {
+         //the unescaped string is never longer than the literal, reserve once for the rest of it
+         const uint8_t *pQuote = bstr_json_string_end(pBegin + 1, pSpecial, pEnd);
+         if (!bstr_json_string_reserve(str, buf, (size_t) (pQuote - pRun)))
+         {
+            bstr_set_error(ctx, BSTR_MEM_ERROR);
+            return (const uint8_t*) 0;
+         }
+         isReserved = true;
+      }
+      if ( (pSpecial > pRun) && !bstr_json_string_append(str, buf, pRun, pSpecial) )
+      {
+         bstr_set_error(ctx, BSTR_MEM_ERROR);
+         return (const uint8_t*) 0;
+      }
+      if (c == (uint8_t) '"')
+      {
+         return pSpecial + 1;
+      }
+      pRun = bstr_json_unescape(ctx, pSpecial, pEnd, decoded, &decodedLen);
+      if (pRun == 0)
+      {
+         return (const uint8_t*) 0;
+      }
+      if (pRun == pSpecial)
+      {
+         return pBegin; //input ends inside the escape sequence
+      }
+      if (!bstr_json_string_append(str, buf, decoded, decoded + decodedLen))
+      {
+         bstr_set_error(ctx, BSTR_MEM_ERROR);
+         return (const uint8_t*) 0;
+      }
+      pSpecial = ops->json_string(pRun, pEnd);
+   }
+}
+
+/**
+ * Reserves room for len more bytes in str or buf. Lengths which adt_str_t can't represent are left to the appends.
+ */
+static bool bstr_json_string_reserve(adt_str_t *str, bstr_buf_t *buf, size_t len)
+{
+   if (buf != 0)
+   {
+      return (len >= (SIZE_MAX - buf->length)) || (bstr_buf_reserve(buf, buf->length + len) == BSTR_NO_ERROR);
+   }
+   if (len < (size_t) (INT32_MAX - adt_str_length(str)))
+   {
+      return adt_str_reserve(str, adt_str_length(str) + (int32_t) len) == ADT_NO_ERROR;
+   }
+   return true;
+}
+
+static bool bstr_json_string_append(adt_str_t *str, bstr_buf_t *buf, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   if (buf != 0)
+   {
+      return bstr_buf_append_bstr(buf, pBegin, pEnd) == BSTR_NO_ERROR;
+   }
+   return adt_str_append_bstr(str, pBegin, pEnd) == ADT_NO_ERROR;
+}
+
+/**
+ * Returns the closing quotation mark of the JSON string whose content starts at pString, searching from pNext.
+ * Returns pEnd when the string is not terminated.
+ */
+static const uint8_t *bstr_json_string_end(const uint8_t *pString, const uint8_t *pNext, const uint8_t *pEnd)
+{
+   const bstr_simd_ops_t *ops = bstr_simd_ops();
+   while (pNext < pEnd)
+   {
+      const uint8_t *pQuote = ops->search_val(pNext, pEnd, (uint8_t) '"');
+      const uint8_t *pBackslash = pQuote;
+      if (pQuote == pEnd)
+      {
+         break;
+      }
+      while ( (pBackslash > pString) && (pBackslash[-1] == (uint8_t) '\\') )
+      {
+         pBackslash--;
+      }
+      if ( ((pQuote - pBackslash) & 1) == 0 )
+      {
+         return pQuote;
+      }
+      pNext = pQuote + 1;
+   }
+   return pEnd;
+}
+
+/**
+ * Decodes the escape sequence at pBackslash into buf, which must have room for 4 bytes. The decoded length is never
+ * larger than the escape sequence itself.
+ * Returns pointer to the first byte after the escape sequence, pBackslash when the input ends inside it
+ * or NULL (with the error set) when the escape sequence is invalid. A truncated \u escape is only incomplete when
+ * the bytes present are hex digits, "\u12" followed by the closing quotation mark is invalid.
+ */
+static const uint8_t *bstr_json_unescape(bstr_context_t *ctx, const uint8_t *pBackslash, const uint8_t *pEnd, uint8_t *buf, size_t *len)
+{
+   const uint8_t *pNext = pBackslash + 1;
+   if (pNext == pEnd)
+   {
+      return pBackslash;
+   }
+   if (*pNext == (uint8_t) 'u')
+   {
+      uint32_t codePoint;
+      if (pEnd - pNext < 5)
+      {
+         if (!bstr_json_is_hex_prefix(pNext + 1, pEnd))
+         {
+            bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
+            return (const uint8_t*) 0;
+         }
+         return pBackslash;
+      }
+      if (!bstr_swar_parse_four_hex_digits(pNext + 1, &codePoint))
+      {
+         bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
+         return (const uint8_t*) 0;
+      }
+      pNext += 5;
+      if ( (codePoint & 0xFC00u) == 0xD800u )
+      {
+         //high surrogate, must be followed by an escaped low surrogate
+         uint32_t lowSurrogate;
+         if ( ( (pNext < pEnd) && (pNext[0] != (uint8_t) '\\') ) || ( (pEnd - pNext >= 2) && (pNext[1] != (uint8_t) 'u') ) )
+         {
+            bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
+            return (const uint8_t*) 0;
+         }
+         if (pEnd - pNext < 6)
+         {
+            if ( (pEnd - pNext > 2) && !bstr_json_is_hex_prefix(pNext + 2, pEnd) )
+            {
+               bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
+               return (const uint8_t*) 0;
+            }
+            return pBackslash;
+         }
+         if ( !bstr_swar_parse_four_hex_digits(pNext + 2, &lowSurrogate) || ((lowSurrogate & 0xFC00u) != 0xDC00u) )
+         {
+            bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
+            return (const uint8_t*) 0;
+         }
+         codePoint = 0x10000u + ((codePoint - 0xD800u) << 10) + (lowSurrogate - 0xDC00u);
+         pNext += 6;
+      }
+      else if ( (codePoint & 0xFC00u) == 0xDC00u )
+      {
+         bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR); //low surrogate without high surrogate
+         return (const uint8_t*) 0;
+      }
+      *len = bstr_utf8_encode(codePoint, buf);
+   }
+   else
+   {
+      uint8_t c = m_jsonEscapeChar[*pNext];
+      if (c == 0u)
+      {
+         bstr_set_error(ctx, BSTR_INVALID_CHARACTER_ERROR);
+         return (const uint8_t*) 0;
+      }
+      buf[0] = c;
+      *len = 1u;
+      pNext++;
+   }
+   return pNext;
+}
+
+/**
+ * Returns true when all bytes in [pBegin, pEnd) are hex digits, the start of a truncated \u escape.
+ */
+static bool bstr_json_is_hex_prefix(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   while (pBegin < pEnd)
+   {
+      if (!bstr_pred_is_hex_digit((int) *pBegin))
+      {
+         return false;
+      }
+      pBegin++;
+   }
+   return true;
+}
+
+/**
+ * Writes codePoint (at most U+10FFFF) as UTF-8 to buf which must have room for 4 bytes. Returns number of bytes written.
+ */
+static size_t bstr_utf8_encode(uint32_t codePoint, uint8_t *buf)
+{
+   if (codePoint < 0x80u)
+   {
+      buf[0] = (uint8_t) codePoint;
+      return 1u;
+   }
+   else if (codePoint < 0x800u)
+   {
+      buf[0] = (uint8_t) (0xC0u | (codePoint >> 6));
+      buf[1] = (uint8_t) (0x80u | (codePoint & 0x3Fu));
+      return 2u;
+   }
+   else if (codePoint < 0x10000u)
+   {
+      buf[0] = (uint8_t) (0xE0u | (codePoint >> 12));
+      buf[1] = (uint8_t) (0x80u | ((codePoint >> 6) & 0x3Fu));
+      buf[2] = (uint8_t) (0x80u | (codePoint & 0x3Fu));
+      return 3u;
+   }
+   buf[0] = (uint8_t) (0xF0u | (codePoint >> 18));
+   buf[1] = (uint8_t) (0x80u | ((codePoint >> 12) & 0x3Fu));
+   buf[2] = (uint8_t) (0x80u | ((codePoint >> 6) & 0x3Fu));
+   buf[3] = (uint8_t) (0x80u | (codePoint & 0x3Fu));
+   return 4u;
+}
+
+static void *bstr_default_alloc(void *arg, size_t size)
+{
+   (void) arg;
+   return malloc(size);
+}
+
+static void *bstr_default_realloc(void *arg, void *ptr, size_t oldSize, size_t newSize)
+{
+   (void) arg;
+   (void) oldSize;
+   return realloc(ptr, newSize);
+}
+
+static void bstr_default_free(void *arg, void *ptr, size_t size)
+{
+   (void) arg;
+   (void) size;
+   free(ptr);
+}
+
+/**
+ * A string which is still inline owns no memory yet, so it can switch to the context allocator.
+ */
+static void bstr_buf_adopt_allocator(bstr_buf_t *self, const bstr_context_t *ctx)
+{
+   if ( (self->allocator == 0) && (self->capacity <= BUF_INLINE_CAPACITY) )
+   {
+      self->allocator = ctx->allocator;
+   }
+}
+
+/**
+ * Grows the storage geometrically to fit len more bytes.
+ */
+static bstr_error_t bstr_buf_expand(bstr_buf_t *self, size_t len)
+{
+   size_t required;
+   size_t capacity;
+   if (len >= (SIZE_MAX - self->length))
+   {
+      return BSTR_MEM_ERROR;
+   }
+   required = self->length + len;
+   capacity = (self->capacity < (SIZE_MAX / 2u))? (self->capacity * 2u + 1u) : required;
+   return bstr_buf_realloc(self, (capacity > required)? capacity : required);
+}
+
+/**
+ * Moves the string to a heap block of capacity+1 bytes. capacity must be larger than the current capacity.
+ */
+static bstr_error_t bstr_buf_realloc(bstr_buf_t *self, size_t capacity)
+{
+   uint8_t *pData;
+   if (capacity == SIZE_MAX)
+   {
+      return BSTR_MEM_ERROR;
+   }
+   if (self->capacity > BUF_INLINE_CAPACITY)
+   {
+      pData = (uint8_t*) bstr_allocator_realloc(self->allocator, self->data.pHeap, self->capacity + 1u, capacity + 1u);
+      if (pData == 0)
+      {
+         return BSTR_MEM_ERROR;
+      }
+   }
+   else
+   {
+      pData = (uint8_t*) bstr_allocator_alloc(self->allocator, capacity + 1u);
+      if (pData == 0)
+      {
+         return BSTR_MEM_ERROR;
+      }
+      memcpy(pData, self->data.inlineData, self->length + 1u);
+   }
+   self->data.pHeap = pData;
+   self->capacity = capacity;
+   return BSTR_NO_ERROR;
+}
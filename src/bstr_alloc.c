@@ -0,0 +1,445 @@
+/*****************************************************************************
+* \file      bstr_alloc.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Arena and pool allocators implementing bstr_allocator_t
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#include "bstr_alloc.h"
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Header of each chunk (arena) or slab (pool). The usable memory starts CHUNK_HEADER_SIZE bytes into the chunk.
+ */
+typedef struct bstr_alloc_chunk_tag
+{
+   struct bstr_alloc_chunk_tag *next;
+   size_t size;   //total size including the header
+} bstr_alloc_chunk_t;
+
+#define ALIGN_UP(x)          (((x) + (BSTR_ARENA_ALIGNMENT - 1u)) & ~((size_t) BSTR_ARENA_ALIGNMENT - 1u))
+#define CHUNK_HEADER_SIZE    ALIGN_UP(sizeof(bstr_alloc_chunk_t))
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static bstr_alloc_chunk_t *bstr_chunk_new(const bstr_allocator_t *backing, size_t dataSize);
+static void bstr_chunk_list_delete(const bstr_allocator_t *backing, bstr_alloc_chunk_t *chunk);
+static bool bstr_arena_grow(bstr_arena_t *self, size_t size);
+static void *bstr_arena_alloc_func(void *arg, size_t size);
+static void *bstr_arena_realloc_func(void *arg, void *ptr, size_t oldSize, size_t newSize);
+static void bstr_arena_free_func(void *arg, void *ptr, size_t size);
+static uint32_t bstr_pool_class(size_t size);
+static void *bstr_pool_alloc_func(void *arg, size_t size);
+static void *bstr_pool_realloc_func(void *arg, void *ptr, size_t oldSize, size_t newSize);
+static void bstr_pool_free_func(void *arg, void *ptr, size_t size);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/*************** arena ***************/
+
+/**
+ * Creates an arena which allocates chunks of chunkSize bytes (0 selects BSTR_ARENA_DEFAULT_CHUNK) from backing.
+ * Larger requests get a chunk of their own. backing can be NULL to use the default allocator.
+ */
+void bstr_arena_create(bstr_arena_t *self, size_t chunkSize, const bstr_allocator_t *backing)
+{
+   if (self != 0)
+   {
+      self->allocator.allocFunc = bstr_arena_alloc_func;
+      self->allocator.reallocFunc = bstr_arena_realloc_func;
+      self->allocator.freeFunc = bstr_arena_free_func;
+      self->allocator.arg = (void*) self;
+      self->backing = backing;
+      self->chunks = 0;
+      self->pBase = 0;
+      self->pNext = 0;
+      self->pLimit = 0;
+      self->pLast = 0;
+      self->chunkSize = (chunkSize == 0u)? BSTR_ARENA_DEFAULT_CHUNK : ALIGN_UP(chunkSize);
+   }
+}
+
+/**
+ * Creates an arena over a caller-supplied buffer. The arena never allocates, requests fail when the buffer is full.
+ */
+void bstr_arena_create_fixed(bstr_arena_t *self, void *buffer, size_t size)
+{
+   bstr_arena_create(self, 0u, 0);
+   if ( (self != 0) && (buffer != 0) )
+   {
+      uint8_t *pBuffer = (uint8_t*) buffer;
+      size_t skip = ALIGN_UP((size_t) (uintptr_t) pBuffer) - (size_t) (uintptr_t) pBuffer;
+      self->chunkSize = 0u;
+      if (skip < size)
+      {
+         self->pBase = pBuffer + skip;
+         self->pNext = self->pBase;
+         self->pLimit = pBuffer + size;
+      }
+   }
+}
+
+void bstr_arena_destroy(bstr_arena_t *self)
+{
+   if (self != 0)
+   {
+      bstr_chunk_list_delete(self->backing, self->chunks);
+      self->chunks = 0;
+      self->pBase = 0;
+      self->pNext = 0;
+      self->pLimit = 0;
+      self->pLast = 0;
+   }
+}
+
+/**
+ * Releases all allocations at once. The current chunk is kept for reuse, all other chunks are freed.
+ */
+void bstr_arena_reset(bstr_arena_t *self)
+{
+   if (self != 0)
+   {
+      if (self->chunks != 0)
+      {
+         bstr_chunk_list_delete(self->backing, self->chunks->next);
+         self->chunks->next = 0;
+      }
+      self->pNext = self->pBase;
+      self->pLast = 0;
+   }
+}
+
+/**
+ * Returns BSTR_ARENA_ALIGNMENT aligned memory or NULL when the arena is out of memory.
+ */
+void *bstr_arena_alloc(bstr_arena_t *self, size_t size)
+{
+   uint8_t *p;
+   if (self == 0)
+   {
+      return 0;
+   }
+   if (size > SIZE_MAX - BSTR_ARENA_ALIGNMENT)
+   {
+      return 0;
+   }
+   size = (size == 0u)? BSTR_ARENA_ALIGNMENT : ALIGN_UP(size);
+   if ( ((size_t) (self->pLimit - self->pNext) < size) && !bstr_arena_grow(self, size) )
+   {
+      return 0;
+   }
+   p = self->pNext;
+   self->pNext += size;
+   self->pLast = p;
+   return (void*) p;
+}
+
+/**
+ * Returns the allocator interface of the arena, to be passed to the _a functions or bstr_context_set_allocator.
+ */
+const bstr_allocator_t *bstr_arena_allocator(bstr_arena_t *self)
+{
+   return (self != 0)? &self->allocator : 0;
+}
+
+/*************** pool ***************/
+
+/**
+ * Creates a pool which carves its blocks from slabs of slabSize bytes (0 selects BSTR_POOL_DEFAULT_SLAB)
+ * allocated from backing. backing can be NULL to use the default allocator.
+ */
+void bstr_pool_create(bstr_pool_t *self, size_t slabSize, const bstr_allocator_t *backing)
+{
+   if (self != 0)
+   {
+      uint32_t i;
+      self->allocator.allocFunc = bstr_pool_alloc_func;
+      self->allocator.reallocFunc = bstr_pool_realloc_func;
+      self->allocator.freeFunc = bstr_pool_free_func;
+      self->allocator.arg = (void*) self;
+      self->backing = backing;
+      self->slabs = 0;
+      for (i = 0u; i < BSTR_POOL_NUM_CLASSES; i++)
+      {
+         self->freeLists[i] = 0;
+      }
+      self->pNext = 0;
+      self->pLimit = 0;
+      self->slabSize = (slabSize < BSTR_POOL_MAX_CLASS)? BSTR_POOL_DEFAULT_SLAB : ALIGN_UP(slabSize);
+   }
+}
+
+void bstr_pool_destroy(bstr_pool_t *self)
+{
+   if (self != 0)
+   {
+      bstr_pool_reset(self);
+      bstr_chunk_list_delete(self->backing, self->slabs);
+      self->slabs = 0;
+      self->pNext = 0;
+      self->pLimit = 0;
+   }
+}
+
+/**
+ * Releases all blocks of the size classes at once, the current slab is kept for reuse.
+ * Blocks larger than BSTR_POOL_MAX_CLASS belong to the backing allocator and are not affected.
+ */
+void bstr_pool_reset(bstr_pool_t *self)
+{
+   if (self != 0)
+   {
+      uint32_t i;
+      for (i = 0u; i < BSTR_POOL_NUM_CLASSES; i++)
+      {
+         self->freeLists[i] = 0;
+      }
+      if (self->slabs != 0)
+      {
+         bstr_chunk_list_delete(self->backing, self->slabs->next);
+         self->slabs->next = 0;
+         self->pNext = (uint8_t*) self->slabs + CHUNK_HEADER_SIZE;
+      }
+   }
+}
+
+void *bstr_pool_alloc(bstr_pool_t *self, size_t size)
+{
+   uint32_t sizeClass;
+   size_t classSize;
+   void *p;
+   if (self == 0)
+   {
+      return 0;
+   }
+   if (size > BSTR_POOL_MAX_CLASS)
+   {
+      return bstr_allocator_alloc(self->backing, size);
+   }
+   sizeClass = bstr_pool_class(size);
+   p = self->freeLists[sizeClass];
+   if (p != 0)
+   {
+      memcpy(&self->freeLists[sizeClass], p, sizeof(void*)); //next pointer is stored in the free block
+      return p;
+   }
+   classSize = (size_t) BSTR_POOL_MIN_CLASS << sizeClass;
+   if ((size_t) (self->pLimit - self->pNext) < classSize)
+   {
+      bstr_alloc_chunk_t *slab = bstr_chunk_new(self->backing, self->slabSize);
+      if (slab == 0)
+      {
+         return 0;
+      }
+      slab->next = self->slabs;
+      self->slabs = slab;
+      self->pNext = (uint8_t*) slab + CHUNK_HEADER_SIZE;
+      self->pLimit = (uint8_t*) slab + slab->size;
+   }
+   p = (void*) self->pNext;
+   self->pNext += classSize;
+   return p;
+}
+
+/**
+ * Returns a block to the pool. size must be the size the block was allocated with.
+ */
+void bstr_pool_free(bstr_pool_t *self, void *ptr, size_t size)
+{
+   if ( (self != 0) && (ptr != 0) )
+   {
+      if (size > BSTR_POOL_MAX_CLASS)
+      {
+         bstr_allocator_free(self->backing, ptr, size);
+      }
+      else
+      {
+         uint32_t sizeClass = bstr_pool_class(size);
+         memcpy(ptr, &self->freeLists[sizeClass], sizeof(void*));
+         self->freeLists[sizeClass] = ptr;
+      }
+   }
+}
+
+const bstr_allocator_t *bstr_pool_allocator(bstr_pool_t *self)
+{
+   return (self != 0)? &self->allocator : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static bstr_alloc_chunk_t *bstr_chunk_new(const bstr_allocator_t *backing, size_t dataSize)
+{
+   bstr_alloc_chunk_t *chunk;
+   if (dataSize > SIZE_MAX - CHUNK_HEADER_SIZE)
+   {
+      return 0;
+   }
+   chunk = (bstr_alloc_chunk_t*) bstr_allocator_alloc(backing, CHUNK_HEADER_SIZE + dataSize);
+   if (chunk != 0)
+   {
+      chunk->next = 0;
+      chunk->size = CHUNK_HEADER_SIZE + dataSize;
+   }
+   return chunk;
+}
+
+static void bstr_chunk_list_delete(const bstr_allocator_t *backing, bstr_alloc_chunk_t *chunk)
+{
+   while (chunk != 0)
+   {
+      bstr_alloc_chunk_t *next = chunk->next;
+      bstr_allocator_free(backing, chunk, chunk->size);
+      chunk = next;
+   }
+}
+
+/**
+ * Starts a new chunk with room for at least size bytes. The rest of the current chunk is abandoned.
+ */
+static bool bstr_arena_grow(bstr_arena_t *self, size_t size)
+{
+   bstr_alloc_chunk_t *chunk;
+   if (self->chunkSize == 0u)
+   {
+      return false; //fixed buffer
+   }
+   chunk = bstr_chunk_new(self->backing, (size > self->chunkSize)? size : self->chunkSize);
+   if (chunk == 0)
+   {
+      return false;
+   }
+   chunk->next = self->chunks;
+   self->chunks = chunk;
+   self->pBase = (uint8_t*) chunk + CHUNK_HEADER_SIZE;
+   self->pNext = self->pBase;
+   self->pLimit = (uint8_t*) chunk + chunk->size;
+   self->pLast = 0;
+   return true;
+}
+
+static void *bstr_arena_alloc_func(void *arg, size_t size)
+{
+   return bstr_arena_alloc((bstr_arena_t*) arg, size);
+}
+
+/**
+ * The most recent allocation is resized in place when the chunk has room, other blocks are copied.
+ */
+static void *bstr_arena_realloc_func(void *arg, void *ptr, size_t oldSize, size_t newSize)
+{
+   bstr_arena_t *self = (bstr_arena_t*) arg;
+   void *p;
+   if ( ((uint8_t*) ptr == self->pLast) && (newSize <= SIZE_MAX - BSTR_ARENA_ALIGNMENT) &&
+        ((size_t) (self->pLimit - self->pLast) >= ALIGN_UP(newSize)) )
+   {
+      self->pNext = self->pLast + ((newSize == 0u)? BSTR_ARENA_ALIGNMENT : ALIGN_UP(newSize));
+      return ptr;
+   }
+   if (newSize <= oldSize)
+   {
+      return ptr;
+   }
+   p = bstr_arena_alloc(self, newSize);
+   if (p != 0)
+   {
+      memcpy(p, ptr, oldSize);
+   }
+   return p;
+}
+
+/**
+ * Only the most recent allocation is given back, other blocks are released by bstr_arena_reset.
+ */
+static void bstr_arena_free_func(void *arg, void *ptr, size_t size)
+{
+   bstr_arena_t *self = (bstr_arena_t*) arg;
+   (void) size;
+   if ((uint8_t*) ptr == self->pLast)
+   {
+      self->pNext = self->pLast;
+      self->pLast = 0;
+   }
+}
+
+/**
+ * Index of the smallest size class that holds size bytes (size <= BSTR_POOL_MAX_CLASS).
+ */
+static uint32_t bstr_pool_class(size_t size)
+{
+   uint32_t sizeClass = 0u;
+   while (((size_t) BSTR_POOL_MIN_CLASS << sizeClass) < size)
+   {
+      sizeClass++;
+   }
+   return sizeClass;
+}
+
+static void *bstr_pool_alloc_func(void *arg, size_t size)
+{
+   return bstr_pool_alloc((bstr_pool_t*) arg, size);
+}
+
+/**
+ * Blocks stay in place while the new size maps to the same size class.
+ */
+static void *bstr_pool_realloc_func(void *arg, void *ptr, size_t oldSize, size_t newSize)
+{
+   bstr_pool_t *self = (bstr_pool_t*) arg;
+   void *p;
+   if ( (oldSize <= BSTR_POOL_MAX_CLASS) && (newSize <= BSTR_POOL_MAX_CLASS) && (bstr_pool_class(oldSize) == bstr_pool_class(newSize)) )
+   {
+      return ptr;
+   }
+   if ( (oldSize > BSTR_POOL_MAX_CLASS) && (newSize > BSTR_POOL_MAX_CLASS) )
+   {
+      return bstr_allocator_realloc(self->backing, ptr, oldSize, newSize);
+   }
+   p = bstr_pool_alloc(self, newSize);
+   if (p != 0)
+   {
+      memcpy(p, ptr, (oldSize < newSize)? oldSize : newSize);
+      bstr_pool_free(self, ptr, oldSize);
+   }
+   return p;
+}
+
+static void bstr_pool_free_func(void *arg, void *ptr, size_t size)
+{
+   bstr_pool_free((bstr_pool_t*) arg, ptr, size);
+}
@@ -0,0 +1,459 @@
+/*****************************************************************************
+* \file      bstr_csv.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     RFC 4180 CSV/TSV reader producing views into the input
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#include "bstr_csv.h"
+#include "bstr_simd.h"
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Computes the separator and quote masks of numBlocks complete 64-byte blocks starting at pBegin.
+ * *prevInQuote is all ones when pBegin is inside quotes and is updated to the state after the last block.
+ */
+typedef void (*bstr_csv_index_func_t)(const uint8_t *pBegin, size_t numBlocks, uint8_t delimiter, bstr_csv_block_t *blocks, uint64_t *prevInQuote);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static bool bstr_csv_next_batch(bstr_csv_reader_t *self);
+static const uint8_t *bstr_csv_next_separator(bstr_csv_reader_t *self, uint32_t *numQuotes);
+static bstr_error_t bstr_csv_make_field(bstr_csv_field_t *field, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t numQuotes);
+static bstr_csv_index_func_t bstr_csv_index_func(void);
+static inline void bstr_csv_store_block(bstr_csv_block_t *block, uint64_t separators, uint64_t quotes, uint64_t quotePrefix, uint64_t *prevInQuote);
+static void bstr_csv_index_scalar(const uint8_t *pBegin, size_t numBlocks, uint8_t delimiter, bstr_csv_block_t *blocks, uint64_t *prevInQuote);
+#ifdef BSTR_SIMD_X86
+static void bstr_csv_index_sse2(const uint8_t *pBegin, size_t numBlocks, uint8_t delimiter, bstr_csv_block_t *blocks, uint64_t *prevInQuote);
+static void bstr_csv_index_avx2(const uint8_t *pBegin, size_t numBlocks, uint8_t delimiter, bstr_csv_block_t *blocks, uint64_t *prevInQuote);
+static void bstr_csv_index_avx512(const uint8_t *pBegin, size_t numBlocks, uint8_t delimiter, bstr_csv_block_t *blocks, uint64_t *prevInQuote);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Prepares self for reading records from pBegin..pEnd. The delimiter is typically ',' or '\t', it can't be '"', '\r' or '\n'.
+ * With BSTR_CSV_PARTIAL a last record which isn't terminated by '\n' is not returned, see bstr_csv_reader_rest.
+ */
+void bstr_csv_reader_create(bstr_csv_reader_t *self, const uint8_t *pBegin, const uint8_t *pEnd, uint8_t delimiter, uint32_t flags)
+{
+   if (self != 0)
+   {
+      self->lastError = BSTR_NO_ERROR;
+      if ( (pBegin == 0) || (pEnd == 0) || (pEnd < pBegin) || (delimiter == '"') || (delimiter == '\r') || (delimiter == '\n') )
+      {
+         self->lastError = BSTR_INVALID_ARGUMENT_ERROR;
+         pBegin = 0;
+         pEnd = 0;
+      }
+      self->pEnd = pEnd;
+      self->pRecord = pBegin;
+      self->pScan = pBegin;
+      self->pBlock = pBegin;
+      self->numBlocks = 0u;
+      self->nextBlock = 0u;
+      self->separators = 0u;
+      self->quotes = 0u;
+      self->prevInQuote = 0u;
+      self->flags = flags;
+      self->delimiter = delimiter;
+   }
+}
+
+/**
+ * Reads the next record. Up to maxFields fields are stored in fields, *numFields is set to the number of fields in
+ * the record which can be larger than maxFields. *numFields is 0 when there are no more (complete) records.
+ * A '\r' before the terminating '\n' is not part of the last field. Errors are sticky.
+ */
+bstr_error_t bstr_csv_next_record(bstr_csv_reader_t *self, bstr_csv_field_t *fields, size_t maxFields, size_t *numFields)
+{
+   const uint8_t *pField;
+   size_t count = 0u;
+   if ( (self == 0) || (numFields == 0) || ( (fields == 0) && (maxFields > 0u) ) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   *numFields = 0u;
+   if (self->lastError != BSTR_NO_ERROR)
+   {
+      return self->lastError;
+   }
+   pField = self->pRecord;
+   if (pField == self->pEnd)
+   {
+      return BSTR_NO_ERROR;
+   }
+   for (;;)
+   {
+      uint32_t numQuotes = 0u;
+      const uint8_t *pSeparator = bstr_csv_next_separator(self, &numQuotes);
+      const uint8_t *pFieldEnd = pSeparator;
+      bool isLastField = (pSeparator == self->pEnd) || (*pSeparator == '\n');
+      bstr_csv_field_t field;
+      bstr_error_t result;
+      if (pSeparator == self->pEnd)
+      {
+         if ( (self->prevInQuote != 0u) && ( (pField == pSeparator) || (*pField != '"') ) )
+         {
+            //a stray quote inside an unquoted field opened a quoted region which never ends
+            self->lastError = BSTR_PARSE_ERROR;
+            return self->lastError;
+         }
+         if ( (self->flags & BSTR_CSV_PARTIAL) != 0u )
+         {
+            return BSTR_NO_ERROR; //the record continues in the next chunk
+         }
+         if (self->prevInQuote != 0u)
+         {
+            self->lastError = BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+            return self->lastError;
+         }
+      }
+      if ( isLastField && (pFieldEnd > pField) && (pFieldEnd[-1] == '\r') )
+      {
+         pFieldEnd--;
+      }
+      result = bstr_csv_make_field(&field, pField, pFieldEnd, numQuotes);
+      if (result != BSTR_NO_ERROR)
+      {
+         self->lastError = result;
+         return result;
+      }
+      if (count < maxFields)
+      {
+         fields[count] = field;
+      }
+      count++;
+      if (isLastField)
+      {
+         self->pRecord = (pSeparator == self->pEnd) ? pSeparator : pSeparator + 1;
+         break;
+      }
+      pField = pSeparator + 1;
+   }
+   *numFields = count;
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Returns the start of the first record not yet returned. When reading a stream with BSTR_CSV_PARTIAL, the bytes from
+ * here to the end of the chunk must be placed in front of the next chunk. Only this incomplete record is scanned again.
+ */
+const uint8_t *bstr_csv_reader_rest(const bstr_csv_reader_t *self)
+{
+   return (self != 0) ? self->pRecord : 0;
+}
+
+/**
+ * Appends the value of field to buf. Doubled quotes are collapsed, fields without escapes are copied as is.
+ */
+bstr_error_t bstr_csv_field_unescape(const bstr_csv_field_t *field, bstr_buf_t *buf)
+{
+   const uint8_t *pNext;
+   if ( (field == 0) || (buf == 0) || (field->pBegin == 0) || (field->pEnd < field->pBegin) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   if (!field->hasEscapes)
+   {
+      return bstr_buf_append_bstr(buf, field->pBegin, field->pEnd);
+   }
+   pNext = field->pBegin;
+   while (pNext < field->pEnd)
+   {
+      const uint8_t *pQuote = bstr_simd_ops()->search_val(pNext, field->pEnd, (uint8_t) '"');
+      bstr_error_t result;
+      if (pQuote == field->pEnd)
+      {
+         return bstr_buf_append_bstr(buf, pNext, pQuote);
+      }
+      result = bstr_buf_append_bstr(buf, pNext, pQuote + 1); //keeps the first quote of the pair
+      if (result != BSTR_NO_ERROR)
+      {
+         return result;
+      }
+      pNext = (pQuote + 1 < field->pEnd) ? pQuote + 2 : field->pEnd;
+   }
+   return BSTR_NO_ERROR;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Indexes the next batch of blocks and makes the first of them current. Returns false when all input has been indexed.
+ */
+static bool bstr_csv_next_batch(bstr_csv_reader_t *self)
+{
+   size_t remaining = (size_t) (self->pEnd - self->pScan);
+   size_t numBlocks = remaining / 64u;
+   bstr_csv_index_func_t index_func;
+   if (remaining == 0u)
+   {
+      return false;
+   }
+   index_func = bstr_csv_index_func();
+   if (numBlocks > 0u)
+   {
+      if (numBlocks > BSTR_CSV_BATCH_BLOCKS)
+      {
+         numBlocks = BSTR_CSV_BATCH_BLOCKS;
+      }
+      index_func(self->pScan, numBlocks, self->delimiter, self->blocks, &self->prevInQuote);
+   }
+   else
+   {
+      //the padding is neither quotes nor separators once masked off
+      uint8_t tail[64];
+      uint64_t validMask = ((uint64_t) 1u << remaining) - 1u;
+      memset(&tail[0], 0, sizeof(tail));
+      memcpy(&tail[0], self->pScan, remaining);
+      index_func(&tail[0], 1u, self->delimiter, self->blocks, &self->prevInQuote);
+      self->blocks[0].separators &= validMask;
+      self->blocks[0].quotes &= validMask;
+      numBlocks = 1u;
+   }
+   self->pBlock = self->pScan;
+   self->pScan = (remaining < 64u) ? self->pEnd : self->pScan + numBlocks * 64u;
+   self->numBlocks = (uint32_t) numBlocks;
+   self->nextBlock = 1u;
+   self->separators = self->blocks[0].separators;
+   self->quotes = self->blocks[0].quotes;
+   return true;
+}
+
+/**
+ * Returns the next delimiter or '\n' outside of quotes, or pEnd when there are none left. The number of quotes
+ * passed on the way is added to *numQuotes.
+ */
+static const uint8_t *bstr_csv_next_separator(bstr_csv_reader_t *self, uint32_t *numQuotes)
+{
+   for (;;)
+   {
+      if (self->separators != 0u)
+      {
+         uint32_t bit = bstr_ctz64(self->separators);
+         uint64_t consumed = (((uint64_t) 1u << bit) << 1) - 1u; //bits 0..bit, all ones when bit is 63
+         if ( (self->quotes & consumed) != 0u )
+         {
+            //most fields have no quotes, only count them when there are some
+            *numQuotes += bstr_popcount64(self->quotes & consumed);
+            self->quotes &= ~consumed;
+         }
+         self->separators &= self->separators - 1u;
+         return self->pBlock + bit;
+      }
+      if (self->quotes != 0u)
+      {
+         *numQuotes += bstr_popcount64(self->quotes);
+         self->quotes = 0u;
+      }
+      if (self->nextBlock < self->numBlocks)
+      {
+         const bstr_csv_block_t *block = &self->blocks[self->nextBlock++];
+         self->pBlock += 64u;
+         self->separators = block->separators;
+         self->quotes = block->quotes;
+      }
+      else if (!bstr_csv_next_batch(self))
+      {
+         return self->pEnd;
+      }
+   }
+}
+
+/**
+ * A field without quotes is taken as is. Otherwise it must be quoted as a whole and every quote in the content must
+ * be doubled. The content is only searched for doubled quotes when the field has more than the two enclosing quotes.
+ */
+static bstr_error_t bstr_csv_make_field(bstr_csv_field_t *field, const uint8_t *pBegin, const uint8_t *pEnd, uint32_t numQuotes)
+{
+   field->isQuoted = false;
+   field->hasEscapes = false;
+   if (numQuotes == 0u)
+   {
+      field->pBegin = pBegin;
+      field->pEnd = pEnd;
+      return BSTR_NO_ERROR;
+   }
+   if ( ((pEnd - pBegin) < 2) || (*pBegin != '"') || (pEnd[-1] != '"') )
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   field->pBegin = pBegin + 1;
+   field->pEnd = pEnd - 1;
+   field->isQuoted = true;
+   if (numQuotes > 2u)
+   {
+      const uint8_t *pNext = field->pBegin;
+      for (;;)
+      {
+         const uint8_t *pQuote = bstr_simd_ops()->search_val(pNext, field->pEnd, (uint8_t) '"');
+         if (pQuote == field->pEnd)
+         {
+            break;
+         }
+         if ( (pQuote + 1 == field->pEnd) || (pQuote[1] != '"') )
+         {
+            return BSTR_PARSE_ERROR;
+         }
+         pNext = pQuote + 2;
+      }
+      field->hasEscapes = true;
+   }
+   return BSTR_NO_ERROR;
+}
+
+static bstr_csv_index_func_t bstr_csv_index_func(void)
+{
+#ifdef BSTR_SIMD_X86
+   uint32_t features = bstr_simd_ops()->features;
+   if ( (features & BSTR_SIMD_AVX512BW) && (features & BSTR_SIMD_PCLMUL) )
+   {
+      return bstr_csv_index_avx512;
+   }
+   else if ( (features & BSTR_SIMD_AVX2) && (features & BSTR_SIMD_PCLMUL) )
+   {
+      return bstr_csv_index_avx2;
+   }
+   else if (features & BSTR_SIMD_SSE2)
+   {
+      return bstr_csv_index_sse2;
+   }
+#endif
+   return bstr_csv_index_scalar;
+}
+
+static inline void bstr_csv_store_block(bstr_csv_block_t *block, uint64_t separators, uint64_t quotes, uint64_t quotePrefix, uint64_t *prevInQuote)
+{
+   uint64_t inQuote = quotePrefix ^ *prevInQuote;
+   *prevInQuote = (uint64_t) ((int64_t) inQuote >> 63);
+   block->separators = separators & ~inQuote;
+   block->quotes = quotes;
+}
+
+static void bstr_csv_index_scalar(const uint8_t *pBegin, size_t numBlocks, uint8_t delimiter, bstr_csv_block_t *blocks, uint64_t *prevInQuote)
+{
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      const uint8_t *pBlock = pBegin + i * 64u;
+      uint64_t separators = 0u;
+      uint64_t quotes = 0u;
+      uint32_t j;
+      for (j = 0u; j < 64u; j++)
+      {
+         uint8_t c = pBlock[j];
+         if ( (c == delimiter) || (c == (uint8_t) '\n') )
+         {
+            separators |= (uint64_t) 1u << j;
+         }
+         else if (c == (uint8_t) '"')
+         {
+            quotes |= (uint64_t) 1u << j;
+         }
+      }
+      bstr_csv_store_block(&blocks[i], separators, quotes, bstr_prefix_xor_swar(quotes), prevInQuote);
+   }
+}
+
+#ifdef BSTR_SIMD_X86
+BSTR_TARGET("sse2")
+static void bstr_csv_index_sse2(const uint8_t *pBegin, size_t numBlocks, uint8_t delimiter, bstr_csv_block_t *blocks, uint64_t *prevInQuote)
+{
+   const __m128i quote = _mm_set1_epi8('"');
+   const __m128i newline = _mm_set1_epi8('\n');
+   const __m128i delim = _mm_set1_epi8((char) delimiter);
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      const uint8_t *pBlock = pBegin + i * 64u;
+      __m128i a = _mm_loadu_si128((const __m128i*) pBlock);
+      __m128i b = _mm_loadu_si128((const __m128i*) (pBlock + 16));
+      __m128i c = _mm_loadu_si128((const __m128i*) (pBlock + 32));
+      __m128i d = _mm_loadu_si128((const __m128i*) (pBlock + 48));
+      uint64_t quotes = bstr_cmpeq_mask_sse2(a, b, c, d, quote);
+      uint64_t separators = bstr_cmpeq_mask_sse2(a, b, c, d, delim) | bstr_cmpeq_mask_sse2(a, b, c, d, newline);
+      bstr_csv_store_block(&blocks[i], separators, quotes, bstr_prefix_xor_swar(quotes), prevInQuote);
+   }
+}
+
+BSTR_TARGET("avx2,pclmul")
+static void bstr_csv_index_avx2(const uint8_t *pBegin, size_t numBlocks, uint8_t delimiter, bstr_csv_block_t *blocks, uint64_t *prevInQuote)
+{
+   const __m256i quote = _mm256_set1_epi8('"');
+   const __m256i newline = _mm256_set1_epi8('\n');
+   const __m256i delim = _mm256_set1_epi8((char) delimiter);
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      const uint8_t *pBlock = pBegin + i * 64u;
+      __m256i lo = _mm256_loadu_si256((const __m256i*) pBlock);
+      __m256i hi = _mm256_loadu_si256((const __m256i*) (pBlock + 32));
+      __m256i loSeparators = _mm256_or_si256(_mm256_cmpeq_epi8(lo, delim), _mm256_cmpeq_epi8(lo, newline));
+      __m256i hiSeparators = _mm256_or_si256(_mm256_cmpeq_epi8(hi, delim), _mm256_cmpeq_epi8(hi, newline));
+      uint64_t quotes = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, quote))
+                      | ((uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, quote)) << 32);
+      uint64_t separators = (uint64_t) (uint32_t) _mm256_movemask_epi8(loSeparators)
+                          | ((uint64_t) (uint32_t) _mm256_movemask_epi8(hiSeparators) << 32);
+      bstr_csv_store_block(&blocks[i], separators, quotes, bstr_prefix_xor_clmul(quotes), prevInQuote);
+   }
+}
+
+BSTR_TARGET("avx512f,avx512bw,pclmul")
+static void bstr_csv_index_avx512(const uint8_t *pBegin, size_t numBlocks, uint8_t delimiter, bstr_csv_block_t *blocks, uint64_t *prevInQuote)
+{
+   const __m512i quote = _mm512_set1_epi8('"');
+   const __m512i newline = _mm512_set1_epi8('\n');
+   const __m512i delim = _mm512_set1_epi8((char) delimiter);
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      __m512i v = _mm512_loadu_si512((const void*) (pBegin + i * 64u));
+      uint64_t quotes = (uint64_t) _mm512_cmpeq_epi8_mask(v, quote);
+      uint64_t separators = (uint64_t) (_mm512_cmpeq_epi8_mask(v, delim) | _mm512_cmpeq_epi8_mask(v, newline));
+      bstr_csv_store_block(&blocks[i], separators, quotes, bstr_prefix_xor_clmul(quotes), prevInQuote);
+   }
+}
+#endif //BSTR_SIMD_X86
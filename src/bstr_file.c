@@ -0,0 +1,418 @@
+/*****************************************************************************
+* \file      bstr_file.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Memory-mapped files exposed as bounded strings
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE //madvise and MAP_POPULATE are hidden by strict -std=c99
+#endif
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <errno.h>
+#include "bstr_file.h"
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#if !defined(_WIN32) && !defined(O_CLOEXEC)
+#define O_CLOEXEC 0
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void bstr_file_init(bstr_file_t *self, size_t windowSize, uint32_t flags);
+static bstr_error_t bstr_file_open_internal(bstr_file_t *self, const char *path);
+static bstr_error_t bstr_file_map(bstr_file_t *self, uint64_t offset);
+static void bstr_file_unmap(bstr_file_t *self);
+static void bstr_file_apply_flags(bstr_file_t *self);
+static uint64_t bstr_file_granularity(void);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint8_t m_empty[1] = {0u}; //view of empty files and of the end of file
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Maps the whole file read-only. On failure self is left closed, BSTR_IO_ERROR leaves the reason in errno
+ * (GetLastError on Windows) and BSTR_MEM_ERROR means the file doesn't fit in the address space, which is what
+ * bstr_file_open_window is for.
+ */
+bstr_error_t bstr_file_open(bstr_file_t *self, const char *path, uint32_t flags)
+{
+   bstr_error_t result;
+   if ( (self == 0) || (path == 0) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   bstr_file_init(self, 0u, flags);
+   result = bstr_file_open_internal(self, path);
+   if (result == BSTR_NO_ERROR)
+   {
+      if (self->size > (uint64_t) (size_t) -1)
+      {
+         result = BSTR_MEM_ERROR;
+      }
+      else
+      {
+         result = bstr_file_map(self, 0u);
+      }
+   }
+   if (result != BSTR_NO_ERROR)
+   {
+      bstr_file_close(self);
+   }
+   return result;
+}
+
+/**
+ * Maps at most windowSize bytes at a time, starting at the beginning of the file. Move the window forward with
+ * bstr_file_advance (or anywhere with bstr_file_seek) to read files larger than the address space budget.
+ * Records must be shorter than windowSize to be seen in one piece.
+ */
+bstr_error_t bstr_file_open_window(bstr_file_t *self, const char *path, size_t windowSize, uint32_t flags)
+{
+   bstr_error_t result;
+   if ( (self == 0) || (path == 0) || (windowSize == 0u) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   bstr_file_init(self, windowSize, flags);
+   result = bstr_file_open_internal(self, path);
+   if (result == BSTR_NO_ERROR)
+   {
+      result = bstr_file_map(self, 0u);
+   }
+   if (result != BSTR_NO_ERROR)
+   {
+      bstr_file_close(self);
+   }
+   return result;
+}
+
+void bstr_file_close(bstr_file_t *self)
+{
+   if (self != 0)
+   {
+      bstr_file_unmap(self);
+#if defined(_WIN32)
+      if (self->mappingHandle != 0)
+      {
+         CloseHandle((HANDLE) self->mappingHandle);
+         self->mappingHandle = 0;
+      }
+      if (self->fileHandle != 0)
+      {
+         CloseHandle((HANDLE) self->fileHandle);
+         self->fileHandle = 0;
+      }
+#else
+      if (self->fd >= 0)
+      {
+         (void) close(self->fd);
+         self->fd = -1;
+      }
+#endif
+      self->size = 0u;
+      self->offset = 0u;
+   }
+}
+
+/**
+ * Replaces the access hints (BSTR_FILE_SEQUENTIAL, BSTR_FILE_RANDOM, BSTR_FILE_HUGE_PAGES) of the current view and
+ * of later windows. Giving BSTR_FILE_POPULATE reads the current view in.
+ */
+bstr_error_t bstr_file_advise(bstr_file_t *self, uint32_t flags)
+{
+   if ( (self == 0) || ( (flags & BSTR_FILE_SEQUENTIAL) && (flags & BSTR_FILE_RANDOM) ) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   self->flags = flags;
+   bstr_file_apply_flags(self);
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Moves the view to start at offset. The view is empty when offset is at the end of the file.
+ */
+bstr_error_t bstr_file_seek(bstr_file_t *self, uint64_t offset)
+{
+   if ( (self == 0) || (self->pBegin == 0) || (offset > self->size) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   if (self->windowSize == 0u)
+   {
+      //the whole file is mapped, the view is only narrowed
+      self->pBegin = (self->mapping != 0) ? (const uint8_t*) self->mapping + offset : m_empty;
+      self->offset = offset;
+      return BSTR_NO_ERROR;
+   }
+   return bstr_file_map(self, offset);
+}
+
+/**
+ * Moves the view to start at pNext, which is inside the current view or at its end. It's used to slide the window
+ * past the records which were processed, pNext typically being the start of the first incomplete one.
+ */
+bstr_error_t bstr_file_advance(bstr_file_t *self, const uint8_t *pNext)
+{
+   if ( (self == 0) || (self->pBegin == 0) || (pNext < self->pBegin) || (pNext > self->pEnd) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   return bstr_file_seek(self, self->offset + (uint64_t) (pNext - self->pBegin));
+}
+
+/**
+ * Returns true when the view reaches the end of the file, meaning that a final record without terminator is complete.
+ */
+bool bstr_file_at_end(const bstr_file_t *self)
+{
+   if ( (self == 0) || (self->pBegin == 0) )
+   {
+      return true;
+   }
+   return (self->offset + (uint64_t) (self->pEnd - self->pBegin) == self->size);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void bstr_file_init(bstr_file_t *self, size_t windowSize, uint32_t flags)
+{
+   self->pBegin = 0;
+   self->pEnd = 0;
+   self->size = 0u;
+   self->offset = 0u;
+   self->windowSize = windowSize;
+   self->flags = flags;
+   self->mapping = 0;
+   self->mappingLength = 0u;
+#if defined(_WIN32)
+   self->fileHandle = 0;
+   self->mappingHandle = 0;
+#else
+   self->fd = -1;
+#endif
+}
+
+/**
+ * Opens the file and gets its size.
+ */
+static bstr_error_t bstr_file_open_internal(bstr_file_t *self, const char *path)
+{
+#if defined(_WIN32)
+   LARGE_INTEGER size;
+   DWORD attributes = FILE_ATTRIBUTE_NORMAL;
+   HANDLE file;
+   if (self->flags & BSTR_FILE_SEQUENTIAL)
+   {
+      attributes |= FILE_FLAG_SEQUENTIAL_SCAN;
+   }
+   else if (self->flags & BSTR_FILE_RANDOM)
+   {
+      attributes |= FILE_FLAG_RANDOM_ACCESS;
+   }
+   file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, attributes, 0);
+   if (file == INVALID_HANDLE_VALUE)
+   {
+      return BSTR_IO_ERROR;
+   }
+   self->fileHandle = (void*) file;
+   if (!GetFileSizeEx(file, &size))
+   {
+      return BSTR_IO_ERROR;
+   }
+   self->size = (uint64_t) size.QuadPart;
+   if (self->size > 0u)
+   {
+      //empty files can't be mapped
+      self->mappingHandle = (void*) CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+      if (self->mappingHandle == 0)
+      {
+         return BSTR_IO_ERROR;
+      }
+   }
+   return BSTR_NO_ERROR;
+#else
+   struct stat info;
+   self->fd = open(path, O_RDONLY | O_CLOEXEC);
+   if (self->fd < 0)
+   {
+      return BSTR_IO_ERROR;
+   }
+   if (fstat(self->fd, &info) != 0)
+   {
+      return BSTR_IO_ERROR;
+   }
+   if (!S_ISREG(info.st_mode))
+   {
+      errno = ENODEV; //pipes, sockets and devices can't be mapped, see bstr_reader_t
+      return BSTR_IO_ERROR;
+   }
+   self->size = (uint64_t) info.st_size;
+   return BSTR_NO_ERROR;
+#endif
+}
+
+/**
+ * Replaces the mapping by one whose view starts at offset. The mapping itself starts at offset rounded down to the
+ * page size (allocation granularity on Windows).
+ */
+static bstr_error_t bstr_file_map(bstr_file_t *self, uint64_t offset)
+{
+   uint64_t mappingOffset = offset - offset % bstr_file_granularity();
+   uint64_t viewLength = self->size - offset;
+   size_t mappingLength;
+   void *mapping;
+   if ( (self->windowSize > 0u) && (viewLength > (uint64_t) self->windowSize) )
+   {
+      viewLength = (uint64_t) self->windowSize;
+   }
+   mappingLength = (size_t) (offset - mappingOffset + viewLength);
+   bstr_file_unmap(self);
+   self->offset = offset;
+   if (viewLength == 0u)
+   {
+      self->pBegin = m_empty;
+      self->pEnd = m_empty;
+      return BSTR_NO_ERROR;
+   }
+#if defined(_WIN32)
+   mapping = MapViewOfFile((HANDLE) self->mappingHandle, FILE_MAP_READ, (DWORD) (mappingOffset >> 32), (DWORD) mappingOffset, mappingLength);
+   if (mapping == 0)
+   {
+      return BSTR_IO_ERROR;
+   }
+#else
+   {
+      int mapFlags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+      if (self->flags & BSTR_FILE_POPULATE)
+      {
+         mapFlags |= MAP_POPULATE;
+      }
+#endif
+      mapping = mmap(0, mappingLength, PROT_READ, mapFlags, self->fd, (off_t) mappingOffset);
+      if (mapping == MAP_FAILED)
+      {
+         return BSTR_IO_ERROR;
+      }
+   }
+#endif
+   self->mapping = mapping;
+   self->mappingLength = mappingLength;
+   self->pBegin = (const uint8_t*) mapping + (size_t) (offset - mappingOffset);
+   self->pEnd = self->pBegin + (size_t) viewLength;
+   bstr_file_apply_flags(self);
+   return BSTR_NO_ERROR;
+}
+
+static void bstr_file_unmap(bstr_file_t *self)
+{
+   if (self->mapping != 0)
+   {
+#if defined(_WIN32)
+      (void) UnmapViewOfFile(self->mapping);
+#else
+      (void) munmap(self->mapping, self->mappingLength);
+#endif
+      self->mapping = 0;
+      self->mappingLength = 0u;
+   }
+   self->pBegin = 0;
+   self->pEnd = 0;
+}
+
+/**
+ * Passes the flags on to the kernel. The hints only affect performance so failures are ignored.
+ * On Windows the access pattern is given when the file is opened instead.
+ */
+static void bstr_file_apply_flags(bstr_file_t *self)
+{
+#if !defined(_WIN32)
+   int advice = MADV_NORMAL;
+   if (self->mapping == 0)
+   {
+      return;
+   }
+   if (self->flags & BSTR_FILE_SEQUENTIAL)
+   {
+      advice = MADV_SEQUENTIAL;
+   }
+   else if (self->flags & BSTR_FILE_RANDOM)
+   {
+      advice = MADV_RANDOM;
+   }
+   (void) madvise(self->mapping, self->mappingLength, advice);
+#ifdef MADV_HUGEPAGE
+   if (self->flags & BSTR_FILE_HUGE_PAGES)
+   {
+      (void) madvise(self->mapping, self->mappingLength, MADV_HUGEPAGE);
+   }
+#endif
+   if (self->flags & BSTR_FILE_POPULATE)
+   {
+      //MAP_POPULATE only applies to new mappings
+      (void) madvise(self->mapping, self->mappingLength, MADV_WILLNEED);
+   }
+#else
+   (void) self;
+#endif
+}
+
+static uint64_t bstr_file_granularity(void)
+{
+#if defined(_WIN32)
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   return (uint64_t) info.dwAllocationGranularity;
+#else
+   long pageSize = sysconf(_SC_PAGESIZE);
+   return (pageSize > 0) ? (uint64_t) pageSize : 4096u;
+#endif
+}
@@ -0,0 +1,66 @@
+/*****************************************************************************
+* \file      bstr_float.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Private decimal to binary floating point conversion
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_FLOAT_H
+#define BSTR_FLOAT_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+#define BSTR_DECIMAL_JSON 0x01u  //strict JSON grammar instead of the strtod subset
+
+
+/**
+ * A decimal number as it appears in the source text. The value is mantissa * 10^exponent unless isTruncated is set,
+ * in that case mantissa only holds the first 19 significant digits and the digit ranges are needed to get the exact value.
+ */
+typedef struct bstr_decimal_tag
+{
+   const uint8_t *pIntBegin;     //integer digits
+   const uint8_t *pIntEnd;
+   const uint8_t *pFracBegin;    //fraction digits, empty when there is no fraction
+   const uint8_t *pFracEnd;
+   int64_t explicitExponent;     //value after 'e' or 'E', 0 when there is no exponent
+   uint64_t intMantissa;         //integer digits only, wraps around after 19 digits
+   uint64_t mantissa;
+   int64_t exponent;
+   bool isNegative;
+   bool isTruncated;
+} bstr_decimal_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+const uint8_t *bstr_decimal_parse(const uint8_t *pBegin, const uint8_t *pEnd, uint32_t flags, bstr_decimal_t *decimal);
+double bstr_decimal_to_double(const bstr_decimal_t *decimal);
+
+#endif //BSTR_FLOAT_H
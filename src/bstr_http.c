@@ -0,0 +1,709 @@
+/*****************************************************************************
+* \file      bstr_http.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Zero-copy HTTP/1.x request, response and header parser
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#include "bstr_http.h"
+#include "bstr_simd.h"
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define HASH_OFFSET_BASIS  2166136261u  //32-bit FNV-1a
+#define HASH_PRIME         16777619u
+
+//classes of m_httpStop
+#define STOP_VALUE         ((uint8_t) 0x01u)   //control characters except HT, ends a header value or reason phrase
+#define STOP_TARGET        ((uint8_t) 0x02u)   //control characters and SP, ends a request target
+
+#define MESSAGE_REQUEST    0u
+#define MESSAGE_RESPONSE   1u
+#define MESSAGE_HEADERS    2u
+
+/**
+ * Returns the first byte in pBegin..pEnd which is a member of stopClass, or pEnd.
+ */
+typedef const uint8_t *(*bstr_http_find_stop_func_t)(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t stopClass);
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static bstr_error_t bstr_http_parse(bstr_http_parser_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppNext, uint8_t messageType);
+static bool bstr_http_has_blank_line(const uint8_t *pBegin, const uint8_t *pFrom, const uint8_t *pEnd, bool isFirstLineBlank);
+static bstr_error_t bstr_http_parse_request_line(bstr_http_parser_t *self, const uint8_t **ppNext, const uint8_t *pEnd, bstr_http_find_stop_func_t find_stop);
+static bstr_error_t bstr_http_parse_status_line(bstr_http_parser_t *self, const uint8_t **ppNext, const uint8_t *pEnd, bstr_http_find_stop_func_t find_stop);
+static bstr_error_t bstr_http_parse_version(bstr_http_parser_t *self, const uint8_t **ppNext, const uint8_t *pEnd);
+static bstr_error_t bstr_http_parse_line_end(const uint8_t **ppNext, const uint8_t *pEnd);
+static bstr_error_t bstr_http_parse_header_fields(bstr_http_parser_t *self, const uint8_t **ppNext, const uint8_t *pEnd, bstr_http_find_stop_func_t find_stop);
+static bool bstr_http_name_equals(const uint8_t *pBegin, const uint8_t *pEnd, const char *name);
+static inline uint8_t bstr_http_lower(uint8_t c);
+static inline bool bstr_http_is_ows(uint8_t c);
+static bstr_http_find_stop_func_t bstr_http_find_stop_func(void);
+static const uint8_t *bstr_http_find_stop_scalar(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t stopClass);
+#ifdef BSTR_SIMD_X86
+static const uint8_t *bstr_http_find_stop_sse42(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t stopClass);
+static const uint8_t *bstr_http_find_stop_avx2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t stopClass);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//tchar (RFC 7230 3.2.6) mapped to lower case, 0 for all other bytes
+static const uint8_t m_httpToken[256] = {
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x21, 0x00, 0x23, 0x24, 0x25, 0x26, 0x27, 0x00, 0x00, 0x2A, 0x2B, 0x00, 0x2D, 0x2E, 0x00,
+   0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+   0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x00, 0x00, 0x00, 0x5E, 0x5F,
+   0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+   0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x00, 0x7C, 0x00, 0x7E, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+//STOP_VALUE and STOP_TARGET membership of each byte
+static const uint8_t m_httpStop[256] = {
+   3, 3, 3, 3, 3, 3, 3, 3, 3, 2, 3, 3, 3, 3, 3, 3,
+   3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+   2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The parser stores up to maxHeaders headers in the headers array.
+ */
+void bstr_http_parser_create(bstr_http_parser_t *self, bstr_http_header_t *headers, size_t maxHeaders)
+{
+   if (self != 0)
+   {
+      self->headers = headers;
+      self->maxHeaders = (headers != 0) ? maxHeaders : 0u;
+      bstr_http_parser_reset(self);
+   }
+}
+
+/**
+ * Forgets any partial input. Call this before parsing a message in a different buffer.
+ */
+void bstr_http_parser_reset(bstr_http_parser_t *self)
+{
+   if (self != 0)
+   {
+      self->numHeaders = 0u;
+      self->method.pBegin = self->method.pEnd = 0;
+      self->target.pBegin = self->target.pEnd = 0;
+      self->reason.pBegin = self->reason.pEnd = 0;
+      self->status = 0u;
+      self->versionMinor = 0u;
+      self->scannedLen = 0u;
+   }
+}
+
+/**
+ * Parses a request line followed by header fields and the blank line ending the head.
+ * On success *ppNext points to the first byte of the message body. When the input ends before the head does,
+ * BSTR_NO_ERROR is returned with *ppNext set to pBegin; call again with the same input extended with more data.
+ */
+bstr_error_t bstr_http_parse_request(bstr_http_parser_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppNext)
+{
+   return bstr_http_parse(self, pBegin, pEnd, ppNext, MESSAGE_REQUEST);
+}
+
+/**
+ * Same as bstr_http_parse_request for a status line followed by header fields.
+ */
+bstr_error_t bstr_http_parse_response(bstr_http_parser_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppNext)
+{
+   return bstr_http_parse(self, pBegin, pEnd, ppNext, MESSAGE_RESPONSE);
+}
+
+/**
+ * Same as bstr_http_parse_request for header fields only, such as trailers or MIME part headers.
+ */
+bstr_error_t bstr_http_parse_headers(bstr_http_parser_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppNext)
+{
+   return bstr_http_parse(self, pBegin, pEnd, ppNext, MESSAGE_HEADERS);
+}
+
+/**
+ * Returns the first stored header after prev (or the first one when prev is NULL) whose name equals name, ignoring
+ * case. nameHash must be bstr_http_name_hash_cstr(name), it is meant to be computed once and used for every message.
+ * Returns NULL when there is no such header.
+ */
+const bstr_http_header_t *bstr_http_find_header(const bstr_http_parser_t *self, const bstr_http_header_t *prev, const char *name, uint32_t nameHash)
+{
+   const bstr_http_header_t *header;
+   const bstr_http_header_t *pLast;
+   if ( (self == 0) || (self->headers == 0) || (name == 0) )
+   {
+      return 0;
+   }
+   header = (prev != 0) ? prev + 1 : self->headers;
+   pLast = self->headers + ( (self->numHeaders < self->maxHeaders) ? self->numHeaders : self->maxHeaders );
+   for (; header < pLast; header++)
+   {
+      if ( (header->nameHash == nameHash) && bstr_http_name_equals(header->pNameBegin, header->pNameEnd, name) )
+      {
+         return header;
+      }
+   }
+   return 0;
+}
+
+/**
+ * Case-insensitive 32-bit FNV-1a hash of a header or parameter name.
+ */
+uint32_t bstr_http_name_hash(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   uint32_t hash = HASH_OFFSET_BASIS;
+   if ( (pBegin != 0) && (pEnd != 0) )
+   {
+      for (; pBegin < pEnd; pBegin++)
+      {
+         hash = (hash ^ bstr_http_lower(*pBegin)) * HASH_PRIME;
+      }
+   }
+   return hash;
+}
+
+uint32_t bstr_http_name_hash_cstr(const char *name)
+{
+   if (name == 0)
+   {
+      return HASH_OFFSET_BASIS;
+   }
+   return bstr_http_name_hash((const uint8_t*) name, (const uint8_t*) name + strlen(name));
+}
+
+/**
+ * Parses a list of key=value parameters such as a query string (pairSep '&', assign '=') or a cookie header
+ * (pairSep ';', assign '='). Whitespace around keys and values is ignored, a pair without assign gets an empty value
+ * and empty pairs are skipped. Stores up to maxParams pairs and returns the number of pairs found which can be larger.
+ * The values are not decoded.
+ */
+size_t bstr_http_parse_params(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t pairSep, uint8_t assign, bstr_http_header_t *params, size_t maxParams)
+{
+   bstr_split_iter_t iter;
+   const uint8_t *pPairBegin;
+   const uint8_t *pPairEnd;
+   size_t count = 0u;
+   if ( (pBegin == 0) || (pEnd == 0) || (pEnd < pBegin) || ( (params == 0) && (maxParams > 0u) ) )
+   {
+      return 0u;
+   }
+   bstr_split_iter_create(&iter, pBegin, pEnd, pairSep, BSTR_SPLIT_STRIP);
+   while (bstr_split_next(&iter, &pPairBegin, &pPairEnd))
+   {
+      bstr_http_header_t param;
+      const uint8_t *pAssign;
+      if (pPairBegin == pPairEnd)
+      {
+         continue;
+      }
+      pAssign = bstr_simd_ops()->search_val(pPairBegin, pPairEnd, assign);
+      param.pNameBegin = pPairBegin;
+      param.pNameEnd = pAssign;
+      while ( (param.pNameEnd > param.pNameBegin) && bstr_http_is_ows(param.pNameEnd[-1]) )
+      {
+         param.pNameEnd--;
+      }
+      param.pValueBegin = (pAssign < pPairEnd) ? pAssign + 1 : pPairEnd;
+      while ( (param.pValueBegin < pPairEnd) && bstr_http_is_ows(*param.pValueBegin) )
+      {
+         param.pValueBegin++;
+      }
+      param.pValueEnd = pPairEnd;
+      param.nameHash = bstr_http_name_hash(param.pNameBegin, param.pNameEnd);
+      if (count < maxParams)
+      {
+         params[count] = param;
+      }
+      count++;
+   }
+   return count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * BSTR_PREMATURE_END_OF_BUFFER_ERROR from the parse functions below means that more input is needed.
+ * A call following an incomplete one first looks for the blank line among the new bytes and only parses the
+ * head once it has arrived, so a head trickling in a few bytes at a time is not parsed over and over.
+ */
+static bstr_error_t bstr_http_parse(bstr_http_parser_t *self, const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t **ppNext, uint8_t messageType)
+{
+   const uint8_t *pNext = pBegin;
+   size_t length;
+   bstr_http_find_stop_func_t find_stop;
+   bstr_error_t result = BSTR_NO_ERROR;
+   if ( (self == 0) || (pBegin == 0) || (pEnd == 0) || (pEnd < pBegin) || (ppNext == 0) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   *ppNext = pBegin;
+   length = (size_t) (pEnd - pBegin);
+   if ( (self->scannedLen > 0u) && (self->scannedLen <= length) && !bstr_http_has_blank_line(pBegin, pBegin + self->scannedLen, pEnd, messageType == MESSAGE_HEADERS) )
+   {
+      self->scannedLen = length;
+      return BSTR_NO_ERROR;
+   }
+   bstr_http_parser_reset(self);
+   find_stop = bstr_http_find_stop_func();
+   if (messageType == MESSAGE_REQUEST)
+   {
+      result = bstr_http_parse_request_line(self, &pNext, pEnd, find_stop);
+   }
+   else if (messageType == MESSAGE_RESPONSE)
+   {
+      result = bstr_http_parse_status_line(self, &pNext, pEnd, find_stop);
+   }
+   if (result == BSTR_NO_ERROR)
+   {
+      result = bstr_http_parse_header_fields(self, &pNext, pEnd, find_stop);
+   }
+   if (result == BSTR_PREMATURE_END_OF_BUFFER_ERROR)
+   {
+      self->scannedLen = length;
+      return BSTR_NO_ERROR;
+   }
+   if (result == BSTR_NO_ERROR)
+   {
+      *ppNext = pNext;
+   }
+   return result;
+}
+
+/**
+ * Returns true when a '\n' at or after pFrom ends a blank line ("\n\n" or "\n\r\n"). With isFirstLineBlank a
+ * blank line at pBegin also counts, an empty header block (such as an empty chunked trailer) is just "\r\n".
+ */
+static bool bstr_http_has_blank_line(const uint8_t *pBegin, const uint8_t *pFrom, const uint8_t *pEnd, bool isFirstLineBlank)
+{
+   const uint8_t *pNext = pFrom;
+   for (;;)
+   {
+      const uint8_t *pNewline = bstr_simd_ops()->search_val(pNext, pEnd, (uint8_t) '\n');
+      if (pNewline == pEnd)
+      {
+         return false;
+      }
+      if ( isFirstLineBlank && ( (pNewline == pBegin) || ( (pNewline == pBegin + 1) && (*pBegin == '\r') ) ) )
+      {
+         return true;
+      }
+      if ( (pNewline > pBegin) && (pNewline[-1] == '\n') )
+      {
+         return true;
+      }
+      if ( (pNewline - pBegin >= 2) && (pNewline[-1] == '\r') && (pNewline[-2] == '\n') )
+      {
+         return true;
+      }
+      pNext = pNewline + 1;
+   }
+}
+
+static bstr_error_t bstr_http_parse_request_line(bstr_http_parser_t *self, const uint8_t **ppNext, const uint8_t *pEnd, bstr_http_find_stop_func_t find_stop)
+{
+   const uint8_t *pNext = *ppNext;
+   bstr_error_t result;
+   //RFC 7230 3.5, empty lines before the request line are ignored
+   while ( (pNext < pEnd) && ( (*pNext == '\r') || (*pNext == '\n') ) )
+   {
+      pNext++;
+   }
+   self->method.pBegin = pNext;
+   while ( (pNext < pEnd) && (m_httpToken[*pNext] != 0u) )
+   {
+      pNext++;
+   }
+   if (pNext == pEnd)
+   {
+      return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+   }
+   if ( (pNext == self->method.pBegin) || (*pNext != ' ') )
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   self->method.pEnd = pNext++;
+   self->target.pBegin = pNext;
+   pNext = find_stop(pNext, pEnd, STOP_TARGET);
+   if (pNext == pEnd)
+   {
+      return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+   }
+   if ( (pNext == self->target.pBegin) || (*pNext != ' ') )
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   self->target.pEnd = pNext++;
+   result = bstr_http_parse_version(self, &pNext, pEnd);
+   if (result == BSTR_NO_ERROR)
+   {
+      result = bstr_http_parse_line_end(&pNext, pEnd);
+   }
+   *ppNext = pNext;
+   return result;
+}
+
+/**
+ * The reason phrase is optional, "HTTP/1.1 204\r\n" is accepted.
+ */
+static bstr_error_t bstr_http_parse_status_line(bstr_http_parser_t *self, const uint8_t **ppNext, const uint8_t *pEnd, bstr_http_find_stop_func_t find_stop)
+{
+   const uint8_t *pNext = *ppNext;
+   bstr_error_t result = bstr_http_parse_version(self, &pNext, pEnd);
+   uint32_t i;
+   if (result != BSTR_NO_ERROR)
+   {
+      return result;
+   }
+   if (pNext == pEnd)
+   {
+      return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+   }
+   if (*pNext++ != ' ')
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   for (i = 0u; i < 3u; i++)
+   {
+      if (pNext == pEnd)
+      {
+         return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+      }
+      if ( (*pNext < '0') || (*pNext > '9') )
+      {
+         return BSTR_PARSE_ERROR;
+      }
+      self->status = (uint16_t) (self->status * 10u + (uint16_t) (*pNext++ - '0'));
+   }
+   if (pNext == pEnd)
+   {
+      return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+   }
+   if (*pNext == ' ')
+   {
+      pNext++;
+   }
+   else if ( (*pNext != '\r') && (*pNext != '\n') )
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   self->reason.pBegin = pNext;
+   pNext = find_stop(pNext, pEnd, STOP_VALUE);
+   self->reason.pEnd = pNext;
+   result = bstr_http_parse_line_end(&pNext, pEnd);
+   *ppNext = pNext;
+   return result;
+}
+
+static bstr_error_t bstr_http_parse_version(bstr_http_parser_t *self, const uint8_t **ppNext, const uint8_t *pEnd)
+{
+   static const char prefix[] = "HTTP/1.";
+   const uint8_t *pNext = *ppNext;
+   size_t available = (size_t) (pEnd - pNext);
+   if (memcmp(pNext, prefix, (available < 7u) ? available : 7u) != 0)
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   if (available < 8u)
+   {
+      return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+   }
+   if ( (pNext[7] < '0') || (pNext[7] > '9') )
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   self->versionMinor = (uint8_t) (pNext[7] - '0');
+   *ppNext = pNext + 8;
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Accepts "\r\n" as well as a bare "\n".
+ */
+static bstr_error_t bstr_http_parse_line_end(const uint8_t **ppNext, const uint8_t *pEnd)
+{
+   const uint8_t *pNext = *ppNext;
+   if (pNext == pEnd)
+   {
+      return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+   }
+   if (*pNext == '\r')
+   {
+      if (pNext + 1 == pEnd)
+      {
+         return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+      }
+      pNext++;
+   }
+   if (*pNext != '\n')
+   {
+      return ( (*pNext < 0x20u) || (*pNext == 0x7Fu) ) ? BSTR_INVALID_CHARACTER_ERROR : BSTR_PARSE_ERROR;
+   }
+   *ppNext = pNext + 1;
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Parses header fields up to and including the blank line. The name hash is computed while the name is scanned.
+ * Obsolete line folding and whitespace between the name and the colon are rejected (RFC 7230 3.2.4).
+ */
+static bstr_error_t bstr_http_parse_header_fields(bstr_http_parser_t *self, const uint8_t **ppNext, const uint8_t *pEnd, bstr_http_find_stop_func_t find_stop)
+{
+   const uint8_t *pNext = *ppNext;
+   for (;;)
+   {
+      bstr_http_header_t header;
+      uint32_t hash = HASH_OFFSET_BASIS;
+      bstr_error_t result;
+      if (pNext == pEnd)
+      {
+         return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+      }
+      if ( (*pNext == '\r') || (*pNext == '\n') )
+      {
+         result = bstr_http_parse_line_end(&pNext, pEnd);
+         if (result == BSTR_NO_ERROR)
+         {
+            *ppNext = pNext;
+         }
+         return result;
+      }
+      header.pNameBegin = pNext;
+      for (;;)
+      {
+         uint8_t c;
+         if (pNext == pEnd)
+         {
+            return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+         }
+         c = m_httpToken[*pNext];
+         if (c == 0u)
+         {
+            break;
+         }
+         hash = (hash ^ c) * HASH_PRIME;
+         pNext++;
+      }
+      if ( (pNext == header.pNameBegin) || (*pNext != ':') )
+      {
+         return BSTR_PARSE_ERROR;
+      }
+      header.pNameEnd = pNext++;
+      header.nameHash = hash;
+      while ( (pNext < pEnd) && bstr_http_is_ows(*pNext) )
+      {
+         pNext++;
+      }
+      header.pValueBegin = pNext;
+      pNext = find_stop(pNext, pEnd, STOP_VALUE);
+      if (pNext == pEnd)
+      {
+         return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+      }
+      header.pValueEnd = pNext;
+      while ( (header.pValueEnd > header.pValueBegin) && bstr_http_is_ows(header.pValueEnd[-1]) )
+      {
+         header.pValueEnd--;
+      }
+      result = bstr_http_parse_line_end(&pNext, pEnd);
+      if (result != BSTR_NO_ERROR)
+      {
+         return result;
+      }
+      if (self->numHeaders < self->maxHeaders)
+      {
+         self->headers[self->numHeaders] = header;
+      }
+      self->numHeaders++;
+   }
+}
+
+static bool bstr_http_name_equals(const uint8_t *pBegin, const uint8_t *pEnd, const char *name)
+{
+   for (; pBegin < pEnd; pBegin++, name++)
+   {
+      if ( (*name == '\0') || (bstr_http_lower(*pBegin) != bstr_http_lower((uint8_t) *name)) )
+      {
+         return false;
+      }
+   }
+   return *name == '\0';
+}
+
+static inline uint8_t bstr_http_lower(uint8_t c)
+{
+   return ( (c >= (uint8_t) 'A') && (c <= (uint8_t) 'Z') ) ? (uint8_t) (c + 0x20u) : c;
+}
+
+static inline bool bstr_http_is_ows(uint8_t c)
+{
+   return (c == (uint8_t) ' ') || (c == (uint8_t) '\t');
+}
+
+static bstr_http_find_stop_func_t bstr_http_find_stop_func(void)
+{
+#ifdef BSTR_SIMD_X86
+   uint32_t features = bstr_simd_ops()->features;
+   if (features & BSTR_SIMD_AVX2)
+   {
+      return bstr_http_find_stop_avx2;
+   }
+   else if (features & BSTR_SIMD_SSE42)
+   {
+      return bstr_http_find_stop_sse42;
+   }
+#endif
+   return bstr_http_find_stop_scalar;
+}
+
+static const uint8_t *bstr_http_find_stop_scalar(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t stopClass)
+{
+   const uint8_t *pNext = pBegin;
+   while ( (pNext < pEnd) && ( (m_httpStop[*pNext] & stopClass) == 0u ) )
+   {
+      pNext++;
+   }
+   return pNext;
+}
+
+#ifdef BSTR_SIMD_X86
+/**
+ * Same approach as picohttpparser: pcmpestri in range mode finds the first byte inside any of up to eight ranges.
+ */
+BSTR_TARGET("sse4.2")
+static const uint8_t *bstr_http_find_stop_sse42(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t stopClass)
+{
+   static const char valueRanges[16] = "\000\010\012\037\177\177";
+   static const char targetRanges[16] = "\000\040\177\177";
+   const uint8_t *pNext = pBegin;
+   if (pEnd - pNext >= 16)
+   {
+      const bool isValue = (stopClass == STOP_VALUE);
+      const __m128i ranges = _mm_loadu_si128((const __m128i*) (isValue ? valueRanges : targetRanges));
+      const int rangesLen = isValue ? 6 : 4;
+      do
+      {
+         int index = _mm_cmpestri(ranges, rangesLen, _mm_loadu_si128((const __m128i*) pNext), 16,
+                                  _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+         if (index != 16)
+         {
+            return pNext + index;
+         }
+         pNext += 16;
+      } while (pEnd - pNext >= 16);
+   }
+   return bstr_http_find_stop_scalar(pNext, pEnd, stopClass);
+}
+
+/**
+ * A byte is a control character when max(byte, limit) == limit. HT is then removed from the value class.
+ */
+BSTR_TARGET("avx2")
+static const uint8_t *bstr_http_find_stop_avx2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t stopClass)
+{
+   const uint8_t *pNext = pBegin;
+   const bool isValue = (stopClass == STOP_VALUE);
+   const char limit = isValue ? (char) 0x1F : (char) 0x20;
+   if (pEnd - pNext >= 32)
+   {
+      const __m256i limits = _mm256_set1_epi8(limit);
+      const __m256i tabs = _mm256_set1_epi8('\t');
+      const __m256i dels = _mm256_set1_epi8((char) 0x7F);
+      do
+      {
+         __m256i v = _mm256_loadu_si256((const __m256i*) pNext);
+         __m256i stops = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(v, limits), limits), _mm256_cmpeq_epi8(v, dels));
+         uint32_t mask;
+         if (isValue)
+         {
+            stops = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, tabs), stops);
+         }
+         mask = (uint32_t) _mm256_movemask_epi8(stops);
+         if (mask != 0u)
+         {
+            return pNext + bstr_ctz32(mask);
+         }
+         pNext += 32;
+      } while (pEnd - pNext >= 32);
+   }
+   if (pEnd - pNext >= 16)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i*) pNext);
+      __m128i limits = _mm_set1_epi8(limit);
+      __m128i stops = _mm_or_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, limits), limits), _mm_cmpeq_epi8(v, _mm_set1_epi8((char) 0x7F)));
+      uint32_t mask;
+      if (isValue)
+      {
+         stops = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), stops);
+      }
+      mask = (uint32_t) _mm_movemask_epi8(stops);
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz32(mask);
+      }
+      pNext += 16;
+   }
+   return bstr_http_find_stop_scalar(pNext, pEnd, stopClass);
+}
+#endif //BSTR_SIMD_X86
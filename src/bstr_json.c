@@ -0,0 +1,1509 @@
+/*****************************************************************************
+* \file      bstr_json.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     JSON documents: two-stage parser producing a flat tape of 64-bit entries and a lazy cursor
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#include "bstr_json.h"
+#include "bstr_simd.h"
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define BSTR_JSON_BATCH_BLOCKS 64u          //blocks per call to the structural kernel
+#define BSTR_JSON_FLATTEN_SLACK 16u         //bstr_json_flatten writes up to 16 positions past the last one
+#define BSTR_JSON_SKIP_MAX_BLOCKS 16u       //largest batch of blocks classified at a time by bstr_json_skip_container
+#define BSTR_JSON_MAX_LENGTH 0x7FFFFFFFu    //input offsets and tape indices are stored in 32 bits
+
+#define TAPE_ROOT ((uint8_t) 'r')
+#define TAPE_STRING_IN_BUF ((uint64_t) 1u << 55)
+#define TAPE_PAYLOAD_MASK 0x00FFFFFFFFFFFFFFull
+#define TAPE_MAX_COUNT 0xFFFFFFu
+
+#define STATE_VALUE       0u  //expecting a value
+#define STATE_KEY         1u  //expecting an object key
+#define STATE_AFTER_VALUE 2u  //expecting ',' or the close of the innermost container
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void *bstr_json_reserve(const bstr_allocator_t *allocator, void *data, size_t *capacity, size_t required, size_t elementSize);
+static bstr_error_t bstr_json_find_structurals(bstr_json_document_t *self);
+static size_t bstr_json_flatten(const uint64_t *masks, size_t numBlocks, uint32_t offset, uint32_t *positions, size_t count);
+static bstr_error_t bstr_json_build_tape(bstr_json_document_t *self);
+static bstr_error_t bstr_json_parse_scalar(bstr_json_document_t *self, bstr_context_t *ctx, const uint8_t *p, size_t *tapeLen);
+static bstr_error_t bstr_json_parse_string(bstr_json_document_t *self, bstr_context_t *ctx, const uint8_t *p, size_t *tapeLen);
+static bool bstr_json_parse_small_integer(const uint8_t *p, const uint8_t *pEnd, uint64_t *entry);
+static bool bstr_json_is_literal(const uint8_t *p, const uint8_t *pEnd, const char *literal, size_t len);
+static inline bool bstr_json_is_scalar_end(const uint8_t *p, const uint8_t *pEnd);
+static inline uint64_t bstr_json_tape_entry(uint8_t type, uint64_t payload);
+static inline uint8_t bstr_json_tape_type(const bstr_json_document_t *document, size_t index);
+static size_t bstr_json_skip(const bstr_json_document_t *document, size_t index);
+static bool bstr_json_cursor_enter(bstr_json_cursor_t *self, const uint8_t *p, uint8_t container, bool isFirst);
+static bool bstr_json_cursor_fail(bstr_json_cursor_t *self, bstr_error_t error);
+static bool bstr_json_cursor_key_equals(const bstr_json_cursor_t *self, const uint8_t *pKeyBegin, const uint8_t *pKeyEnd);
+static bool bstr_json_cursor_decode(bstr_json_cursor_t *self, const uint8_t *pQuote, bstr_buf_t *buf, const uint8_t **ppBegin, const uint8_t **ppEnd);
+static bool bstr_json_pointer_index(const char *pBegin, const char *pEnd, size_t *index);
+static bool bstr_json_pointer_unescape(const char *pBegin, const char *pEnd, bstr_buf_t *buf);
+static bstr_error_t bstr_json_skip_value(const uint8_t *p, const uint8_t *pEnd, const uint8_t **ppNext);
+static bstr_error_t bstr_json_skip_string(const uint8_t *p, const uint8_t *pEnd, const uint8_t **ppNext, bool *hasEscapes);
+static bstr_error_t bstr_json_skip_container(const uint8_t *p, const uint8_t *pEnd, const uint8_t **ppNext);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Creates an empty document, NULL allocator selects the default allocator. Nothing is allocated before the first parse.
+ */
+void bstr_json_document_create(bstr_json_document_t *self, const bstr_allocator_t *allocator)
+{
+   if (self != 0)
+   {
+      self->pBegin = 0;
+      self->pEnd = 0;
+      self->pError = 0;
+      self->structurals = 0;
+      self->numStructurals = 0u;
+      self->structuralsCapacity = 0u;
+      self->tape = 0;
+      self->tapeLen = 0u;
+      self->tapeCapacity = 0u;
+      self->stack = 0;
+      bstr_buf_create(&self->strings, allocator);
+      self->allocator = allocator;
+      self->lastError = BSTR_NO_ERROR;
+   }
+}
+
+void bstr_json_document_destroy(bstr_json_document_t *self)
+{
+   if (self != 0)
+   {
+      bstr_allocator_free(self->allocator, self->structurals, self->structuralsCapacity * sizeof(uint32_t));
+      bstr_allocator_free(self->allocator, self->tape, self->tapeCapacity * sizeof(uint64_t));
+      bstr_allocator_free(self->allocator, self->stack, 2u * BSTR_JSON_MAX_DEPTH * sizeof(uint32_t));
+      bstr_buf_destroy(&self->strings);
+      self->structurals = 0;
+      self->structuralsCapacity = 0u;
+      self->numStructurals = 0u;
+      self->tape = 0;
+      self->tapeCapacity = 0u;
+      self->tapeLen = 0u;
+      self->stack = 0;
+   }
+}
+
+/**
+ * Parses the JSON document pBegin..pEnd (which must contain exactly one value, surrounded by optional whitespace)
+ * replacing the previous content of self. The input must stay unchanged while the document is in use.
+ * Returns BSTR_PARSE_ERROR on invalid JSON and on nesting deeper than BSTR_JSON_MAX_DEPTH,
+ * BSTR_PREMATURE_END_OF_BUFFER_ERROR when the input ends inside a value and errors from bstr_parse_json_number and
+ * bstr_parse_json_string_view_buf as is. self->pError tells where the error was found.
+ * Inputs of 2 GiB and more give BSTR_INVALID_ARGUMENT_ERROR.
+ */
+bstr_error_t bstr_json_document_parse(bstr_json_document_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   bstr_error_t result = BSTR_NO_ERROR;
+   size_t length;
+   if (self == 0)
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   self->pError = 0;
+   self->numStructurals = 0u;
+   self->tapeLen = 0u;
+   bstr_buf_clear(&self->strings);
+   if ( (pBegin == 0) || (pEnd == 0) || (pEnd < pBegin) || ((size_t) (pEnd - pBegin) > BSTR_JSON_MAX_LENGTH) )
+   {
+      self->lastError = BSTR_INVALID_ARGUMENT_ERROR;
+      return self->lastError;
+   }
+   self->pBegin = pBegin;
+   self->pEnd = pEnd;
+   length = (size_t) (pEnd - pBegin);
+   self->structurals = (uint32_t*) bstr_json_reserve(self->allocator, self->structurals, &self->structuralsCapacity, length + BSTR_JSON_FLATTEN_SLACK, sizeof(uint32_t));
+   if (self->stack == 0)
+   {
+      self->stack = (uint32_t*) bstr_allocator_alloc(self->allocator, 2u * BSTR_JSON_MAX_DEPTH * sizeof(uint32_t));
+   }
+   if ( (self->structurals == 0) || (self->stack == 0) )
+   {
+      result = BSTR_MEM_ERROR;
+   }
+   if (result == BSTR_NO_ERROR)
+   {
+      result = bstr_json_find_structurals(self);
+   }
+   if (result == BSTR_NO_ERROR)
+   {
+      //each structural adds at most two entries, the root adds two more
+      self->tape = (uint64_t*) bstr_json_reserve(self->allocator, self->tape, &self->tapeCapacity, 2u * self->numStructurals + 2u, sizeof(uint64_t));
+      result = (self->tape != 0) ? bstr_json_build_tape(self) : BSTR_MEM_ERROR;
+   }
+   if (result != BSTR_NO_ERROR)
+   {
+      self->tapeLen = 0u;
+   }
+   self->lastError = result;
+   return result;
+}
+
+/**
+ * Returns the top-level value of the document, its type is BSTR_JSON_NONE when the last parse failed.
+ */
+bstr_json_value_t bstr_json_document_root(const bstr_json_document_t *self)
+{
+   bstr_json_value_t value;
+   value.document = self;
+   value.index = ( (self != 0) && (self->tapeLen > 0u) ) ? 1u : 0u;
+   return value;
+}
+
+uint8_t bstr_json_value_type(bstr_json_value_t value)
+{
+   uint8_t type = bstr_json_tape_type(value.document, value.index);
+   return ( (type == (uint8_t) '}') || (type == (uint8_t) ']') || (type == TAPE_ROOT) ) ? BSTR_JSON_NONE : type;
+}
+
+/**
+ * Returns the number of elements of an array or members of an object, 0 for other types.
+ * Counts are stored on the tape up to 2^24-1, larger containers are counted by iterating.
+ */
+size_t bstr_json_value_count(bstr_json_value_t value)
+{
+   uint8_t type = bstr_json_value_type(value);
+   size_t count;
+   bstr_json_value_t child;
+   if ( (type != BSTR_JSON_OBJECT) && (type != BSTR_JSON_ARRAY) )
+   {
+      return 0u;
+   }
+   count = (size_t) ((value.document->tape[value.index] >> 32) & TAPE_MAX_COUNT);
+   if ( (count == TAPE_MAX_COUNT) && bstr_json_value_child(value, &child) )
+   {
+      count = 1u;
+      while (bstr_json_value_next(&child))
+      {
+         count++;
+      }
+      if (type == BSTR_JSON_OBJECT)
+      {
+         count /= 2u;
+      }
+   }
+   return count;
+}
+
+/**
+ * Gets the first element of an array or the first key of an object. The value of an object member is the value
+ * following its key. Returns false for empty containers and other types.
+ */
+bool bstr_json_value_child(bstr_json_value_t value, bstr_json_value_t *child)
+{
+   uint8_t type = bstr_json_value_type(value);
+   if ( (child == 0) || ( (type != BSTR_JSON_OBJECT) && (type != BSTR_JSON_ARRAY) ) )
+   {
+      return false;
+   }
+   child->document = value.document;
+   child->index = value.index + 1u;
+   return bstr_json_value_type(*child) != BSTR_JSON_NONE;
+}
+
+/**
+ * Moves value to the value after it in the same container, skipping over nested containers in constant time.
+ * Returns false (leaving value unchanged) at the end of the container.
+ */
+bool bstr_json_value_next(bstr_json_value_t *value)
+{
+   bstr_json_value_t next;
+   if ( (value == 0) || (bstr_json_value_type(*value) == BSTR_JSON_NONE) )
+   {
+      return false;
+   }
+   next.document = value->document;
+   next.index = bstr_json_skip(value->document, value->index);
+   if (bstr_json_value_type(next) == BSTR_JSON_NONE)
+   {
+      return false;
+   }
+   *value = next;
+   return true;
+}
+
+/**
+ * Gets element number index of an array. Runs in O(index) time.
+ */
+bool bstr_json_value_at(bstr_json_value_t array, size_t index, bstr_json_value_t *element)
+{
+   bstr_json_value_t next;
+   if ( (bstr_json_value_type(array) != BSTR_JSON_ARRAY) || !bstr_json_value_child(array, &next) )
+   {
+      return false;
+   }
+   while (index > 0u)
+   {
+      if (!bstr_json_value_next(&next))
+      {
+         return false;
+      }
+      index--;
+   }
+   if (element != 0)
+   {
+      *element = next;
+   }
+   return true;
+}
+
+/**
+ * Gets the value of the first member of object whose (unescaped) key equals pKeyBegin..pKeyEnd.
+ */
+bool bstr_json_value_find_bstr(bstr_json_value_t object, const uint8_t *pKeyBegin, const uint8_t *pKeyEnd, bstr_json_value_t *member)
+{
+   bstr_json_value_t key;
+   size_t keyLen;
+   if ( (pKeyBegin == 0) || (pKeyEnd < pKeyBegin) || (bstr_json_value_type(object) != BSTR_JSON_OBJECT) ||
+        !bstr_json_value_child(object, &key) )
+   {
+      return false;
+   }
+   keyLen = (size_t) (pKeyEnd - pKeyBegin);
+   for (;;)
+   {
+      const uint8_t *pBegin;
+      const uint8_t *pEnd;
+      bstr_json_value_t value = key;
+      if ( !bstr_json_value_get_string(key, &pBegin, &pEnd) || !bstr_json_value_next(&value) )
+      {
+         return false;
+      }
+      if ( ((size_t) (pEnd - pBegin) == keyLen) && (memcmp(pBegin, pKeyBegin, keyLen) == 0) )
+      {
+         if (member != 0)
+         {
+            *member = value;
+         }
+         return true;
+      }
+      key = value;
+      if (!bstr_json_value_next(&key))
+      {
+         return false;
+      }
+   }
+}
+
+bool bstr_json_value_find_cstr(bstr_json_value_t object, const char *key, bstr_json_value_t *member)
+{
+   if (key == 0)
+   {
+      return false;
+   }
+   return bstr_json_value_find_bstr(object, (const uint8_t*) key, (const uint8_t*) key + strlen(key), member);
+}
+
+/**
+ * Gets the unescaped content of a string. Strings without escapes point into the parsed input, others into the document.
+ */
+bool bstr_json_value_get_string(bstr_json_value_t value, const uint8_t **ppBegin, const uint8_t **ppEnd)
+{
+   const uint8_t *pData;
+   uint64_t entry;
+   if ( (ppBegin == 0) || (ppEnd == 0) || (bstr_json_value_type(value) != BSTR_JSON_STRING) )
+   {
+      return false;
+   }
+   entry = value.document->tape[value.index];
+   if (entry & TAPE_STRING_IN_BUF)
+   {
+      const uint8_t *pBufEnd;
+      bstr_buf_view(&value.document->strings, &pData, &pBufEnd);
+      pData += entry & (TAPE_STRING_IN_BUF - 1u);
+   }
+   else
+   {
+      pData = value.document->pBegin + (entry & TAPE_PAYLOAD_MASK);
+   }
+   *ppBegin = pData;
+   *ppEnd = pData + value.document->tape[value.index + 1u];
+   return true;
+}
+
+/**
+ * Gets an integer which fits in int64_t.
+ */
+bool bstr_json_value_get_int64(bstr_json_value_t value, int64_t *result)
+{
+   if ( (result == 0) || (bstr_json_value_type(value) != BSTR_JSON_INT64) )
+   {
+      return false;
+   }
+   *result = (int64_t) value.document->tape[value.index + 1u];
+   return true;
+}
+
+/**
+ * Gets a non-negative integer which fits in uint64_t.
+ */
+bool bstr_json_value_get_uint64(bstr_json_value_t value, uint64_t *result)
+{
+   uint8_t type = bstr_json_value_type(value);
+   uint64_t bits;
+   if ( (result == 0) || ( (type != BSTR_JSON_INT64) && (type != BSTR_JSON_UINT64) ) )
+   {
+      return false;
+   }
+   bits = value.document->tape[value.index + 1u];
+   if ( (type == BSTR_JSON_INT64) && ((int64_t) bits < 0) )
+   {
+      return false;
+   }
+   *result = bits;
+   return true;
+}
+
+/**
+ * Gets any number as double, integers are converted.
+ */
+bool bstr_json_value_get_double(bstr_json_value_t value, double *result)
+{
+   uint8_t type = bstr_json_value_type(value);
+   uint64_t bits;
+   if ( (result == 0) || ( (type != BSTR_JSON_DOUBLE) && (type != BSTR_JSON_INT64) && (type != BSTR_JSON_UINT64) ) )
+   {
+      return false;
+   }
+   bits = value.document->tape[value.index + 1u];
+   if (type == BSTR_JSON_DOUBLE)
+   {
+      memcpy(result, &bits, sizeof(double));
+   }
+   else
+   {
+      *result = (type == BSTR_JSON_INT64) ? (double) (int64_t) bits : (double) bits;
+   }
+   return true;
+}
+
+bool bstr_json_value_get_bool(bstr_json_value_t value, bool *result)
+{
+   uint8_t type = bstr_json_value_type(value);
+   if ( (result == 0) || ( (type != BSTR_JSON_TRUE) && (type != BSTR_JSON_FALSE) ) )
+   {
+      return false;
+   }
+   *result = (type == BSTR_JSON_TRUE);
+   return true;
+}
+
+/**
+ * Positions the cursor at the top-level value of pBegin..pEnd. The input must stay unchanged while cursors into it
+ * are in use. Functions moving or reading a cursor return false when the value doesn't exist or has another type,
+ * malformed JSON found on the way additionally sets lastError.
+ */
+void bstr_json_cursor_create(bstr_json_cursor_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   if (self != 0)
+   {
+      self->pValue = 0;
+      self->pEnd = 0;
+      self->pKeyBegin = 0;
+      self->pKeyEnd = 0;
+      self->container = 0u;
+      self->keyHasEscapes = false;
+      self->lastError = BSTR_NO_ERROR;
+      if ( (pBegin == 0) || (pEnd == 0) || (pEnd < pBegin) )
+      {
+         self->lastError = BSTR_INVALID_ARGUMENT_ERROR;
+         return;
+      }
+      self->pEnd = pEnd;
+      pBegin = bstr_lstrip(pBegin, pEnd);
+      if (pBegin == pEnd)
+      {
+         self->lastError = BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+      }
+      else
+      {
+         self->pValue = pBegin;
+      }
+   }
+}
+
+/**
+ * Returns the type of the current value from its first byte, numbers are reported as BSTR_JSON_NUMBER.
+ */
+uint8_t bstr_json_cursor_type(const bstr_json_cursor_t *self)
+{
+   const uint8_t *p;
+   if ( (self == 0) || (self->pValue == 0) )
+   {
+      return BSTR_JSON_NONE;
+   }
+   p = self->pValue;
+   switch (*p)
+   {
+   case '{':
+      return BSTR_JSON_OBJECT;
+   case '[':
+      return BSTR_JSON_ARRAY;
+   case '"':
+      return BSTR_JSON_STRING;
+   case 't':
+      return bstr_json_is_literal(p, self->pEnd, "true", 4u) ? BSTR_JSON_TRUE : BSTR_JSON_NONE;
+   case 'f':
+      return bstr_json_is_literal(p, self->pEnd, "false", 5u) ? BSTR_JSON_FALSE : BSTR_JSON_NONE;
+   case 'n':
+      return bstr_json_is_literal(p, self->pEnd, "null", 4u) ? BSTR_JSON_NULL : BSTR_JSON_NONE;
+   case '-':
+      return BSTR_JSON_NUMBER;
+   default:
+      return ((uint8_t) (*p - '0') <= 9u) ? BSTR_JSON_NUMBER : BSTR_JSON_NONE;
+   }
+}
+
+/**
+ * Moves the cursor to the first element of an array or the first member of an object.
+ * Returns false for empty containers and other types.
+ */
+bool bstr_json_cursor_child(bstr_json_cursor_t *self)
+{
+   uint8_t type = bstr_json_cursor_type(self);
+   if ( (type != BSTR_JSON_OBJECT) && (type != BSTR_JSON_ARRAY) )
+   {
+      return false;
+   }
+   return bstr_json_cursor_enter(self, bstr_lstrip(self->pValue + 1, self->pEnd), type, true);
+}
+
+/**
+ * Moves the cursor past the current value to the next element or member of the same container.
+ * Returns false (leaving the cursor unchanged) at the end of the container and for the top-level value.
+ */
+bool bstr_json_cursor_next(bstr_json_cursor_t *self)
+{
+   const uint8_t *p;
+   bstr_error_t result;
+   if ( (self == 0) || (self->pValue == 0) || (self->container == 0u) )
+   {
+      return false;
+   }
+   result = bstr_json_skip_value(self->pValue, self->pEnd, &p);
+   if (result != BSTR_NO_ERROR)
+   {
+      return bstr_json_cursor_fail(self, result);
+   }
+   p = bstr_lstrip(p, self->pEnd);
+   if (p == self->pEnd)
+   {
+      return bstr_json_cursor_fail(self, BSTR_PREMATURE_END_OF_BUFFER_ERROR);
+   }
+   if (*p == (uint8_t) ',')
+   {
+      return bstr_json_cursor_enter(self, bstr_lstrip(p + 1, self->pEnd), self->container, false);
+   }
+   if (*p != ((self->container == BSTR_JSON_OBJECT) ? (uint8_t) '}' : (uint8_t) ']'))
+   {
+      return bstr_json_cursor_fail(self, BSTR_PARSE_ERROR);
+   }
+   return false;
+}
+
+/**
+ * Moves the cursor from an object to the value of its first member named pKeyBegin..pKeyEnd (compared after
+ * unescaping). The values of the members before it are skipped without being parsed.
+ */
+bool bstr_json_cursor_find_bstr(bstr_json_cursor_t *self, const uint8_t *pKeyBegin, const uint8_t *pKeyEnd)
+{
+   bstr_json_cursor_t member;
+   if ( (pKeyBegin == 0) || (pKeyEnd < pKeyBegin) || (bstr_json_cursor_type(self) != BSTR_JSON_OBJECT) )
+   {
+      return false;
+   }
+   member = *self;
+   if (bstr_json_cursor_child(&member))
+   {
+      do
+      {
+         if (bstr_json_cursor_key_equals(&member, pKeyBegin, pKeyEnd))
+         {
+            *self = member;
+            return true;
+         }
+      } while (bstr_json_cursor_next(&member));
+   }
+   self->lastError = member.lastError;
+   return false;
+}
+
+bool bstr_json_cursor_find_cstr(bstr_json_cursor_t *self, const char *key)
+{
+   if (key == 0)
+   {
+      return false;
+   }
+   return bstr_json_cursor_find_bstr(self, (const uint8_t*) key, (const uint8_t*) key + strlen(key));
+}
+
+/**
+ * Moves the cursor from an array to element number index, skipping the elements before it.
+ */
+bool bstr_json_cursor_at(bstr_json_cursor_t *self, size_t index)
+{
+   bstr_json_cursor_t element;
+   if (bstr_json_cursor_type(self) != BSTR_JSON_ARRAY)
+   {
+      return false;
+   }
+   element = *self;
+   if (bstr_json_cursor_child(&element))
+   {
+      while (index > 0u)
+      {
+         if (!bstr_json_cursor_next(&element))
+         {
+            self->lastError = element.lastError;
+            return false;
+         }
+         index--;
+      }
+      *self = element;
+      return true;
+   }
+   self->lastError = element.lastError;
+   return false;
+}
+
+/**
+ * Moves the cursor to the value a JSON Pointer (RFC 6901) such as "/items/0/id" refers to, relative to the current
+ * value. "~1" and "~0" in a reference token stand for '/' and '~'. The empty pointer refers to the current value.
+ * A malformed pointer gives BSTR_INVALID_ARGUMENT_ERROR.
+ */
+bool bstr_json_cursor_pointer(bstr_json_cursor_t *self, const char *pointer)
+{
+   bstr_json_cursor_t cursor;
+   const char *pToken;
+   if ( (self == 0) || (pointer == 0) || (self->pValue == 0) )
+   {
+      return false;
+   }
+   if ( (*pointer != '\0') && (*pointer != '/') )
+   {
+      return bstr_json_cursor_fail(self, BSTR_INVALID_ARGUMENT_ERROR);
+   }
+   cursor = *self;
+   pToken = pointer;
+   while (*pToken == '/')
+   {
+      const char *pTokenEnd = ++pToken;
+      uint8_t type = bstr_json_cursor_type(&cursor);
+      bool isFound = false;
+      while ( (*pTokenEnd != '\0') && (*pTokenEnd != '/') )
+      {
+         pTokenEnd++;
+      }
+      if (type == BSTR_JSON_ARRAY)
+      {
+         size_t index;
+         isFound = bstr_json_pointer_index(pToken, pTokenEnd, &index) && bstr_json_cursor_at(&cursor, index);
+      }
+      else if (type == BSTR_JSON_OBJECT)
+      {
+         if (memchr(pToken, '~', (size_t) (pTokenEnd - pToken)) == 0)
+         {
+            isFound = bstr_json_cursor_find_bstr(&cursor, (const uint8_t*) pToken, (const uint8_t*) pTokenEnd);
+         }
+         else
+         {
+            bstr_buf_t key;
+            bstr_buf_create(&key, 0);
+            if (bstr_json_pointer_unescape(pToken, pTokenEnd, &key))
+            {
+               const uint8_t *pKeyBegin;
+               const uint8_t *pKeyEnd;
+               bstr_buf_view(&key, &pKeyBegin, &pKeyEnd);
+               isFound = bstr_json_cursor_find_bstr(&cursor, pKeyBegin, pKeyEnd);
+            }
+            else
+            {
+               cursor.lastError = BSTR_INVALID_ARGUMENT_ERROR;
+            }
+            bstr_buf_destroy(&key);
+         }
+      }
+      if (!isFound)
+      {
+         self->lastError = cursor.lastError;
+         return false;
+      }
+      pToken = pTokenEnd;
+   }
+   *self = cursor;
+   return true;
+}
+
+/**
+ * Gets the key of the current object member, see bstr_json_cursor_get_string.
+ */
+bool bstr_json_cursor_get_key(bstr_json_cursor_t *self, bstr_buf_t *buf, const uint8_t **ppBegin, const uint8_t **ppEnd)
+{
+   if ( (self == 0) || (self->pKeyBegin == 0) )
+   {
+      return false;
+   }
+   return bstr_json_cursor_decode(self, self->pKeyBegin - 1, buf, ppBegin, ppEnd);
+}
+
+/**
+ * Gets the bytes of the current value as they appear in the document, including quotes and brackets.
+ */
+bool bstr_json_cursor_get_raw(bstr_json_cursor_t *self, const uint8_t **ppBegin, const uint8_t **ppEnd)
+{
+   bstr_error_t result;
+   if ( (self == 0) || (self->pValue == 0) || (ppBegin == 0) || (ppEnd == 0) )
+   {
+      return false;
+   }
+   result = bstr_json_skip_value(self->pValue, self->pEnd, ppEnd);
+   if (result != BSTR_NO_ERROR)
+   {
+      return bstr_json_cursor_fail(self, result);
+   }
+   *ppBegin = self->pValue;
+   return true;
+}
+
+/**
+ * Gets the unescaped content of a string. Strings without escapes point into the document, others are appended to
+ * buf and point into it.
+ */
+bool bstr_json_cursor_get_string(bstr_json_cursor_t *self, bstr_buf_t *buf, const uint8_t **ppBegin, const uint8_t **ppEnd)
+{
+   if (bstr_json_cursor_type(self) != BSTR_JSON_STRING)
+   {
+      return false;
+   }
+   return bstr_json_cursor_decode(self, self->pValue, buf, ppBegin, ppEnd);
+}
+
+bool bstr_json_cursor_get_number(bstr_json_cursor_t *self, bstr_number_t *number)
+{
+   bstr_context_t ctx;
+   const uint8_t *pNext;
+   if ( (number == 0) || (bstr_json_cursor_type(self) != BSTR_JSON_NUMBER) )
+   {
+      return false;
+   }
+   bstr_context_create(&ctx);
+   pNext = bstr_parse_json_number(&ctx, self->pValue, self->pEnd, number);
+   if (pNext == 0)
+   {
+      return bstr_json_cursor_fail(self, (ctx.lastError != BSTR_NO_ERROR) ? ctx.lastError : BSTR_PARSE_ERROR);
+   }
+   if ( (pNext == self->pValue) || !bstr_json_is_scalar_end(pNext, self->pEnd) )
+   {
+      return bstr_json_cursor_fail(self, BSTR_PARSE_ERROR);
+   }
+   return true;
+}
+
+/**
+ * Gets an integer which fits in int64_t.
+ */
+bool bstr_json_cursor_get_int64(bstr_json_cursor_t *self, int64_t *result)
+{
+   bstr_number_t number;
+   if ( (result == 0) || !bstr_json_cursor_get_number(self, &number) || (number.type != BSTR_NUMBER_INT64) )
+   {
+      return false;
+   }
+   *result = number.value.i64;
+   return true;
+}
+
+/**
+ * Gets any number as double, integers are converted.
+ */
+bool bstr_json_cursor_get_double(bstr_json_cursor_t *self, double *result)
+{
+   bstr_number_t number;
+   if ( (result == 0) || !bstr_json_cursor_get_number(self, &number) )
+   {
+      return false;
+   }
+   if (number.type == BSTR_NUMBER_INT64)
+   {
+      *result = (double) number.value.i64;
+   }
+   else if (number.type == BSTR_NUMBER_UINT64)
+   {
+      *result = (double) number.value.u64;
+   }
+   else
+   {
+      *result = number.value.f64;
+   }
+   return true;
+}
+
+bool bstr_json_cursor_get_bool(bstr_json_cursor_t *self, bool *result)
+{
+   uint8_t type = bstr_json_cursor_type(self);
+   if ( (result == 0) || ( (type != BSTR_JSON_TRUE) && (type != BSTR_JSON_FALSE) ) )
+   {
+      return false;
+   }
+   *result = (type == BSTR_JSON_TRUE);
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns an array of at least required elements, data is reused when it is large enough. The old content is not kept.
+ */
+static void *bstr_json_reserve(const bstr_allocator_t *allocator, void *data, size_t *capacity, size_t required, size_t elementSize)
+{
+   if (*capacity < required)
+   {
+      bstr_allocator_free(allocator, data, *capacity * elementSize);
+      data = bstr_allocator_alloc(allocator, required * elementSize);
+      *capacity = (data != 0) ? required : 0u;
+   }
+   return data;
+}
+
+/**
+ * Stage 1: stores the offset of every structural byte in self->structurals.
+ */
+static bstr_error_t bstr_json_find_structurals(bstr_json_document_t *self)
+{
+   const bstr_simd_ops_t *ops = bstr_simd_ops();
+   uint64_t masks[BSTR_JSON_BATCH_BLOCKS];
+   bstr_json_scan_state_t state;
+   size_t length = (size_t) (self->pEnd - self->pBegin);
+   size_t numFullBlocks = length / 64u;
+   size_t block = 0u;
+   size_t count = 0u;
+   state.prevEscaped = 0u;
+   state.prevInString = 0u;
+   state.prevScalar = 0u;
+   while (block < numFullBlocks)
+   {
+      size_t numBlocks = numFullBlocks - block;
+      if (numBlocks > BSTR_JSON_BATCH_BLOCKS)
+      {
+         numBlocks = BSTR_JSON_BATCH_BLOCKS;
+      }
+      ops->json_structurals(self->pBegin + block * 64u, numBlocks, masks, &state);
+      count = bstr_json_flatten(masks, numBlocks, (uint32_t) (block * 64u), self->structurals, count);
+      block += numBlocks;
+   }
+   if (numFullBlocks * 64u < length)
+   {
+      //the last partial block is padded with whitespace which has no structural meaning
+      uint8_t tail[64];
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, self->pBegin + numFullBlocks * 64u, length - numFullBlocks * 64u);
+      ops->json_structurals(tail, 1u, masks, &state);
+      count = bstr_json_flatten(masks, 1u, (uint32_t) (numFullBlocks * 64u), self->structurals, count);
+   }
+   self->numStructurals = count;
+   if (state.prevInString != 0u)
+   {
+      //the opening quote of the unterminated string is the last structural
+      self->pError = self->pBegin + self->structurals[count - 1u];
+      return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+   }
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Appends the positions of the set bits of each mask. Positions are written eight at a time without checking how many
+ * bits are left, which keeps the loop free of mispredicted branches for typical densities. The sentinel bit makes the
+ * extra writes well defined, they are overwritten by the next block.
+ */
+static size_t bstr_json_flatten(const uint64_t *masks, size_t numBlocks, uint32_t offset, uint32_t *positions, size_t count)
+{
+   const uint64_t sentinel = (uint64_t) 1u << 63;
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      uint64_t mask = masks[i];
+      if (mask != 0u)
+      {
+         uint32_t *pOut = &positions[count];
+         uint32_t numBits = bstr_popcount64(mask);
+         uint32_t j;
+         for (j = 0u; j < 8u; j++)
+         {
+            pOut[j] = offset + bstr_ctz64(mask | sentinel);
+            mask &= mask - 1u;
+         }
+         if (numBits > 8u)
+         {
+            for (j = 8u; j < 16u; j++)
+            {
+               pOut[j] = offset + bstr_ctz64(mask | sentinel);
+               mask &= mask - 1u;
+            }
+         }
+         for (j = 16u; j < numBits; j++)
+         {
+            pOut[j] = offset + bstr_ctz64(mask);
+            mask &= mask - 1u;
+         }
+         count += numBits;
+      }
+      offset += 64u;
+   }
+   return count;
+}
+
+/**
+ * Stage 2: validates the sequence of structurals and writes the tape. Only the bytes at structural positions
+ * (and the scalars starting there) are looked at, whitespace has already been skipped by stage 1.
+ */
+static bstr_error_t bstr_json_build_tape(bstr_json_document_t *self)
+{
+   const uint8_t *pBegin = self->pBegin;
+   const uint32_t *structurals = self->structurals;
+   size_t numStructurals = self->numStructurals;
+   uint64_t *tape = self->tape;
+   uint32_t *stack = self->stack;
+   size_t tapeLen = 1u;
+   size_t pos = 0u;
+   uint32_t depth = 0u;
+   uint32_t state = STATE_VALUE;
+   const uint8_t *p = self->pEnd;
+   bstr_error_t result = BSTR_NO_ERROR;
+   bstr_context_t ctx;
+   bstr_context_create(&ctx);
+   ctx.allocator = self->allocator;
+   while (pos < numStructurals)
+   {
+      uint8_t c;
+      p = pBegin + structurals[pos++];
+      c = *p;
+      if (state == STATE_AFTER_VALUE)
+      {
+         uint32_t openIndex;
+         uint8_t openType;
+         uint32_t count;
+         if (depth == 0u)
+         {
+            result = BSTR_PARSE_ERROR; //content after the top-level value
+            break;
+         }
+         openIndex = stack[2u * (depth - 1u)];
+         openType = (uint8_t) (tape[openIndex] >> 56);
+         if (c == (uint8_t) ',')
+         {
+            stack[2u * (depth - 1u) + 1u]++;
+            state = (openType == BSTR_JSON_OBJECT) ? STATE_KEY : STATE_VALUE;
+            continue;
+         }
+         if (c != ((openType == BSTR_JSON_OBJECT) ? (uint8_t) '}' : (uint8_t) ']'))
+         {
+            result = BSTR_PARSE_ERROR;
+            break;
+         }
+         depth--;
+         count = stack[2u * depth + 1u];
+         if (count > TAPE_MAX_COUNT)
+         {
+            count = TAPE_MAX_COUNT;
+         }
+         tape[openIndex] = bstr_json_tape_entry(openType, ((uint64_t) count << 32) | (uint64_t) (tapeLen + 1u));
+         tape[tapeLen++] = bstr_json_tape_entry(c, openIndex);
+      }
+      else if (state == STATE_KEY)
+      {
+         result = (c == (uint8_t) '"') ? bstr_json_parse_string(self, &ctx, p, &tapeLen) : BSTR_PARSE_ERROR;
+         if (result != BSTR_NO_ERROR)
+         {
+            break;
+         }
+         p = (pos < numStructurals) ? pBegin + structurals[pos] : self->pEnd;
+         if (p == self->pEnd)
+         {
+            result = BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+            break;
+         }
+         if (*p != (uint8_t) ':')
+         {
+            result = BSTR_PARSE_ERROR;
+            break;
+         }
+         pos++;
+         state = STATE_VALUE;
+      }
+      else if ( (c == (uint8_t) '{') || (c == (uint8_t) '[') )
+      {
+         uint8_t close = (c == (uint8_t) '{') ? (uint8_t) '}' : (uint8_t) ']';
+         if ( (pos < numStructurals) && (pBegin[structurals[pos]] == close) )
+         {
+            pos++;
+            tape[tapeLen] = bstr_json_tape_entry(c, tapeLen + 2u);
+            tape[tapeLen + 1u] = bstr_json_tape_entry(close, tapeLen);
+            tapeLen += 2u;
+            state = STATE_AFTER_VALUE;
+         }
+         else
+         {
+            if (depth == BSTR_JSON_MAX_DEPTH)
+            {
+               result = BSTR_PARSE_ERROR;
+               break;
+            }
+            stack[2u * depth] = (uint32_t) tapeLen;
+            stack[2u * depth + 1u] = 1u;
+            depth++;
+            tape[tapeLen++] = bstr_json_tape_entry(c, 0u);
+            state = (c == (uint8_t) '{') ? STATE_KEY : STATE_VALUE;
+         }
+      }
+      else
+      {
+         result = bstr_json_parse_scalar(self, &ctx, p, &tapeLen);
+         if (result != BSTR_NO_ERROR)
+         {
+            break;
+         }
+         state = STATE_AFTER_VALUE;
+      }
+   }
+   if ( (result == BSTR_NO_ERROR) && ( (state != STATE_AFTER_VALUE) || (depth != 0u) ) )
+   {
+      p = self->pEnd;
+      result = BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+   }
+   if (result != BSTR_NO_ERROR)
+   {
+      self->pError = p;
+      return result;
+   }
+   tape[0] = bstr_json_tape_entry(TAPE_ROOT, tapeLen);
+   tape[tapeLen] = bstr_json_tape_entry(TAPE_ROOT, 0u);
+   self->tapeLen = tapeLen + 1u;
+   return BSTR_NO_ERROR;
+}
+
+static bstr_error_t bstr_json_parse_scalar(bstr_json_document_t *self, bstr_context_t *ctx, const uint8_t *p, size_t *tapeLen)
+{
+   uint64_t *entry = &self->tape[*tapeLen];
+   const uint8_t *pEnd = self->pEnd;
+   const uint8_t *pNext;
+   bstr_number_t number;
+   switch (*p)
+   {
+   case '"':
+      return bstr_json_parse_string(self, ctx, p, tapeLen);
+   case 't':
+      if (!bstr_json_is_literal(p, pEnd, "true", 4u))
+      {
+         return BSTR_PARSE_ERROR;
+      }
+      entry[0] = bstr_json_tape_entry(BSTR_JSON_TRUE, 0u);
+      *tapeLen += 1u;
+      return BSTR_NO_ERROR;
+   case 'f':
+      if (!bstr_json_is_literal(p, pEnd, "false", 5u))
+      {
+         return BSTR_PARSE_ERROR;
+      }
+      entry[0] = bstr_json_tape_entry(BSTR_JSON_FALSE, 0u);
+      *tapeLen += 1u;
+      return BSTR_NO_ERROR;
+   case 'n':
+      if (!bstr_json_is_literal(p, pEnd, "null", 4u))
+      {
+         return BSTR_PARSE_ERROR;
+      }
+      entry[0] = bstr_json_tape_entry(BSTR_JSON_NULL, 0u);
+      *tapeLen += 1u;
+      return BSTR_NO_ERROR;
+   default:
+      break;
+   }
+   if ( (*p != (uint8_t) '-') && ( (*p < (uint8_t) '0') || (*p > (uint8_t) '9') ) )
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   if (bstr_json_parse_small_integer(p, pEnd, entry))
+   {
+      *tapeLen += 2u;
+      return BSTR_NO_ERROR;
+   }
+   pNext = bstr_parse_json_number(ctx, p, pEnd, &number);
+   if (pNext == 0)
+   {
+      return (ctx->lastError != BSTR_NO_ERROR) ? ctx->lastError : BSTR_PARSE_ERROR;
+   }
+   if ( (pNext == p) || !bstr_json_is_scalar_end(pNext, pEnd) )
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   if (number.type == BSTR_NUMBER_INT64)
+   {
+      entry[0] = bstr_json_tape_entry(BSTR_JSON_INT64, 0u);
+      entry[1] = (uint64_t) number.value.i64;
+   }
+   else if (number.type == BSTR_NUMBER_UINT64)
+   {
+      entry[0] = bstr_json_tape_entry(BSTR_JSON_UINT64, 0u);
+      entry[1] = number.value.u64;
+   }
+   else
+   {
+      entry[0] = bstr_json_tape_entry(BSTR_JSON_DOUBLE, 0u);
+      memcpy(&entry[1], &number.value.f64, sizeof(double));
+   }
+   *tapeLen += 2u;
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Strings without escapes are stored as offset into the input, others are unescaped into self->strings.
+ */
+static bstr_error_t bstr_json_parse_string(bstr_json_document_t *self, bstr_context_t *ctx, const uint8_t *p, size_t *tapeLen)
+{
+   uint64_t *entry = &self->tape[*tapeLen];
+   size_t offset = self->strings.length;
+   const uint8_t *pStrBegin = p + 1;
+   const uint8_t *pStrEnd = bstr_simd_ops()->json_string(pStrBegin, self->pEnd);
+   bool isView = false;
+   const uint8_t *pNext;
+   if ( (pStrEnd < self->pEnd) && (*pStrEnd == (uint8_t) '"') )
+   {
+      //common case without escapes, the same check bstr_parse_json_string_view_buf starts with
+      entry[0] = bstr_json_tape_entry(BSTR_JSON_STRING, (uint64_t) (pStrBegin - self->pBegin));
+      entry[1] = (uint64_t) (pStrEnd - pStrBegin);
+      *tapeLen += 2u;
+      return BSTR_NO_ERROR;
+   }
+   pNext = bstr_parse_json_string_view_buf(ctx, p, self->pEnd, &pStrBegin, &pStrEnd, &self->strings, &isView);
+   if (pNext == 0)
+   {
+      return (ctx->lastError != BSTR_NO_ERROR) ? ctx->lastError : BSTR_PARSE_ERROR;
+   }
+   if (pNext == p)
+   {
+      return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+   }
+   if (isView)
+   {
+      entry[0] = bstr_json_tape_entry(BSTR_JSON_STRING, (uint64_t) (pStrBegin - self->pBegin));
+   }
+   else
+   {
+      entry[0] = bstr_json_tape_entry(BSTR_JSON_STRING, TAPE_STRING_IN_BUF | (uint64_t) offset);
+   }
+   entry[1] = (uint64_t) (pStrEnd - pStrBegin);
+   *tapeLen += 2u;
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Fast path for integers of up to 18 digits which are followed by a scalar end. Returns false for everything else,
+ * including malformed numbers, which are left to bstr_parse_json_number.
+ */
+static bool bstr_json_parse_small_integer(const uint8_t *p, const uint8_t *pEnd, uint64_t *entry)
+{
+   const uint8_t *pDigits = (*p == (uint8_t) '-') ? p + 1 : p;
+   const uint8_t *pNext = pDigits;
+   const uint8_t *pMax = ((size_t) (pEnd - pDigits) > 18u) ? pDigits + 18 : pEnd;
+   uint64_t value = 0u;
+   while ( (pNext < pMax) && ((uint8_t) (*pNext - '0') <= 9u) )
+   {
+      value = value * 10u + (uint8_t) (*pNext - '0');
+      pNext++;
+   }
+   if ( (pNext == pDigits) || ( (*pDigits == (uint8_t) '0') && (pNext - pDigits > 1) ) || !bstr_json_is_scalar_end(pNext, pEnd) )
+   {
+      return false;
+   }
+   entry[0] = bstr_json_tape_entry(BSTR_JSON_INT64, 0u);
+   entry[1] = (pDigits != p) ? (uint64_t) -(int64_t) value : value;
+   return true;
+}
+
+static bool bstr_json_is_literal(const uint8_t *p, const uint8_t *pEnd, const char *literal, size_t len)
+{
+   return ((size_t) (pEnd - p) >= len) && (memcmp(p, literal, len) == 0) && bstr_json_is_scalar_end(p + len, pEnd);
+}
+
+/**
+ * Numbers and literals must be followed by whitespace, an operator or the end of input.
+ */
+static inline bool bstr_json_is_scalar_end(const uint8_t *p, const uint8_t *pEnd)
+{
+   if (p == pEnd)
+   {
+      return true;
+   }
+   switch (*p)
+   {
+   case ' ': case '\t': case '\n': case '\r':
+   case ',': case ':': case '}': case ']': case '{': case '[':
+      return true;
+   default:
+      return false;
+   }
+}
+
+static inline uint64_t bstr_json_tape_entry(uint8_t type, uint64_t payload)
+{
+   return ((uint64_t) type << 56) | payload;
+}
+
+/**
+ * Returns the type byte of a tape entry or BSTR_JSON_NONE when index is outside the tape.
+ */
+static inline uint8_t bstr_json_tape_type(const bstr_json_document_t *document, size_t index)
+{
+   if ( (document == 0) || (index >= document->tapeLen) )
+   {
+      return BSTR_JSON_NONE;
+   }
+   return (uint8_t) (document->tape[index] >> 56);
+}
+
+/**
+ * Moves self to the member or element at p, the first byte after '{', '[' or ','. isFirst allows the container to be empty.
+ * self is only changed on success.
+ */
+static bool bstr_json_cursor_enter(bstr_json_cursor_t *self, const uint8_t *p, uint8_t container, bool isFirst)
+{
+   const uint8_t *pEnd = self->pEnd;
+   const uint8_t *pKeyBegin = 0;
+   const uint8_t *pKeyEnd = 0;
+   bool hasEscapes = false;
+   if (p == pEnd)
+   {
+      return bstr_json_cursor_fail(self, BSTR_PREMATURE_END_OF_BUFFER_ERROR);
+   }
+   if (*p == ((container == BSTR_JSON_OBJECT) ? (uint8_t) '}' : (uint8_t) ']'))
+   {
+      return isFirst ? false : bstr_json_cursor_fail(self, BSTR_PARSE_ERROR);
+   }
+   if (container == BSTR_JSON_OBJECT)
+   {
+      const uint8_t *pNext;
+      bstr_error_t result = (*p == (uint8_t) '"') ? bstr_json_skip_string(p, pEnd, &pNext, &hasEscapes) : BSTR_PARSE_ERROR;
+      if (result != BSTR_NO_ERROR)
+      {
+         return bstr_json_cursor_fail(self, result);
+      }
+      pKeyBegin = p + 1;
+      pKeyEnd = pNext - 1;
+      p = bstr_lstrip(pNext, pEnd);
+      if ( (p < pEnd) && (*p != (uint8_t) ':') )
+      {
+         return bstr_json_cursor_fail(self, BSTR_PARSE_ERROR);
+      }
+      p = (p < pEnd) ? bstr_lstrip(p + 1, pEnd) : pEnd;
+      if (p == pEnd)
+      {
+         return bstr_json_cursor_fail(self, BSTR_PREMATURE_END_OF_BUFFER_ERROR);
+      }
+   }
+   self->pValue = p;
+   self->pKeyBegin = pKeyBegin;
+   self->pKeyEnd = pKeyEnd;
+   self->container = container;
+   self->keyHasEscapes = hasEscapes;
+   return true;
+}
+
+static bool bstr_json_cursor_fail(bstr_json_cursor_t *self, bstr_error_t error)
+{
+   self->lastError = error;
+   return false;
+}
+
+static bool bstr_json_cursor_key_equals(const bstr_json_cursor_t *self, const uint8_t *pKeyBegin, const uint8_t *pKeyEnd)
+{
+   size_t keyLen = (size_t) (pKeyEnd - pKeyBegin);
+   bstr_buf_t buf;
+   bstr_context_t ctx;
+   bool isEqual;
+   if (!self->keyHasEscapes)
+   {
+      return ((size_t) (self->pKeyEnd - self->pKeyBegin) == keyLen) && (memcmp(self->pKeyBegin, pKeyBegin, keyLen) == 0);
+   }
+   bstr_context_create(&ctx);
+   bstr_buf_create(&buf, 0);
+   isEqual = (bstr_parse_json_string_literal_buf(&ctx, self->pKeyBegin - 1, self->pEnd, &buf) == self->pKeyEnd + 1) &&
+             (bstr_buf_length(&buf) == keyLen) && (memcmp(bstr_buf_data(&buf), pKeyBegin, keyLen) == 0);
+   bstr_buf_destroy(&buf);
+   return isEqual;
+}
+
+static bool bstr_json_cursor_decode(bstr_json_cursor_t *self, const uint8_t *pQuote, bstr_buf_t *buf, const uint8_t **ppBegin, const uint8_t **ppEnd)
+{
+   bstr_context_t ctx;
+   const uint8_t *pNext;
+   bool isView;
+   if ( (buf == 0) || (ppBegin == 0) || (ppEnd == 0) )
+   {
+      return bstr_json_cursor_fail(self, BSTR_INVALID_ARGUMENT_ERROR);
+   }
+   bstr_context_create(&ctx);
+   pNext = bstr_parse_json_string_view_buf(&ctx, pQuote, self->pEnd, ppBegin, ppEnd, buf, &isView);
+   if (pNext == 0)
+   {
+      return bstr_json_cursor_fail(self, (ctx.lastError != BSTR_NO_ERROR) ? ctx.lastError : BSTR_PARSE_ERROR);
+   }
+   if (pNext == pQuote)
+   {
+      return bstr_json_cursor_fail(self, BSTR_PREMATURE_END_OF_BUFFER_ERROR);
+   }
+   return true;
+}
+
+/**
+ * Array indices in JSON Pointers are decimal without leading zeros.
+ */
+static bool bstr_json_pointer_index(const char *pBegin, const char *pEnd, size_t *index)
+{
+   size_t value = 0u;
+   const char *p;
+   if ( (pBegin == pEnd) || ( (*pBegin == '0') && (pEnd - pBegin > 1) ) )
+   {
+      return false;
+   }
+   for (p = pBegin; p < pEnd; p++)
+   {
+      if ( ((uint8_t) (*p - '0') > 9u) || (value > ((size_t) -1 - 9u) / 10u) )
+      {
+         return false;
+      }
+      value = value * 10u + (size_t) (*p - '0');
+   }
+   *index = value;
+   return true;
+}
+
+static bool bstr_json_pointer_unescape(const char *pBegin, const char *pEnd, bstr_buf_t *buf)
+{
+   const char *p;
+   for (p = pBegin; p < pEnd; p++)
+   {
+      uint8_t c = (uint8_t) *p;
+      if (c == (uint8_t) '~')
+      {
+         if ( (p + 1 == pEnd) || ( (p[1] != '0') && (p[1] != '1') ) )
+         {
+            return false;
+         }
+         c = (p[1] == '0') ? (uint8_t) '~' : (uint8_t) '/';
+         p++;
+      }
+      if (bstr_buf_push(buf, c) != BSTR_NO_ERROR)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+/**
+ * Sets *ppNext to the first byte after the value at p. Only strings are validated, containers are checked for a
+ * matching bracket and scalars for their end.
+ */
+static bstr_error_t bstr_json_skip_value(const uint8_t *p, const uint8_t *pEnd, const uint8_t **ppNext)
+{
+   const uint8_t *pNext = p;
+   bool hasEscapes;
+   switch (*p)
+   {
+   case '{':
+   case '[':
+      return bstr_json_skip_container(p, pEnd, ppNext);
+   case '"':
+      return bstr_json_skip_string(p, pEnd, ppNext, &hasEscapes);
+   default:
+      break;
+   }
+   while (!bstr_json_is_scalar_end(pNext, pEnd))
+   {
+      pNext++;
+   }
+   if (pNext == p)
+   {
+      return BSTR_PARSE_ERROR;
+   }
+   *ppNext = pNext;
+   return BSTR_NO_ERROR;
+}
+
+static bstr_error_t bstr_json_skip_string(const uint8_t *p, const uint8_t *pEnd, const uint8_t **ppNext, bool *hasEscapes)
+{
+   const bstr_simd_ops_t *ops = bstr_simd_ops();
+   const uint8_t *pNext = p + 1;
+   *hasEscapes = false;
+   for (;;)
+   {
+      pNext = ops->json_string(pNext, pEnd);
+      if (pNext == pEnd)
+      {
+         return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+      }
+      if (*pNext == (uint8_t) '"')
+      {
+         *ppNext = pNext + 1;
+         return BSTR_NO_ERROR;
+      }
+      if (*pNext != (uint8_t) '\\')
+      {
+         return BSTR_INVALID_CHARACTER_ERROR; //control character or invalid UTF-8
+      }
+      if (pEnd - pNext < 2)
+      {
+         return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+      }
+      *hasEscapes = true;
+      pNext += 2;
+   }
+}
+
+/**
+ * Bracket skip without an index of the whole document: the blocks following the opening bracket are classified by the
+ * json_index kernel, which drops brackets inside strings, and blocks with fewer closing brackets than the current depth
+ * are passed over using population counts. Batches start at one block and double so that small containers stay cheap.
+ */
+static bstr_error_t bstr_json_skip_container(const uint8_t *p, const uint8_t *pEnd, const uint8_t **ppNext)
+{
+   const bstr_simd_ops_t *ops = bstr_simd_ops();
+   bstr_json_index_block_t blocks[BSTR_JSON_SKIP_MAX_BLOCKS];
+   bstr_json_scan_state_t state;
+   const uint8_t *pBlock = p + 1;
+   uint8_t close = (*p == (uint8_t) '{') ? (uint8_t) '}' : (uint8_t) ']';
+   size_t depth = 1u;
+   size_t numBlocks = 1u;
+   state.prevEscaped = 0u;
+   state.prevInString = 0u;
+   state.prevScalar = 0u;
+   while (pBlock < pEnd)
+   {
+      size_t numAvailable = (size_t) (pEnd - pBlock) / 64u;
+      size_t i;
+      if (numAvailable == 0u)
+      {
+         //the last partial block is padded with whitespace which has no structural meaning
+         uint8_t tail[64];
+         memset(tail, ' ', sizeof(tail));
+         memcpy(tail, pBlock, (size_t) (pEnd - pBlock));
+         numBlocks = 1u;
+         ops->json_index(tail, 1u, blocks, &state);
+      }
+      else
+      {
+         if (numBlocks > numAvailable)
+         {
+            numBlocks = numAvailable;
+         }
+         ops->json_index(pBlock, numBlocks, blocks, &state);
+      }
+      for (i = 0u; i < numBlocks; i++)
+      {
+         uint64_t opens = blocks[i].opens;
+         uint64_t closes = blocks[i].closes;
+         uint32_t numCloses = (closes != 0u) ? bstr_popcount64(closes) : 0u;
+         if (numCloses >= depth)
+         {
+            uint64_t mask = opens | closes;
+            while (mask != 0u)
+            {
+               uint64_t lowest = mask & (0u - mask);
+               if ( (closes & lowest) == 0u )
+               {
+                  depth++;
+               }
+               else if (--depth == 0u)
+               {
+                  const uint8_t *pClose = pBlock + i * 64u + bstr_ctz64(lowest);
+                  if (*pClose != close)
+                  {
+                     return BSTR_PARSE_ERROR;
+                  }
+                  *ppNext = pClose + 1;
+                  return BSTR_NO_ERROR;
+               }
+               mask ^= lowest;
+            }
+         }
+         else
+         {
+            depth = depth - numCloses + ((opens != 0u) ? bstr_popcount64(opens) : 0u);
+         }
+      }
+      pBlock += numBlocks * 64u;
+      if (numBlocks < BSTR_JSON_SKIP_MAX_BLOCKS)
+      {
+         numBlocks *= 2u;
+      }
+   }
+   return BSTR_PREMATURE_END_OF_BUFFER_ERROR;
+}
+
+/**
+ * Returns the tape index after the value at index.
+ */
+static size_t bstr_json_skip(const bstr_json_document_t *document, size_t index)
+{
+   uint64_t entry = document->tape[index];
+   switch ((uint8_t) (entry >> 56))
+   {
+   case '{':
+   case '[':
+      return (size_t) (uint32_t) entry;
+   case '"':
+   case 'l':
+   case 'u':
+   case 'd':
+      return index + 2u;
+   default:
+      return index + 1u;
+   }
+}
@@ -0,0 +1,757 @@
+/*****************************************************************************
+* \file      bstr_matcher.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Multi-pattern matching over bounded strings
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#include <stdlib.h>
+#include "bstr_matcher.h"
+#include "bstr_simd.h"
+#ifdef BSTR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define INVALID_STATE       0xFFFFFFFFu
+#define OUTPUT_FLAG         0x80000000u  //set on transitions into states which have outputs
+#define NUM_TEDDY_BUCKETS   8u
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void bstr_matcher_free_tables(bstr_matcher_t *self);
+static bstr_error_t bstr_matcher_build_dfa(bstr_matcher_t *self);
+static void bstr_matcher_build_teddy(bstr_matcher_t *self);
+static bool bstr_matcher_report(const bstr_matcher_t *self, const uint8_t *pMatchEnd, uint32_t patternIndex, bstr_match_func_t func, void *arg, size_t *count);
+static size_t bstr_matcher_scan_dfa(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_func_t func, void *arg);
+#ifdef BSTR_SIMD_X86
+static bool bstr_teddy_verify(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pPos, uint32_t bucketMask, bstr_match_func_t func, void *arg, size_t *count);
+static bool bstr_teddy_scan_tail(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pNext, const uint8_t *pEnd, bstr_match_func_t func, void *arg, size_t *count);
+static size_t bstr_teddy_scan_ssse3(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_func_t func, void *arg);
+static size_t bstr_teddy_scan_avx2(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_func_t func, void *arg);
+#endif
+static bool bstr_matcher_find_first(void *arg, const bstr_match_t *match);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+void bstr_matcher_create(bstr_matcher_t *self)
+{
+   bstr_matcher_create_a(self, 0);
+}
+
+/**
+ * Same as bstr_matcher_create but patterns and tables are allocated from allocator.
+ */
+void bstr_matcher_create_a(bstr_matcher_t *self, const bstr_allocator_t *allocator)
+{
+   if (self != 0)
+   {
+      memset(self, 0, sizeof(bstr_matcher_t));
+      self->allocator = allocator;
+   }
+}
+
+void bstr_matcher_destroy(bstr_matcher_t *self)
+{
+   if (self != 0)
+   {
+      const bstr_allocator_t *allocator = self->allocator;
+      bstr_matcher_free_tables(self);
+      bstr_allocator_free(allocator, self->patternData, self->patternDataCapacity);
+      bstr_allocator_free(allocator, self->patterns, self->patternsCapacity * sizeof(bstr_matcher_pattern_t));
+      memset(self, 0, sizeof(bstr_matcher_t));
+      self->allocator = allocator;
+   }
+}
+
+bstr_matcher_t *bstr_matcher_new(void)
+{
+   return bstr_matcher_new_a(0);
+}
+
+bstr_matcher_t *bstr_matcher_new_a(const bstr_allocator_t *allocator)
+{
+   bstr_matcher_t *self = (bstr_matcher_t*) bstr_allocator_alloc(allocator, sizeof(bstr_matcher_t));
+   if (self != 0)
+   {
+      bstr_matcher_create_a(self, allocator);
+   }
+   return self;
+}
+
+void bstr_matcher_delete(bstr_matcher_t *self)
+{
+   if (self != 0)
+   {
+      const bstr_allocator_t *allocator = self->allocator;
+      bstr_matcher_destroy(self);
+      bstr_allocator_free(allocator, self, sizeof(bstr_matcher_t));
+   }
+}
+
+/**
+ * Adds a pattern to the matcher. The pattern bytes are copied. Empty patterns are not allowed.
+ * Several patterns can share the same id. bstr_matcher_compile must be called before the next scan.
+ */
+bstr_error_t bstr_matcher_add_bstr(bstr_matcher_t *self, const uint8_t *pStrBegin, const uint8_t *pStrEnd, uint32_t patternId)
+{
+   size_t len;
+   if ( (self == 0) || (pStrBegin == 0) || (pStrEnd <= pStrBegin) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   len = (size_t) (pStrEnd - pStrBegin);
+   if (self->patternDataLen + len > self->patternDataCapacity)
+   {
+      size_t newCapacity = (self->patternDataCapacity == 0u)? 256u : self->patternDataCapacity * 2u;
+      uint8_t *newData;
+      while (newCapacity < self->patternDataLen + len)
+      {
+         newCapacity *= 2u;
+      }
+      newData = (uint8_t*) bstr_allocator_realloc(self->allocator, self->patternData, self->patternDataCapacity, newCapacity);
+      if (newData == 0)
+      {
+         return BSTR_MEM_ERROR;
+      }
+      self->patternData = newData;
+      self->patternDataCapacity = newCapacity;
+   }
+   if (self->numPatterns == self->patternsCapacity)
+   {
+      uint32_t newCapacity = (self->patternsCapacity == 0u)? 16u : self->patternsCapacity * 2u;
+      bstr_matcher_pattern_t *newPatterns = (bstr_matcher_pattern_t*) bstr_allocator_realloc(self->allocator, self->patterns,
+            self->patternsCapacity * sizeof(bstr_matcher_pattern_t), newCapacity * sizeof(bstr_matcher_pattern_t));
+      if (newPatterns == 0)
+      {
+         return BSTR_MEM_ERROR;
+      }
+      self->patterns = newPatterns;
+      self->patternsCapacity = newCapacity;
+   }
+   memcpy(self->patternData + self->patternDataLen, pStrBegin, len);
+   self->patterns[self->numPatterns].offset = self->patternDataLen;
+   self->patterns[self->numPatterns].length = len;
+   self->patterns[self->numPatterns].id = patternId;
+   self->patternDataLen += len;
+   self->numPatterns++;
+   self->isCompiled = false;
+   return BSTR_NO_ERROR;
+}
+
+bstr_error_t bstr_matcher_add_cstr(bstr_matcher_t *self, const char *cstr, uint32_t patternId)
+{
+   if (cstr == 0)
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   return bstr_matcher_add_bstr(self, (const uint8_t*) cstr, (const uint8_t*) cstr + strlen(cstr), patternId);
+}
+
+/**
+ * Builds the matching tables from the patterns added so far.
+ */
+bstr_error_t bstr_matcher_compile(bstr_matcher_t *self)
+{
+   bstr_error_t result;
+   if (self == 0)
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   bstr_matcher_free_tables(self);
+   result = bstr_matcher_build_dfa(self);
+   if (result != BSTR_NO_ERROR)
+   {
+      bstr_matcher_free_tables(self);
+      return result;
+   }
+   bstr_matcher_build_teddy(self);
+   self->isCompiled = true;
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Scans the buffer between \par pBegin and \par pEnd in a single pass and calls \par func for every
+ * (possibly overlapping) match. Matches are reported in order of their end position, matches ending at the
+ * same position are reported longest first and then in the order the patterns were added.
+ * \par func can be NULL in which case the matches are only counted.
+ * Returns the number of reported matches. A compiled matcher is not modified by scanning so the same
+ * matcher can be used from several threads at once.
+ */
+size_t bstr_matcher_scan(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_func_t func, void *arg)
+{
+   if ( (self == 0) || (!self->isCompiled) || (self->numPatterns == 0u) || (pBegin == 0) || (pBegin >= pEnd) )
+   {
+      return 0u;
+   }
+#ifdef BSTR_SIMD_X86
+   if (self->hasTeddy)
+   {
+      uint32_t features = bstr_simd_ops()->features;
+      if (features & BSTR_SIMD_AVX2)
+      {
+         return bstr_teddy_scan_avx2(self, pBegin, pEnd, func, arg);
+      }
+      else if (features & BSTR_SIMD_SSSE3)
+      {
+         return bstr_teddy_scan_ssse3(self, pBegin, pEnd, func, arg);
+      }
+   }
+#endif
+   return bstr_matcher_scan_dfa(self, pBegin, pEnd, func, arg);
+}
+
+/**
+ * Finds the first match (the one which ends first) and stores it in \par match.
+ * Returns match->pEnd on success, \par pBegin when there was no match or NULL on invalid arguments.
+ */
+const uint8_t *bstr_matcher_find(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_t *match)
+{
+   if ( (self == 0) || (!self->isCompiled) || (match == 0) || (pBegin > pEnd) )
+   {
+      return 0;
+   }
+   if (bstr_matcher_scan(self, pBegin, pEnd, bstr_matcher_find_first, match) > 0u)
+   {
+      return match->pEnd;
+   }
+   return pBegin;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void bstr_matcher_free_tables(bstr_matcher_t *self)
+{
+   if (self->transitions != 0)
+   {
+      bstr_allocator_free(self->allocator, self->transitions, self->transitionsLen * sizeof(uint32_t));
+      self->transitions = 0;
+      self->transitionsLen = 0u;
+   }
+   if (self->outputs != 0)
+   {
+      bstr_allocator_free(self->allocator, self->outputs, ((size_t) self->outputStart[self->numStates] + 1u) * sizeof(uint32_t));
+      self->outputs = 0;
+   }
+   if (self->outputStart != 0)
+   {
+      bstr_allocator_free(self->allocator, self->outputStart, ((size_t) self->numStates + 1u) * sizeof(uint32_t));
+      self->outputStart = 0;
+   }
+   self->numStates = 0u;
+   self->hasTeddy = false;
+   self->isCompiled = false;
+}
+
+/**
+ * Builds the Aho-Corasick automaton as a full DFA. Bytes which don't occur in any pattern share a single
+ * byte class which keeps each row of the transition table small.
+ */
+static bstr_error_t bstr_matcher_build_dfa(bstr_matcher_t *self)
+{
+   bool isUsed[256];
+   uint32_t numUsed = 0u;
+   uint32_t c;
+   uint32_t i;
+   uint32_t maxStates = 1u;
+   uint32_t numClasses;
+   uint32_t *fail = 0;
+   uint32_t *queue = 0;
+   uint32_t *ownCount = 0;
+   uint32_t *outCount = 0;
+   uint32_t *patternState = 0;
+   uint32_t queueHead = 0u;
+   uint32_t queueTail = 0u;
+   uint32_t numTrieStates = 0u;
+   bstr_error_t result = BSTR_MEM_ERROR;
+
+   memset(isUsed, 0, sizeof(isUsed));
+   for (i = 0u; i < self->patternDataLen; i++)
+   {
+      isUsed[self->patternData[i]] = true;
+   }
+   for (c = 0u; c < 256u; c++)
+   {
+      if (isUsed[c])
+      {
+         numUsed++;
+      }
+   }
+   if (numUsed == 256u)
+   {
+      for (c = 0u; c < 256u; c++)
+      {
+         self->classMap[c] = (uint8_t) c;
+      }
+      numClasses = 256u;
+   }
+   else
+   {
+      numClasses = 1u;
+      for (c = 0u; c < 256u; c++)
+      {
+         self->classMap[c] = isUsed[c]? (uint8_t) numClasses++ : 0u;
+      }
+   }
+   self->numClasses = numClasses;
+   if ((uint64_t) self->patternDataLen + 1u >= (uint64_t) OUTPUT_FLAG / numClasses)
+   {
+      return BSTR_MEM_ERROR; //the premultiplied state numbers would not fit
+   }
+   maxStates += (uint32_t) self->patternDataLen;
+
+   //trie
+   self->transitions = (uint32_t*) bstr_allocator_alloc(self->allocator, (size_t) maxStates * numClasses * sizeof(uint32_t));
+   self->transitionsLen = (size_t) maxStates * numClasses;
+   patternState = (uint32_t*) bstr_allocator_alloc(self->allocator, ((size_t) self->numPatterns + 1u) * sizeof(uint32_t));
+   if ( (self->transitions == 0) || (patternState == 0) )
+   {
+      goto cleanup;
+   }
+   memset(self->transitions, 0xFF, (size_t) maxStates * numClasses * sizeof(uint32_t));
+   self->numStates = 1u;
+   for (i = 0u; i < self->numPatterns; i++)
+   {
+      const uint8_t *pNext = self->patternData + self->patterns[i].offset;
+      const uint8_t *pPatternEnd = pNext + self->patterns[i].length;
+      uint32_t state = 0u;
+      for (; pNext < pPatternEnd; pNext++)
+      {
+         uint32_t *pEntry = &self->transitions[(size_t) state * numClasses + self->classMap[*pNext]];
+         if (*pEntry == INVALID_STATE)
+         {
+            *pEntry = self->numStates++;
+         }
+         state = *pEntry;
+      }
+      patternState[i] = state;
+   }
+
+   //failure links in breadth-first order, missing transitions are filled in from the failure state
+   numTrieStates = self->numStates;
+   fail = (uint32_t*) bstr_allocator_alloc(self->allocator, (size_t) numTrieStates * sizeof(uint32_t));
+   queue = (uint32_t*) bstr_allocator_alloc(self->allocator, (size_t) numTrieStates * sizeof(uint32_t));
+   ownCount = (uint32_t*) bstr_allocator_alloc(self->allocator, (size_t) numTrieStates * sizeof(uint32_t));
+   outCount = (uint32_t*) bstr_allocator_alloc(self->allocator, (size_t) numTrieStates * sizeof(uint32_t));
+   self->outputStart = (uint32_t*) bstr_allocator_alloc(self->allocator, ((size_t) numTrieStates + 1u) * sizeof(uint32_t));
+   if ( (fail == 0) || (queue == 0) || (ownCount == 0) || (outCount == 0) || (self->outputStart == 0) )
+   {
+      goto cleanup;
+   }
+   memset(ownCount, 0, (size_t) numTrieStates * sizeof(uint32_t));
+   memset(outCount, 0, (size_t) numTrieStates * sizeof(uint32_t));
+   fail[0] = 0u;
+   for (c = 0u; c < numClasses; c++)
+   {
+      uint32_t next = self->transitions[c];
+      if (next == INVALID_STATE)
+      {
+         self->transitions[c] = 0u;
+      }
+      else
+      {
+         fail[next] = 0u;
+         queue[queueTail++] = next;
+      }
+   }
+   while (queueHead < queueTail)
+   {
+      uint32_t state = queue[queueHead++];
+      uint32_t *row = &self->transitions[(size_t) state * numClasses];
+      const uint32_t *failRow = &self->transitions[(size_t) fail[state] * numClasses];
+      for (c = 0u; c < numClasses; c++)
+      {
+         if (row[c] == INVALID_STATE)
+         {
+            row[c] = failRow[c];
+         }
+         else
+         {
+            fail[row[c]] = failRow[c];
+            queue[queueTail++] = row[c];
+         }
+      }
+   }
+
+   //outputs, each state inherits the outputs of its failure state (which are always shorter)
+   for (i = 0u; i < self->numPatterns; i++)
+   {
+      ownCount[patternState[i]]++;
+   }
+   outCount[0] = 0u;
+   for (i = 0u; i < queueTail; i++)
+   {
+      uint32_t state = queue[i];
+      outCount[state] = ownCount[state] + outCount[fail[state]];
+   }
+   self->outputStart[0] = 0u;
+   for (i = 0u; i < self->numStates; i++)
+   {
+      self->outputStart[i + 1u] = self->outputStart[i] + outCount[i];
+   }
+   self->outputs = (uint32_t*) bstr_allocator_alloc(self->allocator, ((size_t) self->outputStart[self->numStates] + 1u) * sizeof(uint32_t));
+   if (self->outputs == 0)
+   {
+      goto cleanup;
+   }
+   memset(ownCount, 0, (size_t) self->numStates * sizeof(uint32_t));
+   for (i = 0u; i < self->numPatterns; i++)
+   {
+      uint32_t state = patternState[i];
+      self->outputs[self->outputStart[state] + ownCount[state]++] = i;
+   }
+   for (i = 0u; i < queueTail; i++)
+   {
+      uint32_t state = queue[i];
+      uint32_t failState = fail[state];
+      memcpy(&self->outputs[self->outputStart[state] + ownCount[state]], &self->outputs[self->outputStart[failState]],
+             (size_t) outCount[failState] * sizeof(uint32_t));
+   }
+
+   //premultiply the transitions by the row length and flag the transitions into states with outputs
+   for (i = 0u; i < self->numStates * numClasses; i++)
+   {
+      uint32_t next = self->transitions[i];
+      self->transitions[i] = (next * numClasses) | ((outCount[next] > 0u)? OUTPUT_FLAG : 0u);
+   }
+   if (self->numStates < maxStates)
+   {
+      uint32_t *shrunk = (uint32_t*) bstr_allocator_realloc(self->allocator, self->transitions, self->transitionsLen * sizeof(uint32_t),
+                                                            (size_t) self->numStates * numClasses * sizeof(uint32_t));
+      if (shrunk != 0)
+      {
+         self->transitions = shrunk;
+         self->transitionsLen = (size_t) self->numStates * numClasses;
+      }
+   }
+   result = BSTR_NO_ERROR;
+
+cleanup:
+   bstr_allocator_free(self->allocator, fail, (size_t) numTrieStates * sizeof(uint32_t));
+   bstr_allocator_free(self->allocator, queue, (size_t) numTrieStates * sizeof(uint32_t));
+   bstr_allocator_free(self->allocator, ownCount, (size_t) numTrieStates * sizeof(uint32_t));
+   bstr_allocator_free(self->allocator, outCount, (size_t) numTrieStates * sizeof(uint32_t));
+   bstr_allocator_free(self->allocator, patternState, ((size_t) self->numPatterns + 1u) * sizeof(uint32_t));
+   return result;
+}
+
+/**
+ * Teddy uses the last teddyLen bytes of each pattern as fingerprint. Patterns are sorted by fingerprint and
+ * spread over 8 buckets so that patterns with equal fingerprints always end up in the same bucket.
+ */
+static void bstr_matcher_build_teddy(bstr_matcher_t *self)
+{
+   uint32_t sorted[BSTR_TEDDY_MAX_PATTERNS];
+   uint32_t fingerprint[BSTR_TEDDY_MAX_PATTERNS];
+   size_t minLen = SIZE_MAX;
+   uint32_t i;
+   uint32_t j;
+   uint32_t k;
+   self->hasTeddy = false;
+   if ( (self->numPatterns == 0u) || (self->numPatterns > BSTR_TEDDY_MAX_PATTERNS) )
+   {
+      return;
+   }
+   for (i = 0u; i < self->numPatterns; i++)
+   {
+      if (self->patterns[i].length < minLen)
+      {
+         minLen = self->patterns[i].length;
+      }
+   }
+   self->teddyLen = (uint8_t) ((minLen < BSTR_TEDDY_MAX_FINGERPRINT)? minLen : BSTR_TEDDY_MAX_FINGERPRINT);
+   for (i = 0u; i < self->numPatterns; i++)
+   {
+      const uint8_t *pLast = self->patternData + self->patterns[i].offset + self->patterns[i].length - 1u;
+      fingerprint[i] = 0u;
+      for (k = 0u; k < self->teddyLen; k++)
+      {
+         fingerprint[i] = (fingerprint[i] << 8) | pLast[-(ptrdiff_t) k];
+      }
+      sorted[i] = i;
+   }
+   //insertion sort by fingerprint
+   for (i = 1u; i < self->numPatterns; i++)
+   {
+      uint32_t tmp = sorted[i];
+      for (j = i; (j > 0u) && (fingerprint[sorted[j - 1u]] > fingerprint[tmp]); j--)
+      {
+         sorted[j] = sorted[j - 1u];
+      }
+      sorted[j] = tmp;
+   }
+   memset(self->teddyLo, 0, sizeof(self->teddyLo));
+   memset(self->teddyHi, 0, sizeof(self->teddyHi));
+   for (i = 0u; i < self->numPatterns; i++)
+   {
+      uint32_t index = sorted[i];
+      uint8_t bucket;
+      const uint8_t *pLast = self->patternData + self->patterns[index].offset + self->patterns[index].length - 1u;
+      if ( (i > 0u) && (fingerprint[sorted[i - 1u]] == fingerprint[index]) )
+      {
+         bucket = self->teddyBucket[sorted[i - 1u]];
+      }
+      else
+      {
+         bucket = (uint8_t) ((i * NUM_TEDDY_BUCKETS) / self->numPatterns);
+      }
+      self->teddyBucket[index] = bucket;
+      for (k = 0u; k < self->teddyLen; k++)
+      {
+         uint8_t c = pLast[-(ptrdiff_t) k];
+         self->teddyLo[k][c & 0x0Fu] |= (uint8_t) (1u << bucket);
+         self->teddyHi[k][c >> 4] |= (uint8_t) (1u << bucket);
+      }
+   }
+   //verification order: longest first, then in the order the patterns were added
+   for (i = 0u; i < self->numPatterns; i++)
+   {
+      self->teddyOrder[i] = i;
+   }
+   for (i = 1u; i < self->numPatterns; i++)
+   {
+      uint32_t tmp = self->teddyOrder[i];
+      for (j = i; (j > 0u) && (self->patterns[self->teddyOrder[j - 1u]].length < self->patterns[tmp].length); j--)
+      {
+         self->teddyOrder[j] = self->teddyOrder[j - 1u];
+      }
+      self->teddyOrder[j] = tmp;
+   }
+   self->hasTeddy = true;
+}
+
+static bool bstr_matcher_report(const bstr_matcher_t *self, const uint8_t *pMatchEnd, uint32_t patternIndex, bstr_match_func_t func, void *arg, size_t *count)
+{
+   (*count)++;
+   if (func != 0)
+   {
+      bstr_match_t match;
+      match.pBegin = pMatchEnd - self->patterns[patternIndex].length;
+      match.pEnd = pMatchEnd;
+      match.patternId = self->patterns[patternIndex].id;
+      return func(arg, &match);
+   }
+   return true;
+}
+
+static size_t bstr_matcher_scan_dfa(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_func_t func, void *arg)
+{
+   const uint32_t *transitions = self->transitions;
+   const uint8_t *classMap = self->classMap;
+   const uint8_t *pNext = pBegin;
+   uint32_t row = 0u;
+   size_t count = 0u;
+   while (pNext < pEnd)
+   {
+      uint32_t next = transitions[row + classMap[*pNext++]];
+      row = next & ~OUTPUT_FLAG;
+      if (next & OUTPUT_FLAG)
+      {
+         uint32_t state = row / self->numClasses;
+         uint32_t i;
+         for (i = self->outputStart[state]; i < self->outputStart[state + 1u]; i++)
+         {
+            if (!bstr_matcher_report(self, pNext, self->outputs[i], func, arg, &count))
+            {
+               return count;
+            }
+         }
+      }
+   }
+   return count;
+}
+
+#ifdef BSTR_SIMD_X86
+
+/**
+ * Verifies all patterns in the buckets of bucketMask whose last byte is at pPos.
+ */
+static bool bstr_teddy_verify(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pPos, uint32_t bucketMask, bstr_match_func_t func, void *arg, size_t *count)
+{
+   uint32_t i;
+   const uint8_t *pMatchEnd = pPos + 1;
+   size_t avail = (size_t) (pMatchEnd - pBegin);
+   for (i = 0u; i < self->numPatterns; i++)
+   {
+      uint32_t index = self->teddyOrder[i];
+      const bstr_matcher_pattern_t *pattern = &self->patterns[index];
+      if ( ((bucketMask >> self->teddyBucket[index]) & 1u) && (pattern->length <= avail) &&
+           (memcmp(pMatchEnd - pattern->length, self->patternData + pattern->offset, pattern->length) == 0) )
+      {
+         if (!bstr_matcher_report(self, pMatchEnd, index, func, arg, count))
+         {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+/**
+ * Handles the positions from pNext to pEnd which the vector loop could not process.
+ */
+static bool bstr_teddy_scan_tail(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pNext, const uint8_t *pEnd, bstr_match_func_t func, void *arg, size_t *count)
+{
+   for (; pNext < pEnd; pNext++)
+   {
+      uint32_t bucketMask = 0xFFu;
+      uint32_t k;
+      if ((size_t) (pNext - pBegin) + 1u < self->teddyLen)
+      {
+         continue;
+      }
+      for (k = 0u; k < self->teddyLen; k++)
+      {
+         uint8_t c = pNext[-(ptrdiff_t) k];
+         bucketMask &= self->teddyLo[k][c & 0x0Fu] & self->teddyHi[k][c >> 4];
+      }
+      if ( (bucketMask != 0u) && !bstr_teddy_verify(self, pBegin, pNext, bucketMask, func, arg, count) )
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+BSTR_TARGET("ssse3")
+static size_t bstr_teddy_scan_ssse3(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_func_t func, void *arg)
+{
+   const __m128i lowMask = _mm_set1_epi8(0x0F);
+   const uint32_t fingerprintLen = self->teddyLen;
+   const uint8_t *pNext = pBegin + (fingerprintLen - 1u); //first position where a pattern can end
+   __m128i lo[BSTR_TEDDY_MAX_FINGERPRINT];
+   __m128i hi[BSTR_TEDDY_MAX_FINGERPRINT];
+   size_t count = 0u;
+   uint32_t k;
+   if ((size_t) (pEnd - pBegin) < fingerprintLen)
+   {
+      return 0u;
+   }
+   for (k = 0u; k < fingerprintLen; k++)
+   {
+      lo[k] = _mm_loadu_si128((const __m128i*) self->teddyLo[k]);
+      hi[k] = _mm_loadu_si128((const __m128i*) self->teddyHi[k]);
+   }
+   while (pEnd - pNext >= 16)
+   {
+      __m128i buckets = _mm_set1_epi8((char) 0xFF);
+      uint32_t mask;
+      for (k = 0u; k < fingerprintLen; k++)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i*) (pNext - k));
+         __m128i vlo = _mm_and_si128(v, lowMask);
+         __m128i vhi = _mm_and_si128(_mm_srli_epi16(v, 4), lowMask);
+         buckets = _mm_and_si128(buckets, _mm_and_si128(_mm_shuffle_epi8(lo[k], vlo), _mm_shuffle_epi8(hi[k], vhi)));
+      }
+      mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(buckets, _mm_setzero_si128())) ^ 0xFFFFu;
+      if (mask != 0u)
+      {
+         uint8_t bucketBytes[16];
+         _mm_storeu_si128((__m128i*) bucketBytes, buckets);
+         while (mask != 0u)
+         {
+            uint32_t j = bstr_ctz32(mask);
+            if (!bstr_teddy_verify(self, pBegin, pNext + j, bucketBytes[j], func, arg, &count))
+            {
+               return count;
+            }
+            mask &= mask - 1u;
+         }
+      }
+      pNext += 16;
+   }
+   (void) bstr_teddy_scan_tail(self, pBegin, pNext, pEnd, func, arg, &count);
+   return count;
+}
+
+BSTR_TARGET("avx2")
+static size_t bstr_teddy_scan_avx2(const bstr_matcher_t *self, const uint8_t *pBegin, const uint8_t *pEnd, bstr_match_func_t func, void *arg)
+{
+   const __m256i lowMask = _mm256_set1_epi8(0x0F);
+   const uint32_t fingerprintLen = self->teddyLen;
+   const uint8_t *pNext = pBegin + (fingerprintLen - 1u);
+   __m256i lo[BSTR_TEDDY_MAX_FINGERPRINT];
+   __m256i hi[BSTR_TEDDY_MAX_FINGERPRINT];
+   size_t count = 0u;
+   uint32_t k;
+   if ((size_t) (pEnd - pBegin) < fingerprintLen)
+   {
+      return 0u;
+   }
+   for (k = 0u; k < fingerprintLen; k++)
+   {
+      lo[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) self->teddyLo[k]));
+      hi[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) self->teddyHi[k]));
+   }
+   while (pEnd - pNext >= 32)
+   {
+      __m256i buckets = _mm256_set1_epi8((char) 0xFF);
+      uint32_t mask;
+      for (k = 0u; k < fingerprintLen; k++)
+      {
+         __m256i v = _mm256_loadu_si256((const __m256i*) (pNext - k));
+         __m256i vlo = _mm256_and_si256(v, lowMask);
+         __m256i vhi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+         buckets = _mm256_and_si256(buckets, _mm256_and_si256(_mm256_shuffle_epi8(lo[k], vlo), _mm256_shuffle_epi8(hi[k], vhi)));
+      }
+      mask = ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(buckets, _mm256_setzero_si256()));
+      if (mask != 0u)
+      {
+         uint8_t bucketBytes[32];
+         _mm256_storeu_si256((__m256i*) bucketBytes, buckets);
+         while (mask != 0u)
+         {
+            uint32_t j = bstr_ctz32(mask);
+            if (!bstr_teddy_verify(self, pBegin, pNext + j, bucketBytes[j], func, arg, &count))
+            {
+               return count;
+            }
+            mask &= mask - 1u;
+         }
+      }
+      pNext += 32;
+   }
+   (void) bstr_teddy_scan_tail(self, pBegin, pNext, pEnd, func, arg, &count);
+   return count;
+}
+
+#endif //BSTR_SIMD_X86
+
+static bool bstr_matcher_find_first(void *arg, const bstr_match_t *match)
+{
+   *(bstr_match_t*) arg = *match;
+   return false;
+}
@@ -0,0 +1,521 @@
+/*****************************************************************************
+* \file      bstr_parallel.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Parallel processing of line-oriented input such as NDJSON on a work-stealing thread pool
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include "bstr_parallel.h"
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#if defined(_WIN32)
+typedef HANDLE bstr_thread_t;
+typedef CRITICAL_SECTION bstr_mutex_t;
+#else
+typedef pthread_t bstr_thread_t;
+typedef pthread_mutex_t bstr_mutex_t;
+#endif
+
+struct bstr_parallel_job_tag;
+
+/**
+ * Each worker owns the chunks head..tail-1. It takes chunks from the head of its own range and steals half of the
+ * remaining range from the tail of another worker when its own range is empty.
+ */
+typedef struct bstr_parallel_worker_tag
+{
+   bstr_mutex_t lock;
+   size_t head;
+   size_t tail;
+   unsigned id;
+   bool isStarted;
+   bstr_thread_t thread;
+   struct bstr_parallel_job_tag *job;
+} bstr_parallel_worker_t;
+
+typedef struct bstr_parallel_job_tag
+{
+   bstr_parallel_line_func_t func;
+   void *arg;
+   const bstr_allocator_t *allocator;
+   const uint8_t **boundaries;         //numChunks+1 entries, chunk i is boundaries[i]..boundaries[i+1]
+   size_t numChunks;
+   bstr_parallel_worker_t *workers;
+   unsigned numWorkers;
+   bstr_mutex_t lock;                  //protects the members below
+   bool isStopped;
+   bstr_error_t lastError;
+   //ordered mode
+   bstr_buf_t *output;
+   bstr_buf_t *chunkOutputs;           //numChunks entries
+   uint8_t *isChunkDone;               //numChunks entries, 1 when completed and 2 when cut short by func
+   size_t nextChunkToMerge;
+} bstr_parallel_job_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static size_t bstr_parallel_split(bstr_parallel_job_t *job, const uint8_t *pBegin, const uint8_t *pEnd, size_t numChunks);
+static void bstr_parallel_run(bstr_parallel_worker_t *self);
+static bool bstr_parallel_take(bstr_parallel_worker_t *self, size_t *chunk);
+static bool bstr_parallel_process(bstr_parallel_job_t *job, unsigned worker, size_t chunk);
+static void bstr_parallel_finish(bstr_parallel_job_t *job, size_t chunk, bool isCompleted);
+static void bstr_parallel_stop(bstr_parallel_job_t *job);
+static inline const uint8_t *bstr_parallel_line_end(const uint8_t *pBegin, const uint8_t *pEnd);
+static void bstr_mutex_init(bstr_mutex_t *mutex);
+static void bstr_mutex_destroy(bstr_mutex_t *mutex);
+static void bstr_mutex_lock(bstr_mutex_t *mutex);
+static void bstr_mutex_unlock(bstr_mutex_t *mutex);
+static bool bstr_thread_start(bstr_parallel_worker_t *worker);
+static void bstr_thread_join(bstr_parallel_worker_t *worker);
+#if defined(_WIN32)
+static DWORD WINAPI bstr_thread_main(LPVOID arg);
+#else
+static void *bstr_thread_main(void *arg);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+void bstr_parallel_options_create(bstr_parallel_options_t *self)
+{
+   if (self != 0)
+   {
+      self->numThreads = 0u;
+      self->minChunkSize = 0u;
+      self->allocator = 0;
+   }
+}
+
+/**
+ * Returns the number of online processors, 1 when it can't be determined.
+ */
+unsigned bstr_parallel_num_processors(void)
+{
+#if defined(_WIN32)
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   return (info.dwNumberOfProcessors > 0u) ? (unsigned) info.dwNumberOfProcessors : 1u;
+#elif defined(_SC_NPROCESSORS_ONLN)
+   long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+   return (numProcessors > 0) ? (unsigned) numProcessors : 1u;
+#else
+   return 1u;
+#endif
+}
+
+/**
+ * Returns the number of workers bstr_parallel_lines uses with options (NULL selects the default options),
+ * which is the upper bound of the worker argument given to the line callback.
+ */
+unsigned bstr_parallel_num_threads(const bstr_parallel_options_t *options)
+{
+   unsigned numThreads = ( (options != 0) && (options->numThreads > 0u) ) ? options->numThreads : bstr_parallel_num_processors();
+   return (numThreads > BSTR_PARALLEL_MAX_THREADS) ? BSTR_PARALLEL_MAX_THREADS : numThreads;
+}
+
+/**
+ * Calls func for each line of pBegin..pEnd from a pool of worker threads, the calling thread being one of them.
+ * The input is split into chunks ending after a '\n' (BSTR_PARALLEL_CHUNKS_PER_THREAD per worker but at least
+ * minChunkSize bytes each). Lines are visited in order within a chunk while chunks run concurrently. A final line
+ * without '\n' is visited as well, a '\n' at the very end doesn't start another line.
+ *
+ * Ordered mode is selected by giving an output buffer. Every chunk then gets a buffer of its own which func appends
+ * its results to, and these are appended to output in input order as soon as all chunks before them are done.
+ *
+ * When func returns false, the chunks not yet started are skipped and the others run to completion before this
+ * function returns BSTR_NO_ERROR. In ordered mode output then holds the results up to the first unfinished chunk.
+ */
+bstr_error_t bstr_parallel_lines(const uint8_t *pBegin, const uint8_t *pEnd, bstr_parallel_line_func_t func, void *arg, const bstr_parallel_options_t *options, bstr_buf_t *output)
+{
+   bstr_parallel_job_t job;
+   size_t minChunkSize = ( (options != 0) && (options->minChunkSize > 0u) ) ? options->minChunkSize : BSTR_PARALLEL_DEFAULT_MIN_CHUNK;
+   size_t length;
+   size_t maxChunks;
+   size_t numAllocated;                //chunk count the arrays are allocated for, the split may use fewer
+   size_t i;
+   unsigned numThreads;
+   unsigned w;
+   if ( (pBegin == 0) || (pEnd == 0) || (pEnd < pBegin) || (func == 0) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   length = (size_t) (pEnd - pBegin);
+   if (length == 0u)
+   {
+      return BSTR_NO_ERROR;
+   }
+   numThreads = bstr_parallel_num_threads(options);
+   maxChunks = (length - 1u) / minChunkSize + 1u;
+   job.numChunks = (size_t) numThreads * BSTR_PARALLEL_CHUNKS_PER_THREAD;
+   if (job.numChunks > maxChunks)
+   {
+      job.numChunks = maxChunks;
+   }
+   if ((size_t) numThreads > job.numChunks)
+   {
+      numThreads = (unsigned) job.numChunks;
+   }
+   numAllocated = job.numChunks;
+   job.func = func;
+   job.arg = arg;
+   job.allocator = (options != 0) ? options->allocator : 0;
+   job.numWorkers = numThreads;
+   job.isStopped = false;
+   job.lastError = BSTR_NO_ERROR;
+   job.output = output;
+   job.chunkOutputs = 0;
+   job.isChunkDone = 0;
+   job.nextChunkToMerge = 0u;
+   job.boundaries = (const uint8_t**) bstr_allocator_alloc(job.allocator, (numAllocated + 1u) * sizeof(const uint8_t*));
+   job.workers = (bstr_parallel_worker_t*) bstr_allocator_alloc(job.allocator, numThreads * sizeof(bstr_parallel_worker_t));
+   if (output != 0)
+   {
+      job.chunkOutputs = (bstr_buf_t*) bstr_allocator_alloc(job.allocator, numAllocated * sizeof(bstr_buf_t));
+      job.isChunkDone = (uint8_t*) bstr_allocator_alloc(job.allocator, numAllocated);
+   }
+   if ( (job.boundaries == 0) || (job.workers == 0) || ( (output != 0) && ( (job.chunkOutputs == 0) || (job.isChunkDone == 0) ) ) )
+   {
+      job.lastError = BSTR_MEM_ERROR;
+   }
+   else
+   {
+      job.numChunks = bstr_parallel_split(&job, pBegin, pEnd, numAllocated);
+      if (output != 0)
+      {
+         for (i = 0u; i < job.numChunks; i++)
+         {
+            bstr_buf_create(&job.chunkOutputs[i], job.allocator);
+         }
+         memset(job.isChunkDone, 0, job.numChunks);
+      }
+      bstr_mutex_init(&job.lock);
+      for (w = 0u; w < numThreads; w++)
+      {
+         bstr_parallel_worker_t *worker = &job.workers[w];
+         bstr_mutex_init(&worker->lock);
+         worker->head = job.numChunks * w / numThreads;
+         worker->tail = job.numChunks * (w + 1u) / numThreads;
+         worker->id = w;
+         worker->isStarted = false;
+         worker->job = &job;
+      }
+      //when a thread can't be started its chunks are stolen by the others, at worst all of them by the calling thread
+      for (w = 1u; w < numThreads; w++)
+      {
+         job.workers[w].isStarted = bstr_thread_start(&job.workers[w]);
+      }
+      bstr_parallel_run(&job.workers[0]);
+      for (w = 1u; w < numThreads; w++)
+      {
+         if (job.workers[w].isStarted)
+         {
+            bstr_thread_join(&job.workers[w]);
+         }
+      }
+      for (w = 0u; w < numThreads; w++)
+      {
+         bstr_mutex_destroy(&job.workers[w].lock);
+      }
+      bstr_mutex_destroy(&job.lock);
+      if (output != 0)
+      {
+         for (i = 0u; i < job.numChunks; i++)
+         {
+            bstr_buf_destroy(&job.chunkOutputs[i]);
+         }
+      }
+   }
+   bstr_allocator_free(job.allocator, job.isChunkDone, (job.isChunkDone != 0) ? numAllocated : 0u);
+   bstr_allocator_free(job.allocator, job.chunkOutputs, (job.chunkOutputs != 0) ? numAllocated * sizeof(bstr_buf_t) : 0u);
+   bstr_allocator_free(job.allocator, job.workers, numThreads * sizeof(bstr_parallel_worker_t));
+   bstr_allocator_free(job.allocator, job.boundaries, (numAllocated + 1u) * sizeof(const uint8_t*));
+   return job.lastError;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Fills in the chunk boundaries. Each one is moved back to just after the last '\n' before its even split point, or
+ * forward past the next '\n' when the preceding text has none. Returns the number of chunks, which is smaller than
+ * numChunks when lines are longer than chunks.
+ */
+static size_t bstr_parallel_split(bstr_parallel_job_t *job, const uint8_t *pBegin, const uint8_t *pEnd, size_t numChunks)
+{
+   bstr_byteset_t newline;
+   size_t length = (size_t) (pEnd - pBegin);
+   size_t numBoundaries = 1u;
+   size_t i;
+   bstr_byteset_create_cstr(&newline, "\n");
+   job->boundaries[0] = pBegin;
+   for (i = 1u; i < numChunks; i++)
+   {
+      const uint8_t *pPrev = job->boundaries[numBoundaries - 1u];
+      const uint8_t *pSplit = pBegin + (length / numChunks) * i + (length % numChunks) * i / numChunks;
+      const uint8_t *pLineEnd;
+      if (pSplit <= pPrev)
+      {
+         continue;
+      }
+      pLineEnd = bstr_search_any_reverse(pPrev, pSplit, &newline);
+      if (pLineEnd == pSplit)
+      {
+         pLineEnd = bstr_parallel_line_end(pSplit, pEnd);
+      }
+      if ( (pLineEnd == pEnd) || (pLineEnd + 1 == pEnd) )
+      {
+         break;
+      }
+      job->boundaries[numBoundaries++] = pLineEnd + 1;
+   }
+   job->boundaries[numBoundaries] = pEnd;
+   return numBoundaries;
+}
+
+static void bstr_parallel_run(bstr_parallel_worker_t *self)
+{
+   bstr_parallel_job_t *job = self->job;
+   size_t chunk;
+   while (bstr_parallel_take(self, &chunk))
+   {
+      bool isStopped;
+      bool isCompleted = false;
+      bstr_mutex_lock(&job->lock);
+      isStopped = job->isStopped;
+      bstr_mutex_unlock(&job->lock);
+      if (!isStopped)
+      {
+         isCompleted = bstr_parallel_process(job, self->id, chunk);
+         if (!isCompleted)
+         {
+            bstr_parallel_stop(job);
+         }
+      }
+      if (job->output != 0)
+      {
+         bstr_parallel_finish(job, chunk, isCompleted);
+      }
+   }
+}
+
+static bool bstr_parallel_take(bstr_parallel_worker_t *self, size_t *chunk)
+{
+   bstr_parallel_job_t *job = self->job;
+   unsigned i;
+   bstr_mutex_lock(&self->lock);
+   if (self->head < self->tail)
+   {
+      *chunk = self->head++;
+      bstr_mutex_unlock(&self->lock);
+      return true;
+   }
+   bstr_mutex_unlock(&self->lock);
+   //only one lock is held at a time so that workers stealing from each other can't deadlock
+   for (i = 1u; i < job->numWorkers; i++)
+   {
+      bstr_parallel_worker_t *victim = &job->workers[(self->id + i) % job->numWorkers];
+      size_t head = 0u;
+      size_t tail = 0u;
+      bstr_mutex_lock(&victim->lock);
+      if (victim->head < victim->tail)
+      {
+         tail = victim->tail;
+         head = tail - (tail - victim->head + 1u) / 2u;
+         victim->tail = head;
+      }
+      bstr_mutex_unlock(&victim->lock);
+      if (head < tail)
+      {
+         *chunk = head;
+         bstr_mutex_lock(&self->lock);
+         self->head = head + 1u;
+         self->tail = tail;
+         bstr_mutex_unlock(&self->lock);
+         return true;
+      }
+   }
+   return false;
+}
+
+static bool bstr_parallel_process(bstr_parallel_job_t *job, unsigned worker, size_t chunk)
+{
+   const uint8_t *pNext = job->boundaries[chunk];
+   const uint8_t *pChunkEnd = job->boundaries[chunk + 1u];
+   bstr_buf_t *out = (job->output != 0) ? &job->chunkOutputs[chunk] : 0;
+   while (pNext < pChunkEnd)
+   {
+      const uint8_t *pLineEnd = bstr_parallel_line_end(pNext, pChunkEnd);
+      if (!job->func(job->arg, worker, pNext, pLineEnd, out))
+      {
+         return false;
+      }
+      pNext = (pLineEnd < pChunkEnd) ? pLineEnd + 1 : pChunkEnd;
+   }
+   return true;
+}
+
+/**
+ * Appends the output of all chunks which are done and have no unfinished chunk before them.
+ */
+static void bstr_parallel_finish(bstr_parallel_job_t *job, size_t chunk, bool isCompleted)
+{
+   bstr_mutex_lock(&job->lock);
+   job->isChunkDone[chunk] = isCompleted ? 1u : 2u;
+   while ( (job->nextChunkToMerge < job->numChunks) && (job->isChunkDone[job->nextChunkToMerge] == 1u) &&
+           (job->lastError == BSTR_NO_ERROR) )
+   {
+      bstr_buf_t *chunkOutput = &job->chunkOutputs[job->nextChunkToMerge];
+      const uint8_t *pDataBegin;
+      const uint8_t *pDataEnd;
+      bstr_buf_view(chunkOutput, &pDataBegin, &pDataEnd);
+      if (bstr_buf_append_bstr(job->output, pDataBegin, pDataEnd) != BSTR_NO_ERROR)
+      {
+         job->isStopped = true;
+         job->lastError = BSTR_MEM_ERROR;
+      }
+      bstr_buf_destroy(chunkOutput);
+      job->nextChunkToMerge++;
+   }
+   bstr_mutex_unlock(&job->lock);
+}
+
+static void bstr_parallel_stop(bstr_parallel_job_t *job)
+{
+   bstr_mutex_lock(&job->lock);
+   job->isStopped = true;
+   bstr_mutex_unlock(&job->lock);
+}
+
+/**
+ * Returns the '\n' ending the line at pBegin or pEnd when there is none (bstr_line returns pBegin in that case).
+ */
+static inline const uint8_t *bstr_parallel_line_end(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const uint8_t *pLineEnd = bstr_line(pBegin, pEnd);
+   return ( (pLineEnd < pEnd) && (*pLineEnd == (uint8_t) '\n') ) ? pLineEnd : pEnd;
+}
+
+#if defined(_WIN32)
+
+static DWORD WINAPI bstr_thread_main(LPVOID arg)
+{
+   bstr_parallel_run((bstr_parallel_worker_t*) arg);
+   return 0;
+}
+
+static void bstr_mutex_init(bstr_mutex_t *mutex)
+{
+   InitializeCriticalSection(mutex);
+}
+
+static void bstr_mutex_destroy(bstr_mutex_t *mutex)
+{
+   DeleteCriticalSection(mutex);
+}
+
+static void bstr_mutex_lock(bstr_mutex_t *mutex)
+{
+   EnterCriticalSection(mutex);
+}
+
+static void bstr_mutex_unlock(bstr_mutex_t *mutex)
+{
+   LeaveCriticalSection(mutex);
+}
+
+static bool bstr_thread_start(bstr_parallel_worker_t *worker)
+{
+   worker->thread = CreateThread(0, 0, bstr_thread_main, worker, 0, 0);
+   return (worker->thread != 0);
+}
+
+static void bstr_thread_join(bstr_parallel_worker_t *worker)
+{
+   WaitForSingleObject(worker->thread, INFINITE);
+   CloseHandle(worker->thread);
+}
+
+#else
+
+static void *bstr_thread_main(void *arg)
+{
+   bstr_parallel_run((bstr_parallel_worker_t*) arg);
+   return 0;
+}
+
+static void bstr_mutex_init(bstr_mutex_t *mutex)
+{
+   (void) pthread_mutex_init(mutex, 0);
+}
+
+static void bstr_mutex_destroy(bstr_mutex_t *mutex)
+{
+   (void) pthread_mutex_destroy(mutex);
+}
+
+static void bstr_mutex_lock(bstr_mutex_t *mutex)
+{
+   (void) pthread_mutex_lock(mutex);
+}
+
+static void bstr_mutex_unlock(bstr_mutex_t *mutex)
+{
+   (void) pthread_mutex_unlock(mutex);
+}
+
+static bool bstr_thread_start(bstr_parallel_worker_t *worker)
+{
+   return (pthread_create(&worker->thread, 0, bstr_thread_main, worker) == 0);
+}
+
+static void bstr_thread_join(bstr_parallel_worker_t *worker)
+{
+   (void) pthread_join(worker->thread, 0);
+}
+
+#endif
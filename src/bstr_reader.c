@@ -0,0 +1,681 @@
+/*****************************************************************************
+* \file      bstr_reader.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Buffered reader handing out line and token views from a file descriptor
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE //memfd_create
+#elif !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__) && defined(BSTR_HAVE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#include "bstr_reader.h"
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define BSTR_READER_MAX_READ ((size_t) 1u << 30)   //largest single read, io_uring takes 32-bit lengths
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+#define BSTR_READER_HAVE_RING
+#endif
+
+#if defined(__linux__) && defined(BSTR_HAVE_IO_URING)
+#define BSTR_READER_URING_READ     1u   //user_data of read requests
+#define BSTR_READER_URING_CANCEL   2u   //user_data of cancel requests
+
+/**
+ * Submission and completion rings shared with the kernel. Only one read is in flight at a time.
+ */
+typedef struct bstr_reader_uring_tag
+{
+   int ringFd;
+   uint8_t *sqRing;
+   size_t sqRingSize;
+   uint8_t *cqRing;
+   size_t cqRingSize;
+   struct io_uring_sqe *sqes;
+   size_t sqesSize;
+   unsigned *sqTail;
+   unsigned *sqMask;
+   unsigned *sqArray;
+   unsigned *cqHead;
+   unsigned *cqTail;
+   unsigned *cqMask;
+   struct io_uring_cqe *cqes;
+} bstr_reader_uring_t;
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static bool bstr_reader_next(bstr_reader_t *self, const bstr_byteset_t *separators, const uint8_t **ppBegin, const uint8_t **ppEnd);
+static bool bstr_reader_fill(bstr_reader_t *self);
+static size_t bstr_reader_make_space(bstr_reader_t *self);
+static bool bstr_reader_grow(bstr_reader_t *self);
+static void bstr_reader_read_ahead(bstr_reader_t *self);
+static bool bstr_reader_submit(bstr_reader_t *self, size_t length);
+static ptrdiff_t bstr_reader_complete(bstr_reader_t *self);
+static uint8_t *bstr_reader_alloc(bstr_reader_t *self, size_t *capacity, bool isRing);
+static void bstr_reader_free(bstr_reader_t *self, uint8_t *buffer, size_t capacity, bool isRing);
+static inline uint8_t *bstr_reader_ptr(const bstr_reader_t *self, uint64_t pos);
+static inline size_t bstr_reader_space(const bstr_reader_t *self);
+#if defined(__linux__) && defined(BSTR_HAVE_IO_URING)
+static bool bstr_reader_uring_create(bstr_reader_t *self);
+static void bstr_reader_uring_destroy(bstr_reader_t *self);
+static bool bstr_reader_uring_submit(bstr_reader_t *self, uint8_t opcode, uint64_t addr, uint32_t len, uint64_t userData);
+static int bstr_reader_uring_wait(bstr_reader_t *self);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Creates a reader of fd, which stays owned by the caller. capacity 0 selects BSTR_READER_DEFAULT_CAPACITY, ring
+ * buffers round it up to the page size. The buffer grows when a line doesn't fit.
+ * The flags field tells which of the requested features are in use.
+ */
+bstr_error_t bstr_reader_create(bstr_reader_t *self, int fd, size_t capacity, uint32_t flags, const bstr_allocator_t *allocator)
+{
+   if ( (self == 0) || (fd < 0) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   self->bufferPos = 0u;
+   self->pinPos = 0u;
+   self->viewPos = 0u;
+   self->nextPos = 0u;
+   self->endPos = 0u;
+   self->pendingPos = 0u;
+   self->fd = fd;
+   self->flags = 0u;
+   self->isPinned = false;
+   self->isEof = false;
+   self->lastError = BSTR_NO_ERROR;
+   self->allocator = allocator;
+   self->uring = 0;
+   self->capacity = (capacity > 0u) ? capacity : BSTR_READER_DEFAULT_CAPACITY;
+   self->buffer = bstr_reader_alloc(self, &self->capacity, (flags & BSTR_READER_RING) != 0u);
+   if ( (self->buffer == 0) && (flags & BSTR_READER_RING) )
+   {
+      self->buffer = bstr_reader_alloc(self, &self->capacity, false);
+   }
+   else if (flags & BSTR_READER_RING)
+   {
+      self->flags |= BSTR_READER_RING;
+   }
+   if (self->buffer == 0)
+   {
+      return BSTR_MEM_ERROR;
+   }
+#if defined(__linux__) && defined(BSTR_HAVE_IO_URING)
+   if ( (flags & BSTR_READER_IO_URING) && bstr_reader_uring_create(self) )
+   {
+      self->flags |= BSTR_READER_IO_URING;
+      bstr_reader_read_ahead(self);
+   }
+#endif
+   return BSTR_NO_ERROR;
+}
+
+void bstr_reader_destroy(bstr_reader_t *self)
+{
+   if (self != 0)
+   {
+#if defined(__linux__) && defined(BSTR_HAVE_IO_URING)
+      bstr_reader_uring_destroy(self);
+#endif
+      bstr_reader_free(self, self->buffer, self->capacity, (self->flags & BSTR_READER_RING) != 0u);
+      self->buffer = 0;
+      self->capacity = 0u;
+   }
+}
+
+/**
+ * Gets the next line without its '\n' (a '\r' before it is kept). A final line without '\n' is returned at the end
+ * of the stream. Returns false at the end of the stream, on errors (see lastError) and when a non-blocking descriptor
+ * has no complete line yet, in which case bstr_reader_eof is false and lastError is BSTR_NO_ERROR.
+ */
+bool bstr_reader_next_line(bstr_reader_t *self, const uint8_t **ppBegin, const uint8_t **ppEnd)
+{
+   return bstr_reader_next(self, 0, ppBegin, ppEnd);
+}
+
+/**
+ * Gets the next token ending before a member of separators, which is consumed. Consecutive separators give empty
+ * tokens. Otherwise it works like bstr_reader_next_line.
+ */
+bool bstr_reader_next_token(bstr_reader_t *self, const bstr_byteset_t *separators, const uint8_t **ppBegin, const uint8_t **ppEnd)
+{
+   if (separators == 0)
+   {
+      return false;
+   }
+   return bstr_reader_next(self, separators, ppBegin, ppEnd);
+}
+
+/**
+ * Keeps the last view and all later ones valid and in place until bstr_reader_unpin. The buffer is neither compacted
+ * nor grown meanwhile, so reading fails with BSTR_MEM_ERROR when the pinned data and the next line don't fit. The
+ * read can be retried after bstr_reader_unpin.
+ */
+void bstr_reader_pin(bstr_reader_t *self)
+{
+   if ( (self != 0) && !self->isPinned )
+   {
+      self->isPinned = true;
+      self->pinPos = self->viewPos;
+   }
+}
+
+void bstr_reader_unpin(bstr_reader_t *self)
+{
+   if (self != 0)
+   {
+      self->isPinned = false;
+   }
+}
+
+/**
+ * Returns true when the end of the stream was reached and all data has been handed out.
+ */
+bool bstr_reader_eof(const bstr_reader_t *self)
+{
+   return (self == 0) || ( self->isEof && (self->nextPos == self->endPos) );
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Finds the next separator (a '\n' when separators is NULL), reading more data until there is one.
+ */
+static bool bstr_reader_next(bstr_reader_t *self, const bstr_byteset_t *separators, const uint8_t **ppBegin, const uint8_t **ppEnd)
+{
+   uint64_t scanPos;
+   uint64_t viewEnd;
+   size_t separatorLen = 1u;
+   if ( (self == 0) || (ppBegin == 0) || (ppEnd == 0) || (self->buffer == 0) )
+   {
+      return false;
+   }
+   if (self->lastError != BSTR_IO_ERROR)
+   {
+      self->lastError = BSTR_NO_ERROR; //a full buffer is retried, the caller may have unpinned
+   }
+   self->viewPos = self->nextPos; //the previous view is released
+   scanPos = self->nextPos;
+   for (;;)
+   {
+      if (scanPos < self->endPos)
+      {
+         const uint8_t *pScan = bstr_reader_ptr(self, scanPos);
+         const uint8_t *pEnd = pScan + (size_t) (self->endPos - scanPos);
+         const uint8_t *pFound = (separators == 0) ? bstr_line(pScan, pEnd) : bstr_search_any(pScan, pEnd, separators);
+         bool isFound = (separators == 0) ? ( (pFound < pEnd) && (*pFound == (uint8_t) '\n') ) :
+                                            ( (pFound < pEnd) && bstr_byteset_contains(separators, *pFound) );
+         if (isFound)
+         {
+            viewEnd = scanPos + (uint64_t) (pFound - pScan);
+            break;
+         }
+         scanPos = self->endPos;
+      }
+      if (!bstr_reader_fill(self))
+      {
+         if ( !self->isEof || (self->nextPos == self->endPos) )
+         {
+            return false;
+         }
+         viewEnd = self->endPos;
+         separatorLen = 0u;
+         break;
+      }
+   }
+   //positions are resolved last since filling may have moved the data
+   *ppBegin = bstr_reader_ptr(self, self->nextPos);
+   *ppEnd = *ppBegin + (size_t) (viewEnd - self->nextPos);
+   self->nextPos = viewEnd + separatorLen;
+   return true;
+}
+
+/**
+ * Reads more data after endPos, or waits for the read in flight. Returns false at the end of the stream, on errors and
+ * when a non-blocking descriptor has no data.
+ */
+static bool bstr_reader_fill(bstr_reader_t *self)
+{
+   ptrdiff_t result;
+   if ( self->isEof || (self->lastError == BSTR_IO_ERROR) )
+   {
+      return false;
+   }
+   if (self->pendingPos == self->endPos)
+   {
+      size_t length = bstr_reader_make_space(self);
+      if (length == 0u)
+      {
+         return false;
+      }
+      if (!bstr_reader_submit(self, length))
+      {
+         self->lastError = BSTR_IO_ERROR;
+         return false;
+      }
+   }
+   result = bstr_reader_complete(self);
+   self->pendingPos = self->endPos;
+   if (result > 0)
+   {
+      self->endPos += (uint64_t) result;
+      self->pendingPos = self->endPos;
+      bstr_reader_read_ahead(self);
+      return true;
+   }
+   if (result == 0)
+   {
+      self->isEof = true;
+   }
+   else if ( (result != -EAGAIN) && (result != -EWOULDBLOCK) )
+   {
+      errno = (int) -result;
+      self->lastError = BSTR_IO_ERROR;
+   }
+   return false;
+}
+
+/**
+ * Returns the number of bytes which can be read after endPos. Unpinned data is moved to the front of a linear buffer
+ * when less than a quarter of it is free, and the buffer is grown when it's full.
+ */
+static size_t bstr_reader_make_space(bstr_reader_t *self)
+{
+   size_t space = bstr_reader_space(self);
+   if ( !self->isPinned && ((self->flags & BSTR_READER_RING) == 0u) && (space < self->capacity / 4u) && (self->nextPos > self->bufferPos) )
+   {
+      size_t used = (size_t) (self->endPos - self->nextPos);
+      memmove(self->buffer, bstr_reader_ptr(self, self->nextPos), used);
+      self->bufferPos = self->nextPos;
+      space = self->capacity - used;
+   }
+   if (space == 0u)
+   {
+      if ( self->isPinned || !bstr_reader_grow(self) )
+      {
+         self->lastError = BSTR_MEM_ERROR;
+         return 0u;
+      }
+      space = bstr_reader_space(self);
+   }
+   return (space > BSTR_READER_MAX_READ) ? BSTR_READER_MAX_READ : space;
+}
+
+static bool bstr_reader_grow(bstr_reader_t *self)
+{
+   bool isRing = (self->flags & BSTR_READER_RING) != 0u;
+   size_t capacity = self->capacity * 2u;
+   size_t used = (size_t) (self->endPos - self->nextPos);
+   uint8_t *buffer;
+   if (capacity < self->capacity)
+   {
+      return false;
+   }
+   buffer = bstr_reader_alloc(self, &capacity, isRing);
+   if (buffer == 0)
+   {
+      return false;
+   }
+   memcpy(isRing ? buffer + (size_t) (self->nextPos % capacity) : buffer, bstr_reader_ptr(self, self->nextPos), used);
+   bstr_reader_free(self, self->buffer, self->capacity, isRing);
+   self->buffer = buffer;
+   self->capacity = capacity;
+   self->bufferPos = self->nextPos;
+   return true;
+}
+
+/**
+ * With io_uring the next read is submitted right away, so that it runs while the caller works on the view it's about
+ * to get. It only uses free space, nothing is moved while views are handed out.
+ */
+static void bstr_reader_read_ahead(bstr_reader_t *self)
+{
+   if ( (self->uring != 0) && !self->isEof && (self->pendingPos == self->endPos) )
+   {
+      size_t space = bstr_reader_space(self);
+      if ( (space > 0u) && (space >= self->capacity / 4u) )
+      {
+         (void) bstr_reader_submit(self, (space > BSTR_READER_MAX_READ) ? BSTR_READER_MAX_READ : space);
+      }
+   }
+}
+
+static bool bstr_reader_submit(bstr_reader_t *self, size_t length)
+{
+#if defined(__linux__) && defined(BSTR_HAVE_IO_URING)
+   if ( (self->uring != 0) &&
+        !bstr_reader_uring_submit(self, IORING_OP_READ, (uint64_t) (uintptr_t) bstr_reader_ptr(self, self->endPos), (uint32_t) length, BSTR_READER_URING_READ) )
+   {
+      return false;
+   }
+#endif
+   self->pendingPos = self->endPos + length;
+   return true;
+}
+
+/**
+ * Completes the read of pendingPos-endPos bytes at endPos. Returns the number of bytes read, 0 at the end of the
+ * stream or a negated errno value.
+ */
+static ptrdiff_t bstr_reader_complete(bstr_reader_t *self)
+{
+   size_t length = (size_t) (self->pendingPos - self->endPos);
+#if defined(__linux__) && defined(BSTR_HAVE_IO_URING)
+   if (self->uring != 0)
+   {
+      return (ptrdiff_t) bstr_reader_uring_wait(self);
+   }
+#endif
+   for (;;)
+   {
+#if defined(_WIN32)
+      int result = _read(self->fd, bstr_reader_ptr(self, self->endPos), (unsigned) ((length > INT_MAX) ? INT_MAX : length));
+#else
+      ssize_t result = read(self->fd, bstr_reader_ptr(self, self->endPos), length);
+#endif
+      if (result >= 0)
+      {
+         return (ptrdiff_t) result;
+      }
+      if (errno != EINTR)
+      {
+         return (ptrdiff_t) -errno;
+      }
+   }
+}
+
+/**
+ * Allocates a buffer of at least *capacity bytes. Ring buffers map the same pages twice in a row so that any
+ * capacity bytes starting inside the buffer are contiguous in memory.
+ */
+static uint8_t *bstr_reader_alloc(bstr_reader_t *self, size_t *capacity, bool isRing)
+{
+   if (!isRing)
+   {
+      return (uint8_t*) bstr_allocator_alloc(self->allocator, *capacity);
+   }
+#if defined(BSTR_READER_HAVE_RING)
+   {
+      long pageSize = sysconf(_SC_PAGESIZE);
+      size_t size;
+      int memfd;
+      uint8_t *base;
+      if ( (pageSize <= 0) || (*capacity > ((size_t) -1) / 4u) )
+      {
+         return 0;
+      }
+      size = (*capacity + (size_t) pageSize - 1u) / (size_t) pageSize * (size_t) pageSize;
+      memfd = memfd_create("bstr_reader", MFD_CLOEXEC);
+      if (memfd < 0)
+      {
+         return 0;
+      }
+      base = (uint8_t*) mmap(0, 2u * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if ( (ftruncate(memfd, (off_t) size) != 0) || (base == (uint8_t*) MAP_FAILED) ||
+           (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd, 0) == MAP_FAILED) ||
+           (mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd, 0) == MAP_FAILED) )
+      {
+         if (base != (uint8_t*) MAP_FAILED)
+         {
+            (void) munmap(base, 2u * size);
+         }
+         (void) close(memfd);
+         return 0;
+      }
+      (void) close(memfd); //the mappings keep the memory alive
+      *capacity = size;
+      return base;
+   }
+#else
+   return 0;
+#endif
+}
+
+static void bstr_reader_free(bstr_reader_t *self, uint8_t *buffer, size_t capacity, bool isRing)
+{
+   if (buffer != 0)
+   {
+#if defined(BSTR_READER_HAVE_RING)
+      if (isRing)
+      {
+         (void) munmap(buffer, 2u * capacity);
+         return;
+      }
+#else
+      (void) isRing;
+#endif
+      bstr_allocator_free(self->allocator, buffer, capacity);
+   }
+}
+
+static inline uint8_t *bstr_reader_ptr(const bstr_reader_t *self, uint64_t pos)
+{
+   if (self->flags & BSTR_READER_RING)
+   {
+      return self->buffer + (size_t) (pos % self->capacity);
+   }
+   return self->buffer + (size_t) (pos - self->bufferPos);
+}
+
+/**
+ * Returns the free space after endPos without moving anything. The last view and pinned data are kept.
+ */
+static inline size_t bstr_reader_space(const bstr_reader_t *self)
+{
+   if (self->flags & BSTR_READER_RING)
+   {
+      uint64_t keepPos = self->isPinned ? self->pinPos : self->viewPos;
+      return self->capacity - (size_t) (self->endPos - keepPos);
+   }
+   return self->capacity - (size_t) (self->endPos - self->bufferPos);
+}
+
+#if defined(__linux__) && defined(BSTR_HAVE_IO_URING)
+
+/**
+ * Sets up a small io_uring instance. Fails on kernels without IORING_FEAT_RW_CUR_POS (5.6), which is needed to read
+ * at the current position of pipes and sockets, and where io_uring is disabled. The reader then uses read().
+ */
+static bool bstr_reader_uring_create(bstr_reader_t *self)
+{
+   struct io_uring_params params;
+   bstr_reader_uring_t *uring;
+   int ringFd;
+   memset(&params, 0, sizeof(params));
+   ringFd = (int) syscall(__NR_io_uring_setup, 2u, &params);
+   if (ringFd < 0)
+   {
+      return false;
+   }
+   uring = (bstr_reader_uring_t*) bstr_allocator_alloc(self->allocator, sizeof(bstr_reader_uring_t));
+   if ( (uring == 0) || ((params.features & IORING_FEAT_RW_CUR_POS) == 0u) )
+   {
+      bstr_allocator_free(self->allocator, uring, sizeof(bstr_reader_uring_t));
+      (void) close(ringFd);
+      return false;
+   }
+   uring->ringFd = ringFd;
+   uring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+   uring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+   uring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+   if (params.features & IORING_FEAT_SINGLE_MMAP)
+   {
+      if (uring->cqRingSize > uring->sqRingSize)
+      {
+         uring->sqRingSize = uring->cqRingSize;
+      }
+      uring->cqRingSize = uring->sqRingSize;
+   }
+   uring->sqRing = (uint8_t*) mmap(0, uring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+   uring->cqRing = (uint8_t*) MAP_FAILED;
+   uring->sqes = (struct io_uring_sqe*) MAP_FAILED;
+   if (uring->sqRing != (uint8_t*) MAP_FAILED)
+   {
+      uring->cqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? uring->sqRing :
+                      (uint8_t*) mmap(0, uring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+      uring->sqes = (struct io_uring_sqe*) mmap(0, uring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+   }
+   self->uring = uring;
+   if ( (uring->sqRing == (uint8_t*) MAP_FAILED) || (uring->cqRing == (uint8_t*) MAP_FAILED) || (uring->sqes == (struct io_uring_sqe*) MAP_FAILED) )
+   {
+      bstr_reader_uring_destroy(self);
+      return false;
+   }
+   uring->sqTail = (unsigned*) (uring->sqRing + params.sq_off.tail);
+   uring->sqMask = (unsigned*) (uring->sqRing + params.sq_off.ring_mask);
+   uring->sqArray = (unsigned*) (uring->sqRing + params.sq_off.array);
+   uring->cqHead = (unsigned*) (uring->cqRing + params.cq_off.head);
+   uring->cqTail = (unsigned*) (uring->cqRing + params.cq_off.tail);
+   uring->cqMask = (unsigned*) (uring->cqRing + params.cq_off.ring_mask);
+   uring->cqes = (struct io_uring_cqe*) (uring->cqRing + params.cq_off.cqes);
+   return true;
+}
+
+/**
+ * Cancels the read in flight and waits for it, the kernel must be done with the buffer before it's freed.
+ */
+static void bstr_reader_uring_destroy(bstr_reader_t *self)
+{
+   bstr_reader_uring_t *uring = (bstr_reader_uring_t*) self->uring;
+   if (uring == 0)
+   {
+      return;
+   }
+   if ( (self->pendingPos != self->endPos) && (uring->sqes != (struct io_uring_sqe*) MAP_FAILED) )
+   {
+      if (bstr_reader_uring_submit(self, IORING_OP_ASYNC_CANCEL, BSTR_READER_URING_READ, 0u, BSTR_READER_URING_CANCEL))
+      {
+         (void) bstr_reader_uring_wait(self);
+      }
+      self->pendingPos = self->endPos;
+   }
+   if (uring->sqes != (struct io_uring_sqe*) MAP_FAILED)
+   {
+      (void) munmap(uring->sqes, uring->sqesSize);
+   }
+   if ( (uring->cqRing != (uint8_t*) MAP_FAILED) && (uring->cqRing != uring->sqRing) )
+   {
+      (void) munmap(uring->cqRing, uring->cqRingSize);
+   }
+   if (uring->sqRing != (uint8_t*) MAP_FAILED)
+   {
+      (void) munmap(uring->sqRing, uring->sqRingSize);
+   }
+   (void) close(uring->ringFd);
+   bstr_allocator_free(self->allocator, uring, sizeof(bstr_reader_uring_t));
+   self->uring = 0;
+}
+
+static bool bstr_reader_uring_submit(bstr_reader_t *self, uint8_t opcode, uint64_t addr, uint32_t len, uint64_t userData)
+{
+   bstr_reader_uring_t *uring = (bstr_reader_uring_t*) self->uring;
+   unsigned tail = *uring->sqTail;
+   unsigned index = tail & *uring->sqMask;
+   struct io_uring_sqe *sqe = &uring->sqes[index];
+   long result;
+   memset(sqe, 0, sizeof(struct io_uring_sqe));
+   sqe->opcode = opcode;
+   sqe->fd = -1;
+   sqe->addr = addr;
+   sqe->len = len;
+   if (opcode == IORING_OP_READ)
+   {
+      sqe->fd = self->fd;
+      sqe->off = (uint64_t) -1; //current file position
+   }
+   sqe->user_data = userData;
+   uring->sqArray[index] = index;
+   __atomic_store_n(uring->sqTail, tail + 1u, __ATOMIC_RELEASE);
+   do
+   {
+      result = syscall(__NR_io_uring_enter, uring->ringFd, 1u, 0u, 0u, (void*) 0, 0u);
+   } while ( (result < 0) && (errno == EINTR) );
+   return (result == 1);
+}
+
+/**
+ * Waits for the completion of the read in flight and returns its result, completions of cancel requests are skipped.
+ */
+static int bstr_reader_uring_wait(bstr_reader_t *self)
+{
+   bstr_reader_uring_t *uring = (bstr_reader_uring_t*) self->uring;
+   for (;;)
+   {
+      unsigned head = *uring->cqHead;
+      if (head != __atomic_load_n(uring->cqTail, __ATOMIC_ACQUIRE))
+      {
+         struct io_uring_cqe *cqe = &uring->cqes[head & *uring->cqMask];
+         int result = cqe->res;
+         uint64_t userData = cqe->user_data;
+         __atomic_store_n(uring->cqHead, head + 1u, __ATOMIC_RELEASE);
+         if (userData == BSTR_READER_URING_READ)
+         {
+            return result;
+         }
+      }
+      else if ( (syscall(__NR_io_uring_enter, uring->ringFd, 0u, 1u, IORING_ENTER_GETEVENTS, (void*) 0, 0u) < 0) && (errno != EINTR) )
+      {
+         return -errno;
+      }
+   }
+}
+
+#endif
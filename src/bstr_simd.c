@@ -0,0 +1,1915 @@
+/*****************************************************************************
+* \file      bstr_simd.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Private SIMD kernels and CPU dispatch for bstr
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#include "bstr_simd.h"
+#ifdef BSTR_SIMD_X86
+#include <immintrin.h>
+#if !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+//candidate verification may cost this many bytes plus twice the number of bytes scanned
+#define FIND_WORK_ALLOWANCE 1024u
+
+//UTF-8 error classes of the Keiser-Lemire validator, one bit per class
+#define UTF8_TOO_SHORT      0x01u
+#define UTF8_TOO_LONG       0x02u
+#define UTF8_OVERLONG_3     0x04u
+#define UTF8_TOO_LARGE      0x08u
+#define UTF8_SURROGATE      0x10u
+#define UTF8_OVERLONG_2     0x20u
+#define UTF8_TOO_LARGE_1000 0x40u
+#define UTF8_OVERLONG_4     0x40u
+#define UTF8_TWO_CONTS      0x80u
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+#if defined(_WIN32)
+static BOOL CALLBACK bstr_simd_init_once(PINIT_ONCE initOnce, PVOID param, PVOID *context);
+#else
+static void bstr_simd_init_once(void);
+#endif
+static uint32_t bstr_simd_detect(void);
+static void bstr_simd_select(bstr_simd_ops_t *ops, uint32_t features);
+static const uint8_t *bstr_search_val_swar(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val);
+static const uint8_t *bstr_search_any_scalar(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+static const uint8_t *bstr_search_any_reverse_scalar(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+static const uint8_t *bstr_find_short_scalar(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pNeedle, size_t needleLen, const uint8_t **ppStop);
+static size_t bstr_index_val_scalar(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+static size_t bstr_index_any_scalar(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+static void bstr_json_index_scalar(const uint8_t *pBegin, size_t numBlocks, bstr_json_index_block_t *blocks, bstr_json_scan_state_t *state);
+static void bstr_json_structurals_scalar(const uint8_t *pBegin, size_t numBlocks, uint64_t *structurals, bstr_json_scan_state_t *state);
+static const uint8_t *bstr_json_string_swar(const uint8_t *pBegin, const uint8_t *pEnd);
+#ifdef BSTR_SIMD_X86
+static const uint8_t *bstr_search_val_sse2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val);
+static const uint8_t *bstr_search_val_avx2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val);
+static const uint8_t *bstr_search_val_avx512(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val);
+static const uint8_t *bstr_search_any_ssse3(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+static const uint8_t *bstr_search_any_reverse_ssse3(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+static const uint8_t *bstr_search_any_avx2(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+static const uint8_t *bstr_search_any_reverse_avx2(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+static const uint8_t *bstr_search_any_avx512(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+static const uint8_t *bstr_find_short_sse2(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pNeedle, size_t needleLen, const uint8_t **ppStop);
+static const uint8_t *bstr_find_short_avx2(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pNeedle, size_t needleLen, const uint8_t **ppStop);
+static const uint8_t *bstr_find_short_avx512(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pNeedle, size_t needleLen, const uint8_t **ppStop);
+static size_t bstr_index_val_sse2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+static size_t bstr_index_val_avx2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+static size_t bstr_index_val_avx512(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+static size_t bstr_index_any_ssse3(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+static size_t bstr_index_any_avx2(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+static size_t bstr_index_any_avx512(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+static void bstr_json_index_sse2(const uint8_t *pBegin, size_t numBlocks, bstr_json_index_block_t *blocks, bstr_json_scan_state_t *state);
+static void bstr_json_index_avx2(const uint8_t *pBegin, size_t numBlocks, bstr_json_index_block_t *blocks, bstr_json_scan_state_t *state);
+static void bstr_json_index_avx512(const uint8_t *pBegin, size_t numBlocks, bstr_json_index_block_t *blocks, bstr_json_scan_state_t *state);
+static void bstr_json_structurals_sse2(const uint8_t *pBegin, size_t numBlocks, uint64_t *structurals, bstr_json_scan_state_t *state);
+static void bstr_json_structurals_avx2(const uint8_t *pBegin, size_t numBlocks, uint64_t *structurals, bstr_json_scan_state_t *state);
+static void bstr_json_structurals_avx512(const uint8_t *pBegin, size_t numBlocks, uint64_t *structurals, bstr_json_scan_state_t *state);
+static const uint8_t *bstr_json_string_sse2(const uint8_t *pBegin, const uint8_t *pEnd);
+static const uint8_t *bstr_json_string_ssse3(const uint8_t *pBegin, const uint8_t *pEnd);
+static const uint8_t *bstr_json_string_avx2(const uint8_t *pBegin, const uint8_t *pEnd);
+static const uint8_t *bstr_json_string_avx512(const uint8_t *pBegin, const uint8_t *pEnd);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+const bstr_simd_ops_t *g_bstr_simd_ops = 0;
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static bstr_simd_ops_t m_ops;
+static uint32_t m_detectedFeatures = 0u;
+#if defined(_WIN32)
+static INIT_ONCE m_initOnce = INIT_ONCE_STATIC_INIT;
+#else
+static pthread_once_t m_initOnce = PTHREAD_ONCE_INIT;
+#endif
+
+//Keiser-Lemire lookup tables, indexed by the high nibble of the previous byte, the low nibble of the previous byte
+//and the high nibble of the current byte. A byte pair is invalid when the three entries have a bit in common.
+#ifdef BSTR_SIMD_X86
+static const uint8_t m_utf8PrevHigh[16] = {
+   UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+   UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+   UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+   UTF8_TOO_SHORT,
+   UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+   UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+static const uint8_t m_utf8PrevLow[16] = {
+   UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+   UTF8_CARRY | UTF8_OVERLONG_2,
+   UTF8_CARRY,
+   UTF8_CARRY,
+   UTF8_CARRY | UTF8_TOO_LARGE,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+   UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+};
+static const uint8_t m_utf8CurHigh[16] = {
+   UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+   UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+   UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+   UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+   UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+   UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Detects the CPU features and selects the kernels to use, once. Called automatically on first use.
+ */
+const bstr_simd_ops_t *bstr_simd_ops_init(void)
+{
+#if defined(_WIN32)
+   (void) InitOnceExecuteOnce(&m_initOnce, bstr_simd_init_once, 0, 0);
+#else
+   (void) pthread_once(&m_initOnce, bstr_simd_init_once);
+#endif
+   return &m_ops;
+}
+
+/**
+ * Returns the set of BSTR_SIMD_* features currently used by the library.
+ */
+uint32_t bstr_simd_get_features(void)
+{
+   return bstr_simd_ops()->features;
+}
+
+/**
+ * Restricts the library to the given BSTR_SIMD_* features (features not supported by the CPU are ignored).
+ * Passing 0 forces the portable code paths. Returns the feature set now in use.
+ * This is intended for testing and benchmarking and must not be called while other threads use the library.
+ */
+uint32_t bstr_simd_set_features(uint32_t features)
+{
+   (void) bstr_simd_ops();
+   bstr_simd_select(&m_ops, features & m_detectedFeatures);
+   return m_ops.features;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef BSTR_SIMD_X86
+static void bstr_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+   int tmp[4];
+   __cpuidex(tmp, (int) leaf, (int) subleaf);
+   regs[0] = (uint32_t) tmp[0];
+   regs[1] = (uint32_t) tmp[1];
+   regs[2] = (uint32_t) tmp[2];
+   regs[3] = (uint32_t) tmp[3];
+#else
+   unsigned int a = 0u, b = 0u, c = 0u, d = 0u;
+   __cpuid_count(leaf, subleaf, a, b, c, d);
+   regs[0] = a;
+   regs[1] = b;
+   regs[2] = c;
+   regs[3] = d;
+#endif
+}
+
+static uint64_t bstr_xgetbv(void)
+{
+#if defined(_MSC_VER)
+   return (uint64_t) _xgetbv(0);
+#else
+   uint32_t eax, edx;
+   __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+   return ((uint64_t) edx << 32) | eax;
+#endif
+}
+#endif
+
+/**
+ * The table is complete before its address is published, threads on the fast path of bstr_simd_ops never see it
+ * half written.
+ */
+#if defined(_WIN32)
+static BOOL CALLBACK bstr_simd_init_once(PINIT_ONCE initOnce, PVOID param, PVOID *context)
+#else
+static void bstr_simd_init_once(void)
+#endif
+{
+#if defined(_WIN32)
+   (void) initOnce;
+   (void) param;
+   (void) context;
+#endif
+   m_detectedFeatures = bstr_simd_detect();
+   bstr_simd_select(&m_ops, m_detectedFeatures);
+#if defined(_MSC_VER) && !defined(__clang__)
+   *(const bstr_simd_ops_t * volatile*) &g_bstr_simd_ops = &m_ops;
+#else
+   __atomic_store_n(&g_bstr_simd_ops, &m_ops, __ATOMIC_RELEASE);
+#endif
+#if defined(_WIN32)
+   return TRUE;
+#endif
+}
+
+static uint32_t bstr_simd_detect(void)
+{
+   uint32_t features = 0u;
+#ifdef BSTR_SIMD_X86
+   uint32_t regs[4];
+   uint32_t maxLeaf;
+   bstr_cpuid(0u, 0u, regs);
+   maxLeaf = regs[0];
+   if (maxLeaf >= 1u)
+   {
+      uint64_t xcr0 = 0u;
+      bool hasOsxsave;
+      bstr_cpuid(1u, 0u, regs);
+      if (regs[3] & (1u << 26)) features |= BSTR_SIMD_SSE2;
+      if (regs[2] & (1u << 9)) features |= BSTR_SIMD_SSSE3;
+      if (regs[2] & (1u << 20)) features |= BSTR_SIMD_SSE42;
+      if (regs[2] & (1u << 1)) features |= BSTR_SIMD_PCLMUL;
+      hasOsxsave = (regs[2] & (1u << 27)) != 0u;
+      if (hasOsxsave)
+      {
+         xcr0 = bstr_xgetbv();
+      }
+      if ( (maxLeaf >= 7u) && ((xcr0 & 0x06u) == 0x06u) )
+      {
+         bstr_cpuid(7u, 0u, regs);
+         if (regs[1] & (1u << 5)) features |= BSTR_SIMD_AVX2;
+         if (regs[1] & (1u << 8)) features |= BSTR_SIMD_BMI2;
+         if ( ((xcr0 & 0xE0u) == 0xE0u) && (regs[1] & (1u << 16)) && (regs[1] & (1u << 30)) )
+         {
+            features |= BSTR_SIMD_AVX512BW;
+         }
+      }
+   }
+#endif
+   return features;
+}
+
+static void bstr_simd_select(bstr_simd_ops_t *ops, uint32_t features)
+{
+   ops->features = features;
+   ops->search_val = bstr_search_val_swar;
+   ops->search_any = bstr_search_any_scalar;
+   ops->search_any_reverse = bstr_search_any_reverse_scalar;
+   ops->find_short = bstr_find_short_scalar;
+   ops->index_val = bstr_index_val_scalar;
+   ops->index_any = bstr_index_any_scalar;
+   ops->json_index = bstr_json_index_scalar;
+   ops->json_structurals = bstr_json_structurals_scalar;
+   ops->json_string = bstr_json_string_swar;
+#ifdef BSTR_SIMD_X86
+   if (features & BSTR_SIMD_AVX512BW)
+   {
+      ops->search_val = bstr_search_val_avx512;
+      ops->find_short = bstr_find_short_avx512;
+      ops->index_val = bstr_index_val_avx512;
+      ops->json_string = bstr_json_string_avx512;
+   }
+   else if (features & BSTR_SIMD_AVX2)
+   {
+      ops->search_val = bstr_search_val_avx2;
+      ops->find_short = bstr_find_short_avx2;
+      ops->index_val = bstr_index_val_avx2;
+      ops->json_string = bstr_json_string_avx2;
+   }
+   else if (features & BSTR_SIMD_SSE2)
+   {
+      ops->search_val = bstr_search_val_sse2;
+      ops->find_short = bstr_find_short_sse2;
+      ops->index_val = bstr_index_val_sse2;
+      ops->json_string = (features & BSTR_SIMD_SSSE3) ? bstr_json_string_ssse3 : bstr_json_string_sse2;
+   }
+   if ( (features & BSTR_SIMD_AVX512BW) && (features & BSTR_SIMD_AVX2) )
+   {
+      ops->search_any = bstr_search_any_avx512;
+      ops->search_any_reverse = bstr_search_any_reverse_avx2;
+      ops->index_any = bstr_index_any_avx512;
+   }
+   else if (features & BSTR_SIMD_AVX2)
+   {
+      ops->search_any = bstr_search_any_avx2;
+      ops->search_any_reverse = bstr_search_any_reverse_avx2;
+      ops->index_any = bstr_index_any_avx2;
+   }
+   else if (features & BSTR_SIMD_SSSE3)
+   {
+      ops->search_any = bstr_search_any_ssse3;
+      ops->search_any_reverse = bstr_search_any_reverse_ssse3;
+      ops->index_any = bstr_index_any_ssse3;
+   }
+   if ( (features & BSTR_SIMD_AVX512BW) && (features & BSTR_SIMD_PCLMUL) )
+   {
+      ops->json_index = bstr_json_index_avx512;
+      ops->json_structurals = bstr_json_structurals_avx512;
+   }
+   else if ( (features & BSTR_SIMD_AVX2) && (features & BSTR_SIMD_PCLMUL) )
+   {
+      ops->json_index = bstr_json_index_avx2;
+      ops->json_structurals = bstr_json_structurals_avx2;
+   }
+   else if (features & BSTR_SIMD_SSE2)
+   {
+      ops->json_index = bstr_json_index_sse2;
+      ops->json_structurals = bstr_json_structurals_sse2;
+   }
+#endif
+}
+
+/*************** search_val ***************/
+
+static const uint8_t *bstr_search_val_swar(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val)
+{
+   const uint8_t *pNext = pBegin;
+   const uint64_t pattern = BSTR_SWAR_ONES * val;
+   while ( (pNext < pEnd) && (((uintptr_t) pNext & 7u) != 0u) )
+   {
+      if (*pNext == val)
+      {
+         return pNext;
+      }
+      pNext++;
+   }
+   while (pEnd - pNext >= 8)
+   {
+      uint64_t mask = bstr_swar_zero_bytes(bstr_load_u64(pNext) ^ pattern);
+      if (mask != 0u)
+      {
+#ifdef BSTR_LITTLE_ENDIAN
+         return pNext + (bstr_ctz64(mask) >> 3);
+#else
+         break;
+#endif
+      }
+      pNext += 8;
+   }
+   while (pNext < pEnd)
+   {
+      if (*pNext == val)
+      {
+         return pNext;
+      }
+      pNext++;
+   }
+   return pEnd;
+}
+
+/*************** search_any ***************/
+
+static const uint8_t *bstr_search_any_scalar(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   const uint8_t *pNext = pBegin;
+   while (pEnd - pNext >= 4)
+   {
+      if (bstr_byteset_has(set, pNext[0])) return pNext;
+      if (bstr_byteset_has(set, pNext[1])) return pNext + 1;
+      if (bstr_byteset_has(set, pNext[2])) return pNext + 2;
+      if (bstr_byteset_has(set, pNext[3])) return pNext + 3;
+      pNext += 4;
+   }
+   while (pNext < pEnd)
+   {
+      if (bstr_byteset_has(set, *pNext))
+      {
+         return pNext;
+      }
+      pNext++;
+   }
+   return pEnd;
+}
+
+static const uint8_t *bstr_search_any_reverse_scalar(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   const uint8_t *pNext = pEnd;
+   while (pNext > pBegin)
+   {
+      pNext--;
+      if (bstr_byteset_has(set, *pNext))
+      {
+         return pNext;
+      }
+   }
+   return pEnd;
+}
+
+/*************** find_short ***************/
+
+/**
+ * Verifies the candidate at pCandidate whose first and last bytes are already known to match.
+ * Returns true on a full match. Otherwise the verification is charged against the work budget and
+ * *pIsExhausted is set when the budget has run out.
+ */
+static inline bool bstr_find_verify(const uint8_t *pBegin, const uint8_t *pCandidate, const uint8_t *pNeedle, size_t needleLen, size_t *pWork, bool *pIsExhausted)
+{
+   if ( (needleLen <= 2u) || (memcmp(pCandidate + 1, pNeedle + 1, needleLen - 2u) == 0) )
+   {
+      return true;
+   }
+   *pWork += needleLen;
+   if (*pWork > FIND_WORK_ALLOWANCE + 2u * (size_t) (pCandidate - pBegin))
+   {
+      *pIsExhausted = true;
+   }
+   return false;
+}
+
+static const uint8_t *bstr_find_short_scalar(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pNeedle, size_t needleLen, const uint8_t **ppStop)
+{
+   const uint8_t *pNext = pBegin;
+   const uint8_t *pLastStart = pEnd - needleLen; //caller guarantees needleLen <= pEnd - pBegin
+   const uint8_t first = pNeedle[0];
+   const uint8_t last = pNeedle[needleLen - 1u];
+   bstr_search_val_func_t search_val = bstr_simd_ops()->search_val;
+   size_t work = 0u;
+   bool isExhausted = false;
+   while (pNext <= pLastStart)
+   {
+      pNext = search_val(pNext, pLastStart + 1, first);
+      if (pNext > pLastStart)
+      {
+         break;
+      }
+      if ( (pNext[needleLen - 1u] == last) && bstr_find_verify(pBegin, pNext, pNeedle, needleLen, &work, &isExhausted) )
+      {
+         return pNext;
+      }
+      if (isExhausted)
+      {
+         *ppStop = pNext + 1;
+         return pEnd;
+      }
+      pNext++;
+   }
+   return pEnd;
+}
+
+/*************** index_val ***************/
+
+/**
+ * Appends blockOffset plus the index of each bit set in mask to positions. Returns false when positions
+ * became full before all bits were stored, *ppNext is then set just past the last stored occurrence.
+ */
+static inline bool bstr_index_mask(uint64_t mask, const uint8_t *pBegin, size_t blockOffset, size_t *positions, size_t maxPositions, size_t *pCount, const uint8_t **ppNext)
+{
+   size_t count = *pCount;
+   if (maxPositions - count >= 64u)
+   {
+      //room for every bit: store four offsets per iteration, the extra stores past the last bit are overwritten later
+      const uint64_t guard = (uint64_t) 1u << 63;
+      size_t *pOut = positions + count;
+      *pCount = count + bstr_popcount64(mask);
+      while (mask != 0u)
+      {
+         pOut[0] = blockOffset + bstr_ctz64(mask | guard);
+         mask &= mask - 1u;
+         pOut[1] = blockOffset + bstr_ctz64(mask | guard);
+         mask &= mask - 1u;
+         pOut[2] = blockOffset + bstr_ctz64(mask | guard);
+         mask &= mask - 1u;
+         pOut[3] = blockOffset + bstr_ctz64(mask | guard);
+         mask &= mask - 1u;
+         pOut += 4;
+      }
+      return true;
+   }
+   while (mask != 0u)
+   {
+      if (count == maxPositions)
+      {
+         *pCount = count;
+         *ppNext = (count > 0u) ? pBegin + positions[count - 1u] + 1u : pBegin + blockOffset;
+         return false;
+      }
+      positions[count++] = blockOffset + bstr_ctz64(mask);
+      mask &= mask - 1u;
+   }
+   *pCount = count;
+   return true;
+}
+
+static inline uint64_t bstr_index_tail_mask(const uint8_t *pNext, const uint8_t *pEnd, uint8_t val)
+{
+   uint64_t mask = 0u;
+   uint32_t i;
+   for (i = 0u; pNext + i < pEnd; i++)
+   {
+      if (pNext[i] == val)
+      {
+         mask |= (uint64_t) 1u << i;
+      }
+   }
+   return mask;
+}
+
+static size_t bstr_index_val_scalar(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val, size_t *positions, size_t maxPositions, const uint8_t **ppNext)
+{
+   const uint8_t *pNext = pBegin;
+   size_t count = 0u;
+   while (count < maxPositions)
+   {
+      const uint8_t *pFound = bstr_search_val_swar(pNext, pEnd, val);
+      if (pFound == pEnd)
+      {
+         pNext = pEnd;
+         break;
+      }
+      positions[count++] = (size_t) (pFound - pBegin);
+      pNext = pFound + 1;
+   }
+   *ppNext = pNext;
+   return count;
+}
+
+static inline uint64_t bstr_index_any_tail_mask(const uint8_t *pNext, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   uint64_t mask = 0u;
+   uint32_t i;
+   for (i = 0u; pNext + i < pEnd; i++)
+   {
+      if (bstr_byteset_has(set, pNext[i]))
+      {
+         mask |= (uint64_t) 1u << i;
+      }
+   }
+   return mask;
+}
+
+static size_t bstr_index_any_scalar(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, size_t *positions, size_t maxPositions, const uint8_t **ppNext)
+{
+   const uint8_t *pNext = pBegin;
+   size_t count = 0u;
+   while ( (pNext < pEnd) && (count < maxPositions) )
+   {
+      if (bstr_byteset_has(set, *pNext))
+      {
+         positions[count++] = (size_t) (pNext - pBegin);
+      }
+      pNext++;
+   }
+   *ppNext = pNext;
+   return count;
+}
+
+/*************** json_index ***************/
+
+/**
+ * Returns the mask of bytes escaped by a backslash, runs of backslashes spanning several blocks are handled
+ * through state->prevEscaped. Based on the branchless method of simdjson.
+ */
+static inline uint64_t bstr_json_escaped(uint64_t backslash, bstr_json_scan_state_t *state)
+{
+   const uint64_t evenBits = 0x5555555555555555ull;
+   uint64_t followsEscape;
+   uint64_t oddSequenceStarts;
+   uint64_t sequencesStartingOnEvenBits;
+   backslash &= ~state->prevEscaped;
+   followsEscape = (backslash << 1) | state->prevEscaped;
+   oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+   sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+   state->prevEscaped = (sequencesStartingOnEvenBits < backslash) ? 1u : 0u;
+   return (evenBits ^ (sequencesStartingOnEvenBits << 1)) & followsEscape;
+}
+
+/**
+ * Stores the masks of one block given the raw character masks and the prefix xor of its unescaped quotes.
+ */
+static inline void bstr_json_store_block(bstr_json_index_block_t *block, uint64_t quotes, uint64_t quotePrefix, uint64_t opens, uint64_t closes, bstr_json_scan_state_t *state)
+{
+   uint64_t inString = quotePrefix ^ state->prevInString;
+   state->prevInString = (uint64_t) ((int64_t) inString >> 63);
+   block->quotes = quotes;
+   block->opens = opens & ~inString;
+   block->closes = closes & ~inString;
+}
+
+static void bstr_json_index_scalar(const uint8_t *pBegin, size_t numBlocks, bstr_json_index_block_t *blocks, bstr_json_scan_state_t *state)
+{
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      const uint8_t *pBlock = pBegin + i * 64u;
+      uint64_t quotes = 0u, backslash = 0u, opens = 0u, closes = 0u;
+      uint32_t j;
+      for (j = 0u; j < 64u; j++)
+      {
+         uint8_t c = pBlock[j];
+         uint8_t folded = (uint8_t) (c | 0x20u); //'[' and ']' fold onto '{' and '}'
+         uint64_t bit = (uint64_t) 1u << j;
+         if (c == (uint8_t) '"') quotes |= bit;
+         if (c == (uint8_t) '\\') backslash |= bit;
+         if (folded == (uint8_t) '{') opens |= bit;
+         if (folded == (uint8_t) '}') closes |= bit;
+      }
+      quotes &= ~bstr_json_escaped(backslash, state);
+      bstr_json_store_block(&blocks[i], quotes, bstr_prefix_xor_swar(quotes), opens, closes, state);
+   }
+}
+
+/*************** json_structurals ***************/
+
+/**
+ * Returns the structural mask of one block given its character masks and the prefix xor of its unescaped quotes.
+ * A scalar (number or literal) starts at every byte which is neither whitespace nor an operator and doesn't follow
+ * another such byte. Closing quotes and everything inside strings are removed, opening quotes are kept.
+ */
+static inline uint64_t bstr_json_structurals_block(uint64_t quotes, uint64_t quotePrefix, uint64_t operators, uint64_t whitespace, bstr_json_scan_state_t *state)
+{
+   uint64_t inString = quotePrefix ^ state->prevInString;
+   uint64_t scalars = ~(operators | whitespace);
+   uint64_t nonQuoteScalars = scalars & ~quotes;
+   uint64_t followsScalar = (nonQuoteScalars << 1) | state->prevScalar;
+   state->prevInString = (uint64_t) ((int64_t) inString >> 63);
+   state->prevScalar = nonQuoteScalars >> 63;
+   return (operators | (scalars & ~followsScalar)) & ~(inString ^ quotes);
+}
+
+static void bstr_json_structurals_scalar(const uint8_t *pBegin, size_t numBlocks, uint64_t *structurals, bstr_json_scan_state_t *state)
+{
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      const uint8_t *pBlock = pBegin + i * 64u;
+      uint64_t quotes = 0u, backslash = 0u, operators = 0u, whitespace = 0u;
+      uint32_t j;
+      for (j = 0u; j < 64u; j++)
+      {
+         uint8_t c = pBlock[j];
+         uint64_t bit = (uint64_t) 1u << j;
+         switch (c)
+         {
+         case '"':
+            quotes |= bit;
+            break;
+         case '\\':
+            backslash |= bit;
+            break;
+         case '{': case '}': case '[': case ']': case ':': case ',':
+            operators |= bit;
+            break;
+         case ' ': case '\t': case '\n': case '\r':
+            whitespace |= bit;
+            break;
+         default:
+            break;
+         }
+      }
+      quotes &= ~bstr_json_escaped(backslash, state);
+      structurals[i] = bstr_json_structurals_block(quotes, bstr_prefix_xor_swar(quotes), operators, whitespace, state);
+   }
+}
+
+/*************** json_string ***************/
+
+/**
+ * High bit set in each byte that is '"', '\\', below 0x20 or above 0x7F. Only the lowest set bit is exact.
+ */
+static inline uint64_t bstr_json_string_mask_swar(uint64_t x)
+{
+   const uint64_t quotes = BSTR_SWAR_ONES * (uint8_t) '"';
+   const uint64_t backslashes = BSTR_SWAR_ONES * (uint8_t) '\\';
+   return bstr_swar_zero_bytes(x ^ quotes) | bstr_swar_zero_bytes(x ^ backslashes) | ((x - BSTR_SWAR_ONES * 0x20u) & ~x & BSTR_SWAR_HIGHS) |
+          (x & BSTR_SWAR_HIGHS);
+}
+
+static inline bool bstr_is_json_string_stop(uint8_t c)
+{
+   return (c == (uint8_t) '"') || (c == (uint8_t) '\\') || (c < 0x20u) || (c >= 0x80u);
+}
+
+/**
+ * Returns the end of the UTF-8 sequence that starts with the non-ASCII byte at p. Returns p when the sequence is invalid
+ * and pEnd when it is a valid prefix cut off by pEnd.
+ */
+static inline const uint8_t *bstr_utf8_sequence_end(const uint8_t *p, const uint8_t *pEnd)
+{
+   uint8_t lower = 0x80u;
+   uint8_t upper = 0xBFu;
+   ptrdiff_t len;
+   ptrdiff_t i;
+   if (*p < 0xC2u)
+   {
+      return p; //continuation byte or overlong 2-byte sequence
+   }
+   else if (*p < 0xE0u)
+   {
+      len = 2;
+   }
+   else if (*p < 0xF0u)
+   {
+      len = 3;
+      if (*p == 0xE0u) lower = 0xA0u; //overlong
+      else if (*p == 0xEDu) upper = 0x9Fu; //surrogate
+   }
+   else if (*p < 0xF5u)
+   {
+      len = 4;
+      if (*p == 0xF0u) lower = 0x90u; //overlong
+      else if (*p == 0xF4u) upper = 0x8Fu; //above U+10FFFF
+   }
+   else
+   {
+      return p;
+   }
+   for (i = 1; i < len; i++)
+   {
+      if (p + i == pEnd)
+      {
+         return pEnd;
+      }
+      if ( (p[i] < lower) || (p[i] > upper) )
+      {
+         return p;
+      }
+      lower = 0x80u;
+      upper = 0xBFu;
+   }
+   return p + len;
+}
+
+/**
+ * Returns the first '"', '\\', control character or non-ASCII byte.
+ */
+static const uint8_t *bstr_json_string_ascii_swar(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const uint8_t *pNext = pBegin;
+#ifdef BSTR_LITTLE_ENDIAN
+   while (pEnd - pNext >= 8)
+   {
+      uint64_t mask = bstr_json_string_mask_swar(bstr_load_u64(pNext));
+      if (mask != 0u)
+      {
+         return pNext + (bstr_ctz64(mask) >> 3);
+      }
+      pNext += 8;
+   }
+#endif
+   while (pNext < pEnd)
+   {
+      if (bstr_is_json_string_stop(*pNext))
+      {
+         return pNext;
+      }
+      pNext++;
+   }
+   return pEnd;
+}
+
+static const uint8_t *bstr_json_string_swar(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const uint8_t *pNext = pBegin;
+   for (;;)
+   {
+      const uint8_t *pStop = bstr_json_string_ascii_swar(pNext, pEnd);
+      if ( (pStop == pEnd) || (*pStop < 0x80u) )
+      {
+         return pStop;
+      }
+      pNext = bstr_utf8_sequence_end(pStop, pEnd);
+      if (pNext == pStop)
+      {
+         return pStop;
+      }
+   }
+}
+
+/**
+ * Resolves the stop position of a block from its masks of special bytes and UTF-8 errors.
+ * An error flagged on an ASCII byte belongs to the unfinished sequence before it, whose last byte is never ASCII.
+ */
+static inline const uint8_t *bstr_json_string_block_stop(const uint8_t *pBlock, uint64_t special, uint64_t errors)
+{
+   if ( (errors != 0u) && ( (special == 0u) || (bstr_ctz64(errors) <= bstr_ctz64(special)) ) )
+   {
+      const uint8_t *pError = pBlock + bstr_ctz64(errors);
+      return (*pError < 0x80u) ? pError - 1 : pError;
+   }
+   return pBlock + bstr_ctz64(special);
+}
+
+#ifdef BSTR_SIMD_X86
+
+BSTR_TARGET("sse2")
+static const uint8_t *bstr_find_short_sse2(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pNeedle, size_t needleLen, const uint8_t **ppStop)
+{
+   const uint8_t *pNext = pBegin;
+   const __m128i first = _mm_set1_epi8((char) pNeedle[0]);
+   const __m128i last = _mm_set1_epi8((char) pNeedle[needleLen - 1u]);
+   size_t work = 0u;
+   bool isExhausted = false;
+   while ((size_t) (pEnd - pNext) >= needleLen - 1u + 16u)
+   {
+      __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) pNext), first);
+      __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (pNext + needleLen - 1u)), last);
+      uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_and_si128(a, b));
+      while (mask != 0u)
+      {
+         const uint8_t *pCandidate = pNext + bstr_ctz32(mask);
+         if (bstr_find_verify(pBegin, pCandidate, pNeedle, needleLen, &work, &isExhausted))
+         {
+            return pCandidate;
+         }
+         if (isExhausted)
+         {
+            *ppStop = pCandidate + 1;
+            return pEnd;
+         }
+         mask &= mask - 1u;
+      }
+      pNext += 16;
+   }
+   if ((size_t) (pEnd - pNext) >= needleLen)
+   {
+      return bstr_find_short_scalar(pNext, pEnd, pNeedle, needleLen, ppStop);
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("avx2")
+static const uint8_t *bstr_find_short_avx2(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pNeedle, size_t needleLen, const uint8_t **ppStop)
+{
+   const uint8_t *pNext = pBegin;
+   const __m256i first = _mm256_set1_epi8((char) pNeedle[0]);
+   const __m256i last = _mm256_set1_epi8((char) pNeedle[needleLen - 1u]);
+   size_t work = 0u;
+   bool isExhausted = false;
+   while ((size_t) (pEnd - pNext) >= needleLen - 1u + 32u)
+   {
+      __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) pNext), first);
+      __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (pNext + needleLen - 1u)), last);
+      uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(a, b));
+      while (mask != 0u)
+      {
+         const uint8_t *pCandidate = pNext + bstr_ctz32(mask);
+         if (bstr_find_verify(pBegin, pCandidate, pNeedle, needleLen, &work, &isExhausted))
+         {
+            return pCandidate;
+         }
+         if (isExhausted)
+         {
+            *ppStop = pCandidate + 1;
+            return pEnd;
+         }
+         mask &= mask - 1u;
+      }
+      pNext += 32;
+   }
+   if ((size_t) (pEnd - pNext) >= needleLen)
+   {
+      return bstr_find_short_sse2(pNext, pEnd, pNeedle, needleLen, ppStop);
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("avx512f,avx512bw")
+static const uint8_t *bstr_find_short_avx512(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pNeedle, size_t needleLen, const uint8_t **ppStop)
+{
+   const uint8_t *pNext = pBegin;
+   const __m512i first = _mm512_set1_epi8((char) pNeedle[0]);
+   const __m512i last = _mm512_set1_epi8((char) pNeedle[needleLen - 1u]);
+   size_t work = 0u;
+   bool isExhausted = false;
+   while ((size_t) (pEnd - pNext) >= needleLen - 1u + 64u)
+   {
+      __mmask64 mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*) pNext), first);
+      mask = _mm512_mask_cmpeq_epi8_mask(mask, _mm512_loadu_si512((const void*) (pNext + needleLen - 1u)), last);
+      while (mask != 0u)
+      {
+         const uint8_t *pCandidate = pNext + bstr_ctz64(mask);
+         if (bstr_find_verify(pBegin, pCandidate, pNeedle, needleLen, &work, &isExhausted))
+         {
+            return pCandidate;
+         }
+         if (isExhausted)
+         {
+            *ppStop = pCandidate + 1;
+            return pEnd;
+         }
+         mask &= mask - 1u;
+      }
+      pNext += 64;
+   }
+   if ((size_t) (pEnd - pNext) >= needleLen)
+   {
+      return bstr_find_short_avx2(pNext, pEnd, pNeedle, needleLen, ppStop);
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("sse2")
+static const uint8_t *bstr_search_val_sse2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val)
+{
+   const uint8_t *pNext = pBegin;
+   const __m128i pattern = _mm_set1_epi8((char) val);
+   if (pEnd - pBegin < 16)
+   {
+      return bstr_search_val_swar(pBegin, pEnd, val);
+   }
+   while (pEnd - pNext >= 64)
+   {
+      __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) pNext), pattern);
+      __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (pNext + 16)), pattern);
+      __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (pNext + 32)), pattern);
+      __m128i d = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (pNext + 48)), pattern);
+      if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) != 0)
+      {
+         uint64_t mask = (uint64_t) (uint32_t) _mm_movemask_epi8(a)
+                       | ((uint64_t) (uint32_t) _mm_movemask_epi8(b) << 16)
+                       | ((uint64_t) (uint32_t) _mm_movemask_epi8(c) << 32)
+                       | ((uint64_t) (uint32_t) _mm_movemask_epi8(d) << 48);
+         return pNext + bstr_ctz64(mask);
+      }
+      pNext += 64;
+   }
+   while (pEnd - pNext >= 16)
+   {
+      uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) pNext), pattern));
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz32(mask);
+      }
+      pNext += 16;
+   }
+   if (pNext < pEnd)
+   {
+      //overlapping load of the last 16 bytes, ignore bytes that were already checked
+      const uint8_t *pLast = pEnd - 16;
+      uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) pLast), pattern));
+      mask &= 0xFFFFu << (uint32_t) (pNext - pLast);
+      if (mask != 0u)
+      {
+         return pLast + bstr_ctz32(mask);
+      }
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("avx2")
+static const uint8_t *bstr_search_val_avx2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val)
+{
+   const uint8_t *pNext = pBegin;
+   __m256i pattern;
+   if (pEnd - pBegin < 32)
+   {
+      //pattern is set after this check so that the SSE kernel is not entered with a dirty upper ymm state
+      return bstr_search_val_sse2(pBegin, pEnd, val);
+   }
+   pattern = _mm256_set1_epi8((char) val);
+   while (pEnd - pNext >= 128)
+   {
+      __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) pNext), pattern);
+      __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (pNext + 32)), pattern);
+      __m256i c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (pNext + 64)), pattern);
+      __m256i d = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (pNext + 96)), pattern);
+      if (!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b)) )
+      {
+         uint64_t mask = (uint64_t) (uint32_t) _mm256_movemask_epi8(a) | ((uint64_t) (uint32_t) _mm256_movemask_epi8(b) << 32);
+         return pNext + bstr_ctz64(mask);
+      }
+      if (!_mm256_testz_si256(_mm256_or_si256(c, d), _mm256_or_si256(c, d)) )
+      {
+         uint64_t mask = (uint64_t) (uint32_t) _mm256_movemask_epi8(c) | ((uint64_t) (uint32_t) _mm256_movemask_epi8(d) << 32);
+         return pNext + 64 + bstr_ctz64(mask);
+      }
+      pNext += 128;
+   }
+   while (pEnd - pNext >= 32)
+   {
+      uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) pNext), pattern));
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz32(mask);
+      }
+      pNext += 32;
+   }
+   if (pNext < pEnd)
+   {
+      const uint8_t *pLast = pEnd - 32;
+      uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) pLast), pattern));
+      mask &= 0xFFFFFFFFu << (uint32_t) (pNext - pLast);
+      if (mask != 0u)
+      {
+         return pLast + bstr_ctz32(mask);
+      }
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("avx512f,avx512bw")
+static const uint8_t *bstr_search_val_avx512(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val)
+{
+   const uint8_t *pNext = pBegin;
+   const __m512i pattern = _mm512_set1_epi8((char) val);
+   while (pEnd - pNext >= 128)
+   {
+      __mmask64 a = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*) pNext), pattern);
+      __mmask64 b = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*) (pNext + 64)), pattern);
+      if ((a | b) != 0u)
+      {
+         return (a != 0u) ? pNext + bstr_ctz64(a) : pNext + 64 + bstr_ctz64(b);
+      }
+      pNext += 128;
+   }
+   while (pEnd - pNext >= 64)
+   {
+      __mmask64 mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*) pNext), pattern);
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz64(mask);
+      }
+      pNext += 64;
+   }
+   if (pNext < pEnd)
+   {
+      //masked loads never fault on the bytes that are masked off
+      __mmask64 loadMask = ((__mmask64) 1u << (uint32_t) (pEnd - pNext)) - 1u;
+      __mmask64 mask = _mm512_mask_cmpeq_epi8_mask(loadMask, _mm512_maskz_loadu_epi8(loadMask, (const void*) pNext), pattern);
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz64(mask);
+      }
+   }
+   return pEnd;
+}
+
+/*
+ * Nibble-shuffle classification: each input byte is split into its low and high nibble which are used
+ * as indices into two 16-byte tables. The byte belongs to the set when the two looked up bytes share a bit.
+ * Byte sets that need more than 8 buckets use a second pair of tables.
+ */
+BSTR_TARGET("ssse3")
+static inline uint32_t bstr_classify_ssse3(__m128i v, const bstr_byteset_t *set)
+{
+   const __m128i lowMask = _mm_set1_epi8(0x0F);
+   __m128i vlo = _mm_and_si128(v, lowMask);
+   __m128i vhi = _mm_and_si128(_mm_srli_epi16(v, 4), lowMask);
+   __m128i hits = _mm_and_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) set->lo[0]), vlo),
+                                _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) set->hi[0]), vhi));
+   if (set->numTables > 1u)
+   {
+      hits = _mm_or_si128(hits, _mm_and_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) set->lo[1]), vlo),
+                                              _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) set->hi[1]), vhi)));
+   }
+   return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(hits, _mm_setzero_si128())) ^ 0xFFFFu;
+}
+
+BSTR_TARGET("ssse3")
+static const uint8_t *bstr_search_any_ssse3(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   const uint8_t *pNext = pBegin;
+   if (pEnd - pBegin < 16)
+   {
+      return bstr_search_any_scalar(pBegin, pEnd, set);
+   }
+   while (pEnd - pNext >= 16)
+   {
+      uint32_t mask = bstr_classify_ssse3(_mm_loadu_si128((const __m128i*) pNext), set);
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz32(mask);
+      }
+      pNext += 16;
+   }
+   if (pNext < pEnd)
+   {
+      const uint8_t *pLast = pEnd - 16;
+      uint32_t mask = bstr_classify_ssse3(_mm_loadu_si128((const __m128i*) pLast), set);
+      mask &= 0xFFFFu << (uint32_t) (pNext - pLast);
+      if (mask != 0u)
+      {
+         return pLast + bstr_ctz32(mask);
+      }
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("ssse3")
+static const uint8_t *bstr_search_any_reverse_ssse3(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   const uint8_t *pNext = pEnd;
+   if (pEnd - pBegin < 16)
+   {
+      return bstr_search_any_reverse_scalar(pBegin, pEnd, set);
+   }
+   while (pNext - pBegin >= 16)
+   {
+      uint32_t mask;
+      pNext -= 16;
+      mask = bstr_classify_ssse3(_mm_loadu_si128((const __m128i*) pNext), set);
+      if (mask != 0u)
+      {
+         return pNext + bstr_bsr32(mask);
+      }
+   }
+   if (pNext > pBegin)
+   {
+      uint32_t mask = bstr_classify_ssse3(_mm_loadu_si128((const __m128i*) pBegin), set);
+      mask &= (1u << (uint32_t) (pNext - pBegin)) - 1u;
+      if (mask != 0u)
+      {
+         return pBegin + bstr_bsr32(mask);
+      }
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("avx2")
+static inline uint32_t bstr_classify_avx2(__m256i v, const bstr_byteset_t *set)
+{
+   const __m256i lowMask = _mm256_set1_epi8(0x0F);
+   __m256i vlo = _mm256_and_si256(v, lowMask);
+   __m256i vhi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+   __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) set->lo[0]));
+   __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) set->hi[0]));
+   __m256i hits = _mm256_and_si256(_mm256_shuffle_epi8(lo, vlo), _mm256_shuffle_epi8(hi, vhi));
+   if (set->numTables > 1u)
+   {
+      lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) set->lo[1]));
+      hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) set->hi[1]));
+      hits = _mm256_or_si256(hits, _mm256_and_si256(_mm256_shuffle_epi8(lo, vlo), _mm256_shuffle_epi8(hi, vhi)));
+   }
+   return ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hits, _mm256_setzero_si256()));
+}
+
+BSTR_TARGET("avx2")
+static const uint8_t *bstr_search_any_avx2(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   const uint8_t *pNext = pBegin;
+   if (pEnd - pBegin < 32)
+   {
+      return bstr_search_any_ssse3(pBegin, pEnd, set);
+   }
+   while (pEnd - pNext >= 64)
+   {
+      uint64_t mask = (uint64_t) bstr_classify_avx2(_mm256_loadu_si256((const __m256i*) pNext), set)
+                    | ((uint64_t) bstr_classify_avx2(_mm256_loadu_si256((const __m256i*) (pNext + 32)), set) << 32);
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz64(mask);
+      }
+      pNext += 64;
+   }
+   while (pEnd - pNext >= 32)
+   {
+      uint32_t mask = bstr_classify_avx2(_mm256_loadu_si256((const __m256i*) pNext), set);
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz32(mask);
+      }
+      pNext += 32;
+   }
+   if (pNext < pEnd)
+   {
+      const uint8_t *pLast = pEnd - 32;
+      uint32_t mask = bstr_classify_avx2(_mm256_loadu_si256((const __m256i*) pLast), set);
+      mask &= 0xFFFFFFFFu << (uint32_t) (pNext - pLast);
+      if (mask != 0u)
+      {
+         return pLast + bstr_ctz32(mask);
+      }
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("avx2")
+static const uint8_t *bstr_search_any_reverse_avx2(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   const uint8_t *pNext = pEnd;
+   if (pEnd - pBegin < 32)
+   {
+      return bstr_search_any_reverse_ssse3(pBegin, pEnd, set);
+   }
+   while (pNext - pBegin >= 32)
+   {
+      uint32_t mask;
+      pNext -= 32;
+      mask = bstr_classify_avx2(_mm256_loadu_si256((const __m256i*) pNext), set);
+      if (mask != 0u)
+      {
+         return pNext + bstr_bsr32(mask);
+      }
+   }
+   if (pNext > pBegin)
+   {
+      uint32_t mask = bstr_classify_avx2(_mm256_loadu_si256((const __m256i*) pBegin), set);
+      mask &= (1u << (uint32_t) (pNext - pBegin)) - 1u;
+      if (mask != 0u)
+      {
+         return pBegin + bstr_bsr32(mask);
+      }
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("avx512f,avx512bw")
+static inline __mmask64 bstr_classify_avx512(__m512i v, __m512i lo0, __m512i hi0, __m512i lo1, __m512i hi1, bool useSecondTable)
+{
+   const __m512i lowMask = _mm512_set1_epi8(0x0F);
+   __m512i vlo = _mm512_and_si512(v, lowMask);
+   __m512i vhi = _mm512_and_si512(_mm512_srli_epi16(v, 4), lowMask);
+   __m512i hits = _mm512_and_si512(_mm512_shuffle_epi8(lo0, vlo), _mm512_shuffle_epi8(hi0, vhi));
+   if (useSecondTable)
+   {
+      hits = _mm512_or_si512(hits, _mm512_and_si512(_mm512_shuffle_epi8(lo1, vlo), _mm512_shuffle_epi8(hi1, vhi)));
+   }
+   return _mm512_test_epi8_mask(hits, hits);
+}
+
+BSTR_TARGET("avx512f,avx512bw")
+static const uint8_t *bstr_search_any_avx512(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set)
+{
+   const uint8_t *pNext = pBegin;
+   const bool useSecondTable = set->numTables > 1u;
+   const __m512i lo0 = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) set->lo[0]));
+   const __m512i hi0 = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) set->hi[0]));
+   const __m512i lo1 = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) set->lo[1]));
+   const __m512i hi1 = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) set->hi[1]));
+   while (pEnd - pNext >= 64)
+   {
+      __mmask64 mask = bstr_classify_avx512(_mm512_loadu_si512((const void*) pNext), lo0, hi0, lo1, hi1, useSecondTable);
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz64(mask);
+      }
+      pNext += 64;
+   }
+   if (pNext < pEnd)
+   {
+      __mmask64 loadMask = ((__mmask64) 1u << (uint32_t) (pEnd - pNext)) - 1u;
+      __m512i v = _mm512_maskz_loadu_epi8(loadMask, (const void*) pNext);
+      __mmask64 mask = bstr_classify_avx512(v, lo0, hi0, lo1, hi1, useSecondTable) & loadMask;
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz64(mask);
+      }
+   }
+   return pEnd;
+}
+
+/*************** index_val ***************/
+
+BSTR_TARGET("sse2")
+static size_t bstr_index_val_sse2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val, size_t *positions, size_t maxPositions, const uint8_t **ppNext)
+{
+   const uint8_t *pNext = pBegin;
+   const __m128i pattern = _mm_set1_epi8((char) val);
+   size_t count = 0u;
+   *ppNext = pEnd;
+   while (pEnd - pNext >= 64)
+   {
+      uint64_t mask = (uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) pNext), pattern))
+                    | ((uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (pNext + 16)), pattern)) << 16)
+                    | ((uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (pNext + 32)), pattern)) << 32)
+                    | ((uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (pNext + 48)), pattern)) << 48);
+      if (!bstr_index_mask(mask, pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext))
+      {
+         return count;
+      }
+      pNext += 64;
+   }
+   (void) bstr_index_mask(bstr_index_tail_mask(pNext, pEnd, val), pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext);
+   return count;
+}
+
+BSTR_TARGET("avx2")
+static size_t bstr_index_val_avx2(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val, size_t *positions, size_t maxPositions, const uint8_t **ppNext)
+{
+   const uint8_t *pNext = pBegin;
+   const __m256i pattern = _mm256_set1_epi8((char) val);
+   size_t count = 0u;
+   *ppNext = pEnd;
+   while (pEnd - pNext >= 64)
+   {
+      uint64_t mask = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) pNext), pattern))
+                    | ((uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (pNext + 32)), pattern)) << 32);
+      if (!bstr_index_mask(mask, pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext))
+      {
+         return count;
+      }
+      pNext += 64;
+   }
+   (void) bstr_index_mask(bstr_index_tail_mask(pNext, pEnd, val), pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext);
+   return count;
+}
+
+BSTR_TARGET("avx512f,avx512bw")
+static size_t bstr_index_val_avx512(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val, size_t *positions, size_t maxPositions, const uint8_t **ppNext)
+{
+   const uint8_t *pNext = pBegin;
+   const __m512i pattern = _mm512_set1_epi8((char) val);
+   size_t count = 0u;
+   *ppNext = pEnd;
+   while (pEnd - pNext >= 64)
+   {
+      uint64_t mask = (uint64_t) _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*) pNext), pattern);
+      if (!bstr_index_mask(mask, pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext))
+      {
+         return count;
+      }
+      pNext += 64;
+   }
+   if (pNext < pEnd)
+   {
+      __mmask64 loadMask = ((__mmask64) 1u << (uint32_t) (pEnd - pNext)) - 1u;
+      uint64_t mask = (uint64_t) _mm512_mask_cmpeq_epi8_mask(loadMask, _mm512_maskz_loadu_epi8(loadMask, (const void*) pNext), pattern);
+      (void) bstr_index_mask(mask, pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext);
+   }
+   return count;
+}
+
+/*************** index_any ***************/
+
+BSTR_TARGET("ssse3")
+static size_t bstr_index_any_ssse3(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, size_t *positions, size_t maxPositions, const uint8_t **ppNext)
+{
+   const uint8_t *pNext = pBegin;
+   size_t count = 0u;
+   *ppNext = pEnd;
+   while (pEnd - pNext >= 64)
+   {
+      uint64_t mask = (uint64_t) bstr_classify_ssse3(_mm_loadu_si128((const __m128i*) pNext), set)
+                    | ((uint64_t) bstr_classify_ssse3(_mm_loadu_si128((const __m128i*) (pNext + 16)), set) << 16)
+                    | ((uint64_t) bstr_classify_ssse3(_mm_loadu_si128((const __m128i*) (pNext + 32)), set) << 32)
+                    | ((uint64_t) bstr_classify_ssse3(_mm_loadu_si128((const __m128i*) (pNext + 48)), set) << 48);
+      if (!bstr_index_mask(mask, pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext))
+      {
+         return count;
+      }
+      pNext += 64;
+   }
+   (void) bstr_index_mask(bstr_index_any_tail_mask(pNext, pEnd, set), pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext);
+   return count;
+}
+
+BSTR_TARGET("avx2")
+static size_t bstr_index_any_avx2(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, size_t *positions, size_t maxPositions, const uint8_t **ppNext)
+{
+   const uint8_t *pNext = pBegin;
+   size_t count = 0u;
+   *ppNext = pEnd;
+   while (pEnd - pNext >= 64)
+   {
+      uint64_t mask = (uint64_t) bstr_classify_avx2(_mm256_loadu_si256((const __m256i*) pNext), set)
+                    | ((uint64_t) bstr_classify_avx2(_mm256_loadu_si256((const __m256i*) (pNext + 32)), set) << 32);
+      if (!bstr_index_mask(mask, pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext))
+      {
+         return count;
+      }
+      pNext += 64;
+   }
+   (void) bstr_index_mask(bstr_index_any_tail_mask(pNext, pEnd, set), pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext);
+   return count;
+}
+
+BSTR_TARGET("avx512f,avx512bw")
+static size_t bstr_index_any_avx512(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, size_t *positions, size_t maxPositions, const uint8_t **ppNext)
+{
+   const uint8_t *pNext = pBegin;
+   const bool useSecondTable = set->numTables > 1u;
+   const __m512i lo0 = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) set->lo[0]));
+   const __m512i hi0 = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) set->hi[0]));
+   const __m512i lo1 = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) set->lo[1]));
+   const __m512i hi1 = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) set->hi[1]));
+   size_t count = 0u;
+   *ppNext = pEnd;
+   while (pEnd - pNext >= 64)
+   {
+      uint64_t mask = (uint64_t) bstr_classify_avx512(_mm512_loadu_si512((const void*) pNext), lo0, hi0, lo1, hi1, useSecondTable);
+      if (!bstr_index_mask(mask, pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext))
+      {
+         return count;
+      }
+      pNext += 64;
+   }
+   if (pNext < pEnd)
+   {
+      __mmask64 loadMask = ((__mmask64) 1u << (uint32_t) (pEnd - pNext)) - 1u;
+      __m512i v = _mm512_maskz_loadu_epi8(loadMask, (const void*) pNext);
+      uint64_t mask = (uint64_t) (bstr_classify_avx512(v, lo0, hi0, lo1, hi1, useSecondTable) & loadMask);
+      (void) bstr_index_mask(mask, pBegin, (size_t) (pNext - pBegin), positions, maxPositions, &count, ppNext);
+   }
+   return count;
+}
+
+/*************** json_index ***************/
+
+BSTR_TARGET("sse2")
+static void bstr_json_index_sse2(const uint8_t *pBegin, size_t numBlocks, bstr_json_index_block_t *blocks, bstr_json_scan_state_t *state)
+{
+   const __m128i quote = _mm_set1_epi8('"');
+   const __m128i backslash = _mm_set1_epi8('\\');
+   const __m128i open = _mm_set1_epi8('{');
+   const __m128i close = _mm_set1_epi8('}');
+   const __m128i fold = _mm_set1_epi8(0x20);
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      const uint8_t *pBlock = pBegin + i * 64u;
+      __m128i a = _mm_loadu_si128((const __m128i*) pBlock);
+      __m128i b = _mm_loadu_si128((const __m128i*) (pBlock + 16));
+      __m128i c = _mm_loadu_si128((const __m128i*) (pBlock + 32));
+      __m128i d = _mm_loadu_si128((const __m128i*) (pBlock + 48));
+      uint64_t quotes = bstr_cmpeq_mask_sse2(a, b, c, d, quote);
+      uint64_t escaped = bstr_json_escaped(bstr_cmpeq_mask_sse2(a, b, c, d, backslash), state);
+      uint64_t opens;
+      uint64_t closes;
+      a = _mm_or_si128(a, fold);
+      b = _mm_or_si128(b, fold);
+      c = _mm_or_si128(c, fold);
+      d = _mm_or_si128(d, fold);
+      opens = bstr_cmpeq_mask_sse2(a, b, c, d, open);
+      closes = bstr_cmpeq_mask_sse2(a, b, c, d, close);
+      quotes &= ~escaped;
+      bstr_json_store_block(&blocks[i], quotes, bstr_prefix_xor_swar(quotes), opens, closes, state);
+   }
+}
+
+BSTR_TARGET("avx2,pclmul")
+static void bstr_json_index_avx2(const uint8_t *pBegin, size_t numBlocks, bstr_json_index_block_t *blocks, bstr_json_scan_state_t *state)
+{
+   const __m256i quote = _mm256_set1_epi8('"');
+   const __m256i backslash = _mm256_set1_epi8('\\');
+   const __m256i open = _mm256_set1_epi8('{');
+   const __m256i close = _mm256_set1_epi8('}');
+   const __m256i fold = _mm256_set1_epi8(0x20);
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      const uint8_t *pBlock = pBegin + i * 64u;
+      __m256i lo = _mm256_loadu_si256((const __m256i*) pBlock);
+      __m256i hi = _mm256_loadu_si256((const __m256i*) (pBlock + 32));
+      __m256i loFolded = _mm256_or_si256(lo, fold);
+      __m256i hiFolded = _mm256_or_si256(hi, fold);
+      uint64_t quotes = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, quote))
+                      | ((uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, quote)) << 32);
+      uint64_t backslashes = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, backslash))
+                           | ((uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, backslash)) << 32);
+      uint64_t opens = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(loFolded, open))
+                     | ((uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hiFolded, open)) << 32);
+      uint64_t closes = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(loFolded, close))
+                      | ((uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hiFolded, close)) << 32);
+      quotes &= ~bstr_json_escaped(backslashes, state);
+      bstr_json_store_block(&blocks[i], quotes, bstr_prefix_xor_clmul(quotes), opens, closes, state);
+   }
+}
+
+BSTR_TARGET("avx512f,avx512bw,pclmul")
+static void bstr_json_index_avx512(const uint8_t *pBegin, size_t numBlocks, bstr_json_index_block_t *blocks, bstr_json_scan_state_t *state)
+{
+   const __m512i quote = _mm512_set1_epi8('"');
+   const __m512i backslash = _mm512_set1_epi8('\\');
+   const __m512i open = _mm512_set1_epi8('{');
+   const __m512i close = _mm512_set1_epi8('}');
+   const __m512i fold = _mm512_set1_epi8(0x20);
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      __m512i v = _mm512_loadu_si512((const void*) (pBegin + i * 64u));
+      __m512i folded = _mm512_or_si512(v, fold);
+      uint64_t quotes = (uint64_t) _mm512_cmpeq_epi8_mask(v, quote);
+      uint64_t backslashes = (uint64_t) _mm512_cmpeq_epi8_mask(v, backslash);
+      uint64_t opens = (uint64_t) _mm512_cmpeq_epi8_mask(folded, open);
+      uint64_t closes = (uint64_t) _mm512_cmpeq_epi8_mask(folded, close);
+      quotes &= ~bstr_json_escaped(backslashes, state);
+      bstr_json_store_block(&blocks[i], quotes, bstr_prefix_xor_clmul(quotes), opens, closes, state);
+   }
+}
+
+/*************** json_structurals ***************/
+
+BSTR_TARGET("sse2")
+static void bstr_json_structurals_sse2(const uint8_t *pBegin, size_t numBlocks, uint64_t *structurals, bstr_json_scan_state_t *state)
+{
+   const __m128i quote = _mm_set1_epi8('"');
+   const __m128i backslash = _mm_set1_epi8('\\');
+   const __m128i open = _mm_set1_epi8('{');
+   const __m128i close = _mm_set1_epi8('}');
+   const __m128i colon = _mm_set1_epi8(':');
+   const __m128i comma = _mm_set1_epi8(',');
+   const __m128i space = _mm_set1_epi8(' ');
+   const __m128i tab = _mm_set1_epi8('\t');
+   const __m128i lf = _mm_set1_epi8('\n');
+   const __m128i cr = _mm_set1_epi8('\r');
+   const __m128i fold = _mm_set1_epi8(0x20);
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      const uint8_t *pBlock = pBegin + i * 64u;
+      uint64_t quotes = 0u, backslashes = 0u, operators = 0u, whitespace = 0u;
+      uint32_t j;
+      for (j = 0u; j < 64u; j += 16u)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i*) (pBlock + j));
+         __m128i folded = _mm_or_si128(v, fold); //'[' and ']' fold onto '{' and '}'
+         __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+         __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+         quotes |= (uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << j;
+         backslashes |= (uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) << j;
+         operators |= (uint64_t) (uint32_t) _mm_movemask_epi8(op) << j;
+         whitespace |= (uint64_t) (uint32_t) _mm_movemask_epi8(ws) << j;
+      }
+      quotes &= ~bstr_json_escaped(backslashes, state);
+      structurals[i] = bstr_json_structurals_block(quotes, bstr_prefix_xor_swar(quotes), operators, whitespace, state);
+   }
+}
+
+BSTR_TARGET("avx2,pclmul")
+static void bstr_json_structurals_avx2(const uint8_t *pBegin, size_t numBlocks, uint64_t *structurals, bstr_json_scan_state_t *state)
+{
+   const __m256i quote = _mm256_set1_epi8('"');
+   const __m256i backslash = _mm256_set1_epi8('\\');
+   const __m256i open = _mm256_set1_epi8('{');
+   const __m256i close = _mm256_set1_epi8('}');
+   const __m256i colon = _mm256_set1_epi8(':');
+   const __m256i comma = _mm256_set1_epi8(',');
+   const __m256i space = _mm256_set1_epi8(' ');
+   const __m256i tab = _mm256_set1_epi8('\t');
+   const __m256i lf = _mm256_set1_epi8('\n');
+   const __m256i cr = _mm256_set1_epi8('\r');
+   const __m256i fold = _mm256_set1_epi8(0x20);
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      const uint8_t *pBlock = pBegin + i * 64u;
+      uint64_t quotes = 0u, backslashes = 0u, operators = 0u, whitespace = 0u;
+      uint32_t j;
+      for (j = 0u; j < 64u; j += 32u)
+      {
+         __m256i v = _mm256_loadu_si256((const __m256i*) (pBlock + j));
+         __m256i folded = _mm256_or_si256(v, fold);
+         __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+         __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+         quotes |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)) << j;
+         backslashes |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)) << j;
+         operators |= (uint64_t) (uint32_t) _mm256_movemask_epi8(op) << j;
+         whitespace |= (uint64_t) (uint32_t) _mm256_movemask_epi8(ws) << j;
+      }
+      quotes &= ~bstr_json_escaped(backslashes, state);
+      structurals[i] = bstr_json_structurals_block(quotes, bstr_prefix_xor_clmul(quotes), operators, whitespace, state);
+   }
+}
+
+BSTR_TARGET("avx512f,avx512bw,pclmul")
+static void bstr_json_structurals_avx512(const uint8_t *pBegin, size_t numBlocks, uint64_t *structurals, bstr_json_scan_state_t *state)
+{
+   const __m512i quote = _mm512_set1_epi8('"');
+   const __m512i backslash = _mm512_set1_epi8('\\');
+   const __m512i open = _mm512_set1_epi8('{');
+   const __m512i close = _mm512_set1_epi8('}');
+   const __m512i colon = _mm512_set1_epi8(':');
+   const __m512i comma = _mm512_set1_epi8(',');
+   const __m512i space = _mm512_set1_epi8(' ');
+   const __m512i tab = _mm512_set1_epi8('\t');
+   const __m512i lf = _mm512_set1_epi8('\n');
+   const __m512i cr = _mm512_set1_epi8('\r');
+   const __m512i fold = _mm512_set1_epi8(0x20);
+   size_t i;
+   for (i = 0u; i < numBlocks; i++)
+   {
+      __m512i v = _mm512_loadu_si512((const void*) (pBegin + i * 64u));
+      __m512i folded = _mm512_or_si512(v, fold);
+      uint64_t quotes = (uint64_t) _mm512_cmpeq_epi8_mask(v, quote);
+      uint64_t backslashes = (uint64_t) _mm512_cmpeq_epi8_mask(v, backslash);
+      uint64_t operators = (uint64_t) (_mm512_cmpeq_epi8_mask(folded, open) | _mm512_cmpeq_epi8_mask(folded, close) |
+                                       _mm512_cmpeq_epi8_mask(v, colon) | _mm512_cmpeq_epi8_mask(v, comma));
+      uint64_t whitespace = (uint64_t) (_mm512_cmpeq_epi8_mask(v, space) | _mm512_cmpeq_epi8_mask(v, tab) |
+                                        _mm512_cmpeq_epi8_mask(v, lf) | _mm512_cmpeq_epi8_mask(v, cr));
+      quotes &= ~bstr_json_escaped(backslashes, state);
+      structurals[i] = bstr_json_structurals_block(quotes, bstr_prefix_xor_clmul(quotes), operators, whitespace, state);
+   }
+}
+
+/*************** json_string ***************/
+
+BSTR_TARGET("sse2")
+static inline uint32_t bstr_json_string_mask_sse2(__m128i v)
+{
+   __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+   special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1F)), v)); //v <= 0x1F
+   return (uint32_t) _mm_movemask_epi8(special);
+}
+
+/**
+ * Same as bstr_json_string_ascii_swar
+ */
+BSTR_TARGET("sse2")
+static const uint8_t *bstr_json_string_ascii_sse2(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const uint8_t *pNext = pBegin;
+   if (pEnd - pBegin < 16)
+   {
+      return bstr_json_string_ascii_swar(pBegin, pEnd);
+   }
+   while (pEnd - pNext >= 16)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i*) pNext);
+      uint32_t mask = bstr_json_string_mask_sse2(v) | (uint32_t) _mm_movemask_epi8(v);
+      if (mask != 0u)
+      {
+         return pNext + bstr_ctz32(mask);
+      }
+      pNext += 16;
+   }
+   if (pNext < pEnd)
+   {
+      const uint8_t *pLast = pEnd - 16;
+      __m128i v = _mm_loadu_si128((const __m128i*) pLast);
+      uint32_t mask = bstr_json_string_mask_sse2(v) | (uint32_t) _mm_movemask_epi8(v);
+      mask &= 0xFFFFu << (uint32_t) (pNext - pLast);
+      if (mask != 0u)
+      {
+         return pLast + bstr_ctz32(mask);
+      }
+   }
+   return pEnd;
+}
+
+/**
+ * Without SSSE3 there is no byte shuffle for the vectorized UTF-8 check, non-ASCII sequences are validated one by one.
+ */
+BSTR_TARGET("sse2")
+static const uint8_t *bstr_json_string_sse2(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const uint8_t *pNext = pBegin;
+   for (;;)
+   {
+      const uint8_t *pStop = bstr_json_string_ascii_sse2(pNext, pEnd);
+      if ( (pStop == pEnd) || (*pStop < 0x80u) )
+      {
+         return pStop;
+      }
+      pNext = bstr_utf8_sequence_end(pStop, pEnd);
+      if (pNext == pStop)
+      {
+         return pStop;
+      }
+   }
+}
+
+/**
+ * Keiser-Lemire UTF-8 check of input given the previous 16 bytes. Returns non-zero bytes where a sequence is invalid.
+ */
+BSTR_TARGET("ssse3")
+static inline __m128i bstr_utf8_errors_ssse3(__m128i input, __m128i prevInput)
+{
+   const __m128i lowNibble = _mm_set1_epi8(0x0F);
+   __m128i prev1 = _mm_alignr_epi8(input, prevInput, 15);
+   __m128i prev2 = _mm_alignr_epi8(input, prevInput, 14);
+   __m128i prev3 = _mm_alignr_epi8(input, prevInput, 13);
+   __m128i prevHigh = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) m_utf8PrevHigh), _mm_and_si128(_mm_srli_epi16(prev1, 4), lowNibble));
+   __m128i prevLow = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) m_utf8PrevLow), _mm_and_si128(prev1, lowNibble));
+   __m128i curHigh = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) m_utf8CurHigh), _mm_and_si128(_mm_srli_epi16(input, 4), lowNibble));
+   __m128i special = _mm_and_si128(_mm_and_si128(prevHigh, prevLow), curHigh);
+   //3rd and 4th bytes of a sequence must be continuations, the tables only see the byte before
+   __m128i isThird = _mm_subs_epu8(prev2, _mm_set1_epi8((char) (0xE0u - 0x80u)));
+   __m128i isFourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char) (0xF0u - 0x80u)));
+   __m128i mustBeCont = _mm_and_si128(_mm_or_si128(isThird, isFourth), _mm_set1_epi8((char) 0x80));
+   return _mm_xor_si128(mustBeCont, special);
+}
+
+BSTR_TARGET("ssse3")
+static const uint8_t *bstr_json_string_ssse3(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const uint8_t *pNext = pBegin;
+   __m128i prevInput = _mm_setzero_si128();
+   uint32_t prevHigh = 0u;
+   if (pEnd - pBegin < 16)
+   {
+      return bstr_json_string_swar(pBegin, pEnd);
+   }
+   while (pNext < pEnd)
+   {
+      uint8_t tail[16];
+      uint32_t valid = 0xFFFFu;
+      uint32_t special;
+      uint32_t high;
+      uint32_t errors = 0u;
+      __m128i v;
+      if (pEnd - pNext >= 16)
+      {
+         v = _mm_loadu_si128((const __m128i*) pNext);
+      }
+      else
+      {
+         memset(tail, 0, sizeof(tail));
+         memcpy(tail, pNext, (size_t) (pEnd - pNext));
+         v = _mm_loadu_si128((const __m128i*) tail);
+         valid = (1u << (uint32_t) (pEnd - pNext)) - 1u;
+      }
+      special = bstr_json_string_mask_sse2(v) & valid;
+      high = (uint32_t) _mm_movemask_epi8(v);
+      if ( (high | prevHigh) != 0u )
+      {
+         __m128i err = bstr_utf8_errors_ssse3(v, prevInput);
+         errors = ~(uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(err, _mm_setzero_si128())) & valid;
+      }
+      if ( (special | errors) != 0u )
+      {
+         return bstr_json_string_block_stop(pNext, special, errors);
+      }
+      prevInput = v;
+      prevHigh = high;
+      pNext += 16;
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("avx2")
+static inline uint32_t bstr_json_string_mask_avx2(__m256i v)
+{
+   __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+   special = _mm256_or_si256(special, _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1F)), v));
+   return (uint32_t) _mm256_movemask_epi8(special);
+}
+
+BSTR_TARGET("avx2")
+static inline __m256i bstr_utf8_errors_avx2(__m256i input, __m256i prevInput)
+{
+   const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+   __m256i shifted = _mm256_permute2x128_si256(prevInput, input, 0x21); //high lane of prevInput, low lane of input
+   __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+   __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+   __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+   __m256i prevHigh = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) m_utf8PrevHigh)),
+                                          _mm256_and_si256(_mm256_srli_epi16(prev1, 4), lowNibble));
+   __m256i prevLow = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) m_utf8PrevLow)),
+                                         _mm256_and_si256(prev1, lowNibble));
+   __m256i curHigh = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) m_utf8CurHigh)),
+                                         _mm256_and_si256(_mm256_srli_epi16(input, 4), lowNibble));
+   __m256i special = _mm256_and_si256(_mm256_and_si256(prevHigh, prevLow), curHigh);
+   __m256i isThird = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char) (0xE0u - 0x80u)));
+   __m256i isFourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char) (0xF0u - 0x80u)));
+   __m256i mustBeCont = _mm256_and_si256(_mm256_or_si256(isThird, isFourth), _mm256_set1_epi8((char) 0x80));
+   return _mm256_xor_si256(mustBeCont, special);
+}
+
+BSTR_TARGET("avx2")
+static const uint8_t *bstr_json_string_avx2(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const uint8_t *pNext = pBegin;
+   __m256i prevInput = _mm256_setzero_si256();
+   uint32_t prevHigh = 0u;
+   if (pEnd - pBegin < 32)
+   {
+      return bstr_json_string_ssse3(pBegin, pEnd);
+   }
+   while (pNext < pEnd)
+   {
+      uint8_t tail[32];
+      uint32_t valid = 0xFFFFFFFFu;
+      uint32_t special;
+      uint32_t high;
+      uint32_t errors = 0u;
+      __m256i v;
+      if (pEnd - pNext >= 32)
+      {
+         v = _mm256_loadu_si256((const __m256i*) pNext);
+      }
+      else
+      {
+         memset(tail, 0, sizeof(tail));
+         memcpy(tail, pNext, (size_t) (pEnd - pNext));
+         v = _mm256_loadu_si256((const __m256i*) tail);
+         valid = (1u << (uint32_t) (pEnd - pNext)) - 1u;
+      }
+      special = bstr_json_string_mask_avx2(v) & valid;
+      high = (uint32_t) _mm256_movemask_epi8(v);
+      if ( (high | prevHigh) != 0u )
+      {
+         __m256i err = bstr_utf8_errors_avx2(v, prevInput);
+         errors = ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(err, _mm256_setzero_si256())) & valid;
+      }
+      if ( (special | errors) != 0u )
+      {
+         return bstr_json_string_block_stop(pNext, special, errors);
+      }
+      prevInput = v;
+      prevHigh = high;
+      pNext += 32;
+   }
+   return pEnd;
+}
+
+BSTR_TARGET("avx512f,avx512bw")
+static inline __m512i bstr_utf8_errors_avx512(__m512i input, __m512i prevInput)
+{
+   const __m512i lowNibble = _mm512_set1_epi8(0x0F);
+   //last lane of prevInput followed by the first three lanes of input
+   __m512i shifted = _mm512_permutex2var_epi64(input, _mm512_setr_epi64(14, 15, 0, 1, 2, 3, 4, 5), prevInput);
+   __m512i prev1 = _mm512_alignr_epi8(input, shifted, 15);
+   __m512i prev2 = _mm512_alignr_epi8(input, shifted, 14);
+   __m512i prev3 = _mm512_alignr_epi8(input, shifted, 13);
+   __m512i prevHigh = _mm512_shuffle_epi8(_mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) m_utf8PrevHigh)),
+                                          _mm512_and_si512(_mm512_srli_epi16(prev1, 4), lowNibble));
+   __m512i prevLow = _mm512_shuffle_epi8(_mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) m_utf8PrevLow)),
+                                         _mm512_and_si512(prev1, lowNibble));
+   __m512i curHigh = _mm512_shuffle_epi8(_mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*) m_utf8CurHigh)),
+                                         _mm512_and_si512(_mm512_srli_epi16(input, 4), lowNibble));
+   __m512i special = _mm512_and_si512(_mm512_and_si512(prevHigh, prevLow), curHigh);
+   __m512i isThird = _mm512_subs_epu8(prev2, _mm512_set1_epi8((char) (0xE0u - 0x80u)));
+   __m512i isFourth = _mm512_subs_epu8(prev3, _mm512_set1_epi8((char) (0xF0u - 0x80u)));
+   __m512i mustBeCont = _mm512_and_si512(_mm512_or_si512(isThird, isFourth), _mm512_set1_epi8((char) 0x80));
+   return _mm512_xor_si512(mustBeCont, special);
+}
+
+BSTR_TARGET("avx512f,avx512bw")
+static const uint8_t *bstr_json_string_avx512(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   const uint8_t *pNext = pBegin;
+   const __m512i quote = _mm512_set1_epi8('"');
+   const __m512i backslash = _mm512_set1_epi8('\\');
+   const __m512i space = _mm512_set1_epi8(0x20);
+   __m512i prevInput = _mm512_setzero_si512();
+   __mmask64 prevHigh = 0u;
+   while (pNext < pEnd)
+   {
+      __mmask64 valid = ~(__mmask64) 0u;
+      __mmask64 special;
+      __mmask64 high;
+      __mmask64 errors = 0u;
+      __m512i v;
+      if (pEnd - pNext < 64)
+      {
+         valid = ((__mmask64) 1u << (uint32_t) (pEnd - pNext)) - 1u;
+      }
+      v = _mm512_maskz_loadu_epi8(valid, (const void*) pNext);
+      special = _mm512_mask_cmpeq_epi8_mask(valid, v, quote) | _mm512_mask_cmpeq_epi8_mask(valid, v, backslash) |
+                _mm512_mask_cmplt_epu8_mask(valid, v, space);
+      high = _mm512_movepi8_mask(v);
+      if ( (high | prevHigh) != 0u )
+      {
+         __m512i err = bstr_utf8_errors_avx512(v, prevInput);
+         errors = _mm512_test_epi8_mask(err, err) & valid;
+      }
+      if ( (special | errors) != 0u )
+      {
+         return bstr_json_string_block_stop(pNext, special, errors);
+      }
+      prevInput = v;
+      prevHigh = high;
+      pNext += 64;
+   }
+   return pEnd;
+}
+
+#endif //BSTR_SIMD_X86
@@ -0,0 +1,333 @@
+/*****************************************************************************
+* \file      bstr_simd.h
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Private SIMD kernels and CPU dispatch for bstr
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+#ifndef BSTR_SIMD_H
+#define BSTR_SIMD_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "bstr.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+#if !defined(BSTR_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define BSTR_SIMD_X86 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define BSTR_TARGET(x)
+#else
+#define BSTR_TARGET(x) __attribute__((target(x)))
+#endif
+
+#ifdef BSTR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+#define BSTR_LITTLE_ENDIAN 1
+#endif
+
+#define BSTR_SWAR_ONES  ((uint64_t) 0x0101010101010101ull)
+#define BSTR_SWAR_HIGHS ((uint64_t) 0x8080808080808080ull)
+
+/**
+ * Internal kernels return pEnd when nothing was found, the public wrappers translate that into the
+ * "return pBegin when not found" convention used by the rest of the library.
+ */
+typedef const uint8_t *(*bstr_search_val_func_t)(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val);
+typedef const uint8_t *(*bstr_search_any_func_t)(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set);
+
+/**
+ * Finds needle using first/last byte candidate filtering. Each verified candidate is charged to a work budget
+ * proportional to the bytes scanned. When the budget runs out the kernel gives up, stores the first position
+ * not yet excluded in *ppStop and returns pEnd, the caller is then expected to continue with Two-Way.
+ */
+typedef const uint8_t *(*bstr_find_short_func_t)(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pNeedle, size_t needleLen, const uint8_t **ppStop);
+
+/**
+ * Stores the offset (relative to pBegin) of each occurrence of val until maxPositions offsets have been stored.
+ * Returns the number of offsets stored. *ppNext is set to the first byte not yet examined which is pEnd unless
+ * the kernel stopped early because positions was full.
+ */
+typedef size_t (*bstr_index_val_func_t)(const uint8_t *pBegin, const uint8_t *pEnd, uint8_t val, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+
+/**
+ * Same as bstr_index_val_func_t for every byte which is a member of set.
+ */
+typedef size_t (*bstr_index_any_func_t)(const uint8_t *pBegin, const uint8_t *pEnd, const bstr_byteset_t *set, size_t *positions, size_t maxPositions, const uint8_t **ppNext);
+
+/**
+ * Carried between the 64-byte blocks of a JSON document while building a bstr_json_index_t or structural positions.
+ */
+typedef struct bstr_json_scan_state_tag
+{
+   uint64_t prevEscaped;   //1 when the first byte of the next block is escaped
+   uint64_t prevInString;  //all ones when the next block starts inside a string
+   uint64_t prevScalar;    //1 when the last byte of the previous block is part of a number or literal
+} bstr_json_scan_state_t;
+
+/**
+ * Computes the structural masks of numBlocks complete 64-byte blocks starting at pBegin.
+ */
+typedef void (*bstr_json_index_func_t)(const uint8_t *pBegin, size_t numBlocks, bstr_json_index_block_t *blocks, bstr_json_scan_state_t *state);
+
+/**
+ * Computes one structural mask per complete 64-byte block starting at pBegin: '{', '}', '[', ']', ':' and ','
+ * outside of strings, the opening quote of each string and the first byte of each number or literal.
+ */
+typedef void (*bstr_json_structurals_func_t)(const uint8_t *pBegin, size_t numBlocks, uint64_t *structurals, bstr_json_scan_state_t *state);
+
+/**
+ * Returns the first byte that ends a run of plain JSON string content, that is '"', '\\' or a control character
+ * (below 0x20). The run is validated as UTF-8 in the same scan, an invalid sequence stops the scan at one of its
+ * non-ASCII bytes. Returns pEnd when there is no stop, also when pEnd cuts off an otherwise valid sequence.
+ */
+typedef const uint8_t *(*bstr_json_string_func_t)(const uint8_t *pBegin, const uint8_t *pEnd);
+
+typedef struct bstr_simd_ops_tag
+{
+   uint32_t features;
+   bstr_search_val_func_t search_val;
+   bstr_search_any_func_t search_any;
+   bstr_search_any_func_t search_any_reverse; //returns last match or pEnd
+   bstr_find_short_func_t find_short;
+   bstr_index_val_func_t index_val;
+   bstr_index_any_func_t index_any;
+   bstr_json_index_func_t json_index;
+   bstr_json_structurals_func_t json_structurals;
+   bstr_json_string_func_t json_string;
+} bstr_simd_ops_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+const bstr_simd_ops_t *bstr_simd_ops_init(void);
+extern const bstr_simd_ops_t *g_bstr_simd_ops;
+
+/**
+ * Returns the kernel table selected for the running CPU. The table is resolved once, on first use. The acquire load
+ * pairs with the release store in bstr_simd_ops_init (MSVC volatile reads are acquire loads under /volatile:ms,
+ * the default on x86 and x64).
+ */
+static inline const bstr_simd_ops_t *bstr_simd_ops(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+   const bstr_simd_ops_t *ops = *(const bstr_simd_ops_t * const volatile*) &g_bstr_simd_ops;
+#else
+   const bstr_simd_ops_t *ops = __atomic_load_n(&g_bstr_simd_ops, __ATOMIC_ACQUIRE);
+#endif
+   return (ops != 0) ? ops : bstr_simd_ops_init();
+}
+
+static inline uint32_t bstr_ctz32(uint32_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+   unsigned long index;
+   _BitScanForward(&index, x);
+   return (uint32_t) index;
+#else
+   return (uint32_t) __builtin_ctz(x);
+#endif
+}
+
+static inline uint32_t bstr_ctz64(uint64_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_ARM64))
+   unsigned long index;
+   _BitScanForward64(&index, x);
+   return (uint32_t) index;
+#elif defined(_MSC_VER) && !defined(__clang__)
+   uint32_t low = (uint32_t) x;
+   return (low != 0u) ? bstr_ctz32(low) : 32u + bstr_ctz32((uint32_t) (x >> 32));
+#else
+   return (uint32_t) __builtin_ctzll(x);
+#endif
+}
+
+static inline uint32_t bstr_bsr32(uint32_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+   unsigned long index;
+   _BitScanReverse(&index, x);
+   return (uint32_t) index;
+#else
+   return 31u - (uint32_t) __builtin_clz(x);
+#endif
+}
+
+static inline uint32_t bstr_bsr64(uint64_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_ARM64))
+   unsigned long index;
+   _BitScanReverse64(&index, x);
+   return (uint32_t) index;
+#elif defined(_MSC_VER) && !defined(__clang__)
+   uint32_t high = (uint32_t) (x >> 32);
+   return (high != 0u) ? 32u + bstr_bsr32(high) : bstr_bsr32((uint32_t) x);
+#else
+   return 63u - (uint32_t) __builtin_clzll(x);
+#endif
+}
+
+static inline uint32_t bstr_popcount64(uint64_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+   x = x - ((x >> 1) & 0x5555555555555555ull);
+   x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+   x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+   return (uint32_t) ((x * BSTR_SWAR_ONES) >> 56);
+#else
+   return (uint32_t) __builtin_popcountll(x);
+#endif
+}
+
+/**
+ * Returns true when all eight bytes of the little endian word are ASCII decimal digits.
+ */
+static inline bool bstr_swar_is_eight_digits(uint64_t x)
+{
+   return ( (x & 0xF0F0F0F0F0F0F0F0ull) | (((x + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4) ) == 0x3333333333333333ull;
+}
+
+/**
+ * Converts eight ASCII decimal digits (first digit in the lowest byte) to their value using three multiplications.
+ */
+static inline uint32_t bstr_swar_parse_eight_digits(uint64_t x)
+{
+   const uint64_t mask = 0x000000FF000000FFull;
+   const uint64_t mul1 = 0x000F424000000064ull; //100 + (1000000 << 32)
+   const uint64_t mul2 = 0x0000271000000001ull; //1 + (10000 << 32)
+   x -= 0x3030303030303030ull;
+   x = (x * 10u) + (x >> 8);
+   x = (((x & mask) * mul1) + (((x >> 16) & mask) * mul2)) >> 32;
+   return (uint32_t) x;
+}
+
+/**
+ * Converts eight ASCII hexadecimal digits (first digit in the lowest byte, either case) to their value.
+ * Returns false when any of the bytes is not a hexadecimal digit.
+ */
+static inline bool bstr_swar_parse_eight_hex_digits(uint64_t x, uint32_t *value)
+{
+   uint64_t folded = x | 0x2020202020202020ull; //'A'-'F' to 'a'-'f', digits are unaffected
+   uint64_t isDigit = (x + (0x80u - 0x30u) * BSTR_SWAR_ONES) & ~(x + (0x7Fu - 0x39u) * BSTR_SWAR_ONES);
+   uint64_t isAlpha = (folded + (0x80u - 0x61u) * BSTR_SWAR_ONES) & ~(folded + (0x7Fu - 0x66u) * BSTR_SWAR_ONES);
+   uint64_t nibbles;
+   //the range checks above are only valid for 7-bit bytes
+   if ( ((x & BSTR_SWAR_HIGHS) != 0u) || (((isDigit | isAlpha) & BSTR_SWAR_HIGHS) != BSTR_SWAR_HIGHS) )
+   {
+      return false;
+   }
+   nibbles = (folded & 0x0F0F0F0F0F0F0F0Full) + ((isAlpha & BSTR_SWAR_HIGHS) >> 7) * 9u;
+   nibbles = ((nibbles << 4) + (nibbles >> 8)) & 0x00FF00FF00FF00FFull;
+   nibbles = ((nibbles << 8) + (nibbles >> 16)) & 0x0000FFFF0000FFFFull;
+   nibbles = ((nibbles << 16) + (nibbles >> 32)) & 0x00000000FFFFFFFFull;
+   *value = (uint32_t) nibbles;
+   return true;
+}
+
+/**
+ * Parses the 4 hex digits at p in one step by padding them with '0' digits to a word of 8.
+ */
+static inline bool bstr_swar_parse_four_hex_digits(const uint8_t *p, uint32_t *value)
+{
+   uint64_t x = (uint64_t) p[0] | ((uint64_t) p[1] << 8) | ((uint64_t) p[2] << 16) | ((uint64_t) p[3] << 24) | 0x3030303000000000ull;
+   if (!bstr_swar_parse_eight_hex_digits(x, value))
+   {
+      return false;
+   }
+   *value >>= 16;
+   return true;
+}
+
+/**
+ * Returns a word where bit i is the xor of bits 0..i of x. Used to turn a mask of quotes into a mask of string interiors.
+ */
+static inline uint64_t bstr_prefix_xor_swar(uint64_t x)
+{
+   x ^= x << 1;
+   x ^= x << 2;
+   x ^= x << 4;
+   x ^= x << 8;
+   x ^= x << 16;
+   x ^= x << 32;
+   return x;
+}
+
+#ifdef BSTR_SIMD_X86
+BSTR_TARGET("sse2,pclmul")
+static inline uint64_t bstr_prefix_xor_clmul(uint64_t x)
+{
+   //carry-less multiplication by all ones computes the prefix xor in a single instruction
+   __m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, (int64_t) x), _mm_set1_epi8((char) 0xFF), 0);
+   return (uint64_t) _mm_cvtsi128_si64(product);
+}
+
+/**
+ * Returns a 64-bit mask of the bytes in the four 16-byte registers a-d that are equal to pattern.
+ */
+BSTR_TARGET("sse2")
+static inline uint64_t bstr_cmpeq_mask_sse2(__m128i a, __m128i b, __m128i c, __m128i d, __m128i pattern)
+{
+   return (uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(a, pattern))
+        | ((uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(b, pattern)) << 16)
+        | ((uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(c, pattern)) << 32)
+        | ((uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(d, pattern)) << 48);
+}
+#endif
+
+static inline bool bstr_byteset_has(const bstr_byteset_t *set, uint8_t c)
+{
+   return (set->bits[c >> 5] & (1u << (c & 31u))) != 0u;
+}
+
+static inline uint64_t bstr_load_u64(const uint8_t *p)
+{
+   uint64_t v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+/**
+ * Returns a word where the high bit of each byte is set where the corresponding byte of x is zero.
+ * Bits above the first zero byte may be false positives so only the lowest set bit is exact.
+ */
+static inline uint64_t bstr_swar_zero_bytes(uint64_t x)
+{
+   return (x - BSTR_SWAR_ONES) & ~x & BSTR_SWAR_HIGHS;
+}
+
+#endif //BSTR_SIMD_H
@@ -0,0 +1,457 @@
+/*****************************************************************************
+* \file      bstr_tokenizer.c
+* \author    bstr contributors
+* \date      2026-10-17
+* \brief     Resumable JSON tokenizer for input arriving in chunks
+*
+* Copyright (c) 2026 bstr contributors
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+* the Software, and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+* FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+******************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#include "bstr_tokenizer.h"
+#include "bstr_simd.h"
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define STATE_NONE      0u  //between tokens
+#define STATE_STRING    1u  //string literal continues in the next chunk
+#define STATE_NUMBER    2u
+#define STATE_LITERAL   3u
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static bstr_error_t bstr_tokenizer_string(bstr_tokenizer_t *self, const uint8_t *pBegin, bstr_token_t *token);
+static bstr_error_t bstr_tokenizer_resume_string(bstr_tokenizer_t *self, bstr_token_t *token);
+static const uint8_t *bstr_tokenizer_string_end(bstr_tokenizer_t *self, const uint8_t *pNext);
+static bstr_error_t bstr_tokenizer_number(bstr_tokenizer_t *self, const uint8_t *pBegin, bstr_token_t *token);
+static bstr_error_t bstr_tokenizer_resume_number(bstr_tokenizer_t *self, bstr_token_t *token);
+static bstr_error_t bstr_tokenizer_literal(bstr_tokenizer_t *self, const uint8_t *pBegin, bstr_token_t *token);
+static bstr_error_t bstr_tokenizer_suspend(bstr_tokenizer_t *self, uint8_t state, const uint8_t *pBegin, bstr_token_t *token);
+static bstr_error_t bstr_tokenizer_error(bstr_tokenizer_t *self, bstr_error_t errorCode);
+static void bstr_tokenizer_emit(bstr_token_t *token, uint8_t type, const uint8_t *pBegin, const uint8_t *pEnd, bool isView);
+static const uint8_t *bstr_tokenizer_number_run(const uint8_t *pBegin, const uint8_t *pEnd);
+static bool bstr_tokenizer_is_number_char(uint8_t c);
+
+//////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Creates a tokenizer without input. Tokens which straddle chunks are copied to a buffer from allocator,
+ * NULL selects the default allocator.
+ */
+void bstr_tokenizer_create(bstr_tokenizer_t *self, const bstr_allocator_t *allocator)
+{
+   if (self != 0)
+   {
+      bstr_context_create(&self->ctx);
+      bstr_context_set_allocator(&self->ctx, allocator);
+      bstr_buf_create(&self->spill, allocator);
+      bstr_tokenizer_reset(self);
+   }
+}
+
+void bstr_tokenizer_destroy(bstr_tokenizer_t *self)
+{
+   if (self != 0)
+   {
+      bstr_buf_destroy(&self->spill);
+   }
+}
+
+/**
+ * Prepares the tokenizer for a new document. The spill buffer keeps its storage.
+ */
+void bstr_tokenizer_reset(bstr_tokenizer_t *self)
+{
+   if (self != 0)
+   {
+      bstr_clear_error(&self->ctx);
+      bstr_buf_clear(&self->spill);
+      self->pNext = 0;
+      self->pEnd = 0;
+      self->literal = 0;
+      self->literalPos = 0u;
+      self->literalType = BSTR_TOKEN_NEED_MORE;
+      self->state = STATE_NONE;
+      self->isEscapePending = false;
+      self->isFinal = false;
+   }
+}
+
+/**
+ * Gives the next chunk of input to the tokenizer. The previous chunk must have been consumed
+ * (bstr_tokenizer_next returned BSTR_TOKEN_NEED_MORE). The chunk must stay valid while tokens from it are in use.
+ */
+bstr_error_t bstr_tokenizer_feed(bstr_tokenizer_t *self, const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   if ( (self == 0) || (pBegin == 0) || (pEnd == 0) || (pEnd < pBegin) || (self->pNext != self->pEnd) || self->isFinal )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   self->pNext = pBegin;
+   self->pEnd = pEnd;
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Tells the tokenizer that no more chunks will follow. This completes a number at the end of the input and lets
+ * bstr_tokenizer_next return BSTR_TOKEN_END (or BSTR_PREMATURE_END_OF_BUFFER_ERROR inside a token).
+ */
+void bstr_tokenizer_finish(bstr_tokenizer_t *self)
+{
+   if (self != 0)
+   {
+      self->isFinal = true;
+   }
+}
+
+/**
+ * Reads the next token. When the current chunk is consumed the token type is BSTR_TOKEN_NEED_MORE, a token cut by
+ * the end of the chunk is then continued by the next call after bstr_tokenizer_feed.
+ * Errors are sticky, the same error is returned until bstr_tokenizer_reset is called.
+ */
+bstr_error_t bstr_tokenizer_next(bstr_tokenizer_t *self, bstr_token_t *token)
+{
+   const uint8_t *pNext;
+   if ( (self == 0) || (token == 0) )
+   {
+      return BSTR_INVALID_ARGUMENT_ERROR;
+   }
+   bstr_tokenizer_emit(token, BSTR_TOKEN_NEED_MORE, 0, 0, false);
+   if (self->ctx.lastError != BSTR_NO_ERROR)
+   {
+      return self->ctx.lastError;
+   }
+   switch (self->state)
+   {
+   case STATE_STRING:
+      return bstr_tokenizer_resume_string(self, token);
+   case STATE_NUMBER:
+      return bstr_tokenizer_resume_number(self, token);
+   case STATE_LITERAL:
+      return bstr_tokenizer_literal(self, self->pNext, token);
+   default:
+      break;
+   }
+   pNext = self->pNext;
+   while ( (pNext < self->pEnd) && ( (*pNext == (uint8_t) ' ') || (*pNext == (uint8_t) '\n') ||
+           (*pNext == (uint8_t) '\r') || (*pNext == (uint8_t) '\t') ) )
+   {
+      pNext++;
+   }
+   self->pNext = pNext;
+   if (pNext == self->pEnd)
+   {
+      token->type = self->isFinal? BSTR_TOKEN_END : BSTR_TOKEN_NEED_MORE;
+      return BSTR_NO_ERROR;
+   }
+   switch (*pNext)
+   {
+   case '{':
+      bstr_tokenizer_emit(token, BSTR_TOKEN_BEGIN_OBJECT, pNext, pNext + 1, true);
+      break;
+   case '}':
+      bstr_tokenizer_emit(token, BSTR_TOKEN_END_OBJECT, pNext, pNext + 1, true);
+      break;
+   case '[':
+      bstr_tokenizer_emit(token, BSTR_TOKEN_BEGIN_ARRAY, pNext, pNext + 1, true);
+      break;
+   case ']':
+      bstr_tokenizer_emit(token, BSTR_TOKEN_END_ARRAY, pNext, pNext + 1, true);
+      break;
+   case ':':
+      bstr_tokenizer_emit(token, BSTR_TOKEN_NAME_SEPARATOR, pNext, pNext + 1, true);
+      break;
+   case ',':
+      bstr_tokenizer_emit(token, BSTR_TOKEN_VALUE_SEPARATOR, pNext, pNext + 1, true);
+      break;
+   case '"':
+      return bstr_tokenizer_string(self, pNext, token);
+   case 't':
+      self->literal = "true";
+      self->literalType = BSTR_TOKEN_TRUE;
+      self->literalPos = 0u;
+      return bstr_tokenizer_literal(self, pNext, token);
+   case 'f':
+      self->literal = "false";
+      self->literalType = BSTR_TOKEN_FALSE;
+      self->literalPos = 0u;
+      return bstr_tokenizer_literal(self, pNext, token);
+   case 'n':
+      self->literal = "null";
+      self->literalType = BSTR_TOKEN_NULL;
+      self->literalPos = 0u;
+      return bstr_tokenizer_literal(self, pNext, token);
+   default:
+      if (bstr_tokenizer_is_number_char(*pNext))
+      {
+         return bstr_tokenizer_number(self, pNext, token);
+      }
+      return bstr_tokenizer_error(self, BSTR_INVALID_CHARACTER_ERROR);
+   }
+   self->pNext = pNext + 1;
+   return BSTR_NO_ERROR;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Strings that are complete in the chunk are parsed directly. Otherwise the raw literal is copied to the spill
+ * buffer, it is unescaped in place once the closing quotation mark has arrived.
+ */
+static bstr_error_t bstr_tokenizer_string(bstr_tokenizer_t *self, const uint8_t *pBegin, bstr_token_t *token)
+{
+   const uint8_t *pStrBegin = 0;
+   const uint8_t *pStrEnd = 0;
+   const uint8_t *pResult;
+   const uint8_t *pBackslash;
+   bool isView = false;
+   bstr_buf_clear(&self->spill);
+   pResult = bstr_parse_json_string_view_buf(&self->ctx, pBegin, self->pEnd, &pStrBegin, &pStrEnd, &self->spill, &isView);
+   if (pResult == 0)
+   {
+      //a UTF-8 sequence cut by the end of the chunk looks invalid, unterminated strings are validated once complete
+      self->isEscapePending = false;
+      if ( self->isFinal || (bstr_tokenizer_string_end(self, pBegin + 1) != self->pEnd) )
+      {
+         return self->ctx.lastError;
+      }
+      bstr_clear_error(&self->ctx);
+   }
+   else if (pResult != pBegin)
+   {
+      bstr_tokenizer_emit(token, BSTR_TOKEN_STRING, pStrBegin, pStrEnd, isView);
+      self->pNext = pResult;
+      return BSTR_NO_ERROR;
+   }
+   else
+   {
+      //an odd number of trailing backslashes means the chunk ends inside an escape
+      pBackslash = self->pEnd;
+      while ( (pBackslash > (pBegin + 1)) && (pBackslash[-1] == (uint8_t) '\\') )
+      {
+         pBackslash--;
+      }
+      self->isEscapePending = (((self->pEnd - pBackslash) & 1) != 0);
+   }
+   bstr_buf_clear(&self->spill);
+   return bstr_tokenizer_suspend(self, STATE_STRING, pBegin, token);
+}
+
+static bstr_error_t bstr_tokenizer_resume_string(bstr_tokenizer_t *self, bstr_token_t *token)
+{
+   const uint8_t *pNext = bstr_tokenizer_string_end(self, self->pNext);
+   const uint8_t *pStrBegin = 0;
+   const uint8_t *pStrEnd = 0;
+   uint8_t *pData;
+   if (pNext == self->pEnd)
+   {
+      return bstr_tokenizer_suspend(self, STATE_STRING, self->pNext, token);
+   }
+   pNext++;
+   if (bstr_buf_append_bstr(&self->spill, self->pNext, pNext) != BSTR_NO_ERROR)
+   {
+      return bstr_tokenizer_error(self, BSTR_MEM_ERROR);
+   }
+   self->pNext = pNext;
+   self->state = STATE_NONE;
+   pData = bstr_buf_data(&self->spill);
+   if (bstr_unescape_json_inplace(&self->ctx, pData, pData + bstr_buf_length(&self->spill), (uint8_t**) &pStrBegin, (uint8_t**) &pStrEnd) == 0)
+   {
+      return self->ctx.lastError;
+   }
+   bstr_tokenizer_emit(token, BSTR_TOKEN_STRING, pStrBegin, pStrEnd, false);
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Returns the closing quotation mark of a suspended string or pEnd, escapes are skipped across chunks using
+ * isEscapePending. Invalid characters are left for bstr_unescape_json_inplace to report.
+ */
+static const uint8_t *bstr_tokenizer_string_end(bstr_tokenizer_t *self, const uint8_t *pNext)
+{
+   const bstr_simd_ops_t *ops = bstr_simd_ops();
+   if ( self->isEscapePending && (pNext < self->pEnd) )
+   {
+      pNext++;
+      self->isEscapePending = false;
+   }
+   for (;;)
+   {
+      pNext = ops->search_any(pNext, self->pEnd, &bstr_json_string_special_chars);
+      if ( (pNext == self->pEnd) || (*pNext == (uint8_t) '"') )
+      {
+         return pNext;
+      }
+      if (*pNext == (uint8_t) '\\')
+      {
+         if ( (pNext + 1) == self->pEnd)
+         {
+            self->isEscapePending = true;
+            return self->pEnd;
+         }
+         pNext++;
+      }
+      pNext++;
+   }
+}
+
+/**
+ * A number is suspended when its characters run up to the end of the chunk, it may continue in the next one.
+ */
+static bstr_error_t bstr_tokenizer_number(bstr_tokenizer_t *self, const uint8_t *pBegin, bstr_token_t *token)
+{
+   const uint8_t *pResult = bstr_parse_json_number(&self->ctx, pBegin, self->pEnd, &token->number);
+   if ( (!self->isFinal) && ( (pResult == 0) || (pResult == self->pEnd) || bstr_tokenizer_is_number_char(*pResult) ) &&
+        (bstr_tokenizer_number_run(pBegin, self->pEnd) == self->pEnd) )
+   {
+      bstr_clear_error(&self->ctx);
+      bstr_buf_clear(&self->spill);
+      return bstr_tokenizer_suspend(self, STATE_NUMBER, pBegin, token);
+   }
+   if (pResult == 0)
+   {
+      return self->ctx.lastError;
+   }
+   if ( (pResult < self->pEnd) && bstr_tokenizer_is_number_char(*pResult) )
+   {
+      //"01" or "1-2" is an error like it is when the number straddles chunks, not two numbers
+      return bstr_tokenizer_error(self, BSTR_PARSE_ERROR);
+   }
+   bstr_tokenizer_emit(token, BSTR_TOKEN_NUMBER, pBegin, pResult, true);
+   self->pNext = pResult;
+   return BSTR_NO_ERROR;
+}
+
+static bstr_error_t bstr_tokenizer_resume_number(bstr_tokenizer_t *self, bstr_token_t *token)
+{
+   const uint8_t *pNext = bstr_tokenizer_number_run(self->pNext, self->pEnd);
+   const uint8_t *pNumberBegin;
+   const uint8_t *pNumberEnd;
+   const uint8_t *pResult;
+   if ( (pNext == self->pEnd) && (!self->isFinal) )
+   {
+      return bstr_tokenizer_suspend(self, STATE_NUMBER, self->pNext, token);
+   }
+   if (bstr_buf_append_bstr(&self->spill, self->pNext, pNext) != BSTR_NO_ERROR)
+   {
+      return bstr_tokenizer_error(self, BSTR_MEM_ERROR);
+   }
+   self->pNext = pNext;
+   self->state = STATE_NONE;
+   bstr_buf_view(&self->spill, &pNumberBegin, &pNumberEnd);
+   pResult = bstr_parse_json_number(&self->ctx, pNumberBegin, pNumberEnd, &token->number);
+   if (pResult == 0)
+   {
+      return self->ctx.lastError;
+   }
+   if (pResult != pNumberEnd)
+   {
+      return bstr_tokenizer_error(self, BSTR_PARSE_ERROR);
+   }
+   bstr_tokenizer_emit(token, BSTR_TOKEN_NUMBER, pNumberBegin, pNumberEnd, false);
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Matches the rest of self->literal. The token text is the literal itself so nothing needs to be spilled.
+ */
+static bstr_error_t bstr_tokenizer_literal(bstr_tokenizer_t *self, const uint8_t *pBegin, bstr_token_t *token)
+{
+   const uint8_t *pNext = pBegin;
+   size_t len = strlen(self->literal);
+   while ( (self->literalPos < len) && (pNext < self->pEnd) )
+   {
+      if (*pNext != (uint8_t) self->literal[self->literalPos])
+      {
+         return bstr_tokenizer_error(self, BSTR_INVALID_CHARACTER_ERROR);
+      }
+      pNext++;
+      self->literalPos++;
+   }
+   self->pNext = pNext;
+   if (self->literalPos < len)
+   {
+      return bstr_tokenizer_suspend(self, STATE_LITERAL, pNext, token);
+   }
+   self->state = STATE_NONE;
+   bstr_tokenizer_emit(token, self->literalType, (const uint8_t*) self->literal, (const uint8_t*) self->literal + len, false);
+   return BSTR_NO_ERROR;
+}
+
+/**
+ * Appends the rest of the chunk starting at pBegin to the spill buffer and asks for more input.
+ */
+static bstr_error_t bstr_tokenizer_suspend(bstr_tokenizer_t *self, uint8_t state, const uint8_t *pBegin, bstr_token_t *token)
+{
+   if (self->isFinal)
+   {
+      return bstr_tokenizer_error(self, BSTR_PREMATURE_END_OF_BUFFER_ERROR);
+   }
+   if ( (state != STATE_LITERAL) && (bstr_buf_append_bstr(&self->spill, pBegin, self->pEnd) != BSTR_NO_ERROR) )
+   {
+      return bstr_tokenizer_error(self, BSTR_MEM_ERROR);
+   }
+   self->state = state;
+   self->pNext = self->pEnd;
+   token->type = BSTR_TOKEN_NEED_MORE;
+   return BSTR_NO_ERROR;
+}
+
+static bstr_error_t bstr_tokenizer_error(bstr_tokenizer_t *self, bstr_error_t errorCode)
+{
+   self->ctx.lastError = errorCode;
+   return errorCode;
+}
+
+static void bstr_tokenizer_emit(bstr_token_t *token, uint8_t type, const uint8_t *pBegin, const uint8_t *pEnd, bool isView)
+{
+   token->type = type;
+   token->pBegin = pBegin;
+   token->pEnd = pEnd;
+   token->isView = isView;
+}
+
+static const uint8_t *bstr_tokenizer_number_run(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   while ( (pBegin < pEnd) && bstr_tokenizer_is_number_char(*pBegin) )
+   {
+      pBegin++;
+   }
+   return pBegin;
+}
+
+static bool bstr_tokenizer_is_number_char(uint8_t c)
+{
+   return ( (c >= (uint8_t) '0') && (c <= (uint8_t) '9') ) || (c == (uint8_t) '-') || (c == (uint8_t) '+') ||
+          (c == (uint8_t) '.') || (c == (uint8_t) 'e') || (c == (uint8_t) 'E');
+}
@@ -6,6 +6,15 @@
 
 
 CuSuite* testsuite_bstr(void);
+CuSuite* testsuite_bstr_matcher(void);
+CuSuite* testsuite_bstr_alloc(void);
+CuSuite* testsuite_bstr_tokenizer(void);
+CuSuite* testsuite_bstr_csv(void);
+CuSuite* testsuite_bstr_http(void);
+CuSuite* testsuite_bstr_json(void);
+CuSuite* testsuite_bstr_parallel(void);
+CuSuite* testsuite_bstr_file(void);
+CuSuite* testsuite_bstr_reader(void);
 
 
 void streambuf_lock(void){}
@@ -17,6 +26,15 @@ void RunAllTests(void)
    CuSuite* suite = CuSuiteNew();
 
    CuSuiteAddSuite(suite, testsuite_bstr());
+   CuSuiteAddSuite(suite, testsuite_bstr_matcher());
+   CuSuiteAddSuite(suite, testsuite_bstr_alloc());
+   CuSuiteAddSuite(suite, testsuite_bstr_tokenizer());
+   CuSuiteAddSuite(suite, testsuite_bstr_csv());
+   CuSuiteAddSuite(suite, testsuite_bstr_http());
+   CuSuiteAddSuite(suite, testsuite_bstr_json());
+   CuSuiteAddSuite(suite, testsuite_bstr_parallel());
+   CuSuiteAddSuite(suite, testsuite_bstr_file());
+   CuSuiteAddSuite(suite, testsuite_bstr_reader());
 
    CuSuiteRun(suite);
    CuSuiteSummary(suite, output);
@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "test_util.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns numLines lines printed with format, which takes the line number (int) followed by a prefix of padding
+ * ("%.*s") that gives the lines different lengths. The caller frees the data. Returns NULL and sets *length to 0 on
+ * failure.
+ */
+char *test_generate_lines(size_t numLines, const char *format, const char *padding, size_t *length)
+{
+   size_t paddingLen = strlen(padding);
+   size_t maxLineLen = strlen(format) + paddingLen + 16u;
+   char *data = (char*) malloc(numLines * maxLineLen + 1u);
+   size_t offset = 0u;
+   size_t i;
+   *length = 0u;
+   if (data == 0)
+   {
+      return 0;
+   }
+   for (i = 0u; i < numLines; i++)
+   {
+      offset += (size_t) sprintf(&data[offset], format, (int) i, (int) (i % (paddingLen + 1u)), padding);
+   }
+   *length = offset;
+   return data;
+}
+
+bool test_write_file(const char *fileName, const char *data, size_t length)
+{
+   FILE *fh = fopen(fileName, "wb");
+   bool isWritten;
+   if (fh == 0)
+   {
+      return false;
+   }
+   isWritten = (fwrite(data, 1u, length, fh) == length);
+   return (fclose(fh) == 0) && isWritten;
+}
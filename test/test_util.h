@@ -0,0 +1,16 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdbool.h>
+#include <stddef.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+char *test_generate_lines(size_t numLines, const char *format, const char *padding, size_t *length);
+bool test_write_file(const char *fileName, const char *data, size_t length);
+
+#endif //TEST_UTIL_H
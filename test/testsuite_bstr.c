@@ -6,6 +6,9 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
 #include <stddef.h>
 #include <string.h>
 #include "CuTest.h"
@@ -22,6 +25,7 @@
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
+static const uint8_t *naive_find(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pStrBegin, size_t len);
 static void test_bstr_while_predicate_reverse(CuTest* tc);
 static void test_bstr_to_unsigned_long_base10(CuTest* tc);
 static void test_bstr_to_unsigned_long_base16(CuTest* tc);
@@ -36,6 +40,43 @@ static void test_bstr_parse_json_string_literal_empty(CuTest* tc);
 static void test_bstr_parse_json_string_literal_ascii(CuTest* tc);
 static void test_bstr_parse_json_string_literal_escapeChars(CuTest* tc);
 static void test_bstr_to_double(CuTest* tc);
+static void test_bstr_search_val(CuTest* tc);
+static void test_bstr_search_val_simd(CuTest* tc);
+static void test_bstr_byteset(CuTest* tc);
+static void test_bstr_search_any(CuTest* tc);
+static void test_bstr_search_any_simd(CuTest* tc);
+static void test_bstr_find_cstr(CuTest* tc);
+static void test_bstr_find_needle(CuTest* tc);
+static void test_bstr_find_bstr_simd(CuTest* tc);
+static void test_bstr_index_lines(CuTest* tc);
+static void test_bstr_index_lines_chunked(CuTest* tc);
+static void test_bstr_json_index(CuTest* tc);
+static void test_bstr_match_pair_indexed(CuTest* tc);
+static void naive_json_index(const uint8_t *pBegin, size_t len, bstr_json_index_block_t *blocks);
+static void test_bstr_charclass(CuTest* tc);
+static void test_bstr_while_class(CuTest* tc);
+static bool is_equal_byteset(const bstr_byteset_t *a, const bstr_byteset_t *b);
+static void test_bstr_to_long_long(CuTest* tc);
+static void test_bstr_to_integer_vs_libc(CuTest* tc);
+static void test_bstr_to_double_bounded(CuTest* tc);
+static void test_bstr_to_double_vs_libc(CuTest* tc);
+static void check_to_double_vs_libc(CuTest* tc, const char *str);
+static size_t format_halfway(char *buf, uint64_t bits, uint32_t nudge);
+static uint32_t rand_u32(uint32_t *seed);
+static void test_bstr_parse_json_number_int64(CuTest* tc);
+static void test_bstr_parse_json_number_double(CuTest* tc);
+static void test_bstr_parse_json_number_malformed(CuTest* tc);
+static void test_bstr_parse_json_string_literal_simd(CuTest* tc);
+static void test_bstr_parse_json_string_literal_errors(CuTest* tc);
+static void test_bstr_parse_json_string_view(CuTest* tc);
+static void test_bstr_parse_json_string_literal_unicode(CuTest* tc);
+static void test_bstr_parse_json_string_literal_utf8(CuTest* tc);
+static void test_bstr_unescape_json_inplace(CuTest* tc);
+static void test_bstr_buf(CuTest* tc);
+static void test_bstr_parse_json_string_buf(CuTest* tc);
+static void test_bstr_split_iter(CuTest* tc);
+static void test_bstr_split_iter_simd(CuTest* tc);
+static bool is_valid_utf8(const uint8_t *p, size_t len);
 
 
 
@@ -47,6 +88,14 @@ static void test_bstr_to_double(CuTest* tc);
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL VARIABLES
 //////////////////////////////////////////////////////////////////////////////
+static const uint32_t m_simdFeatureSets[] = {
+   0u,
+   BSTR_SIMD_SSE2,
+   BSTR_SIMD_SSE2 | BSTR_SIMD_SSSE3 | BSTR_SIMD_SSE42 | BSTR_SIMD_PCLMUL,
+   BSTR_SIMD_SSE2 | BSTR_SIMD_SSSE3 | BSTR_SIMD_SSE42 | BSTR_SIMD_PCLMUL | BSTR_SIMD_AVX2 | BSTR_SIMD_BMI2,
+   0xFFFFFFFFu
+};
+#define NUM_SIMD_FEATURE_SETS (sizeof(m_simdFeatureSets) / sizeof(m_simdFeatureSets[0]))
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -72,6 +121,37 @@ CuSuite* testsuite_bstr(void)
    SUITE_ADD_TEST(suite, test_bstr_parse_json_string_literal_ascii);
    SUITE_ADD_TEST(suite, test_bstr_parse_json_string_literal_escapeChars);
    SUITE_ADD_TEST(suite, test_bstr_to_double);
+   SUITE_ADD_TEST(suite, test_bstr_search_val);
+   SUITE_ADD_TEST(suite, test_bstr_search_val_simd);
+   SUITE_ADD_TEST(suite, test_bstr_byteset);
+   SUITE_ADD_TEST(suite, test_bstr_search_any);
+   SUITE_ADD_TEST(suite, test_bstr_search_any_simd);
+   SUITE_ADD_TEST(suite, test_bstr_find_cstr);
+   SUITE_ADD_TEST(suite, test_bstr_find_needle);
+   SUITE_ADD_TEST(suite, test_bstr_find_bstr_simd);
+   SUITE_ADD_TEST(suite, test_bstr_index_lines);
+   SUITE_ADD_TEST(suite, test_bstr_index_lines_chunked);
+   SUITE_ADD_TEST(suite, test_bstr_json_index);
+   SUITE_ADD_TEST(suite, test_bstr_match_pair_indexed);
+   SUITE_ADD_TEST(suite, test_bstr_charclass);
+   SUITE_ADD_TEST(suite, test_bstr_while_class);
+   SUITE_ADD_TEST(suite, test_bstr_to_long_long);
+   SUITE_ADD_TEST(suite, test_bstr_to_integer_vs_libc);
+   SUITE_ADD_TEST(suite, test_bstr_to_double_bounded);
+   SUITE_ADD_TEST(suite, test_bstr_to_double_vs_libc);
+   SUITE_ADD_TEST(suite, test_bstr_parse_json_number_int64);
+   SUITE_ADD_TEST(suite, test_bstr_parse_json_number_double);
+   SUITE_ADD_TEST(suite, test_bstr_parse_json_number_malformed);
+   SUITE_ADD_TEST(suite, test_bstr_parse_json_string_literal_simd);
+   SUITE_ADD_TEST(suite, test_bstr_parse_json_string_literal_errors);
+   SUITE_ADD_TEST(suite, test_bstr_parse_json_string_view);
+   SUITE_ADD_TEST(suite, test_bstr_parse_json_string_literal_unicode);
+   SUITE_ADD_TEST(suite, test_bstr_parse_json_string_literal_utf8);
+   SUITE_ADD_TEST(suite, test_bstr_unescape_json_inplace);
+   SUITE_ADD_TEST(suite, test_bstr_buf);
+   SUITE_ADD_TEST(suite, test_bstr_parse_json_string_buf);
+   SUITE_ADD_TEST(suite, test_bstr_split_iter);
+   SUITE_ADD_TEST(suite, test_bstr_split_iter_simd);
 
 
    return suite;
@@ -251,7 +331,7 @@ static void test_bstr_parse_json_number_multi_digit_int(CuTest* tc)
    const char *test_data1 = "100";
    const char *test_data2 = "12345";
    const char *test_data3 = "999999999";
-   const char *test_data4 = "12345678901234567890"; //This is way outside 32-bit range
+   const char *test_data4 = "12345678901234567890"; //This is way outside 32-bit range but fits in 64 bits
    const char *test_data5 = "2147483648"; //This is just outside 31-bit range
    const char *test_data6 = "2147483647"; //This is just inside 31-bit range
    const char *test_data = 0;
@@ -288,8 +368,10 @@ static void test_bstr_parse_json_number_multi_digit_int(CuTest* tc)
    test_data = test_data4;
    pBegin = (const uint8_t*) test_data, pEnd = pBegin+strlen(test_data);
    pResult = bstr_parse_json_number(&ctx, pBegin, pEnd, &number);
-   CuAssertConstPtrEquals(tc, NULL, pResult);
-   CuAssertUIntEquals(tc, BSTR_NUMBER_TOO_LARGE_ERROR, bstr_get_last_error(&ctx));
+   CuAssertConstPtrEquals(tc, pEnd, pResult);
+   CuAssertUIntEquals(tc, BSTR_NUMBER_UINT64, number.type);
+   CuAssertTrue(tc, number.value.u64 == 12345678901234567890ull);
+   CuAssertUIntEquals(tc, BSTR_NO_ERROR, bstr_get_last_error(&ctx));
 
    test_data = test_data5;
    pBegin = (const uint8_t*) test_data, pEnd = pBegin+strlen(test_data);
@@ -525,3 +607,1800 @@ static void test_bstr_to_double(CuTest* tc)
    CuAssertDblEquals(tc, -100.123, value, delta);
 
 }
+
+static void test_bstr_search_val(CuTest* tc)
+{
+   const char *test1 = "";
+   const char *test2 = "abc";
+   const char *test3 = "key=value";
+   const char *test;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+
+   test = test1;
+   pBegin = (const uint8_t*) test, pEnd = (const uint8_t*) (test + strlen(test));
+   CuAssertConstPtrEquals(tc, pBegin, bstr_search_val(pBegin, pEnd, '='));
+
+   test = test2;
+   pBegin = (const uint8_t*) test, pEnd = (const uint8_t*) (test + strlen(test));
+   CuAssertConstPtrEquals(tc, pBegin, bstr_search_val(pBegin, pEnd, '='));
+   CuAssertConstPtrEquals(tc, pBegin + 2, bstr_search_val(pBegin, pEnd, 'c'));
+   CuAssertConstPtrEquals(tc, NULL, bstr_search_val(pEnd, pBegin, 'c'));
+
+   test = test3;
+   pBegin = (const uint8_t*) test, pEnd = (const uint8_t*) (test + strlen(test));
+   CuAssertConstPtrEquals(tc, pBegin + 3, bstr_search_val(pBegin, pEnd, '='));
+   CuAssertConstPtrEquals(tc, pBegin, bstr_line(pBegin, pEnd));
+}
+
+static void test_bstr_search_val_simd(CuTest* tc)
+{
+   uint8_t buf[300];
+   size_t i;
+   uint32_t len;
+   uint32_t pos;
+
+   memset(buf, 'a', sizeof(buf));
+   for (i = 0; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      for (len = 0; len < 260; len += 7)
+      {
+         const uint8_t *pBegin = &buf[len % 5];
+         const uint8_t *pEnd = pBegin + len;
+         char msg[64];
+         sprintf(msg, "features=%x, len=%u", (unsigned) m_simdFeatureSets[i], (unsigned) len);
+         CuAssertConstPtrEquals_Msg(tc, msg, pBegin, bstr_search_val(pBegin, pEnd, '\n'));
+         for (pos = 0; pos < len; pos++)
+         {
+            buf[(len % 5) + pos] = '\n';
+            if (len > 0u)
+            {
+               buf[(len % 5) + len - 1] = '\n'; //the first match must win
+            }
+            CuAssertConstPtrEquals_Msg(tc, msg, pBegin + pos, bstr_search_val(pBegin, pEnd, '\n'));
+            buf[(len % 5) + pos] = 'a';
+            buf[(len % 5) + len - 1] = 'a';
+         }
+         //a match just outside the bounds must not be reported
+         buf[(len % 5) + len] = '\n';
+         CuAssertConstPtrEquals_Msg(tc, msg, pBegin, bstr_search_val(pBegin, pEnd, '\n'));
+         buf[(len % 5) + len] = 'a';
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_byteset(CuTest* tc)
+{
+   bstr_byteset_t set;
+   uint32_t c;
+
+   bstr_byteset_create_cstr(&set, "{}[],:\"");
+   CuAssertTrue(tc, memcmp(set.lo, bstr_json_structural_chars.lo, sizeof(set.lo)) == 0);
+   CuAssertTrue(tc, memcmp(set.hi, bstr_json_structural_chars.hi, sizeof(set.hi)) == 0);
+   CuAssertTrue(tc, memcmp(set.bits, bstr_json_structural_chars.bits, sizeof(set.bits)) == 0);
+   CuAssertUIntEquals(tc, bstr_json_structural_chars.numTables, set.numTables);
+
+   bstr_byteset_create_cstr(&set, "\"\\");
+   bstr_byteset_add_range(&set, 0u, 31u);
+   CuAssertTrue(tc, memcmp(set.lo, bstr_json_string_special_chars.lo, sizeof(set.lo)) == 0);
+   CuAssertTrue(tc, memcmp(set.hi, bstr_json_string_special_chars.hi, sizeof(set.hi)) == 0);
+   CuAssertTrue(tc, memcmp(set.bits, bstr_json_string_special_chars.bits, sizeof(set.bits)) == 0);
+   CuAssertUIntEquals(tc, bstr_json_string_special_chars.numTables, set.numTables);
+
+   bstr_byteset_create(&set, NULL, NULL);
+   bstr_byteset_add(&set, 'x');
+   bstr_byteset_invert(&set);
+   for (c = 0u; c < 256u; c++)
+   {
+      CuAssertTrue(tc, bstr_byteset_contains(&set, (uint8_t) c) == (c != 'x'));
+   }
+}
+
+static void test_bstr_search_any(CuTest* tc)
+{
+   const char *test1 = "{\"key\": [1, 2]}";
+   const char *test2 = "no structure here";
+   const char *test;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   const uint8_t *pResult;
+
+   test = test1;
+   pBegin = (const uint8_t*) test, pEnd = (const uint8_t*) (test + strlen(test));
+   pResult = bstr_search_any(pBegin + 1, pEnd, &bstr_json_structural_chars);
+   CuAssertConstPtrEquals(tc, pBegin + 1, pResult);
+   pResult = bstr_search_any(pBegin + 2, pEnd, &bstr_json_structural_chars);
+   CuAssertConstPtrEquals(tc, pBegin + 5, pResult);
+   pResult = bstr_search_any_reverse(pBegin, pEnd - 1, &bstr_json_structural_chars);
+   CuAssertConstPtrEquals(tc, pEnd - 2, pResult);
+
+   test = test2;
+   pBegin = (const uint8_t*) test, pEnd = (const uint8_t*) (test + strlen(test));
+   CuAssertConstPtrEquals(tc, pBegin, bstr_search_any(pBegin, pEnd, &bstr_json_structural_chars));
+   CuAssertConstPtrEquals(tc, pEnd, bstr_search_any_reverse(pBegin, pEnd, &bstr_json_structural_chars));
+   CuAssertConstPtrEquals(tc, NULL, bstr_search_any(pEnd, pBegin, &bstr_json_structural_chars));
+}
+
+static void test_bstr_search_any_simd(CuTest* tc)
+{
+   uint8_t buf[300];
+   bstr_byteset_t sets[3];
+   size_t i;
+   uint32_t j;
+   uint32_t k;
+   uint32_t seed = 12345u;
+
+   bstr_byteset_create_cstr(&sets[0], "\",:");
+   bstr_byteset_create(&sets[1], NULL, NULL);
+   for (k = 0u; k < 256u; k += 17u)
+   {
+      bstr_byteset_add(&sets[1], (uint8_t) k); //every high nibble gets its own bucket
+   }
+   CuAssertUIntEquals(tc, 2u, sets[1].numTables);
+   bstr_byteset_create(&sets[2], NULL, NULL);
+   bstr_byteset_add_range(&sets[2], 0x80u, 0xFFu);
+   for (i = 0; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      for (j = 0u; j < 3u; j++)
+      {
+         uint32_t len;
+         for (len = 0u; len < 200u; len += 3u)
+         {
+            const uint8_t *pBegin = &buf[len % 7u];
+            const uint8_t *pEnd = pBegin + len;
+            const uint8_t *pFirst = pEnd;
+            const uint8_t *pLast = pEnd;
+            const uint8_t *pNext;
+            char msg[64];
+            for (k = 0u; k < sizeof(buf); k++)
+            {
+               seed = seed * 1103515245u + 12345u;
+               buf[k] = (uint8_t) (seed >> 16);
+               if (bstr_byteset_contains(&sets[j], buf[k]) && ((seed >> 8) & 3u) != 0u)
+               {
+                  buf[k] ^= 0x40; //keep matches sparse
+               }
+            }
+            for (pNext = pBegin; pNext < pEnd; pNext++)
+            {
+               if (bstr_byteset_contains(&sets[j], *pNext))
+               {
+                  if (pFirst == pEnd)
+                  {
+                     pFirst = pNext;
+                  }
+                  pLast = pNext;
+               }
+            }
+            sprintf(msg, "features=%x, set=%u, len=%u", (unsigned) m_simdFeatureSets[i], (unsigned) j, (unsigned) len);
+            CuAssertConstPtrEquals_Msg(tc, msg, (pFirst == pEnd)? pBegin : pFirst, bstr_search_any(pBegin, pEnd, &sets[j]));
+            CuAssertConstPtrEquals_Msg(tc, msg, pLast, bstr_search_any_reverse(pBegin, pEnd, &sets[j]));
+         }
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_find_cstr(CuTest* tc)
+{
+   const char *test1 = "2020-01-01 ERROR disk full, ERROR again";
+   const char *test;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   const uint8_t *pResult;
+
+   test = test1;
+   pBegin = (const uint8_t*) test, pEnd = (const uint8_t*) (test + strlen(test));
+   pResult = bstr_find_cstr(pBegin, pEnd, "ERROR");
+   CuAssertConstPtrEquals(tc, pBegin + 11, pResult);
+   pResult = bstr_find_cstr(pResult + 1, pEnd, "ERROR");
+   CuAssertConstPtrEquals(tc, pBegin + 28, pResult);
+   CuAssertConstPtrEquals(tc, pBegin, bstr_find_cstr(pBegin, pEnd, "WARNING"));
+   CuAssertConstPtrEquals(tc, pBegin, bstr_find_cstr(pBegin, pEnd, ""));
+   CuAssertConstPtrEquals(tc, pEnd - 5, bstr_find_cstr(pBegin, pEnd, "again"));
+   CuAssertConstPtrEquals(tc, pBegin + 34, bstr_find_cstr(pBegin, pEnd, "a"));
+   CuAssertConstPtrEquals(tc, pBegin + 1, bstr_find_cstr(pBegin + 1, pBegin + 4, "2020"));
+   CuAssertConstPtrEquals(tc, NULL, bstr_find_cstr(pBegin, pEnd, NULL));
+   CuAssertConstPtrEquals(tc, NULL, bstr_find_cstr(pEnd, pBegin, "a"));
+}
+
+static void test_bstr_find_needle(CuTest* tc)
+{
+   const char *test1 = "GET /index.html HTTP/1.1\r\nHost: example.com\r\n\r\nbody";
+   const char *str1 = "\r\n\r\n";
+   const char *str2 = "a fairly long needle which should be matched using the Two-Way algorithm";
+   char buf[400];
+   bstr_needle_t needle;
+   bstr_needle_t *pNeedle;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+
+   pBegin = (const uint8_t*) test1, pEnd = (const uint8_t*) (test1 + strlen(test1));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_needle_create(&needle, (const uint8_t*) str1, (const uint8_t*) str1 + strlen(str1)));
+   CuAssertConstPtrEquals(tc, pEnd - 8, bstr_find_needle(pBegin, pEnd, &needle));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_needle_create(&needle, NULL, NULL));
+
+   memset(buf, 'x', sizeof(buf));
+   memcpy(&buf[300], str2, strlen(str2));
+   pBegin = (const uint8_t*) buf, pEnd = pBegin + sizeof(buf);
+   pNeedle = bstr_needle_new((const uint8_t*) str2, (const uint8_t*) str2 + strlen(str2));
+   CuAssertPtrNotNull(tc, pNeedle);
+   CuAssertConstPtrEquals(tc, pBegin + 300, bstr_find_needle(pBegin, pEnd, pNeedle));
+   CuAssertConstPtrEquals(tc, pBegin, bstr_find_needle(pBegin, pBegin + 300 + strlen(str2) - 1, pNeedle));
+   bstr_needle_delete(pNeedle);
+}
+
+static void test_bstr_find_bstr_simd(CuTest* tc)
+{
+   uint8_t hay[2000];
+   uint8_t needle[80];
+   size_t i;
+   uint32_t seed = 4711u;
+   uint32_t iter;
+
+   for (i = 0; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      for (iter = 0u; iter < 200u; iter++)
+      {
+         uint32_t alphabet = 2u + (iter % 3u);
+         size_t hayLen = 1u + (iter * 37u) % sizeof(hay);
+         size_t needleLen = 1u + (iter * 13u) % 70u;
+         size_t k;
+         const uint8_t *pResult;
+         const uint8_t *pExpected;
+         char msg[80];
+         for (k = 0u; k < hayLen; k++)
+         {
+            seed = seed * 1103515245u + 12345u;
+            hay[k] = (uint8_t) ('a' + (seed >> 16) % alphabet);
+         }
+         if ( (iter % 4u) == 0u )
+         {
+            //periodic needle in a periodic haystack, forces the candidate filter over to Two-Way
+            memset(hay, 'a', hayLen);
+            memset(needle, 'a', needleLen);
+            needle[needleLen / 2u] = 'b';
+         }
+         else if ( (iter % 2u) == 0u && (hayLen > needleLen) )
+         {
+            size_t pos = (seed >> 8) % (hayLen - needleLen);
+            memcpy(needle, &hay[pos], needleLen); //guaranteed match
+         }
+         else
+         {
+            for (k = 0u; k < needleLen; k++)
+            {
+               seed = seed * 1103515245u + 12345u;
+               needle[k] = (uint8_t) ('a' + (seed >> 16) % alphabet);
+            }
+         }
+         pExpected = naive_find(hay, hay + hayLen, needle, needleLen);
+         pResult = bstr_find_bstr(hay, hay + hayLen, needle, needle + needleLen);
+         sprintf(msg, "features=%x, iter=%u", (unsigned) m_simdFeatureSets[i], (unsigned) iter);
+         CuAssertConstPtrEquals_Msg(tc, msg, (pExpected != 0)? pExpected : hay, pResult);
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static const uint8_t *naive_find(const uint8_t *pBegin, const uint8_t *pEnd, const uint8_t *pStrBegin, size_t len)
+{
+   const uint8_t *pNext;
+   for (pNext = pBegin; (size_t) (pEnd - pNext) >= len; pNext++)
+   {
+      if (memcmp(pNext, pStrBegin, len) == 0)
+      {
+         return pNext;
+      }
+   }
+   return 0;
+}
+
+static void test_bstr_index_lines(CuTest* tc)
+{
+   const char *test1 = "first\r\nsecond\n\nlast";
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   bstr_line_index_t index;
+
+   pBegin = (const uint8_t*) test1, pEnd = pBegin + strlen(test1);
+   bstr_line_index_create(&index, 0u);
+   CuAssertConstPtrEquals(tc, pEnd, bstr_index_lines(&index, pBegin, pEnd));
+   CuAssertUIntEquals(tc, 3u, index.numLines);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_line_index_finish(&index));
+   CuAssertUIntEquals(tc, 4u, index.numLines);
+   CuAssertUIntEquals(tc, 0u, index.lines[0].begin);
+   CuAssertUIntEquals(tc, 6u, index.lines[0].end); //'\r' is kept without BSTR_LINE_INDEX_CRLF
+   CuAssertUIntEquals(tc, 7u, index.lines[1].begin);
+   CuAssertUIntEquals(tc, 13u, index.lines[1].end);
+   CuAssertUIntEquals(tc, 14u, index.lines[2].begin);
+   CuAssertUIntEquals(tc, 14u, index.lines[2].end);
+   CuAssertUIntEquals(tc, 15u, index.lines[3].begin);
+   CuAssertUIntEquals(tc, 19u, index.lines[3].end);
+   bstr_line_index_destroy(&index);
+
+   //CRLF split over two chunks
+   bstr_line_index_create(&index, BSTR_LINE_INDEX_CRLF);
+   CuAssertConstPtrEquals(tc, pBegin + 6, bstr_index_lines(&index, pBegin, pBegin + 6));
+   CuAssertUIntEquals(tc, 0u, index.numLines);
+   CuAssertConstPtrEquals(tc, pEnd, bstr_index_lines(&index, pBegin + 6, pEnd));
+   CuAssertUIntEquals(tc, 3u, index.numLines);
+   CuAssertUIntEquals(tc, 5u, index.lines[0].end);
+   CuAssertUIntEquals(tc, 13u, index.lines[1].end);
+   bstr_line_index_destroy(&index);
+
+   CuAssertConstPtrEquals(tc, NULL, bstr_index_lines(NULL, pBegin, pEnd));
+   CuAssertIntEquals(tc, EINVAL, errno);
+}
+
+static void test_bstr_index_lines_chunked(CuTest* tc)
+{
+   uint8_t buf[5000];
+   bstr_line_span_t expected[5000];
+   bstr_line_span_t fixed[7];
+   size_t numExpected = 0u;
+   size_t lineBegin = 0u;
+   size_t i;
+   uint32_t seed = 31337u;
+
+   for (i = 0u; i < sizeof(buf); i++)
+   {
+      seed = seed * 1103515245u + 12345u;
+      switch ( (seed >> 16) % ((i < 2500u)? 6u : 150u) )
+      {
+      case 0: buf[i] = '\n'; break;
+      case 1: buf[i] = '\r'; break;
+      default: buf[i] = 'x';
+      }
+   }
+   for (i = 0u; i < sizeof(buf); i++)
+   {
+      if (buf[i] == '\n')
+      {
+         expected[numExpected].begin = lineBegin;
+         expected[numExpected].end = ( (i > lineBegin) && (buf[i - 1u] == '\r') )? i - 1u : i;
+         numExpected++;
+         lineBegin = i + 1u;
+      }
+   }
+   for (i = 0u; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      bstr_line_index_t index;
+      size_t offset = 0u;
+      size_t numLines = 0u;
+      char msg[40];
+      bool isMatch = true;
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      sprintf(msg, "features=%x", (unsigned) m_simdFeatureSets[i]);
+      //growable index fed with chunks of varying size
+      bstr_line_index_create(&index, BSTR_LINE_INDEX_CRLF);
+      while (offset < sizeof(buf))
+      {
+         size_t chunkLen;
+         seed = seed * 1103515245u + 12345u;
+         chunkLen = (seed >> 16) % 200u;
+         if (chunkLen > sizeof(buf) - offset)
+         {
+            chunkLen = sizeof(buf) - offset;
+         }
+         CuAssertConstPtrEquals_Msg(tc, msg, buf + offset + chunkLen, bstr_index_lines(&index, buf + offset, buf + offset + chunkLen));
+         offset += chunkLen;
+      }
+      CuAssertUIntEquals_Msg(tc, msg, numExpected, index.numLines);
+      CuAssert(tc, msg, memcmp(expected, index.lines, numExpected * sizeof(bstr_line_span_t)) == 0);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_line_index_finish(&index));
+      CuAssertUIntEquals_Msg(tc, msg, numExpected + 1u, index.numLines);
+      CuAssertUIntEquals_Msg(tc, msg, sizeof(buf), index.lines[numExpected].end);
+      bstr_line_index_destroy(&index);
+      //fixed size index drained whenever it becomes full
+      bstr_line_index_create_fixed(&index, fixed, sizeof(fixed) / sizeof(fixed[0]), BSTR_LINE_INDEX_CRLF);
+      {
+         const uint8_t *pNext = buf;
+         const uint8_t *pEnd = buf + sizeof(buf);
+         for (;;)
+         {
+            size_t k;
+            pNext = bstr_index_lines(&index, pNext, pEnd);
+            for (k = 0u; k < index.numLines; k++)
+            {
+               if ( (numLines >= numExpected) || (expected[numLines].begin != fixed[k].begin) || (expected[numLines].end != fixed[k].end) )
+               {
+                  isMatch = false;
+               }
+               numLines++;
+            }
+            bstr_line_index_clear(&index);
+            if (pNext == pEnd)
+            {
+               break;
+            }
+         }
+      }
+      CuAssert(tc, msg, isMatch);
+      CuAssertUIntEquals_Msg(tc, msg, numExpected, numLines);
+      bstr_line_index_destroy(&index);
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_json_index(CuTest* tc)
+{
+   static const char alphabet[] = "\"\\\\{}[]ab ";
+   uint8_t buf[700];
+   bstr_json_index_block_t expected[11];
+   size_t i;
+   uint32_t seed = 2024u;
+
+   for (i = 0u; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      uint32_t iter;
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      for (iter = 0u; iter < 40u; iter++)
+      {
+         bstr_json_index_t index;
+         size_t len = (iter * 97u) % sizeof(buf);
+         size_t k;
+         char msg[40];
+         for (k = 0u; k < len; k++)
+         {
+            seed = seed * 1103515245u + 12345u;
+            buf[k] = (uint8_t) alphabet[(seed >> 16) % (sizeof(alphabet) - 1u)];
+            if ( (iter % 3u) == 0u && (k % 64u) >= 60u )
+            {
+               buf[k] = '\\'; //backslash runs across block boundaries
+            }
+         }
+         naive_json_index(buf, len, expected);
+         sprintf(msg, "features=%x, iter=%u", (unsigned) m_simdFeatureSets[i], (unsigned) iter);
+         CuAssertIntEquals_Msg(tc, msg, BSTR_NO_ERROR, bstr_json_index_create(&index, buf, buf + len));
+         CuAssertUIntEquals_Msg(tc, msg, (len + 63u) / 64u, index.numBlocks);
+         for (k = 0u; k < index.numBlocks; k++)
+         {
+            CuAssert(tc, msg, expected[k].quotes == index.blocks[k].quotes);
+            CuAssert(tc, msg, expected[k].opens == index.blocks[k].opens);
+            CuAssert(tc, msg, expected[k].closes == index.blocks[k].closes);
+         }
+         bstr_json_index_destroy(&index);
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_match_pair_indexed(CuTest* tc)
+{
+   const char *test1 = "{\"a\": \"}{\", \"b\": [1, {\"c\": \"\\\"]\"}], \"d\": {}}";
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   bstr_json_index_t *index;
+   uint8_t buf[5000];
+   size_t len = 0u;
+   size_t i;
+
+   pBegin = (const uint8_t*) test1, pEnd = pBegin + strlen(test1);
+   index = bstr_json_index_new(pBegin, pEnd);
+   CuAssertPtrNotNull(tc, index);
+   CuAssertConstPtrEquals(tc, pEnd - 1, bstr_match_pair_indexed(index, pBegin, pEnd));
+   CuAssertConstPtrEquals(tc, pBegin + 3, bstr_match_pair_indexed(index, pBegin + 1, pEnd));
+   CuAssertConstPtrEquals(tc, pBegin + 9, bstr_match_pair_indexed(index, pBegin + 6, pEnd));
+   CuAssertConstPtrEquals(tc, pBegin + 33, bstr_match_pair_indexed(index, pBegin + 17, pEnd));
+   CuAssertConstPtrEquals(tc, pBegin + 32, bstr_match_pair_indexed(index, pBegin + 21, pEnd));
+   CuAssertConstPtrEquals(tc, pBegin + 31, bstr_match_pair_indexed(index, pBegin + 27, pEnd));
+   CuAssertConstPtrEquals(tc, pBegin + 42, bstr_match_pair_indexed(index, pBegin + 41, pEnd));
+   //bracket inside a string and an escaped quote
+   CuAssertConstPtrEquals(tc, NULL, bstr_match_pair_indexed(index, pBegin + 8, pEnd));
+   CuAssertConstPtrEquals(tc, NULL, bstr_match_pair_indexed(index, pBegin + 29, pEnd));
+   //not found before pEnd
+   CuAssertConstPtrEquals(tc, pBegin, bstr_match_pair_indexed(index, pBegin, pEnd - 1));
+   CuAssertConstPtrEquals(tc, NULL, bstr_match_pair_indexed(index, pBegin, pEnd + 1));
+   bstr_json_index_delete(index);
+
+   //deeply nested document spanning many blocks
+   for (i = 0u; i < 300u; i++)
+   {
+      len += (size_t) sprintf((char*) &buf[len], "[\"]\\\\\",{\"k\":");
+   }
+   for (i = 0u; i < 300u; i++)
+   {
+      len += (size_t) sprintf((char*) &buf[len], "1}]");
+   }
+   for (i = 0u; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      bstr_json_index_t index2;
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_json_index_create(&index2, buf, buf + len));
+      CuAssertConstPtrEquals(tc, buf + len - 1, bstr_match_pair_indexed(&index2, buf, buf + len));
+      CuAssertConstPtrEquals(tc, buf + len - 2, bstr_match_pair_indexed(&index2, buf + 7, buf + len));
+      CuAssertConstPtrEquals(tc, buf + len - 4, bstr_match_pair_indexed(&index2, buf + 12, buf + len));
+      CuAssertConstPtrEquals(tc, buf + 5, bstr_match_pair_indexed(&index2, buf + 1, buf + len));
+      CuAssertConstPtrEquals(tc, buf + 17, bstr_match_pair_indexed(&index2, buf + 13, buf + len));
+      bstr_json_index_destroy(&index2);
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void naive_json_index(const uint8_t *pBegin, size_t len, bstr_json_index_block_t *blocks)
+{
+   bool isEscaped = false;
+   bool isInString = false;
+   size_t i;
+   memset(blocks, 0, ((len + 63u) / 64u) * sizeof(bstr_json_index_block_t));
+   for (i = 0u; i < len; i++)
+   {
+      uint8_t c = pBegin[i];
+      uint64_t bit = (uint64_t) 1u << (i % 64u);
+      bstr_json_index_block_t *block = &blocks[i / 64u];
+      if ( (c == '"') && !isEscaped )
+      {
+         block->quotes |= bit;
+         isInString = !isInString;
+      }
+      else if (!isInString)
+      {
+         if ( (c == '{') || (c == '[') ) block->opens |= bit;
+         if ( (c == '}') || (c == ']') ) block->closes |= bit;
+      }
+      isEscaped = (c == '\\') && !isEscaped;
+   }
+}
+
+static void test_bstr_charclass(CuTest* tc)
+{
+   int (*predicates[7])(int c) = {bstr_pred_is_horizontal_space, bstr_pred_is_whitespace, bstr_pred_is_digit,
+      bstr_pred_is_hex_digit, bstr_pred_is_one_nine, bstr_pred_is_control_char, bstr_pred_is_not_zero};
+   const bstr_charclass_t *classes[7] = {&bstr_class_horizontal_space, &bstr_class_whitespace, &bstr_class_digit,
+      &bstr_class_hex_digit, &bstr_class_one_nine, &bstr_class_control_char, &bstr_class_not_zero};
+   uint32_t i;
+
+   for (i = 0u; i < 7u; i++)
+   {
+      bstr_charclass_t cls;
+      uint32_t c;
+      bstr_charclass_create_predicate(&cls, predicates[i]);
+      CuAssertTrue(tc, is_equal_byteset(&cls.members, &classes[i]->members));
+      CuAssertTrue(tc, is_equal_byteset(&cls.others, &classes[i]->others));
+      for (c = 0u; c < 256u; c++)
+      {
+         CuAssertIntEquals(tc, predicates[i]((int) c) != 0, bstr_charclass_contains(classes[i], (uint8_t) c));
+      }
+   }
+}
+
+static void test_bstr_while_class(CuTest* tc)
+{
+   uint8_t buf[600];
+   size_t i;
+   uint32_t seed = 77u;
+
+   for (i = 0u; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      uint32_t iter;
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      for (iter = 0u; iter < 300u; iter++)
+      {
+         size_t len = (iter * 7u) % sizeof(buf);
+         size_t runLen = (len > 0u)? (iter * 13u) % (len + 1u) : 0u;
+         size_t k;
+         char msg[60];
+         for (k = 0u; k < len; k++)
+         {
+            seed = seed * 1103515245u + 12345u;
+            buf[k] = (uint8_t) " \t\r\nx7"[(seed >> 16) % 6u];
+         }
+         //whitespace run at the beginning and at the end
+         for (k = 0u; k < runLen; k++)
+         {
+            buf[k] = (uint8_t) " \t\r\n"[k % 4u];
+            buf[len - 1u - k] = (uint8_t) " \t\r\n"[k % 4u];
+         }
+         sprintf(msg, "features=%x, iter=%u", (unsigned) m_simdFeatureSets[i], (unsigned) iter);
+         CuAssertConstPtrEquals_Msg(tc, msg, bstr_while_predicate(buf, buf + len, bstr_pred_is_whitespace), bstr_while_class(buf, buf + len, &bstr_class_whitespace));
+         CuAssertConstPtrEquals_Msg(tc, msg, bstr_while_predicate_reverse(buf, buf + len, bstr_pred_is_whitespace), bstr_while_class_reverse(buf, buf + len, &bstr_class_whitespace));
+         CuAssertConstPtrEquals_Msg(tc, msg, bstr_while_predicate(buf, buf + len, bstr_pred_is_not_zero), bstr_while_class(buf, buf + len, &bstr_class_not_zero));
+         CuAssertConstPtrEquals_Msg(tc, msg, bstr_while_predicate_reverse(buf, buf + len, bstr_pred_is_digit), bstr_while_class_reverse(buf, buf + len, &bstr_class_digit));
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+   CuAssertConstPtrEquals(tc, NULL, bstr_while_class(buf, buf + 1, NULL));
+   CuAssertConstPtrEquals(tc, buf, bstr_while_class_reverse(buf, buf, &bstr_class_whitespace));
+}
+
+static bool is_equal_byteset(const bstr_byteset_t *a, const bstr_byteset_t *b)
+{
+   return (memcmp(a->lo, b->lo, sizeof(a->lo)) == 0) && (memcmp(a->hi, b->hi, sizeof(a->hi)) == 0) &&
+          (memcmp(a->bits, b->bits, sizeof(a->bits)) == 0) && (a->numTables == b->numTables);
+}
+
+static void test_bstr_to_long_long(CuTest* tc)
+{
+   const char *test_data1 = "  -9223372036854775808,";
+   const char *test_data2 = "9223372036854775808";
+   const char *test_data3 = "0x7fffFFFFffffFFFF";
+   const char *test_data4 = "000000000000000000000000000000000000000042";
+   const char *test_data5 = "0x";
+   const char *test_data6 = "abc";
+   const char *test_data = 0;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   long long value;
+
+   test_data = test_data1;
+   pBegin = (const uint8_t*) test_data, pEnd = pBegin+strlen(test_data);
+   errno = 0;
+   CuAssertConstPtrEquals(tc, pEnd - 1, bstr_to_long_long(pBegin, pEnd, &value));
+   CuAssertTrue(tc, value == LLONG_MIN);
+   CuAssertIntEquals(tc, 0, errno);
+
+   test_data = test_data2;
+   pBegin = (const uint8_t*) test_data, pEnd = pBegin+strlen(test_data);
+   CuAssertConstPtrEquals(tc, pEnd, bstr_to_long_long(pBegin, pEnd, &value));
+   CuAssertTrue(tc, value == LLONG_MAX);
+   CuAssertIntEquals(tc, ERANGE, errno);
+   //only the first 18 digits are inside the bounds
+   errno = 0;
+   CuAssertConstPtrEquals(tc, pEnd - 1, bstr_to_long_long(pBegin, pEnd - 1, &value));
+   CuAssertTrue(tc, value == 922337203685477580LL);
+   CuAssertIntEquals(tc, 0, errno);
+
+   test_data = test_data3;
+   pBegin = (const uint8_t*) test_data, pEnd = pBegin+strlen(test_data);
+   CuAssertConstPtrEquals(tc, pEnd, bstr_to_long_long(pBegin, pEnd, &value));
+   CuAssertTrue(tc, value == LLONG_MAX);
+
+   //longer than the 32 characters that used to be copied
+   test_data = test_data4;
+   pBegin = (const uint8_t*) test_data, pEnd = pBegin+strlen(test_data);
+   CuAssertConstPtrEquals(tc, pEnd, bstr_to_long_long(pBegin, pEnd, &value));
+   CuAssertTrue(tc, value == 042);
+
+   test_data = test_data5;
+   pBegin = (const uint8_t*) test_data, pEnd = pBegin+strlen(test_data);
+   CuAssertConstPtrEquals(tc, pBegin + 1, bstr_to_long_long(pBegin, pEnd, &value));
+   CuAssertTrue(tc, value == 0);
+
+   test_data = test_data6;
+   pBegin = (const uint8_t*) test_data, pEnd = pBegin+strlen(test_data);
+   CuAssertConstPtrEquals(tc, pBegin, bstr_to_long_long(pBegin, pEnd, &value));
+   CuAssertConstPtrEquals(tc, NULL, bstr_to_long_long(NULL, pEnd, &value));
+}
+
+static void test_bstr_to_integer_vs_libc(CuTest* tc)
+{
+   static const char digits[] = "0123456789abcdefABCDEFxz -+";
+   const uint8_t bases[] = {0u, 2u, 8u, 10u, 16u, 36u};
+   char buf[64];
+   uint32_t seed = 12345u;
+   uint32_t iter;
+
+   for (iter = 0u; iter < 20000u; iter++)
+   {
+      size_t len;
+      size_t k;
+      uint8_t base = bases[iter % sizeof(bases)];
+      char *pExpectedEnd;
+      const uint8_t *pBegin = (const uint8_t*) buf;
+      const uint8_t *pResult;
+      unsigned long long uvalue;
+      unsigned long long uexpected;
+      long long svalue;
+      long long sexpected;
+      int expectedErrno;
+      char msg[120];
+      seed = seed * 1103515245u + 12345u;
+      len = (seed >> 16) % 40u;
+      for (k = 0u; k < len; k++)
+      {
+         seed = seed * 1103515245u + 12345u;
+         //mostly valid digits so that long numbers and overflows are common
+         buf[k] = ((seed >> 16) % 8u != 0u)? digits[(seed >> 20) % ((base == 10u || base == 0u)? 10u : 22u)] : digits[(seed >> 20) % (sizeof(digits) - 1u)];
+      }
+      buf[len] = '\0';
+      sprintf(msg, "\"%s\" base %u", buf, (unsigned) base);
+
+      errno = 0;
+      uexpected = strtoull(buf, &pExpectedEnd, base);
+      expectedErrno = errno;
+      errno = 0;
+      pResult = bstr_to_unsigned_long_long(pBegin, pBegin + len, base, &uvalue);
+      CuAssertConstPtrEquals_Msg(tc, msg, (const uint8_t*) pExpectedEnd, pResult);
+      CuAssert(tc, msg, uexpected == uvalue);
+      CuAssertIntEquals_Msg(tc, msg, expectedErrno, errno);
+
+      if (base == 0u)
+      {
+         errno = 0;
+         sexpected = strtoll(buf, &pExpectedEnd, 0);
+         expectedErrno = errno;
+         errno = 0;
+         pResult = bstr_to_long_long(pBegin, pBegin + len, &svalue);
+         CuAssertConstPtrEquals_Msg(tc, msg, (const uint8_t*) pExpectedEnd, pResult);
+         CuAssert(tc, msg, sexpected == svalue);
+         CuAssertIntEquals_Msg(tc, msg, expectedErrno, errno);
+      }
+   }
+}
+
+static void test_bstr_to_double_bounded(CuTest* tc)
+{
+   const uint8_t *pBegin = (const uint8_t*) " -1.5e3x";
+   const uint8_t *pResult;
+   double value;
+   //the exponent is outside the bounded string
+   pResult = bstr_to_double(pBegin, pBegin + 6, &value);
+   CuAssertConstPtrEquals(tc, pBegin + 5, pResult);
+   CuAssertDblEquals(tc, -1.5, value, 0.0);
+   pResult = bstr_to_double(pBegin, pBegin + 7, &value);
+   CuAssertConstPtrEquals(tc, pBegin + 7, pResult);
+   CuAssertDblEquals(tc, -1500.0, value, 0.0);
+   //not a number
+   pResult = bstr_to_double(pBegin, pBegin + 2, &value);
+   CuAssertConstPtrEquals(tc, pBegin, pResult);
+   CuAssertDblEquals(tc, 0.0, value, 0.0);
+   pResult = bstr_to_double(pBegin + 7, pBegin + 8, &value);
+   CuAssertConstPtrEquals(tc, pBegin + 7, pResult);
+   //range errors
+   pBegin = (const uint8_t*) "1e400 -1e-400";
+   errno = 0;
+   pResult = bstr_to_double(pBegin, pBegin + 5, &value);
+   CuAssertConstPtrEquals(tc, pBegin + 5, pResult);
+   CuAssertTrue(tc, value == HUGE_VAL);
+   CuAssertIntEquals(tc, ERANGE, errno);
+   errno = 0;
+   pResult = bstr_to_double(pBegin + 5, pBegin + 13, &value);
+   CuAssertConstPtrEquals(tc, pBegin + 13, pResult);
+   CuAssertDblEquals(tc, 0.0, value, 0.0);
+   CuAssertIntEquals(tc, ERANGE, errno);
+   pBegin = (const uint8_t*) "-Infinity";
+   pResult = bstr_to_double(pBegin, pBegin + 9, &value);
+   CuAssertConstPtrEquals(tc, pBegin + 9, pResult);
+   CuAssertTrue(tc, value == -HUGE_VAL);
+   pResult = bstr_to_double(pBegin, pBegin + 5, &value);
+   CuAssertConstPtrEquals(tc, pBegin + 4, pResult);
+   CuAssertTrue(tc, value == -HUGE_VAL);
+   pBegin = (const uint8_t*) "NaN";
+   pResult = bstr_to_double(pBegin, pBegin + 3, &value);
+   CuAssertConstPtrEquals(tc, pBegin + 3, pResult);
+   CuAssertTrue(tc, value != value);
+   CuAssertPtrEquals(tc, NULL, (void*) bstr_to_double(pBegin + 1, pBegin, &value));
+}
+
+/**
+ * Compares bit patterns with strtod, which is correctly rounded in the C library used for testing.
+ */
+static void test_bstr_to_double_vs_libc(CuTest* tc)
+{
+   const char *edgeCases[] = {
+      "0", "-0", ".5", "5.", "1e", "1e+", "2.", "00000000000000000000000000001.5",
+      "9007199254740993", "9007199254740993.0000000000000000000000000001", "9007199254740992.9999999999999999999",
+      "2.2250738585072011e-308", "2.2250738585072014e-308", "4.9406564584124654e-324",
+      "2.4703282292062327e-324", "2.4703282292062328e-324", "1.7976931348623157e308",
+      "1.7976931348623158e308", "1.7976931348623159e308", "7.2057594037927933e16", "1e23", "8.589973e9",
+      "179769313486231580793728971405301e276", "0.000000000000000000000000000000000000000001e40",
+      "123456789012345678901234567890123456789012345678901234567890e-250",
+      //smallest subnormal minus one unit in the last of 800+ digits, rounds to zero
+      "2.47032822920623272088284396434110686182529901307162382212792841250337753635104375932649918180817996189898282347722858865463328355177969898199387398005390939063150356595155702263922908583924491051844359318028499365361525003193704576782492193656236698636584807570015857692699037063119282795585513329278343384093519780155312465972635795746227664652728272200563740064854999770965994704540208281662262378573934507363390079677619305775067401763246736009689513405355374585166611342237666786041621596804619144672918403005300575308490487653917113865916462395249126236538818796362393732804238910186723484976682350898633885879256283027559956575244555072551893136908362547791869486679949683240497058210285131854513962138377228261454376934125320985913276672363281245e-324",
+      "2.47032822920623272088284396434110686182529901307162382212792841250337753635104375932649918180817996189898282347722858865463328355177969898199387398005390939063150356595155702263922908583924491051844359318028499365361525003193704576782492193656236698636584807570015857692699037063119282795585513329278343384093519780155312465972635795746227664652728272200563740064854999770965994704540208281662262378573934507363390079677619305775067401763246736009689513405355374585166611342237666786041621596804619144672918403005300575308490487653917113865916462395249126236538818796362393732804238910186723484976682350898633885879256283027559956575244555072551893136908362547791869486679949683240497058210285131854513962138377228261454376934125320985913276672363281250000000000000000001e-324"
+   };
+   char buf[1200];
+   uint32_t seed = 4321u;
+   uint32_t iter;
+   size_t i;
+
+   for (i = 0u; i < sizeof(edgeCases) / sizeof(edgeCases[0]); i++)
+   {
+      check_to_double_vs_libc(tc, edgeCases[i]);
+   }
+   for (iter = 0u; iter < 10000u; iter++)
+   {
+      size_t len = 0u;
+      size_t numDigits;
+      size_t k;
+      uint64_t bits = ((uint64_t) rand_u32(&seed) << 32) | rand_u32(&seed);
+      double value;
+      switch (iter % 3u)
+      {
+      case 0u:
+         //any finite double printed with 1-17 significant digits
+         memcpy(&value, &bits, sizeof(value));
+         if ( (value != value) || (value - value != 0.0) )
+         {
+            continue;
+         }
+         len = (size_t) sprintf(buf, "%.*g", (int) (rand_u32(&seed) % 17u) + 1, value);
+         break;
+      case 1u:
+         //the exact halfway point between two adjacent doubles, possibly nudged up or down
+         len = format_halfway(buf, bits & 0x7FEFFFFFFFFFFFFFull, rand_u32(&seed) % 3u);
+         break;
+      default:
+         //long mantissas with random exponents
+         numDigits = rand_u32(&seed) % 40u + 1u;
+         for (k = 0u; k < numDigits; k++)
+         {
+            buf[len++] = (char) ('0' + rand_u32(&seed) % 10u);
+            if (k == numDigits / 2u)
+            {
+               buf[len++] = '.';
+            }
+         }
+         len += (size_t) sprintf(&buf[len], "e%d", (int) (rand_u32(&seed) % 700u) - 350);
+         break;
+      }
+      buf[len] = '\0';
+      check_to_double_vs_libc(tc, buf);
+   }
+}
+
+static void check_to_double_vs_libc(CuTest* tc, const char *str)
+{
+   const uint8_t *pBegin = (const uint8_t*) str;
+   const uint8_t *pResult;
+   char *pExpectedEnd;
+   double expected;
+   double value;
+   int expectedErrno;
+   char msg[80];
+   errno = 0;
+   expected = strtod(str, &pExpectedEnd);
+   expectedErrno = errno;
+   errno = 0;
+   pResult = bstr_to_double(pBegin, pBegin + strlen(str), &value);
+   sprintf(msg, "\"%.60s\"", str);
+   CuAssertConstPtrEquals_Msg(tc, msg, (const uint8_t*) pExpectedEnd, pResult);
+   CuAssert(tc, msg, memcmp(&expected, &value, sizeof(double)) == 0);
+   //libc may also report ERANGE for subnormal results
+   if ( (expected == 0.0) || (expected == HUGE_VAL) || (expected == -HUGE_VAL) )
+   {
+      CuAssertIntEquals_Msg(tc, msg, expectedErrno, errno);
+   }
+}
+
+/**
+ * Writes the exact decimal value halfway between the double with the given bit pattern and the next larger one.
+ * nudge 1 adds and nudge 2 subtracts one unit in the last digit.
+ */
+static size_t format_halfway(char *buf, uint64_t bits, uint32_t nudge)
+{
+   uint32_t limbs[130]; //base 10^9, least significant first
+   uint32_t numLimbs = 0u;
+   uint64_t m = bits & 0xFFFFFFFFFFFFFull;
+   int e = (int) (bits >> 52);
+   int exponent10 = 0;
+   int remaining;
+   size_t len;
+   uint32_t i;
+   if (e == 0)
+   {
+      e = -1074;
+   }
+   else
+   {
+      m |= 0x10000000000000ull;
+      e -= 1075;
+   }
+   //(2m+1) * 2^(e-1)
+   m = 2u * m + 1u;
+   while (m != 0u)
+   {
+      limbs[numLimbs++] = (uint32_t) (m % 1000000000u);
+      m /= 1000000000u;
+   }
+   remaining = (e - 1 >= 0)? e - 1 : 1 - e;
+   exponent10 = (e - 1 >= 0)? 0 : e - 1; //2^-k = 5^k * 10^-k
+   while (remaining > 0)
+   {
+      uint32_t step = (uint32_t) ((remaining > 13)? 13 : remaining);
+      uint64_t mul = 1u;
+      uint64_t carry = 0u;
+      for (i = 0u; i < step; i++)
+      {
+         mul *= (e - 1 >= 0)? 2u : 5u;
+      }
+      for (i = 0u; i < numLimbs; i++)
+      {
+         uint64_t tmp = limbs[i] * mul + carry;
+         limbs[i] = (uint32_t) (tmp % 1000000000u);
+         carry = tmp / 1000000000u;
+      }
+      while (carry != 0u)
+      {
+         limbs[numLimbs++] = (uint32_t) (carry % 1000000000u);
+         carry /= 1000000000u;
+      }
+      remaining -= (int) step;
+   }
+   len = (size_t) sprintf(buf, "%u", limbs[numLimbs - 1u]);
+   for (i = numLimbs - 1u; i > 0u; i--)
+   {
+      len += (size_t) sprintf(&buf[len], "%09u", limbs[i - 1u]);
+   }
+   if (nudge == 1u)
+   {
+      buf[len++] = '1';
+      exponent10--;
+   }
+   else if ( (nudge == 2u) && (buf[len - 1u] != '0') )
+   {
+      buf[len - 1u]--;
+   }
+   len += (size_t) sprintf(&buf[len], "e%d", exponent10);
+   return len;
+}
+
+static uint32_t rand_u32(uint32_t *seed)
+{
+   uint32_t x = *seed;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   *seed = x;
+   return x;
+}
+
+static void test_bstr_parse_json_number_int64(CuTest* tc)
+{
+   bstr_context_t ctx;
+   bstr_number_t number;
+   const uint8_t *pBegin;
+   const uint8_t *pResult;
+   const char *test_data;
+
+   bstr_context_create(&ctx);
+   test_data = "9223372036854775807";
+   pBegin = (const uint8_t*) test_data;
+   pResult = bstr_parse_json_number(&ctx, pBegin, pBegin + strlen(test_data), &number);
+   CuAssertConstPtrEquals(tc, pBegin + strlen(test_data), pResult);
+   CuAssertUIntEquals(tc, BSTR_NUMBER_INT64, number.type);
+   CuAssertTrue(tc, number.value.i64 == INT64_MAX);
+
+   test_data = "9223372036854775808";
+   pBegin = (const uint8_t*) test_data;
+   pResult = bstr_parse_json_number(&ctx, pBegin, pBegin + strlen(test_data), &number);
+   CuAssertConstPtrEquals(tc, pBegin + strlen(test_data), pResult);
+   CuAssertUIntEquals(tc, BSTR_NUMBER_UINT64, number.type);
+   CuAssertTrue(tc, number.value.u64 == (uint64_t) INT64_MAX + 1u);
+
+   test_data = "18446744073709551615";
+   pBegin = (const uint8_t*) test_data;
+   pResult = bstr_parse_json_number(&ctx, pBegin, pBegin + strlen(test_data), &number);
+   CuAssertConstPtrEquals(tc, pBegin + strlen(test_data), pResult);
+   CuAssertUIntEquals(tc, BSTR_NUMBER_UINT64, number.type);
+   CuAssertTrue(tc, number.value.u64 == UINT64_MAX);
+   CuAssertTrue(tc, number.integer == UINT64_MAX);
+
+   test_data = "-9223372036854775808";
+   pBegin = (const uint8_t*) test_data;
+   pResult = bstr_parse_json_number(&ctx, pBegin, pBegin + strlen(test_data), &number);
+   CuAssertConstPtrEquals(tc, pBegin + strlen(test_data), pResult);
+   CuAssertUIntEquals(tc, BSTR_NUMBER_INT64, number.type);
+   CuAssertTrue(tc, number.value.i64 == INT64_MIN);
+
+   //integers outside 64-bit range become doubles
+   test_data = "18446744073709551616";
+   pBegin = (const uint8_t*) test_data;
+   pResult = bstr_parse_json_number(&ctx, pBegin, pBegin + strlen(test_data), &number);
+   CuAssertConstPtrEquals(tc, pBegin + strlen(test_data), pResult);
+   CuAssertUIntEquals(tc, BSTR_NUMBER_DOUBLE, number.type);
+   CuAssertDblEquals(tc, 18446744073709551616.0, number.value.f64, 0.0);
+   CuAssertTrue(tc, number.integer == UINT64_MAX);
+
+   test_data = "-9223372036854775809";
+   pBegin = (const uint8_t*) test_data;
+   pResult = bstr_parse_json_number(&ctx, pBegin, pBegin + strlen(test_data), &number);
+   CuAssertConstPtrEquals(tc, pBegin + strlen(test_data), pResult);
+   CuAssertUIntEquals(tc, BSTR_NUMBER_DOUBLE, number.type);
+   CuAssertDblEquals(tc, -9223372036854775809.0, number.value.f64, 0.0);
+
+   //a leading zero ends the number
+   test_data = "-012";
+   pBegin = (const uint8_t*) test_data;
+   pResult = bstr_parse_json_number(&ctx, pBegin, pBegin + strlen(test_data), &number);
+   CuAssertConstPtrEquals(tc, pBegin + 2, pResult);
+   CuAssertUIntEquals(tc, BSTR_NUMBER_INT64, number.type);
+   CuAssertTrue(tc, number.value.i64 == 0);
+   CuAssertTrue(tc, number.isNegative);
+   CuAssertUIntEquals(tc, BSTR_NO_ERROR, bstr_get_last_error(&ctx));
+}
+
+static void test_bstr_parse_json_number_double(CuTest* tc)
+{
+   const char *test_data[] = {
+      "0.0", "-0.5", "1e3", "1E+3", "12.5e-3", "0.1", "3.141592653589793238462643383279", "-2.2250738585072011e-308",
+      "1.7976931348623157e308", "5e-324", "1e-400", "123456789012345678901234567890", "0e0", "1.0", "42]"
+   };
+   bstr_context_t ctx;
+   uint32_t seed = 777u;
+   uint32_t iter;
+   size_t i;
+   char buf[64];
+
+   bstr_context_create(&ctx);
+   for (i = 0u; i < sizeof(test_data) / sizeof(test_data[0]); i++)
+   {
+      bstr_number_t number;
+      const uint8_t *pBegin = (const uint8_t*) test_data[i];
+      char *pExpectedEnd;
+      double expected = strtod(test_data[i], &pExpectedEnd);
+      const uint8_t *pResult = bstr_parse_json_number(&ctx, pBegin, pBegin + strlen(test_data[i]), &number);
+      CuAssertConstPtrEquals_Msg(tc, test_data[i], (const uint8_t*) pExpectedEnd, pResult);
+      if (number.type == BSTR_NUMBER_DOUBLE)
+      {
+         CuAssert(tc, test_data[i], memcmp(&expected, &number.value.f64, sizeof(double)) == 0);
+      }
+      else
+      {
+         CuAssertUIntEquals_Msg(tc, test_data[i], BSTR_NUMBER_INT64, number.type);
+         CuAssert(tc, test_data[i], (double) number.value.i64 == expected);
+      }
+   }
+   //the parts are reported as well
+   {
+      bstr_number_t number;
+      const uint8_t *pBegin = (const uint8_t*) "-12.5e-3";
+      CuAssertConstPtrEquals(tc, pBegin + 8, bstr_parse_json_number(&ctx, pBegin, pBegin + 8, &number));
+      CuAssertTrue(tc, number.isNegative && number.hasInteger && number.hasFraction && number.hasExponent);
+      CuAssertTrue(tc, number.integer == 12u);
+      CuAssertIntEquals(tc, -3, number.exponent);
+   }
+   for (iter = 0u; iter < 10000u; iter++)
+   {
+      bstr_number_t number;
+      const uint8_t *pBegin = (const uint8_t*) buf;
+      const uint8_t *pResult;
+      size_t len;
+      double expected;
+      uint64_t bits = ((uint64_t) rand_u32(&seed) << 32) | rand_u32(&seed);
+      memcpy(&expected, &bits, sizeof(expected));
+      if ( (expected != expected) || (expected - expected != 0.0) )
+      {
+         continue;
+      }
+      len = (size_t) sprintf(buf, "%.*e", (int) (rand_u32(&seed) % 20u), expected);
+      expected = strtod(buf, 0);
+      pResult = bstr_parse_json_number(&ctx, pBegin, pBegin + len, &number);
+      CuAssertConstPtrEquals_Msg(tc, buf, pBegin + len, pResult);
+      CuAssertUIntEquals_Msg(tc, buf, BSTR_NUMBER_DOUBLE, number.type);
+      CuAssert(tc, buf, memcmp(&expected, &number.value.f64, sizeof(double)) == 0);
+   }
+}
+
+static void test_bstr_parse_json_number_malformed(CuTest* tc)
+{
+   const char *test_data[] = {"-", "+1", ".5", "1.", "1.e5", "1e", "1e+", "-a", "x"};
+   bstr_context_t ctx;
+   size_t i;
+
+   bstr_context_create(&ctx);
+   for (i = 0u; i < sizeof(test_data) / sizeof(test_data[0]); i++)
+   {
+      bstr_number_t number;
+      const uint8_t *pBegin = (const uint8_t*) test_data[i];
+      bstr_clear_error(&ctx);
+      CuAssertConstPtrEquals_Msg(tc, test_data[i], NULL, bstr_parse_json_number(&ctx, pBegin, pBegin + strlen(test_data[i]), &number));
+      CuAssertIntEquals_Msg(tc, test_data[i], BSTR_PARSE_ERROR, bstr_get_last_error(&ctx));
+   }
+   {
+      bstr_number_t number;
+      const uint8_t *pBegin = (const uint8_t*) "-1e999";
+      bstr_clear_error(&ctx);
+      CuAssertConstPtrEquals(tc, NULL, bstr_parse_json_number(&ctx, pBegin, pBegin + 6, &number));
+      CuAssertIntEquals(tc, BSTR_NUMBER_TOO_LARGE_ERROR, bstr_get_last_error(&ctx));
+   }
+}
+
+/**
+ * Literals of all lengths up to 200 bytes with escapes placed at random positions, so that escapes and the closing
+ * quotation mark land at every offset within the vector blocks.
+ */
+static void test_bstr_parse_json_string_literal_simd(CuTest* tc)
+{
+   static const char *escapes[] = {"\\n", "\\\"", "\\\\", "\\/", "\\t", "\\u0041"};
+   static const char decoded[] = {'\n', '"', '\\', '/', '\t', 'A'};
+   uint8_t literal[260];
+   char expected[260];
+   uint32_t seed = 99u;
+   size_t f;
+   bstr_context_t ctx;
+
+   bstr_context_create(&ctx);
+   for (f = 0u; f < NUM_SIMD_FEATURE_SETS; f++)
+   {
+      size_t len;
+      bstr_simd_set_features(m_simdFeatureSets[f]);
+      for (len = 0u; len < 200u; len++)
+      {
+         adt_str_t *str = adt_str_new();
+         size_t literalLen = 0u;
+         size_t expectedLen = 0u;
+         const uint8_t *pResult;
+         char msg[64];
+         literal[literalLen++] = '"';
+         while (expectedLen < len)
+         {
+            uint32_t r = rand_u32(&seed);
+            if (r % 16u == 0u)
+            {
+               size_t k = (r >> 8) % (sizeof(escapes) / sizeof(escapes[0]));
+               memcpy(&literal[literalLen], escapes[k], strlen(escapes[k]));
+               literalLen += strlen(escapes[k]);
+               expected[expectedLen++] = decoded[k];
+            }
+            else
+            {
+               char c = (char) (' ' + (r >> 8) % 95u);
+               if ( (c == '"') || (c == '\\') )
+               {
+                  c = 'x';
+               }
+               literal[literalLen++] = (uint8_t) c;
+               expected[expectedLen++] = c;
+            }
+         }
+         literal[literalLen++] = '"';
+         literal[literalLen] = ',';
+         expected[expectedLen] = '\0';
+         sprintf(msg, "features=%u len=%u", (unsigned) m_simdFeatureSets[f], (unsigned) len);
+         pResult = bstr_parse_json_string_literal(&ctx, literal, literal + literalLen + 1, str);
+         CuAssertConstPtrEquals_Msg(tc, msg, literal + literalLen, pResult);
+         CuAssertIntEquals_Msg(tc, msg, (int) expectedLen, adt_str_length(str));
+         CuAssertStrEquals_Msg(tc, msg, expected, adt_str_cstr(str));
+         adt_str_delete(str);
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_parse_json_string_literal_errors(CuTest* tc)
+{
+   const char *invalid[] = {"\"abc\\x\"", "\"abc\\u12G4\"", "\"tab\there\"", "\"0123456789abcdef0123456789abcdef0123456789\x01\""};
+   const char *unterminated[] = {"\"abc", "\"abc\\", "\"abc\\\"", "\"abc\\u12", "abc\""};
+   bstr_context_t ctx;
+   size_t i;
+
+   bstr_context_create(&ctx);
+   for (i = 0u; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+   {
+      adt_str_t *str = adt_str_new();
+      const uint8_t *pBegin = (const uint8_t*) invalid[i];
+      bstr_clear_error(&ctx);
+      CuAssertConstPtrEquals_Msg(tc, invalid[i], NULL, bstr_parse_json_string_literal(&ctx, pBegin, pBegin + strlen(invalid[i]), str));
+      CuAssertIntEquals_Msg(tc, invalid[i], BSTR_INVALID_CHARACTER_ERROR, bstr_get_last_error(&ctx));
+      adt_str_delete(str);
+   }
+   for (i = 0u; i < sizeof(unterminated) / sizeof(unterminated[0]); i++)
+   {
+      adt_str_t *str = adt_str_new();
+      const uint8_t *pBegin = (const uint8_t*) unterminated[i];
+      bstr_clear_error(&ctx);
+      CuAssertConstPtrEquals_Msg(tc, unterminated[i], pBegin, bstr_parse_json_string_literal(&ctx, pBegin, pBegin + strlen(unterminated[i]), str));
+      CuAssertIntEquals_Msg(tc, unterminated[i], BSTR_NO_ERROR, bstr_get_last_error(&ctx));
+      adt_str_delete(str);
+   }
+   //\u escapes cut short by the closing quotation mark are invalid, cut short by the end of the buffer incomplete
+   for (i = 0u; i < NUM_SIMD_FEATURE_SETS * 2u; i++)
+   {
+      static const char *prefixes[2] = {"\"", "\"0123456789abcdef0123456789abcdef0123456789"};
+      static const char *escapes[6] = {"\\u12\"", "\\u1\"", "\\uD800\\uDC\"", "\\u12", "\\u1", "\\uD800\\uDC"};
+      size_t j;
+      bstr_simd_set_features(m_simdFeatureSets[i / 2u]);
+      for (j = 0u; j < 6u; j++)
+      {
+         char literal[80];
+         char msg[100];
+         const uint8_t *pBegin = (const uint8_t*) literal;
+         const uint8_t *pEnd;
+         const uint8_t *pExpected = (j < 3u) ? 0 : pBegin;
+         bstr_error_t expectedError = (j < 3u) ? BSTR_INVALID_CHARACTER_ERROR : BSTR_NO_ERROR;
+         const uint8_t *pStrBegin;
+         const uint8_t *pStrEnd;
+         adt_str_t *str = adt_str_new();
+         bstr_buf_t buf;
+         bool isView;
+         sprintf(literal, "%s%s", prefixes[i % 2u], escapes[j]);
+         sprintf(msg, "features=%x, %s", (unsigned) m_simdFeatureSets[i / 2u], literal);
+         pEnd = pBegin + strlen(literal);
+         bstr_buf_create(&buf, 0);
+         bstr_clear_error(&ctx);
+         CuAssertConstPtrEquals_Msg(tc, msg, pExpected, bstr_parse_json_string_literal(&ctx, pBegin, pEnd, str));
+         CuAssertIntEquals_Msg(tc, msg, expectedError, bstr_get_last_error(&ctx));
+         bstr_clear_error(&ctx);
+         CuAssertConstPtrEquals_Msg(tc, msg, pExpected, bstr_parse_json_string_literal_buf(&ctx, pBegin, pEnd, &buf));
+         CuAssertIntEquals_Msg(tc, msg, expectedError, bstr_get_last_error(&ctx));
+         bstr_clear_error(&ctx);
+         CuAssertConstPtrEquals_Msg(tc, msg, pExpected, bstr_parse_json_string_view(&ctx, pBegin, pEnd, &pStrBegin, &pStrEnd, str, &isView));
+         CuAssertIntEquals_Msg(tc, msg, expectedError, bstr_get_last_error(&ctx));
+         bstr_clear_error(&ctx);
+         CuAssertConstPtrEquals_Msg(tc, msg, pExpected, bstr_parse_json_string_view_buf(&ctx, pBegin, pEnd, &pStrBegin, &pStrEnd, &buf, &isView));
+         CuAssertIntEquals_Msg(tc, msg, expectedError, bstr_get_last_error(&ctx));
+         if (j < 3u)
+         {
+            //the in-place variant agrees
+            bstr_clear_error(&ctx);
+            CuAssertConstPtrEquals_Msg(tc, msg, NULL, bstr_unescape_json_inplace(&ctx, (uint8_t*) literal, (uint8_t*) literal + strlen(literal), (uint8_t**) &pStrBegin, (uint8_t**) &pStrEnd));
+            CuAssertIntEquals_Msg(tc, msg, BSTR_INVALID_CHARACTER_ERROR, bstr_get_last_error(&ctx));
+         }
+         bstr_buf_destroy(&buf);
+         adt_str_delete(str);
+      }
+   }
+   //fast and portable paths agree wherever the buffer ends inside an escape
+   {
+      static const char *literal = "\"0123456789abcdef0123456789abcdef0123456789\\uD83D\\uDE00\\n\"";
+      const uint8_t *pBegin = (const uint8_t*) literal;
+      size_t len = strlen(literal);
+      size_t cut;
+      for (cut = 43u; cut < len; cut++)
+      {
+         const uint8_t *pExpected;
+         bstr_error_t expectedError;
+         adt_str_t *str = adt_str_new();
+         bstr_simd_set_features(0u);
+         bstr_clear_error(&ctx);
+         pExpected = bstr_parse_json_string_literal(&ctx, pBegin, pBegin + cut, str);
+         expectedError = bstr_get_last_error(&ctx);
+         CuAssertConstPtrEquals(tc, pBegin, pExpected);
+         for (i = 1u; i < NUM_SIMD_FEATURE_SETS; i++)
+         {
+            bstr_simd_set_features(m_simdFeatureSets[i]);
+            bstr_clear_error(&ctx);
+            CuAssertConstPtrEquals(tc, pExpected, bstr_parse_json_string_literal(&ctx, pBegin, pBegin + cut, str));
+            CuAssertIntEquals(tc, expectedError, bstr_get_last_error(&ctx));
+         }
+         adt_str_delete(str);
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_parse_json_string_view(CuTest* tc)
+{
+   const uint8_t plain[] = "\"0123456789abcdef0123456789abcdef0123456789\": 1";
+   const uint8_t escaped[] = "\"0123456789abcdef0123456789abcdef\\n0123456789\"";
+   const uint8_t unterminated[] = "\"0123456789abcdef0123456789abcdef0123456789";
+   const uint8_t invalid[] = "\"0123456789abcdef0123456789abcdef\\q\"";
+   size_t f;
+   bstr_context_t ctx;
+
+   bstr_context_create(&ctx);
+   for (f = 0u; f < NUM_SIMD_FEATURE_SETS; f++)
+   {
+      adt_str_t *str = adt_str_new();
+      const uint8_t *pStrBegin = 0;
+      const uint8_t *pStrEnd = 0;
+      const uint8_t *pResult;
+      const uint8_t *pEnd;
+      bool isView = false;
+      bstr_simd_set_features(m_simdFeatureSets[f]);
+
+      pEnd = plain + sizeof(plain) - 1;
+      pResult = bstr_parse_json_string_view(&ctx, plain, pEnd, &pStrBegin, &pStrEnd, str, &isView);
+      CuAssertConstPtrEquals(tc, plain + 44, pResult);
+      CuAssertTrue(tc, isView);
+      CuAssertConstPtrEquals(tc, plain + 1, pStrBegin);
+      CuAssertConstPtrEquals(tc, plain + 43, pStrEnd);
+      CuAssertIntEquals(tc, 0, adt_str_length(str));
+
+      pEnd = escaped + sizeof(escaped) - 1;
+      pResult = bstr_parse_json_string_view(&ctx, escaped, pEnd, &pStrBegin, &pStrEnd, str, &isView);
+      CuAssertConstPtrEquals(tc, pEnd, pResult);
+      CuAssertTrue(tc, !isView);
+      CuAssertIntEquals(tc, 43, (int) (pStrEnd - pStrBegin));
+      CuAssertTrue(tc, memcmp(pStrBegin, "0123456789abcdef0123456789abcdef\n0123456789", 43) == 0);
+      CuAssertStrEquals(tc, "0123456789abcdef0123456789abcdef\n0123456789", adt_str_cstr(str));
+
+      //the destination is appended to, the view only covers the new part
+      pResult = bstr_parse_json_string_view(&ctx, escaped, pEnd, &pStrBegin, &pStrEnd, str, &isView);
+      CuAssertConstPtrEquals(tc, pEnd, pResult);
+      CuAssertIntEquals(tc, 86, adt_str_length(str));
+      CuAssertConstPtrEquals(tc, (const uint8_t*) adt_str_cstr(str) + 43, pStrBegin);
+      CuAssertIntEquals(tc, 43, (int) (pStrEnd - pStrBegin));
+
+      pEnd = unterminated + sizeof(unterminated) - 1;
+      pResult = bstr_parse_json_string_view(&ctx, unterminated, pEnd, &pStrBegin, &pStrEnd, str, &isView);
+      CuAssertConstPtrEquals(tc, unterminated, pResult);
+      CuAssertTrue(tc, !isView);
+
+      pEnd = invalid + sizeof(invalid) - 1;
+      pResult = bstr_parse_json_string_view(&ctx, invalid, pEnd, &pStrBegin, &pStrEnd, str, &isView);
+      CuAssertConstPtrEquals(tc, 0, pResult);
+      CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, bstr_get_last_error(&ctx));
+      bstr_clear_error(&ctx);
+      adt_str_delete(str);
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_parse_json_string_literal_unicode(CuTest* tc)
+{
+   const char *literals[] = {"\"\\u00e9\"", "\"\\u20AC\"", "\"\\uD83D\\uDE00\"", "\"a\\u0000b\"", "\"\\uFFFF\"", "\"\\udbff\\udfff\"",
+                             "\"caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80\""};
+   const char *expected[] = {"\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "a\0b", "\xEF\xBF\xBF", "\xF4\x8F\xBF\xBF",
+                             "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80"};
+   const int expectedLen[] = {2, 3, 4, 3, 3, 4, 14};
+   const char *invalid[] = {"\"\\uDE00\"", "\"\\uD83D\"", "\"\\uD83Dx\"", "\"\\uD83D\\n\"", "\"\\uD83D\\u0041\"", "\"\\uD83D\\uD83D\"",
+                            "\"\xC3\"", "\"\xE2\x82\"", "\"\xC0\xAF\"", "\"\xED\xA0\x80\"", "\"\xF4\x90\x80\x80\"", "\"\x80\""};
+   const char *unterminated[] = {"\"\\uD83D", "\"\\uD83D\\", "\"\\uD83D\\u", "\"\\uD83D\\uDE0", "\"\xF0\x9F\x98"};
+   size_t i;
+   bstr_context_t ctx;
+
+   bstr_context_create(&ctx);
+   for (i = 0u; i < sizeof(literals) / sizeof(literals[0]); i++)
+   {
+      adt_str_t *str = adt_str_new();
+      const uint8_t *pBegin = (const uint8_t*) literals[i];
+      const uint8_t *pEnd = pBegin + strlen(literals[i]);
+      CuAssertConstPtrEquals(tc, pEnd, bstr_parse_json_string_literal(&ctx, pBegin, pEnd, str));
+      CuAssertIntEquals(tc, expectedLen[i], adt_str_length(str));
+      CuAssertTrue(tc, memcmp(adt_str_cstr(str), expected[i], (size_t) expectedLen[i]) == 0);
+      adt_str_delete(str);
+   }
+   for (i = 0u; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+   {
+      adt_str_t *str = adt_str_new();
+      const uint8_t *pBegin = (const uint8_t*) invalid[i];
+      const uint8_t *pEnd = pBegin + strlen(invalid[i]);
+      CuAssertConstPtrEquals(tc, 0, bstr_parse_json_string_literal(&ctx, pBegin, pEnd, str));
+      CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, bstr_get_last_error(&ctx));
+      bstr_clear_error(&ctx);
+      adt_str_delete(str);
+   }
+   for (i = 0u; i < sizeof(unterminated) / sizeof(unterminated[0]); i++)
+   {
+      adt_str_t *str = adt_str_new();
+      const uint8_t *pBegin = (const uint8_t*) unterminated[i];
+      const uint8_t *pEnd = pBegin + strlen(unterminated[i]);
+      CuAssertConstPtrEquals(tc, pBegin, bstr_parse_json_string_literal(&ctx, pBegin, pEnd, str));
+      adt_str_delete(str);
+   }
+}
+
+static void test_bstr_parse_json_string_literal_utf8(CuTest* tc)
+{
+   static const char *sequences[] = {"\xC3\xA9", "\xDF\xBF", "\xE2\x82\xAC", "\xEF\xBF\xBD", "\xED\x9F\xBF", "\xF0\x9F\x98\x80", "\xF4\x8F\xBF\xBF"};
+   uint8_t literal[300];
+   uint32_t seed = 7u;
+   size_t f;
+   bstr_context_t ctx;
+
+   bstr_context_create(&ctx);
+   for (f = 0u; f < NUM_SIMD_FEATURE_SETS; f++)
+   {
+      int iteration;
+      bstr_simd_set_features(m_simdFeatureSets[f]);
+      for (iteration = 0; iteration < 2000; iteration++)
+      {
+         adt_str_t *str = adt_str_new();
+         size_t len = rand_u32(&seed) % 200u;
+         size_t literalLen = 1u;
+         const uint8_t *pResult;
+         bool isValid;
+         char msg[64];
+         literal[0] = '"';
+         while (literalLen < len + 1u)
+         {
+            uint32_t r = rand_u32(&seed);
+            if (r % 4u == 0u)
+            {
+               const char *seq = sequences[(r >> 8) % (sizeof(sequences) / sizeof(sequences[0]))];
+               memcpy(&literal[literalLen], seq, strlen(seq));
+               literalLen += strlen(seq);
+            }
+            else
+            {
+               literal[literalLen++] = (uint8_t) ('a' + (r >> 8) % 26u);
+            }
+         }
+         if ( (iteration % 2 == 1) && (literalLen > 1u) )
+         {
+            //replace a random byte with a random non-ASCII byte, which may or may not break the encoding
+            uint32_t r = rand_u32(&seed);
+            literal[1u + (r % (literalLen - 1u))] = (uint8_t) (0x80u | (r >> 16));
+         }
+         isValid = is_valid_utf8(&literal[1], literalLen - 1u);
+         literal[literalLen++] = '"';
+         sprintf(msg, "features=%u iteration=%d", (unsigned) m_simdFeatureSets[f], iteration);
+         pResult = bstr_parse_json_string_literal(&ctx, literal, literal + literalLen, str);
+         if (isValid)
+         {
+            CuAssertConstPtrEquals_Msg(tc, msg, literal + literalLen, pResult);
+            CuAssertIntEquals_Msg(tc, msg, (int) literalLen - 2, adt_str_length(str));
+            CuAssertTrue(tc, memcmp(adt_str_cstr(str), &literal[1], literalLen - 2u) == 0);
+         }
+         else
+         {
+            CuAssertConstPtrEquals_Msg(tc, msg, 0, pResult);
+            CuAssertIntEquals_Msg(tc, msg, BSTR_INVALID_CHARACTER_ERROR, bstr_get_last_error(&ctx));
+            bstr_clear_error(&ctx);
+         }
+         adt_str_delete(str);
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_unescape_json_inplace(CuTest* tc)
+{
+   static const char *escapes[] = {"\\n", "\\\"", "\\\\", "\\/", "\\t", "\\u00e9", "\\uD83D\\uDE00"};
+   static const char *decoded[] = {"\n", "\"", "\\", "/", "\t", "\xC3\xA9", "\xF0\x9F\x98\x80"};
+   const char *unterminated = "\"abc\\n0123456789abcdef0123456789abcdef\\t";
+   uint8_t buf[600];
+   uint8_t copy[600];
+   char expected[600];
+   uint32_t seed = 1234u;
+   uint8_t *pStrBegin = 0;
+   uint8_t *pStrEnd = 0;
+   size_t f;
+   size_t len;
+   bstr_context_t ctx;
+
+   bstr_context_create(&ctx);
+   for (f = 0u; f < NUM_SIMD_FEATURE_SETS; f++)
+   {
+      int iteration;
+      bstr_simd_set_features(m_simdFeatureSets[f]);
+      for (iteration = 0; iteration < 500; iteration++)
+      {
+         size_t literalLen = 0u;
+         size_t expectedLen = 0u;
+         size_t targetLen = rand_u32(&seed) % 150u;
+         const uint8_t *pResult;
+         char msg[64];
+         buf[literalLen++] = '"';
+         while (expectedLen < targetLen)
+         {
+            uint32_t r = rand_u32(&seed);
+            if (r % 8u == 0u)
+            {
+               size_t k = (r >> 8) % (sizeof(escapes) / sizeof(escapes[0]));
+               memcpy(&buf[literalLen], escapes[k], strlen(escapes[k]));
+               literalLen += strlen(escapes[k]);
+               memcpy(&expected[expectedLen], decoded[k], strlen(decoded[k]));
+               expectedLen += strlen(decoded[k]);
+            }
+            else
+            {
+               buf[literalLen++] = (uint8_t) ('a' + (r >> 8) % 26u);
+               expected[expectedLen++] = (char) buf[literalLen - 1u];
+            }
+         }
+         buf[literalLen++] = '"';
+         memcpy(&buf[literalLen], ",1", 2u);
+         sprintf(msg, "features=%u iteration=%d", (unsigned) m_simdFeatureSets[f], iteration);
+         pResult = bstr_unescape_json_inplace(&ctx, buf, buf + literalLen + 2u, &pStrBegin, &pStrEnd);
+         CuAssertConstPtrEquals_Msg(tc, msg, buf + literalLen, pResult);
+         CuAssertPtrEquals_Msg(tc, msg, buf + 1, pStrBegin);
+         CuAssertIntEquals_Msg(tc, msg, (int) expectedLen, (int) (pStrEnd - pStrBegin));
+         CuAssertTrue(tc, memcmp(pStrBegin, expected, expectedLen) == 0);
+         CuAssertTrue(tc, memcmp(&buf[literalLen], ",1", 2u) == 0);
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+
+   //an unterminated literal is left untouched
+   len = strlen(unterminated);
+   memcpy(buf, unterminated, len);
+   memcpy(copy, unterminated, len);
+   CuAssertConstPtrEquals(tc, buf, bstr_unescape_json_inplace(&ctx, buf, buf + len, &pStrBegin, &pStrEnd));
+   CuAssertTrue(tc, memcmp(buf, copy, len) == 0);
+
+   len = strlen("\"abc\\x\"");
+   memcpy(buf, "\"abc\\x\"", len);
+   CuAssertConstPtrEquals(tc, 0, bstr_unescape_json_inplace(&ctx, buf, buf + len, &pStrBegin, &pStrEnd));
+   CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, bstr_get_last_error(&ctx));
+   bstr_clear_error(&ctx);
+
+   len = strlen("\"\\u12\"");
+   memcpy(buf, "\"\\u12\"", len);
+   CuAssertConstPtrEquals(tc, 0, bstr_unescape_json_inplace(&ctx, buf, buf + len, &pStrBegin, &pStrEnd));
+   bstr_clear_error(&ctx);
+
+   len = strlen("abc");
+   memcpy(buf, "abc", len);
+   CuAssertConstPtrEquals(tc, buf, bstr_unescape_json_inplace(&ctx, buf, buf + len, &pStrBegin, &pStrEnd));
+}
+
+static void test_bstr_buf(CuTest* tc)
+{
+   const uint8_t *text = (const uint8_t*) "0123456789abcdefghijklmnopqrstuvwxyz";
+   const uint8_t *pBegin = 0;
+   const uint8_t *pEnd = 0;
+   uint8_t *pInline;
+   bstr_buf_t buf;
+   int i;
+
+   bstr_buf_create(&buf, 0);
+   pInline = bstr_buf_data(&buf);
+   CuAssertTrue(tc, (pInline >= (uint8_t*) &buf) && (pInline < (uint8_t*) (&buf + 1)));
+   CuAssertStrEquals(tc, "", bstr_buf_cstr(&buf));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_append_bstr(&buf, text, text + 10));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_append_cstr(&buf, "abcdefghijklm"));
+   //23 bytes still fit inline
+   CuAssertPtrEquals(tc, pInline, bstr_buf_data(&buf));
+   CuAssertIntEquals(tc, 23, (int) bstr_buf_length(&buf));
+   CuAssertStrEquals(tc, "0123456789abcdefghijklm", bstr_buf_cstr(&buf));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_push(&buf, (uint8_t) 'n'));
+   CuAssertTrue(tc, bstr_buf_data(&buf) != pInline);
+   CuAssertStrEquals(tc, "0123456789abcdefghijklmn", bstr_buf_cstr(&buf));
+   for (i = 0; i < 100; i++)
+   {
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_append_bstr(&buf, text, text + 36));
+   }
+   CuAssertIntEquals(tc, 24 + 3600, (int) bstr_buf_length(&buf));
+   bstr_buf_view(&buf, &pBegin, &pEnd);
+   CuAssertConstPtrEquals(tc, bstr_buf_data(&buf), pBegin);
+   CuAssertIntEquals(tc, 24 + 3600, (int) (pEnd - pBegin));
+   CuAssertTrue(tc, memcmp(pEnd - 36, text, 36) == 0);
+   CuAssertIntEquals(tc, 0, *pEnd);
+
+   //clear keeps the storage
+   pInline = bstr_buf_data(&buf);
+   bstr_buf_clear(&buf);
+   CuAssertIntEquals(tc, 0, (int) bstr_buf_length(&buf));
+   CuAssertStrEquals(tc, "", bstr_buf_cstr(&buf));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_append_cstr(&buf, "x"));
+   CuAssertPtrEquals(tc, pInline, bstr_buf_data(&buf));
+   bstr_buf_destroy(&buf);
+
+   //reserve allocates once up front
+   pInline = bstr_buf_data(&buf);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_reserve(&buf, 10u));
+   CuAssertPtrEquals(tc, pInline, bstr_buf_data(&buf));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_reserve(&buf, 1000u));
+   pBegin = bstr_buf_data(&buf);
+   for (i = 0; i < 1000; i++)
+   {
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_push(&buf, (uint8_t) 'a'));
+   }
+   CuAssertConstPtrEquals(tc, pBegin, bstr_buf_data(&buf));
+   bstr_buf_destroy(&buf);
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_buf_append_bstr(&buf, text + 1, text));
+
+   //appending a view of the buffer itself, from inline storage and from the heap
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_append_bstr(&buf, text, text + 20));
+   for (i = 0; i < 3; i++)
+   {
+      bstr_buf_view(&buf, &pBegin, &pEnd);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_buf_append_bstr(&buf, pBegin + 10, pEnd));
+   }
+   CuAssertIntEquals(tc, 90, (int) bstr_buf_length(&buf));
+   bstr_buf_view(&buf, &pBegin, &pEnd);
+   CuAssertTrue(tc, memcmp(pBegin, text, 20) == 0);
+   CuAssertTrue(tc, memcmp(pBegin + 20, text + 10, 10) == 0);
+   CuAssertTrue(tc, memcmp(pBegin + 30, text + 10, 10) == 0);
+   CuAssertTrue(tc, memcmp(pEnd - 10, text + 10, 10) == 0);
+   bstr_buf_destroy(&buf);
+}
+
+static void test_bstr_parse_json_string_buf(CuTest* tc)
+{
+   const uint8_t key[] = "\"key\\u00e5\": 1";
+   const uint8_t escaped[] = "\"0123456789abcdef0123456789abcdef\\n0123456789\"";
+   const uint8_t plain[] = "\"plain\"";
+   const uint8_t unterminated[] = "\"0123456789";
+   size_t f;
+   bstr_context_t ctx;
+
+   bstr_context_create(&ctx);
+   for (f = 0u; f < NUM_SIMD_FEATURE_SETS; f++)
+   {
+      const uint8_t *pStrBegin = 0;
+      const uint8_t *pStrEnd = 0;
+      const uint8_t *pResult;
+      const uint8_t *pEnd;
+      uint8_t *pInline;
+      bool isView = false;
+      bstr_buf_t buf;
+      bstr_simd_set_features(m_simdFeatureSets[f]);
+      bstr_buf_create(&buf, 0);
+      pInline = bstr_buf_data(&buf);
+
+      pEnd = key + sizeof(key) - 1;
+      pResult = bstr_parse_json_string_literal_buf(&ctx, key, pEnd, &buf);
+      CuAssertConstPtrEquals(tc, key + 11, pResult);
+      CuAssertStrEquals(tc, "key\xc3\xa5", bstr_buf_cstr(&buf));
+      CuAssertPtrEquals(tc, pInline, bstr_buf_data(&buf));
+
+      pEnd = escaped + sizeof(escaped) - 1;
+      pResult = bstr_parse_json_string_literal_buf(&ctx, escaped, pEnd, &buf);
+      CuAssertConstPtrEquals(tc, pEnd, pResult);
+      CuAssertStrEquals(tc, "key\xc3\xa5" "0123456789abcdef0123456789abcdef\n0123456789", bstr_buf_cstr(&buf));
+
+      bstr_buf_clear(&buf);
+      pResult = bstr_parse_json_string_view_buf(&ctx, escaped, pEnd, &pStrBegin, &pStrEnd, &buf, &isView);
+      CuAssertConstPtrEquals(tc, pEnd, pResult);
+      CuAssertTrue(tc, !isView);
+      CuAssertConstPtrEquals(tc, bstr_buf_data(&buf), pStrBegin);
+      CuAssertIntEquals(tc, 43, (int) (pStrEnd - pStrBegin));
+
+      pEnd = plain + sizeof(plain) - 1;
+      pResult = bstr_parse_json_string_view_buf(&ctx, plain, pEnd, &pStrBegin, &pStrEnd, &buf, &isView);
+      CuAssertConstPtrEquals(tc, pEnd, pResult);
+      CuAssertTrue(tc, isView);
+      CuAssertConstPtrEquals(tc, plain + 1, pStrBegin);
+      CuAssertIntEquals(tc, 43, (int) bstr_buf_length(&buf));
+
+      pEnd = unterminated + sizeof(unterminated) - 1;
+      CuAssertConstPtrEquals(tc, unterminated, bstr_parse_json_string_literal_buf(&ctx, unterminated, pEnd, &buf));
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_get_last_error(&ctx));
+      bstr_buf_destroy(&buf);
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_split_iter(CuTest* tc)
+{
+   const uint8_t *text = (const uint8_t*) "a,,b,";
+   const uint8_t *padded = (const uint8_t*) " a ;b\t, c ";
+   const uint8_t *repeated = (const uint8_t*) "aaaXaa";
+   const uint8_t *pBegin = 0;
+   const uint8_t *pEnd = 0;
+   bstr_split_iter_t iter;
+   bstr_byteset_t set;
+   bstr_view_t fields[4];
+
+   bstr_split_iter_create(&iter, text, text + 5, (uint8_t) ',', 0u);
+   CuAssertTrue(tc, bstr_split_next(&iter, &pBegin, &pEnd));
+   CuAssertConstPtrEquals(tc, text, pBegin);
+   CuAssertConstPtrEquals(tc, text + 1, pEnd);
+   CuAssertTrue(tc, bstr_split_next(&iter, &pBegin, &pEnd));
+   CuAssertConstPtrEquals(tc, text + 2, pBegin);
+   CuAssertConstPtrEquals(tc, text + 2, pEnd);
+   CuAssertTrue(tc, bstr_split_next(&iter, &pBegin, &pEnd));
+   CuAssertConstPtrEquals(tc, text + 3, pBegin);
+   CuAssertConstPtrEquals(tc, text + 4, pEnd);
+   CuAssertTrue(tc, bstr_split_next(&iter, &pBegin, &pEnd));
+   CuAssertConstPtrEquals(tc, text + 5, pBegin);
+   CuAssertConstPtrEquals(tc, text + 5, pEnd);
+   CuAssertTrue(tc, !bstr_split_next(&iter, &pBegin, &pEnd));
+   CuAssertTrue(tc, !bstr_split_next(&iter, &pBegin, &pEnd));
+
+   //an empty string has a single empty field
+   bstr_split_iter_create(&iter, text, text, (uint8_t) ',', 0u);
+   CuAssertIntEquals(tc, 1, (int) bstr_split_next_batch(&iter, fields, 4u));
+   CuAssertConstPtrEquals(tc, text, fields[0].pEnd);
+   CuAssertIntEquals(tc, 0, (int) bstr_split_next_batch(&iter, fields, 4u));
+
+   bstr_byteset_create_cstr(&set, ",;");
+   bstr_split_iter_create_set(&iter, padded, padded + 10, &set, BSTR_SPLIT_STRIP);
+   CuAssertIntEquals(tc, 3, (int) bstr_split_next_batch(&iter, fields, 4u));
+   CuAssertConstPtrEquals(tc, padded + 1, fields[0].pBegin);
+   CuAssertConstPtrEquals(tc, padded + 2, fields[0].pEnd);
+   CuAssertConstPtrEquals(tc, padded + 4, fields[1].pBegin);
+   CuAssertConstPtrEquals(tc, padded + 5, fields[1].pEnd);
+   CuAssertConstPtrEquals(tc, padded + 8, fields[2].pBegin);
+   CuAssertConstPtrEquals(tc, padded + 9, fields[2].pEnd);
+
+   //multi-byte separators don't overlap
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_split_iter_create_bstr(&iter, repeated, repeated + 6, repeated, repeated + 2, 0u));
+   CuAssertIntEquals(tc, 3, (int) bstr_split_next_batch(&iter, fields, 4u));
+   CuAssertConstPtrEquals(tc, repeated, fields[0].pEnd);
+   CuAssertConstPtrEquals(tc, repeated + 2, fields[1].pBegin);
+   CuAssertConstPtrEquals(tc, repeated + 4, fields[1].pEnd);
+   CuAssertConstPtrEquals(tc, repeated + 6, fields[2].pBegin);
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_split_iter_create_bstr(&iter, repeated, repeated + 6, repeated, repeated, 0u));
+}
+
+/**
+ * Splits random data with many fields per batch and checks that the fields and separators cover the input exactly
+ */
+static void test_bstr_split_iter_simd(CuTest* tc)
+{
+   const uint8_t *sep = (const uint8_t*) "a,";
+   uint8_t buf[6000];
+   bstr_byteset_t set;
+   uint32_t seed = 12345u;
+   size_t f;
+   size_t i;
+   char msg[64];
+
+   for (i = 0u; i < sizeof(buf); i++)
+   {
+      uint32_t r = rand_u32(&seed) % 16u;
+      buf[i] = (r < 3u)? (uint8_t) ',' : (r < 4u)? (uint8_t) ';' : (uint8_t) ('a' + (r % 3u));
+   }
+   bstr_byteset_create_cstr(&set, ",;");
+   for (f = 0u; f < NUM_SIMD_FEATURE_SETS; f++)
+   {
+      uint32_t mode;
+      bstr_simd_set_features(m_simdFeatureSets[f]);
+      for (mode = 0u; mode < 3u; mode++)
+      {
+         bstr_split_iter_t iter;
+         bstr_split_iter_t batchIter;
+         bstr_view_t fields[7];
+         size_t numFields = 0u;
+         size_t numBatched = 0u;
+         size_t sepLen = (mode == 2u)? 2u : 1u;
+         const uint8_t *pExpected = buf;
+         const uint8_t *pBegin;
+         const uint8_t *pEnd;
+         size_t batchLen = 0u;
+         size_t batchPos = 0u;
+         sprintf(msg, "features=%x, mode=%u", (unsigned) m_simdFeatureSets[f], (unsigned) mode);
+         if (mode == 0u)
+         {
+            bstr_split_iter_create(&iter, buf, buf + sizeof(buf), (uint8_t) ',', 0u);
+            bstr_split_iter_create(&batchIter, buf, buf + sizeof(buf), (uint8_t) ',', 0u);
+         }
+         else if (mode == 1u)
+         {
+            bstr_split_iter_create_set(&iter, buf, buf + sizeof(buf), &set, 0u);
+            bstr_split_iter_create_set(&batchIter, buf, buf + sizeof(buf), &set, 0u);
+         }
+         else
+         {
+            (void) bstr_split_iter_create_bstr(&iter, buf, buf + sizeof(buf), sep, sep + 2, 0u);
+            (void) bstr_split_iter_create_bstr(&batchIter, buf, buf + sizeof(buf), sep, sep + 2, 0u);
+         }
+         while (bstr_split_next(&iter, &pBegin, &pEnd))
+         {
+            const uint8_t *p;
+            CuAssertConstPtrEquals_Msg(tc, msg, pExpected, pBegin);
+            for (p = pBegin; p < pEnd; p++)
+            {
+               if (mode == 0u)
+               {
+                  CuAssertTrue(tc, *p != (uint8_t) ',');
+               }
+               else if (mode == 1u)
+               {
+                  CuAssertTrue(tc, !bstr_byteset_contains(&set, *p));
+               }
+               else
+               {
+                  CuAssertTrue(tc, !( (p + 1 < buf + sizeof(buf)) && (p[0] == sep[0]) && (p[1] == sep[1]) ));
+               }
+            }
+            if (batchPos == batchLen)
+            {
+               batchLen = bstr_split_next_batch(&batchIter, fields, 7u);
+               batchPos = 0u;
+               numBatched += batchLen;
+            }
+            CuAssertTrue(tc, batchPos < batchLen);
+            CuAssertConstPtrEquals_Msg(tc, msg, pBegin, fields[batchPos].pBegin);
+            CuAssertConstPtrEquals_Msg(tc, msg, pEnd, fields[batchPos].pEnd);
+            batchPos++;
+            pExpected = pEnd + sepLen;
+            numFields++;
+         }
+         CuAssertConstPtrEquals_Msg(tc, msg, buf + sizeof(buf) + sepLen, pExpected);
+         CuAssertIntEquals(tc, 0, (int) bstr_split_next_batch(&batchIter, fields, 7u));
+         CuAssertIntEquals(tc, (int) numFields, (int) numBatched);
+         CuAssertTrue(tc, numFields > 3u * BSTR_SPLIT_BATCH_SIZE);
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+/**
+ * Straightforward reference decoder for the UTF-8 tests
+ */
+static bool is_valid_utf8(const uint8_t *p, size_t len)
+{
+   size_t i = 0u;
+   while (i < len)
+   {
+      uint32_t codePoint;
+      size_t n;
+      size_t k;
+      if (p[i] < 0x80u) { i++; continue; }
+      else if ( (p[i] & 0xE0u) == 0xC0u ) { n = 2u; codePoint = p[i] & 0x1Fu; }
+      else if ( (p[i] & 0xF0u) == 0xE0u ) { n = 3u; codePoint = p[i] & 0x0Fu; }
+      else if ( (p[i] & 0xF8u) == 0xF0u ) { n = 4u; codePoint = p[i] & 0x07u; }
+      else return false;
+      if (i + n > len) return false;
+      for (k = 1u; k < n; k++)
+      {
+         if ( (p[i + k] & 0xC0u) != 0x80u ) return false;
+         codePoint = (codePoint << 6) | (p[i + k] & 0x3Fu);
+      }
+      if ( (n == 2u && codePoint < 0x80u) || (n == 3u && codePoint < 0x800u) || (n == 4u && codePoint < 0x10000u) ) return false;
+      if ( (codePoint > 0x10FFFFu) || ((codePoint >= 0xD800u) && (codePoint <= 0xDFFFu)) ) return false;
+      i += n;
+   }
+   return true;
+}
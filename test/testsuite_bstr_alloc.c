@@ -0,0 +1,353 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "bstr_alloc.h"
+#include "bstr_matcher.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Backing allocator which checks that every block is resized and freed with the size it was allocated with
+ */
+typedef struct counting_allocator_tag
+{
+   bstr_allocator_t allocator;
+   size_t numAllocs;
+   size_t bytesInUse;
+   bool isSizeMismatch;
+} counting_allocator_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_bstr_arena_alloc(CuTest* tc);
+static void test_bstr_arena_fixed(CuTest* tc);
+static void test_bstr_arena_realloc(CuTest* tc);
+static void test_bstr_pool_alloc(CuTest* tc);
+static void test_bstr_allocator_a_functions(CuTest* tc);
+static void test_bstr_allocator_matcher(CuTest* tc);
+static void counting_allocator_create(counting_allocator_t *self);
+static void *counting_alloc(void *arg, size_t size);
+static void *counting_realloc(void *arg, void *ptr, size_t oldSize, size_t newSize);
+static void counting_free(void *arg, void *ptr, size_t size);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testsuite_bstr_alloc(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_bstr_arena_alloc);
+   SUITE_ADD_TEST(suite, test_bstr_arena_fixed);
+   SUITE_ADD_TEST(suite, test_bstr_arena_realloc);
+   SUITE_ADD_TEST(suite, test_bstr_pool_alloc);
+   SUITE_ADD_TEST(suite, test_bstr_allocator_a_functions);
+   SUITE_ADD_TEST(suite, test_bstr_allocator_matcher);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_bstr_arena_alloc(CuTest* tc)
+{
+   counting_allocator_t backing;
+   bstr_arena_t arena;
+   uint8_t *first;
+   uint8_t *p;
+   int i;
+
+   counting_allocator_create(&backing);
+   bstr_arena_create(&arena, 1024u, &backing.allocator);
+   first = (uint8_t*) bstr_arena_alloc(&arena, 3u);
+   CuAssertPtrNotNull(tc, first);
+   CuAssertIntEquals(tc, 0, (int) ((uintptr_t) first % BSTR_ARENA_ALIGNMENT));
+   p = (uint8_t*) bstr_arena_alloc(&arena, 5u);
+   CuAssertPtrEquals(tc, first + BSTR_ARENA_ALIGNMENT, p);
+   CuAssertIntEquals(tc, 1, (int) backing.numAllocs);
+   for (i = 0; i < 100; i++)
+   {
+      p = (uint8_t*) bstr_arena_alloc(&arena, 100u);
+      CuAssertPtrNotNull(tc, p);
+      CuAssertIntEquals(tc, 0, (int) ((uintptr_t) p % BSTR_ARENA_ALIGNMENT));
+      memset(p, i, 100u);
+   }
+   CuAssertTrue(tc, backing.numAllocs > 1u);
+   p = (uint8_t*) bstr_arena_alloc(&arena, 5000u); //larger than a chunk
+   CuAssertPtrNotNull(tc, p);
+   memset(p, 0, 5000u);
+
+   //reset keeps only the current chunk
+   bstr_arena_reset(&arena);
+   CuAssertTrue(tc, backing.bytesInUse > 5000u);
+   CuAssertTrue(tc, backing.bytesInUse < 6000u);
+   first = (uint8_t*) bstr_arena_alloc(&arena, 1u);
+   CuAssertPtrEquals(tc, p, first);
+   bstr_arena_destroy(&arena);
+   CuAssertIntEquals(tc, 0, (int) backing.bytesInUse);
+   CuAssertTrue(tc, !backing.isSizeMismatch);
+}
+
+static void test_bstr_arena_fixed(CuTest* tc)
+{
+   uint8_t buffer[256];
+   bstr_arena_t arena;
+   uint8_t *p;
+   int count = 0;
+
+   bstr_arena_create_fixed(&arena, buffer, sizeof(buffer));
+   while ( (p = (uint8_t*) bstr_arena_alloc(&arena, 32u)) != 0 )
+   {
+      CuAssertTrue(tc, (p >= buffer) && (p + 32 <= buffer + sizeof(buffer)));
+      count++;
+   }
+   CuAssertTrue(tc, count >= 7);
+   CuAssertPtrEquals(tc, NULL, bstr_arena_alloc(&arena, 1u));
+   bstr_arena_reset(&arena);
+   CuAssertPtrNotNull(tc, bstr_arena_alloc(&arena, 32u));
+   bstr_arena_destroy(&arena);
+}
+
+static void test_bstr_arena_realloc(CuTest* tc)
+{
+   bstr_arena_t arena;
+   const bstr_allocator_t *allocator;
+   uint8_t *p;
+   uint8_t *q;
+   uint8_t *r;
+
+   bstr_arena_create(&arena, 4096u, 0);
+   allocator = bstr_arena_allocator(&arena);
+   p = (uint8_t*) bstr_allocator_alloc(allocator, 10u);
+   memcpy(p, "0123456789", 10u);
+   //the most recent allocation grows in place
+   q = (uint8_t*) bstr_allocator_realloc(allocator, p, 10u, 100u);
+   CuAssertPtrEquals(tc, p, q);
+   r = (uint8_t*) bstr_allocator_alloc(allocator, 10u);
+   CuAssertPtrEquals(tc, p + 112, r);
+   //older allocations are copied
+   q = (uint8_t*) bstr_allocator_realloc(allocator, p, 100u, 200u);
+   CuAssertTrue(tc, q != p);
+   CuAssertTrue(tc, memcmp(q, "0123456789", 10u) == 0);
+   //freeing the most recent allocation gives the memory back
+   bstr_allocator_free(allocator, q, 200u);
+   CuAssertPtrEquals(tc, q, bstr_allocator_alloc(allocator, 50u));
+   bstr_arena_destroy(&arena);
+}
+
+static void test_bstr_pool_alloc(CuTest* tc)
+{
+   counting_allocator_t backing;
+   bstr_pool_t pool;
+   const bstr_allocator_t *allocator;
+   void *blocks[100];
+   uint8_t *p;
+   uint8_t *q;
+   int i;
+
+   counting_allocator_create(&backing);
+   bstr_pool_create(&pool, 4096u, &backing.allocator);
+   allocator = bstr_pool_allocator(&pool);
+   for (i = 0; i < 100; i++)
+   {
+      blocks[i] = bstr_allocator_alloc(allocator, (size_t) (i * 20 + 1));
+      CuAssertPtrNotNull(tc, blocks[i]);
+      memset(blocks[i], i, (size_t) (i * 20 + 1));
+   }
+   for (i = 0; i < 100; i++)
+   {
+      CuAssertIntEquals(tc, i, ((uint8_t*) blocks[i])[i * 20]);
+   }
+   //freed blocks are reused by the same size class
+   bstr_allocator_free(allocator, blocks[10], 201u);
+   CuAssertPtrEquals(tc, blocks[10], bstr_allocator_alloc(allocator, 250u));
+   //resizing within the size class keeps the block
+   CuAssertPtrEquals(tc, blocks[10], bstr_allocator_realloc(allocator, blocks[10], 250u, 256u));
+   p = (uint8_t*) bstr_allocator_realloc(allocator, blocks[10], 256u, 257u);
+   CuAssertTrue(tc, p != blocks[10]);
+   CuAssertIntEquals(tc, 10, p[200]);
+   //blocks above the largest class go to the backing allocator
+   q = (uint8_t*) bstr_allocator_alloc(allocator, BSTR_POOL_MAX_CLASS + 1u);
+   CuAssertPtrNotNull(tc, q);
+   bstr_allocator_free(allocator, q, BSTR_POOL_MAX_CLASS + 1u);
+   bstr_pool_reset(&pool);
+   CuAssertIntEquals(tc, 4096 + 16, (int) backing.bytesInUse);
+   bstr_pool_destroy(&pool);
+   CuAssertIntEquals(tc, 0, (int) backing.bytesInUse);
+   CuAssertTrue(tc, !backing.isSizeMismatch);
+}
+
+static void test_bstr_allocator_a_functions(CuTest* tc)
+{
+   const char *json = "{\"a\": [1, 2, {\"b\": \"c\"}], \"d\": \"0123456789012345678901234567890123456789012345678901234567890123456789\"}";
+   const uint8_t *pJson = (const uint8_t*) json;
+   counting_allocator_t backing;
+   bstr_context_t *ctx;
+   bstr_needle_t *needle;
+   bstr_json_index_t *index;
+   bstr_line_index_t lines;
+   char *cstr;
+   uint8_t text[1000];
+   int i;
+
+   counting_allocator_create(&backing);
+   ctx = bstr_context_new_a(&backing.allocator);
+   CuAssertPtrNotNull(tc, ctx);
+   CuAssertPtrEquals(tc, &backing.allocator, (void*) ctx->allocator);
+   cstr = bstr_make_cstr_a(pJson, pJson + 4, &backing.allocator);
+   CuAssertStrEquals(tc, "{\"a\"", cstr);
+   bstr_allocator_free(&backing.allocator, cstr, 5u);
+   cstr = bstr_make_cstr_x_a(pJson, pJson + 4, 2u, 3u, &backing.allocator);
+   CuAssertTrue(tc, memcmp(cstr + 2, "{\"a\"", 4u) == 0);
+   bstr_allocator_free(&backing.allocator, cstr, 10u);
+   needle = bstr_needle_new_a((const uint8_t*) "\"b\"", (const uint8_t*) "\"b\"" + 3, &backing.allocator);
+   CuAssertPtrEquals(tc, (void*) (pJson + 14), (void*) bstr_find_needle(pJson, pJson + strlen(json), needle));
+   bstr_needle_delete(needle);
+   index = bstr_json_index_new_a(pJson, pJson + strlen(json), &backing.allocator);
+   CuAssertPtrNotNull(tc, index);
+   CuAssertPtrEquals(tc, (void*) (pJson + strlen(json) - 1), (void*) bstr_match_pair_indexed(index, pJson, pJson + strlen(json)));
+   bstr_json_index_delete(index);
+   for (i = 0; i < 1000; i++)
+   {
+      text[i] = (i % 3 == 0)? '\n' : 'x';
+   }
+   bstr_line_index_create_a(&lines, 0u, &backing.allocator);
+   CuAssertPtrEquals(tc, text + sizeof(text), (void*) bstr_index_lines(&lines, text, text + sizeof(text)));
+   CuAssertIntEquals(tc, 334, (int) lines.numLines);
+   bstr_line_index_destroy(&lines);
+   CuAssertTrue(tc, backing.numAllocs >= 7u);
+   //a buffer without an allocator takes the context allocator, one with its own allocator keeps it
+   {
+      const uint8_t *pValue = pJson + 31;
+      const uint8_t *pValueEnd = pJson + strlen(json) - 1;
+      size_t numAllocs = backing.numAllocs;
+      bstr_buf_t buf;
+      bstr_buf_create(&buf, 0);
+      CuAssertPtrEquals(tc, (void*) pValueEnd, (void*) bstr_parse_json_string_literal_buf(ctx, pValue, pValueEnd, &buf));
+      CuAssertIntEquals(tc, 70, (int) bstr_buf_length(&buf));
+      CuAssertPtrEquals(tc, &backing.allocator, (void*) buf.allocator);
+      CuAssertIntEquals(tc, (int) numAllocs + 1, (int) backing.numAllocs);
+      bstr_buf_destroy(&buf);
+      bstr_buf_create(&buf, bstr_allocator_default());
+      CuAssertPtrEquals(tc, (void*) pValueEnd, (void*) bstr_parse_json_string_literal_buf(ctx, pValue, pValueEnd, &buf));
+      CuAssertIntEquals(tc, (int) numAllocs + 1, (int) backing.numAllocs);
+      bstr_buf_destroy(&buf);
+   }
+   bstr_context_delete(ctx);
+   CuAssertIntEquals(tc, 0, (int) backing.bytesInUse);
+   CuAssertTrue(tc, !backing.isSizeMismatch);
+}
+
+static void test_bstr_allocator_matcher(CuTest* tc)
+{
+   const char *patterns[] = {"he", "she", "his", "hers", "usher", "the", "there"};
+   const char *text = "ushers say that there is his hershey";
+   counting_allocator_t backing;
+   bstr_pool_t pool;
+   bstr_matcher_t *matcher;
+   bstr_matcher_t reference;
+   uint32_t i;
+
+   counting_allocator_create(&backing);
+   bstr_pool_create(&pool, 0u, &backing.allocator);
+   matcher = bstr_matcher_new_a(bstr_pool_allocator(&pool));
+   bstr_matcher_create(&reference);
+   for (i = 0u; i < sizeof(patterns) / sizeof(patterns[0]); i++)
+   {
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_add_cstr(matcher, patterns[i], i));
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_add_cstr(&reference, patterns[i], i));
+   }
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_compile(matcher));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_compile(&reference));
+   CuAssertIntEquals(tc, (int) bstr_matcher_scan(&reference, (const uint8_t*) text, (const uint8_t*) text + strlen(text), NULL, NULL),
+                         (int) bstr_matcher_scan(matcher, (const uint8_t*) text, (const uint8_t*) text + strlen(text), NULL, NULL));
+   //compiling twice frees the old tables through the pool
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_compile(matcher));
+   bstr_matcher_delete(matcher);
+   bstr_matcher_destroy(&reference);
+   bstr_pool_destroy(&pool);
+   CuAssertIntEquals(tc, 0, (int) backing.bytesInUse);
+   CuAssertTrue(tc, !backing.isSizeMismatch);
+}
+
+static void counting_allocator_create(counting_allocator_t *self)
+{
+   self->allocator.allocFunc = counting_alloc;
+   self->allocator.reallocFunc = counting_realloc;
+   self->allocator.freeFunc = counting_free;
+   self->allocator.arg = (void*) self;
+   self->numAllocs = 0u;
+   self->bytesInUse = 0u;
+   self->isSizeMismatch = false;
+}
+
+/**
+ * Each block is prefixed with its size so that the size given back by the caller can be verified
+ */
+static void *counting_alloc(void *arg, size_t size)
+{
+   counting_allocator_t *self = (counting_allocator_t*) arg;
+   size_t *p = (size_t*) malloc(size + 2u * sizeof(size_t));
+   if (p == 0)
+   {
+      return 0;
+   }
+   p[0] = size;
+   self->numAllocs++;
+   self->bytesInUse += size;
+   return (void*) (p + 2);
+}
+
+static void *counting_realloc(void *arg, void *ptr, size_t oldSize, size_t newSize)
+{
+   counting_allocator_t *self = (counting_allocator_t*) arg;
+   size_t *p = ((size_t*) ptr) - 2;
+   if (p[0] != oldSize)
+   {
+      self->isSizeMismatch = true;
+   }
+   p = (size_t*) realloc(p, newSize + 2u * sizeof(size_t));
+   if (p == 0)
+   {
+      return 0;
+   }
+   p[0] = newSize;
+   self->bytesInUse = self->bytesInUse - oldSize + newSize;
+   return (void*) (p + 2);
+}
+
+static void counting_free(void *arg, void *ptr, size_t size)
+{
+   counting_allocator_t *self = (counting_allocator_t*) arg;
+   size_t *p = ((size_t*) ptr) - 2;
+   if (p[0] != size)
+   {
+      self->isSizeMismatch = true;
+   }
+   self->bytesInUse -= size;
+   free(p);
+}
@@ -0,0 +1,389 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "bstr_csv.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MAX_FIELDS 16
+#define NUM_RECORDS 400
+#define FIELD_SEPARATOR '\x1f'
+#define RECORD_SEPARATOR '\x1e'
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_bstr_csv_reader(CuTest* tc);
+static void test_bstr_csv_reader_tsv(CuTest* tc);
+static void test_bstr_csv_reader_simd(CuTest* tc);
+static void test_bstr_csv_reader_chunked(CuTest* tc);
+static void test_bstr_csv_reader_errors(CuTest* tc);
+static uint32_t rand_u32(uint32_t *seed);
+static char *generate_csv(uint32_t seed, size_t *length, char **expected);
+static bstr_error_t read_csv(const uint8_t *pBegin, const uint8_t *pEnd, uint32_t flags, char *text, size_t *textLen, const uint8_t **ppRest);
+static bstr_error_t read_csv_chunks(const char *data, size_t length, size_t chunkLen, char *text);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint32_t m_simdFeatureSets[] = {
+   0u,
+   BSTR_SIMD_SSE2,
+   BSTR_SIMD_SSE2 | BSTR_SIMD_SSSE3 | BSTR_SIMD_SSE42 | BSTR_SIMD_PCLMUL | BSTR_SIMD_AVX2 | BSTR_SIMD_BMI2,
+   0xFFFFFFFFu
+};
+#define NUM_SIMD_FEATURE_SETS (sizeof(m_simdFeatureSets) / sizeof(m_simdFeatureSets[0]))
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testsuite_bstr_csv(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_bstr_csv_reader);
+   SUITE_ADD_TEST(suite, test_bstr_csv_reader_tsv);
+   SUITE_ADD_TEST(suite, test_bstr_csv_reader_simd);
+   SUITE_ADD_TEST(suite, test_bstr_csv_reader_chunked);
+   SUITE_ADD_TEST(suite, test_bstr_csv_reader_errors);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_bstr_csv_reader(CuTest* tc)
+{
+   const char *csv = "a,b,c\r\n\"x, y\",\"say \"\"hi\"\"\",\"line1\nline2\"\n,,\n\"\",last";
+   const uint8_t *pBegin = (const uint8_t*) csv;
+   const uint8_t *pEnd = pBegin + strlen(csv);
+   bstr_csv_reader_t reader;
+   bstr_csv_field_t fields[MAX_FIELDS];
+   size_t numFields;
+   bstr_buf_t buf;
+
+   bstr_buf_create(&buf, 0);
+   bstr_csv_reader_create(&reader, pBegin, pEnd, (uint8_t) ',', 0u);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, 3, (int) numFields);
+   CuAssertConstPtrEquals(tc, pBegin, fields[0].pBegin);
+   CuAssertConstPtrEquals(tc, pBegin + 1, fields[0].pEnd);
+   CuAssertConstPtrEquals(tc, pBegin + 4, fields[2].pBegin);
+   CuAssertConstPtrEquals(tc, pBegin + 5, fields[2].pEnd);
+   CuAssertTrue(tc, !fields[2].isQuoted);
+
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, 3, (int) numFields);
+   CuAssertTrue(tc, fields[0].isQuoted);
+   CuAssertTrue(tc, !fields[0].hasEscapes);
+   CuAssertConstPtrEquals(tc, pBegin + 8, fields[0].pBegin);
+   CuAssertConstPtrEquals(tc, pBegin + 12, fields[0].pEnd);
+   CuAssertTrue(tc, fields[1].hasEscapes);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_field_unescape(&fields[1], &buf));
+   CuAssertStrEquals(tc, "say \"hi\"", bstr_buf_cstr(&buf));
+   bstr_buf_clear(&buf);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_field_unescape(&fields[2], &buf));
+   CuAssertStrEquals(tc, "line1\nline2", bstr_buf_cstr(&buf));
+
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, 3, (int) numFields);
+   CuAssertTrue(tc, fields[0].pBegin == fields[0].pEnd);
+   CuAssertTrue(tc, fields[2].pBegin == fields[2].pEnd);
+
+   //last record has no terminating newline, only the first field is stored
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], 1u, &numFields));
+   CuAssertIntEquals(tc, 2, (int) numFields);
+   CuAssertTrue(tc, fields[0].isQuoted);
+   CuAssertTrue(tc, fields[0].pBegin == fields[0].pEnd);
+   CuAssertConstPtrEquals(tc, pEnd, bstr_csv_reader_rest(&reader));
+
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, 0, (int) numFields);
+   bstr_buf_destroy(&buf);
+}
+
+static void test_bstr_csv_reader_tsv(CuTest* tc)
+{
+   const char *tsv = "name\tvalue\n\"a,b\"\t\"1\t2\"\n";
+   const uint8_t *pBegin = (const uint8_t*) tsv;
+   bstr_csv_reader_t reader;
+   bstr_csv_field_t fields[MAX_FIELDS];
+   size_t numFields;
+
+   bstr_csv_reader_create(&reader, pBegin, pBegin + strlen(tsv), (uint8_t) '\t', 0u);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, 2, (int) numFields);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, 2, (int) numFields);
+   CuAssertConstPtrEquals(tc, pBegin + 12, fields[0].pBegin);
+   CuAssertConstPtrEquals(tc, pBegin + 15, fields[0].pEnd);
+   CuAssertConstPtrEquals(tc, pBegin + 18, fields[1].pBegin);
+   CuAssertConstPtrEquals(tc, pBegin + 21, fields[1].pEnd);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, 0, (int) numFields);
+}
+
+static void test_bstr_csv_reader_simd(CuTest* tc)
+{
+   size_t length;
+   char *expected;
+   char *csv = generate_csv(1u, &length, &expected);
+   char *text = (char*) malloc(length + 2u);
+   size_t i;
+   CuAssertPtrNotNull(tc, csv);
+   CuAssertPtrNotNull(tc, text);
+   for (i = 0u; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      const uint8_t *pBegin = (const uint8_t*) csv;
+      size_t textLen = 0u;
+      const uint8_t *pRest;
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, read_csv(pBegin, pBegin + length, 0u, text, &textLen, &pRest));
+      text[textLen] = '\0';
+      CuAssertStrEquals(tc, expected, text);
+      CuAssertConstPtrEquals(tc, pBegin + length, pRest);
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+   free(csv);
+   free(expected);
+   free(text);
+}
+
+static void test_bstr_csv_reader_chunked(CuTest* tc)
+{
+   static const size_t chunkLens[] = {1u, 2u, 3u, 7u, 63u, 64u, 65u, 500u, 4096u};
+   size_t length;
+   char *expected;
+   char *csv = generate_csv(2u, &length, &expected);
+   char *text = (char*) malloc(length + 2u);
+   size_t i;
+   CuAssertPtrNotNull(tc, csv);
+   CuAssertPtrNotNull(tc, text);
+   for (i = 0u; i < sizeof(chunkLens) / sizeof(chunkLens[0]); i++)
+   {
+      char msg[64];
+      sprintf(msg, "chunkLen=%u", (unsigned) chunkLens[i]);
+      CuAssertIntEquals_Msg(tc, msg, BSTR_NO_ERROR, read_csv_chunks(csv, length, chunkLens[i], text));
+      CuAssertStrEquals_Msg(tc, msg, expected, text);
+   }
+   free(csv);
+   free(expected);
+   free(text);
+}
+
+static void test_bstr_csv_reader_errors(CuTest* tc)
+{
+   static const char *invalid[] = {"a,b\"c\n", "\"ab\"c,d\n", "\"a\"b\"c\"\n", "x\"\"\n"};
+   bstr_csv_reader_t reader;
+   bstr_csv_field_t fields[MAX_FIELDS];
+   size_t numFields;
+   const uint8_t *pBegin;
+   size_t i;
+
+   for (i = 0u; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+   {
+      pBegin = (const uint8_t*) invalid[i];
+      bstr_csv_reader_create(&reader, pBegin, pBegin + strlen(invalid[i]), (uint8_t) ',', 0u);
+      CuAssertIntEquals(tc, BSTR_PARSE_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+      CuAssertIntEquals(tc, 0, (int) numFields);
+      //errors are sticky
+      CuAssertIntEquals(tc, BSTR_PARSE_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   }
+
+   //unterminated quote is only an error at the end of the stream
+   pBegin = (const uint8_t*) "a,b\n\"open,";
+   bstr_csv_reader_create(&reader, pBegin, pBegin + 10, (uint8_t) ',', BSTR_CSV_PARTIAL);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, 2, (int) numFields);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, 0, (int) numFields);
+   CuAssertConstPtrEquals(tc, pBegin + 4, bstr_csv_reader_rest(&reader));
+   bstr_csv_reader_create(&reader, pBegin + 4, pBegin + 10, (uint8_t) ',', 0u);
+   CuAssertIntEquals(tc, BSTR_PREMATURE_END_OF_BUFFER_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+
+   bstr_csv_reader_create(&reader, pBegin, pBegin + 10, (uint8_t) '"', 0u);
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields));
+   bstr_csv_reader_create(&reader, pBegin, pBegin + 10, (uint8_t) ',', 0u);
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_csv_next_record(&reader, 0, MAX_FIELDS, &numFields));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, 0));
+}
+
+static uint32_t rand_u32(uint32_t *seed)
+{
+   *seed = *seed * 1103515245u + 12345u;
+   return *seed >> 8;
+}
+
+/**
+ * Generates NUM_RECORDS records of random fields, quoting fields when needed or at random. *expected receives the
+ * field values separated by FIELD_SEPARATOR with each record followed by RECORD_SEPARATOR.
+ */
+static char *generate_csv(uint32_t seed, size_t *length, char **expected)
+{
+   static const char alphabet[] = "abcdefgh ,\"\n\r";
+   size_t capacity = NUM_RECORDS * 8u * 64u;
+   char *csv = (char*) malloc(capacity);
+   char *text = (char*) malloc(capacity);
+   size_t csvLen = 0u;
+   size_t textLen = 0u;
+   uint32_t i;
+   if ( (csv == 0) || (text == 0) )
+   {
+      free(csv);
+      free(text);
+      return 0;
+   }
+   for (i = 0u; i < NUM_RECORDS; i++)
+   {
+      uint32_t numFields = 1u + rand_u32(&seed) % 8u;
+      size_t recordStart = csvLen;
+      uint32_t j;
+      for (j = 0u; j < numFields; j++)
+      {
+         char value[32];
+         uint32_t valueLen = rand_u32(&seed) % 24u;
+         bool isQuoted = (rand_u32(&seed) % 8u) == 0u;
+         uint32_t k;
+         for (k = 0u; k < valueLen; k++)
+         {
+            //special characters are rare so that most fields are plain
+            uint32_t r = rand_u32(&seed) % 64u;
+            value[k] = (r < 59u) ? alphabet[r % 9u] : alphabet[9u + (r - 59u) % 4u];
+            if ( (value[k] == ',') || (value[k] == '"') || (value[k] == '\n') || (value[k] == '\r') )
+            {
+               isQuoted = true;
+            }
+         }
+         if (j > 0u)
+         {
+            csv[csvLen++] = ',';
+            text[textLen++] = FIELD_SEPARATOR;
+         }
+         if (isQuoted)
+         {
+            csv[csvLen++] = '"';
+         }
+         for (k = 0u; k < valueLen; k++)
+         {
+            csv[csvLen++] = value[k];
+            if (value[k] == '"')
+            {
+               csv[csvLen++] = '"';
+            }
+            text[textLen++] = value[k];
+         }
+         if (isQuoted)
+         {
+            csv[csvLen++] = '"';
+         }
+      }
+      //the last record is not always terminated, unless it is an empty line
+      if ( (i + 1u < NUM_RECORDS) || (csvLen == recordStart) || (seed & 1u) )
+      {
+         if (rand_u32(&seed) % 2u)
+         {
+            csv[csvLen++] = '\r';
+         }
+         csv[csvLen++] = '\n';
+      }
+      text[textLen++] = RECORD_SEPARATOR;
+   }
+   text[textLen] = '\0';
+   *length = csvLen;
+   *expected = text;
+   return csv;
+}
+
+/**
+ * Reads all records in pBegin..pEnd into text using the same format as generate_csv.
+ */
+static bstr_error_t read_csv(const uint8_t *pBegin, const uint8_t *pEnd, uint32_t flags, char *text, size_t *textLen, const uint8_t **ppRest)
+{
+   bstr_csv_reader_t reader;
+   bstr_csv_field_t fields[MAX_FIELDS];
+   bstr_buf_t buf;
+   bstr_error_t result = BSTR_NO_ERROR;
+   bstr_buf_create(&buf, 0);
+   bstr_csv_reader_create(&reader, pBegin, pEnd, (uint8_t) ',', flags);
+   for (;;)
+   {
+      size_t numFields;
+      size_t i;
+      result = bstr_csv_next_record(&reader, &fields[0], MAX_FIELDS, &numFields);
+      if ( (result != BSTR_NO_ERROR) || (numFields == 0u) )
+      {
+         break;
+      }
+      for (i = 0u; i < numFields; i++)
+      {
+         if (i > 0u)
+         {
+            text[(*textLen)++] = FIELD_SEPARATOR;
+         }
+         bstr_buf_clear(&buf);
+         result = bstr_csv_field_unescape(&fields[i], &buf);
+         if (result != BSTR_NO_ERROR)
+         {
+            break;
+         }
+         memcpy(&text[*textLen], bstr_buf_data(&buf), bstr_buf_length(&buf));
+         *textLen += bstr_buf_length(&buf);
+      }
+      text[(*textLen)++] = RECORD_SEPARATOR;
+   }
+   *ppRest = bstr_csv_reader_rest(&reader);
+   bstr_buf_destroy(&buf);
+   return result;
+}
+
+/**
+ * Feeds data to the reader chunkLen bytes at a time, carrying each incomplete record over to the next chunk.
+ */
+static bstr_error_t read_csv_chunks(const char *data, size_t length, size_t chunkLen, char *text)
+{
+   uint8_t *chunk = (uint8_t*) malloc(length + 1u);
+   size_t offset = 0u;
+   size_t carry = 0u;
+   size_t textLen = 0u;
+   bstr_error_t result = BSTR_NO_ERROR;
+   if (chunk == 0)
+   {
+      return BSTR_MEM_ERROR;
+   }
+   for (;;)
+   {
+      size_t chunkSize = (length - offset < chunkLen) ? length - offset : chunkLen;
+      bool isLast = (offset + chunkSize == length);
+      const uint8_t *pRest;
+      memcpy(&chunk[carry], &data[offset], chunkSize);
+      offset += chunkSize;
+      result = read_csv(chunk, chunk + carry + chunkSize, isLast ? 0u : BSTR_CSV_PARTIAL, text, &textLen, &pRest);
+      if ( (result != BSTR_NO_ERROR) || isLast )
+      {
+         break;
+      }
+      carry = (size_t) ((chunk + carry + chunkSize) - pRest);
+      memmove(chunk, pRest, carry);
+   }
+   text[textLen] = '\0';
+   free(chunk);
+   return result;
+}
@@ -0,0 +1,213 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "bstr_file.h"
+#include "test_util.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define TEST_FILE_NAME "bstr_file_test.tmp"
+#define NUM_GENERATED_LINES 20000
+#define LINE_FORMAT "{\"id\":%d,\"text\":\"%.*s\"}\n"
+#define LINE_PADDING "abcdefghijklmnopqrstuvwxyz01234"
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_bstr_file_open(CuTest* tc);
+static void test_bstr_file_seek(CuTest* tc);
+static void test_bstr_file_window(CuTest* tc);
+static void test_bstr_file_errors(CuTest* tc);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint32_t m_flags[5] = {
+   0u,
+   BSTR_FILE_SEQUENTIAL,
+   BSTR_FILE_RANDOM,
+   BSTR_FILE_SEQUENTIAL | BSTR_FILE_POPULATE,
+   BSTR_FILE_SEQUENTIAL | BSTR_FILE_POPULATE | BSTR_FILE_HUGE_PAGES
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_bstr_file(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_bstr_file_open);
+   SUITE_ADD_TEST(suite, test_bstr_file_seek);
+   SUITE_ADD_TEST(suite, test_bstr_file_window);
+   SUITE_ADD_TEST(suite, test_bstr_file_errors);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_bstr_file_open(CuTest* tc)
+{
+   size_t length;
+   char *data = test_generate_lines(NUM_GENERATED_LINES, LINE_FORMAT, LINE_PADDING, &length);
+   bstr_file_t file;
+   size_t i;
+   CuAssertPtrNotNull(tc, data);
+   CuAssertTrue(tc, test_write_file(TEST_FILE_NAME, data, length));
+   for (i = 0u; i < sizeof(m_flags) / sizeof(m_flags[0]); i++)
+   {
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_open(&file, TEST_FILE_NAME, m_flags[i]));
+      CuAssertIntEquals(tc, (int) length, (int) file.size);
+      CuAssertIntEquals(tc, (int) length, (int) (file.pEnd - file.pBegin));
+      CuAssertTrue(tc, memcmp(file.pBegin, data, length) == 0);
+      CuAssertTrue(tc, bstr_file_at_end(&file));
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_advise(&file, BSTR_FILE_RANDOM));
+      CuAssertTrue(tc, memcmp(file.pBegin + length / 2u, data + length / 2u, length - length / 2u) == 0);
+      bstr_file_close(&file);
+      CuAssertPtrEquals(tc, 0, (void*) file.pBegin);
+      bstr_file_close(&file);
+   }
+   //empty file
+   CuAssertTrue(tc, test_write_file(TEST_FILE_NAME, data, 0u));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_open(&file, TEST_FILE_NAME, BSTR_FILE_POPULATE));
+   CuAssertPtrNotNull(tc, (void*) file.pBegin);
+   CuAssertTrue(tc, file.pBegin == file.pEnd);
+   CuAssertTrue(tc, bstr_file_at_end(&file));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_seek(&file, 0u));
+   bstr_file_close(&file);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_open_window(&file, TEST_FILE_NAME, 4096u, 0u));
+   CuAssertTrue(tc, file.pBegin == file.pEnd);
+   CuAssertTrue(tc, bstr_file_at_end(&file));
+   bstr_file_close(&file);
+   (void) remove(TEST_FILE_NAME);
+   free(data);
+}
+
+static void test_bstr_file_seek(CuTest* tc)
+{
+   static const uint64_t offsets[6] = {0u, 1u, 4095u, 4096u, 70001u, 0u};
+   size_t length;
+   char *data = test_generate_lines(NUM_GENERATED_LINES, LINE_FORMAT, LINE_PADDING, &length);
+   size_t i;
+   size_t j;
+   CuAssertPtrNotNull(tc, data);
+   CuAssertTrue(tc, test_write_file(TEST_FILE_NAME, data, length));
+   for (i = 0u; i < 2u; i++)
+   {
+      bstr_file_t file;
+      if (i == 0u)
+      {
+         CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_open(&file, TEST_FILE_NAME, BSTR_FILE_RANDOM));
+      }
+      else
+      {
+         CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_open_window(&file, TEST_FILE_NAME, 10000u, BSTR_FILE_RANDOM));
+      }
+      //views start at any offset even though mappings start at page boundaries
+      for (j = 0u; j < sizeof(offsets) / sizeof(offsets[0]); j++)
+      {
+         size_t viewLength = length - (size_t) offsets[j];
+         if ( (i == 1u) && (viewLength > 10000u) )
+         {
+            viewLength = 10000u;
+         }
+         CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_seek(&file, offsets[j]));
+         CuAssertIntEquals(tc, (int) offsets[j], (int) file.offset);
+         CuAssertIntEquals(tc, (int) viewLength, (int) (file.pEnd - file.pBegin));
+         CuAssertTrue(tc, memcmp(file.pBegin, data + offsets[j], viewLength) == 0);
+         CuAssertTrue(tc, bstr_file_at_end(&file) == (i == 0u));
+      }
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_seek(&file, length));
+      CuAssertTrue(tc, file.pBegin == file.pEnd);
+      CuAssertTrue(tc, bstr_file_at_end(&file));
+      CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_file_seek(&file, length + 1u));
+      bstr_file_close(&file);
+   }
+   (void) remove(TEST_FILE_NAME);
+   free(data);
+}
+
+/**
+ * Reads a file through a window smaller than the file, sliding it past the complete lines of each view.
+ */
+static void test_bstr_file_window(CuTest* tc)
+{
+   static const size_t windowSizes[3] = {300u, 4096u, 65537u};
+   size_t length;
+   char *data = test_generate_lines(NUM_GENERATED_LINES, LINE_FORMAT, LINE_PADDING, &length);
+   size_t i;
+   CuAssertPtrNotNull(tc, data);
+   CuAssertTrue(tc, test_write_file(TEST_FILE_NAME, data, length));
+   for (i = 0u; i < 3u; i++)
+   {
+      bstr_file_t file;
+      size_t numLines = 0u;
+      size_t numBytes = 0u;
+      size_t numWindows = 0u;
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_open_window(&file, TEST_FILE_NAME, windowSizes[i], BSTR_FILE_SEQUENTIAL | BSTR_FILE_POPULATE));
+      while (file.pBegin < file.pEnd)
+      {
+         const uint8_t *pNext = file.pBegin;
+         CuAssertTrue(tc, (size_t) (file.pEnd - file.pBegin) <= windowSizes[i]);
+         CuAssertTrue(tc, memcmp(file.pBegin, data + file.offset, (size_t) (file.pEnd - file.pBegin)) == 0);
+         for (;;)
+         {
+            const uint8_t *pLineEnd = bstr_line(pNext, file.pEnd);
+            if ( (pLineEnd == file.pEnd) || (*pLineEnd != (uint8_t) '\n') )
+            {
+               break;
+            }
+            numLines++;
+            numBytes += (size_t) (pLineEnd - pNext) + 1u;
+            pNext = pLineEnd + 1;
+         }
+         numWindows++;
+         CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_advance(&file, pNext));
+      }
+      CuAssertIntEquals(tc, NUM_GENERATED_LINES, (int) numLines);
+      CuAssertIntEquals(tc, (int) length, (int) numBytes);
+      CuAssertTrue(tc, numWindows >= length / windowSizes[i]);
+      CuAssertTrue(tc, bstr_file_at_end(&file));
+      bstr_file_close(&file);
+   }
+   (void) remove(TEST_FILE_NAME);
+   free(data);
+}
+
+static void test_bstr_file_errors(CuTest* tc)
+{
+   bstr_file_t file;
+   CuAssertIntEquals(tc, BSTR_IO_ERROR, bstr_file_open(&file, "no/such/file.txt", 0u));
+   CuAssertPtrEquals(tc, 0, (void*) file.pBegin);
+   bstr_file_close(&file);
+   CuAssertIntEquals(tc, BSTR_IO_ERROR, bstr_file_open_window(&file, "no/such/file.txt", 4096u, 0u));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_file_open(&file, 0, 0u));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_file_open(0, TEST_FILE_NAME, 0u));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_file_open_window(&file, TEST_FILE_NAME, 0u, 0u));
+   CuAssertTrue(tc, test_write_file(TEST_FILE_NAME, "abc\n", 4u));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_open(&file, TEST_FILE_NAME, 0u));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_file_advise(&file, BSTR_FILE_SEQUENTIAL | BSTR_FILE_RANDOM));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_file_advance(&file, file.pEnd + 1));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_file_advance(&file, file.pEnd));
+   CuAssertTrue(tc, file.pBegin == file.pEnd);
+   bstr_file_close(&file);
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_file_seek(&file, 0u));
+   (void) remove(TEST_FILE_NAME);
+}
@@ -0,0 +1,338 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "bstr_http.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MAX_HEADERS 8
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_bstr_http_parse_request(CuTest* tc);
+static void test_bstr_http_parse_response(CuTest* tc);
+static void test_bstr_http_parse_incremental(CuTest* tc);
+static void test_bstr_http_parse_simd(CuTest* tc);
+static void test_bstr_http_parse_errors(CuTest* tc);
+static void test_bstr_http_parse_params(CuTest* tc);
+static bool view_equals(const uint8_t *pBegin, const uint8_t *pEnd, const char *cstr);
+static bstr_error_t parse_request_cstr(bstr_http_parser_t *parser, const char *request, const uint8_t **ppNext);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_request = "GET /index.html?q=1 HTTP/1.1\r\n"
+                               "Host: example.com\r\n"
+                               "User-Agent:\tbstr/1.0 \t\r\n"
+                               "Accept: */*\n"
+                               "Set-Cookie: a=1\r\n"
+                               "set-cookie: b=2\r\n"
+                               "Empty:\r\n"
+                               "\r\n"
+                               "body";
+
+static const uint32_t m_simdFeatureSets[] = {
+   0u,
+   BSTR_SIMD_SSE2 | BSTR_SIMD_SSSE3 | BSTR_SIMD_SSE42 | BSTR_SIMD_PCLMUL,
+   0xFFFFFFFFu
+};
+#define NUM_SIMD_FEATURE_SETS (sizeof(m_simdFeatureSets) / sizeof(m_simdFeatureSets[0]))
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testsuite_bstr_http(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_bstr_http_parse_request);
+   SUITE_ADD_TEST(suite, test_bstr_http_parse_response);
+   SUITE_ADD_TEST(suite, test_bstr_http_parse_incremental);
+   SUITE_ADD_TEST(suite, test_bstr_http_parse_simd);
+   SUITE_ADD_TEST(suite, test_bstr_http_parse_errors);
+   SUITE_ADD_TEST(suite, test_bstr_http_parse_params);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_bstr_http_parse_request(CuTest* tc)
+{
+   const uint8_t *pBegin = (const uint8_t*) m_request;
+   const uint8_t *pEnd = pBegin + strlen(m_request);
+   const uint8_t *pNext = 0;
+   bstr_http_header_t headers[MAX_HEADERS];
+   bstr_http_parser_t parser;
+   const bstr_http_header_t *header;
+   uint32_t cookieHash = bstr_http_name_hash_cstr("Set-Cookie");
+
+   bstr_http_parser_create(&parser, &headers[0], MAX_HEADERS);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_request(&parser, pBegin, pEnd, &pNext));
+   CuAssertConstPtrEquals(tc, pEnd - 4, pNext);
+   CuAssertTrue(tc, view_equals(parser.method.pBegin, parser.method.pEnd, "GET"));
+   CuAssertTrue(tc, view_equals(parser.target.pBegin, parser.target.pEnd, "/index.html?q=1"));
+   CuAssertIntEquals(tc, 1, parser.versionMinor);
+   CuAssertIntEquals(tc, 6, (int) parser.numHeaders);
+   CuAssertTrue(tc, view_equals(headers[0].pNameBegin, headers[0].pNameEnd, "Host"));
+   CuAssertTrue(tc, view_equals(headers[0].pValueBegin, headers[0].pValueEnd, "example.com"));
+   CuAssertTrue(tc, view_equals(headers[1].pValueBegin, headers[1].pValueEnd, "bstr/1.0"));
+   CuAssertTrue(tc, view_equals(headers[2].pValueBegin, headers[2].pValueEnd, "*/*"));
+   CuAssertTrue(tc, view_equals(headers[5].pNameBegin, headers[5].pNameEnd, "Empty"));
+   CuAssertTrue(tc, headers[5].pValueBegin == headers[5].pValueEnd);
+
+   CuAssertUIntEquals(tc, bstr_http_name_hash_cstr("HOST"), headers[0].nameHash);
+   header = bstr_http_find_header(&parser, 0, "user-agent", bstr_http_name_hash_cstr("user-agent"));
+   CuAssertPtrEquals(tc, &headers[1], header);
+   header = bstr_http_find_header(&parser, 0, "Set-Cookie", cookieHash);
+   CuAssertPtrEquals(tc, &headers[3], header);
+   header = bstr_http_find_header(&parser, header, "Set-Cookie", cookieHash);
+   CuAssertPtrEquals(tc, &headers[4], header);
+   CuAssertPtrEquals(tc, 0, bstr_http_find_header(&parser, header, "Set-Cookie", cookieHash));
+   CuAssertPtrEquals(tc, 0, bstr_http_find_header(&parser, 0, "Content-Length", bstr_http_name_hash_cstr("Content-Length")));
+
+   //headers beyond the array are counted but not stored
+   bstr_http_parser_create(&parser, &headers[0], 2u);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_request(&parser, pBegin, pEnd, &pNext));
+   CuAssertIntEquals(tc, 6, (int) parser.numHeaders);
+   CuAssertConstPtrEquals(tc, pEnd - 4, pNext);
+   CuAssertPtrEquals(tc, 0, bstr_http_find_header(&parser, 0, "Set-Cookie", cookieHash));
+
+   //leading empty lines are ignored
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_request_cstr(&parser, "\r\nPOST * HTTP/1.0\n\n", &pNext));
+   CuAssertTrue(tc, view_equals(parser.method.pBegin, parser.method.pEnd, "POST"));
+   CuAssertTrue(tc, view_equals(parser.target.pBegin, parser.target.pEnd, "*"));
+   CuAssertIntEquals(tc, 0, parser.versionMinor);
+   CuAssertIntEquals(tc, 0, (int) parser.numHeaders);
+}
+
+static void test_bstr_http_parse_response(CuTest* tc)
+{
+   const char *response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+   const uint8_t *pBegin = (const uint8_t*) response;
+   const uint8_t *pEnd = pBegin + strlen(response);
+   const uint8_t *pNext = 0;
+   bstr_http_header_t headers[MAX_HEADERS];
+   bstr_http_parser_t parser;
+
+   bstr_http_parser_create(&parser, &headers[0], MAX_HEADERS);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_response(&parser, pBegin, pEnd, &pNext));
+   CuAssertConstPtrEquals(tc, pEnd, pNext);
+   CuAssertIntEquals(tc, 404, parser.status);
+   CuAssertTrue(tc, view_equals(parser.reason.pBegin, parser.reason.pEnd, "Not Found"));
+   CuAssertIntEquals(tc, 1, (int) parser.numHeaders);
+   CuAssertTrue(tc, view_equals(headers[0].pValueBegin, headers[0].pValueEnd, "0"));
+
+   response = "HTTP/1.0 204\r\n\r\n";
+   pBegin = (const uint8_t*) response;
+   pEnd = pBegin + strlen(response);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_response(&parser, pBegin, pEnd, &pNext));
+   CuAssertConstPtrEquals(tc, pEnd, pNext);
+   CuAssertIntEquals(tc, 204, parser.status);
+   CuAssertTrue(tc, parser.reason.pBegin == parser.reason.pEnd);
+
+   response = "HTTP/1.1 2000 OK\r\n\r\n";
+   pBegin = (const uint8_t*) response;
+   CuAssertIntEquals(tc, BSTR_PARSE_ERROR, bstr_http_parse_response(&parser, pBegin, pBegin + strlen(response), &pNext));
+
+   //header block only, as used for trailers
+   response = "Expires: never\r\nX-Checksum: 1234\r\n\r\nnext";
+   pBegin = (const uint8_t*) response;
+   pEnd = pBegin + strlen(response);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_headers(&parser, pBegin, pEnd, &pNext));
+   CuAssertConstPtrEquals(tc, pEnd - 4, pNext);
+   CuAssertIntEquals(tc, 2, (int) parser.numHeaders);
+   CuAssertTrue(tc, view_equals(headers[1].pValueBegin, headers[1].pValueEnd, "1234"));
+}
+
+static void test_bstr_http_parse_incremental(CuTest* tc)
+{
+   const uint8_t *pBegin = (const uint8_t*) m_request;
+   size_t headLen = strlen(m_request) - 4u;
+   bstr_http_header_t headers[MAX_HEADERS];
+   bstr_http_parser_t parser;
+   const uint8_t *pNext = 0;
+   size_t splitLen;
+   size_t len;
+
+   //any prefix of the head is incomplete, the remainder completes it
+   for (splitLen = 0u; splitLen < headLen; splitLen++)
+   {
+      char msg[32];
+      sprintf(msg, "splitLen=%u", (unsigned) splitLen);
+      bstr_http_parser_create(&parser, &headers[0], MAX_HEADERS);
+      CuAssertIntEquals_Msg(tc, msg, BSTR_NO_ERROR, bstr_http_parse_request(&parser, pBegin, pBegin + splitLen, &pNext));
+      CuAssertConstPtrEquals_Msg(tc, msg, pBegin, pNext);
+      CuAssertIntEquals_Msg(tc, msg, BSTR_NO_ERROR, bstr_http_parse_request(&parser, pBegin, pBegin + headLen, &pNext));
+      CuAssertConstPtrEquals_Msg(tc, msg, pBegin + headLen, pNext);
+      CuAssertIntEquals_Msg(tc, msg, 6, (int) parser.numHeaders);
+      CuAssertTrue(tc, view_equals(headers[4].pValueBegin, headers[4].pValueEnd, "b=2"));
+   }
+
+   //one byte at a time
+   bstr_http_parser_create(&parser, &headers[0], MAX_HEADERS);
+   for (len = 1u; len < headLen; len++)
+   {
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_request(&parser, pBegin, pBegin + len, &pNext));
+      CuAssertConstPtrEquals(tc, pBegin, pNext);
+   }
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_request(&parser, pBegin, pBegin + headLen, &pNext));
+   CuAssertConstPtrEquals(tc, pBegin + headLen, pNext);
+   CuAssertTrue(tc, view_equals(parser.target.pBegin, parser.target.pEnd, "/index.html?q=1"));
+   CuAssertIntEquals(tc, 6, (int) parser.numHeaders);
+
+   //an empty header block split after its '\r' completes like it does in one piece
+   pBegin = (const uint8_t*) "\r\nBODY";
+   bstr_http_parser_create(&parser, &headers[0], MAX_HEADERS);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_headers(&parser, pBegin, pBegin + 1, &pNext));
+   CuAssertConstPtrEquals(tc, pBegin, pNext);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_headers(&parser, pBegin, pBegin + 6, &pNext));
+   CuAssertConstPtrEquals(tc, pBegin + 2, pNext);
+   CuAssertIntEquals(tc, 0, (int) parser.numHeaders);
+   pBegin = (const uint8_t*) "\nBODY";
+   bstr_http_parser_create(&parser, &headers[0], MAX_HEADERS);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_headers(&parser, pBegin, pBegin, &pNext));
+   CuAssertConstPtrEquals(tc, pBegin, pNext);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_http_parse_headers(&parser, pBegin, pBegin + 5, &pNext));
+   CuAssertConstPtrEquals(tc, pBegin + 1, pNext);
+}
+
+static void test_bstr_http_parse_simd(CuTest* tc)
+{
+   char request[256];
+   const char *prefix = "GET /";
+   size_t prefixLen = strlen(prefix);
+   bstr_http_header_t headers[MAX_HEADERS];
+   bstr_http_parser_t parser;
+   const uint8_t *pNext = 0;
+   size_t i;
+   size_t pos;
+
+   for (i = 0u; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      bstr_http_parser_create(&parser, &headers[0], MAX_HEADERS);
+      //request targets and header values of every length from 0 to 79, with a tab inside the value
+      for (pos = 0u; pos < 80u; pos++)
+      {
+         size_t len = prefixLen;
+         memcpy(request, prefix, prefixLen);
+         memset(&request[len], 'p', pos);
+         len += pos;
+         memcpy(&request[len], " HTTP/1.1\r\nX:", 13u);
+         len += 13u;
+         memset(&request[len], 'v', pos);
+         if (pos > 2u)
+         {
+            request[len + pos / 2u] = '\t';
+         }
+         len += pos;
+         strcpy(&request[len], "\r\n\r\n");
+         CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_request_cstr(&parser, request, &pNext));
+         CuAssertIntEquals(tc, (int) pos + 1, (int) (parser.target.pEnd - parser.target.pBegin));
+         CuAssertIntEquals(tc, (int) pos, (int) (headers[0].pValueEnd - headers[0].pValueBegin));
+         CuAssertConstPtrEquals(tc, (const uint8_t*) request + len + 4u, pNext);
+
+         //a control character anywhere in the value is rejected
+         request[len - pos / 2u - 1u] = '\x01';
+         CuAssertIntEquals(tc, (pos > 0u) ? BSTR_INVALID_CHARACTER_ERROR : BSTR_PARSE_ERROR, parse_request_cstr(&parser, request, &pNext));
+         //as is DEL in the target
+         request[prefixLen + pos / 2u] = '\x7F';
+         CuAssertIntEquals(tc, BSTR_PARSE_ERROR, parse_request_cstr(&parser, request, &pNext));
+      }
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+}
+
+static void test_bstr_http_parse_errors(CuTest* tc)
+{
+   static const char *invalid[] = {
+      "GET  / HTTP/1.1\r\n\r\n",
+      "GET / HTTP/2.0\r\n\r\n",
+      "GET / HTTP/1.1x\r\n\r\n",
+      "G(ET / HTTP/1.1\r\n\r\n",
+      "GET / HTTP/1.1\r\nHost : x\r\n\r\n",
+      "GET / HTTP/1.1\r\nHost: x\r\n folded\r\n\r\n",
+      "GET / HTTP/1.1\r\nNoColon\r\n\r\n",
+      "GET / HTTP/1.1\r\n: empty\r\n\r\n",
+      "GET / HTTP/1.1\r\nHost: x\rx\n\r\n"
+   };
+   bstr_http_header_t headers[MAX_HEADERS];
+   bstr_http_parser_t parser;
+   const uint8_t *pNext = 0;
+   const uint8_t *pBegin = (const uint8_t*) m_request;
+   size_t i;
+
+   bstr_http_parser_create(&parser, &headers[0], MAX_HEADERS);
+   for (i = 0u; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+   {
+      char msg[16];
+      sprintf(msg, "i=%u", (unsigned) i);
+      CuAssertIntEquals_Msg(tc, msg, BSTR_PARSE_ERROR, parse_request_cstr(&parser, invalid[i], &pNext));
+   }
+   //the error is found before the head is complete
+   CuAssertIntEquals(tc, BSTR_PARSE_ERROR, bstr_http_parse_request(&parser, (const uint8_t*) "GET / HTTP/3", (const uint8_t*) "GET / HTTP/3" + 12, &pNext));
+
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_http_parse_request(0, pBegin, pBegin + 4, &pNext));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_http_parse_request(&parser, pBegin + 4, pBegin, &pNext));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_http_parse_request(&parser, pBegin, pBegin + 4, 0));
+}
+
+static void test_bstr_http_parse_params(CuTest* tc)
+{
+   const char *query = "a=1&b=&&flag& c = x y &d==";
+   const char *cookie = "SID=31d4d96e407aad42; lang=en-US";
+   bstr_http_header_t params[4];
+   const uint8_t *pBegin = (const uint8_t*) query;
+
+   CuAssertUIntEquals(tc, 5u, bstr_http_parse_params(pBegin, pBegin + strlen(query), (uint8_t) '&', (uint8_t) '=', &params[0], 4u));
+   CuAssertTrue(tc, view_equals(params[0].pNameBegin, params[0].pNameEnd, "a"));
+   CuAssertTrue(tc, view_equals(params[0].pValueBegin, params[0].pValueEnd, "1"));
+   CuAssertTrue(tc, view_equals(params[1].pNameBegin, params[1].pNameEnd, "b"));
+   CuAssertTrue(tc, params[1].pValueBegin == params[1].pValueEnd);
+   CuAssertTrue(tc, view_equals(params[2].pNameBegin, params[2].pNameEnd, "flag"));
+   CuAssertTrue(tc, params[2].pValueBegin == params[2].pValueEnd);
+   CuAssertTrue(tc, view_equals(params[3].pNameBegin, params[3].pNameEnd, "c"));
+   CuAssertTrue(tc, view_equals(params[3].pValueBegin, params[3].pValueEnd, "x y"));
+   CuAssertUIntEquals(tc, bstr_http_name_hash_cstr("C"), params[3].nameHash);
+
+   pBegin = (const uint8_t*) cookie;
+   CuAssertUIntEquals(tc, 2u, bstr_http_parse_params(pBegin, pBegin + strlen(cookie), (uint8_t) ';', (uint8_t) '=', &params[0], 4u));
+   CuAssertTrue(tc, view_equals(params[1].pNameBegin, params[1].pNameEnd, "lang"));
+   CuAssertTrue(tc, view_equals(params[1].pValueBegin, params[1].pValueEnd, "en-US"));
+
+   CuAssertUIntEquals(tc, 0u, bstr_http_parse_params(pBegin, pBegin, (uint8_t) ';', (uint8_t) '=', &params[0], 4u));
+   CuAssertUIntEquals(tc, 0u, bstr_http_parse_params(pBegin, pBegin + 4, (uint8_t) ';', (uint8_t) '=', 0, 4u));
+}
+
+static bool view_equals(const uint8_t *pBegin, const uint8_t *pEnd, const char *cstr)
+{
+   size_t len = strlen(cstr);
+   return ( (size_t) (pEnd - pBegin) == len ) && (memcmp(pBegin, cstr, len) == 0);
+}
+
+static bstr_error_t parse_request_cstr(bstr_http_parser_t *parser, const char *request, const uint8_t **ppNext)
+{
+   const uint8_t *pBegin = (const uint8_t*) request;
+   bstr_http_parser_reset(parser);
+   return bstr_http_parse_request(parser, pBegin, pBegin + strlen(request), ppNext);
+}
@@ -0,0 +1,719 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "bstr_json.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_GENERATED_ITEMS 200
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_bstr_json_document_parse(CuTest* tc);
+static void test_bstr_json_document_iterate(CuTest* tc);
+static void test_bstr_json_document_numbers(CuTest* tc);
+static void test_bstr_json_document_simd(CuTest* tc);
+static void test_bstr_json_document_errors(CuTest* tc);
+static void test_bstr_json_cursor_find(CuTest* tc);
+static void test_bstr_json_cursor_pointer(CuTest* tc);
+static void test_bstr_json_cursor_iterate(CuTest* tc);
+static void test_bstr_json_cursor_simd(CuTest* tc);
+static void test_bstr_json_cursor_errors(CuTest* tc);
+static void cursor_create_cstr(bstr_json_cursor_t *cursor, const char *json);
+static bool cursor_string_equals(bstr_json_cursor_t *cursor, const char *cstr);
+static bstr_error_t parse_cstr(bstr_json_document_t *document, const char *json);
+static bool string_equals(bstr_json_value_t value, const char *cstr);
+static char *generate_json(size_t *length);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint32_t m_simdFeatureSets[] = {
+   0u,
+   BSTR_SIMD_SSE2,
+   BSTR_SIMD_SSE2 | BSTR_SIMD_SSSE3 | BSTR_SIMD_SSE42 | BSTR_SIMD_PCLMUL | BSTR_SIMD_AVX2 | BSTR_SIMD_BMI2,
+   0xFFFFFFFFu
+};
+#define NUM_SIMD_FEATURE_SETS (sizeof(m_simdFeatureSets) / sizeof(m_simdFeatureSets[0]))
+
+static const char *m_texts[4] = {"q\\\"q", "\\\\", "\\u00e9", "plain {[,:]} \\t"};
+static const char *m_unescapedTexts[4] = {"q\"q", "\\", "\xC3\xA9", "plain {[,:]} \t"};
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_bstr_json(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_bstr_json_document_parse);
+   SUITE_ADD_TEST(suite, test_bstr_json_document_iterate);
+   SUITE_ADD_TEST(suite, test_bstr_json_document_numbers);
+   SUITE_ADD_TEST(suite, test_bstr_json_document_simd);
+   SUITE_ADD_TEST(suite, test_bstr_json_document_errors);
+   SUITE_ADD_TEST(suite, test_bstr_json_cursor_find);
+   SUITE_ADD_TEST(suite, test_bstr_json_cursor_pointer);
+   SUITE_ADD_TEST(suite, test_bstr_json_cursor_iterate);
+   SUITE_ADD_TEST(suite, test_bstr_json_cursor_simd);
+   SUITE_ADD_TEST(suite, test_bstr_json_cursor_errors);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_bstr_json_document_parse(CuTest* tc)
+{
+   const char *json = " {\"name\": \"bstr\", \"escaped\": \"a\\nb\\u0041\", \"version\": 3, \"ratio\": 0.25,\n"
+                      "  \"enabled\": true, \"debug\": false, \"owner\": null, \"tags\": [\"x\", \"y\"], \"empty\": {}} ";
+   bstr_json_document_t document;
+   bstr_json_value_t root;
+   bstr_json_value_t value;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   int64_t i64;
+   double f64;
+   bool flag;
+
+   bstr_json_document_create(&document, 0);
+   CuAssertIntEquals(tc, BSTR_JSON_NONE, bstr_json_value_type(bstr_json_document_root(&document)));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_cstr(&document, json));
+   CuAssertPtrEquals(tc, 0, (void*) document.pError);
+   root = bstr_json_document_root(&document);
+   CuAssertIntEquals(tc, BSTR_JSON_OBJECT, bstr_json_value_type(root));
+   CuAssertIntEquals(tc, 9, (int) bstr_json_value_count(root));
+
+   CuAssertTrue(tc, bstr_json_value_find_cstr(root, "name", &value));
+   CuAssertTrue(tc, bstr_json_value_get_string(value, &pBegin, &pEnd));
+   CuAssertConstPtrEquals(tc, (const uint8_t*) json + 11, pBegin); //view into the input
+   CuAssertTrue(tc, string_equals(value, "bstr"));
+   CuAssertTrue(tc, bstr_json_value_find_cstr(root, "escaped", &value));
+   CuAssertTrue(tc, string_equals(value, "a\nbA"));
+   CuAssertTrue(tc, bstr_json_value_find_cstr(root, "version", &value));
+   CuAssertIntEquals(tc, BSTR_JSON_INT64, bstr_json_value_type(value));
+   CuAssertTrue(tc, bstr_json_value_get_int64(value, &i64));
+   CuAssertIntEquals(tc, 3, (int) i64);
+   CuAssertTrue(tc, bstr_json_value_find_cstr(root, "ratio", &value));
+   CuAssertTrue(tc, bstr_json_value_get_double(value, &f64));
+   CuAssertDblEquals(tc, 0.25, f64, 0.0);
+   CuAssertTrue(tc, !bstr_json_value_get_int64(value, &i64));
+   CuAssertTrue(tc, bstr_json_value_find_cstr(root, "enabled", &value));
+   CuAssertTrue(tc, bstr_json_value_get_bool(value, &flag));
+   CuAssertTrue(tc, flag);
+   CuAssertTrue(tc, bstr_json_value_find_cstr(root, "debug", &value));
+   CuAssertTrue(tc, bstr_json_value_get_bool(value, &flag));
+   CuAssertTrue(tc, !flag);
+   CuAssertTrue(tc, bstr_json_value_find_cstr(root, "owner", &value));
+   CuAssertIntEquals(tc, BSTR_JSON_NULL, bstr_json_value_type(value));
+   CuAssertTrue(tc, !bstr_json_value_get_bool(value, &flag));
+   CuAssertTrue(tc, bstr_json_value_find_cstr(root, "tags", &value));
+   CuAssertIntEquals(tc, 2, (int) bstr_json_value_count(value));
+   CuAssertTrue(tc, bstr_json_value_at(value, 1u, &value));
+   CuAssertTrue(tc, string_equals(value, "y"));
+   CuAssertTrue(tc, bstr_json_value_find_cstr(root, "empty", &value));
+   CuAssertIntEquals(tc, BSTR_JSON_OBJECT, bstr_json_value_type(value));
+   CuAssertIntEquals(tc, 0, (int) bstr_json_value_count(value));
+   CuAssertTrue(tc, !bstr_json_value_child(value, &value));
+   CuAssertTrue(tc, !bstr_json_value_find_cstr(root, "missing", &value));
+   CuAssertTrue(tc, !bstr_json_value_find_cstr(root, "bstr", &value)); //values are not keys
+
+   //the document is reused, the previous tape is replaced
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_cstr(&document, "\"\\\"top\\\"\""));
+   root = bstr_json_document_root(&document);
+   CuAssertTrue(tc, string_equals(root, "\"top\""));
+   CuAssertTrue(tc, !bstr_json_value_next(&root));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_cstr(&document, "[]"));
+   root = bstr_json_document_root(&document);
+   CuAssertIntEquals(tc, BSTR_JSON_ARRAY, bstr_json_value_type(root));
+   CuAssertIntEquals(tc, 0, (int) bstr_json_value_count(root));
+   CuAssertTrue(tc, !bstr_json_value_at(root, 0u, &value));
+   bstr_json_document_destroy(&document);
+}
+
+static void test_bstr_json_document_iterate(CuTest* tc)
+{
+   const char *json = "[{\"a\":[1,[2,[3]],{\"b\":{}}],\"c\":\"d\"},[],\"e\",{\"f\":[{}]},7]";
+   const uint8_t expectedTypes[5] = {BSTR_JSON_OBJECT, BSTR_JSON_ARRAY, BSTR_JSON_STRING, BSTR_JSON_OBJECT, BSTR_JSON_INT64};
+   bstr_json_document_t document;
+   bstr_json_value_t root;
+   bstr_json_value_t element;
+   bstr_json_value_t member;
+   int count = 0;
+
+   bstr_json_document_create(&document, 0);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_cstr(&document, json));
+   root = bstr_json_document_root(&document);
+   CuAssertIntEquals(tc, 5, (int) bstr_json_value_count(root));
+   //next skips over nested containers
+   CuAssertTrue(tc, bstr_json_value_child(root, &element));
+   do
+   {
+      CuAssertIntEquals(tc, expectedTypes[count], bstr_json_value_type(element));
+      count++;
+   } while (bstr_json_value_next(&element));
+   CuAssertIntEquals(tc, 5, count);
+   CuAssertIntEquals(tc, BSTR_JSON_INT64, bstr_json_value_type(element));
+   //keys and values alternate within an object
+   CuAssertTrue(tc, bstr_json_value_child(root, &element));
+   CuAssertTrue(tc, bstr_json_value_child(element, &member));
+   CuAssertTrue(tc, string_equals(member, "a"));
+   CuAssertTrue(tc, bstr_json_value_next(&member));
+   CuAssertIntEquals(tc, 3, (int) bstr_json_value_count(member));
+   CuAssertTrue(tc, bstr_json_value_next(&member));
+   CuAssertTrue(tc, string_equals(member, "c"));
+   CuAssertTrue(tc, bstr_json_value_next(&member));
+   CuAssertTrue(tc, string_equals(member, "d"));
+   CuAssertTrue(tc, !bstr_json_value_next(&member));
+   CuAssertTrue(tc, bstr_json_value_find_cstr(element, "a", &member));
+   CuAssertTrue(tc, bstr_json_value_at(member, 2u, &member));
+   CuAssertTrue(tc, bstr_json_value_find_cstr(member, "b", &member));
+   CuAssertIntEquals(tc, BSTR_JSON_OBJECT, bstr_json_value_type(member));
+   CuAssertTrue(tc, bstr_json_value_at(root, 3u, &element));
+   CuAssertTrue(tc, bstr_json_value_find_cstr(element, "f", &member));
+   CuAssertTrue(tc, bstr_json_value_at(member, 0u, &member));
+   CuAssertIntEquals(tc, 0, (int) bstr_json_value_count(member));
+   CuAssertTrue(tc, !bstr_json_value_at(root, 5u, &element));
+   bstr_json_document_destroy(&document);
+}
+
+static void test_bstr_json_document_numbers(CuTest* tc)
+{
+   bstr_json_document_t document;
+   bstr_json_value_t value;
+   int64_t i64;
+   uint64_t u64;
+   double f64;
+
+   bstr_json_document_create(&document, 0);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_cstr(&document, "[-9223372036854775808,9223372036854775807,18446744073709551615,"
+                                                                "18446744073709551616,-0,1e2,-1.5E-3,0]"));
+   CuAssertTrue(tc, bstr_json_value_at(bstr_json_document_root(&document), 0u, &value));
+   CuAssertTrue(tc, bstr_json_value_get_int64(value, &i64));
+   CuAssertTrue(tc, i64 == INT64_MIN);
+   CuAssertTrue(tc, !bstr_json_value_get_uint64(value, &u64));
+   CuAssertTrue(tc, bstr_json_value_next(&value));
+   CuAssertTrue(tc, bstr_json_value_get_int64(value, &i64));
+   CuAssertTrue(tc, i64 == INT64_MAX);
+   CuAssertTrue(tc, bstr_json_value_get_uint64(value, &u64));
+   CuAssertTrue(tc, u64 == (uint64_t) INT64_MAX);
+   CuAssertTrue(tc, bstr_json_value_next(&value));
+   CuAssertIntEquals(tc, BSTR_JSON_UINT64, bstr_json_value_type(value));
+   CuAssertTrue(tc, !bstr_json_value_get_int64(value, &i64));
+   CuAssertTrue(tc, bstr_json_value_get_uint64(value, &u64));
+   CuAssertTrue(tc, u64 == UINT64_MAX);
+   CuAssertTrue(tc, bstr_json_value_next(&value));
+   CuAssertIntEquals(tc, BSTR_JSON_DOUBLE, bstr_json_value_type(value));
+   CuAssertTrue(tc, bstr_json_value_get_double(value, &f64));
+   CuAssertDblEquals(tc, 18446744073709551616.0, f64, 0.0);
+   CuAssertTrue(tc, bstr_json_value_next(&value));
+   CuAssertTrue(tc, bstr_json_value_get_int64(value, &i64));
+   CuAssertTrue(tc, i64 == 0);
+   CuAssertTrue(tc, bstr_json_value_next(&value));
+   CuAssertTrue(tc, bstr_json_value_get_double(value, &f64));
+   CuAssertDblEquals(tc, 100.0, f64, 0.0);
+   CuAssertTrue(tc, bstr_json_value_next(&value));
+   CuAssertTrue(tc, bstr_json_value_get_double(value, &f64));
+   CuAssertDblEquals(tc, -0.0015, f64, 0.0);
+   CuAssertTrue(tc, bstr_json_value_next(&value));
+   CuAssertTrue(tc, bstr_json_value_get_double(value, &f64));
+   CuAssertDblEquals(tc, 0.0, f64, 0.0);
+   CuAssertTrue(tc, !bstr_json_value_next(&value));
+   //a number on its own ends at the end of input
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_cstr(&document, "42"));
+   CuAssertTrue(tc, bstr_json_value_get_int64(bstr_json_document_root(&document), &i64));
+   CuAssertIntEquals(tc, 42, (int) i64);
+   CuAssertIntEquals(tc, BSTR_NUMBER_TOO_LARGE_ERROR, parse_cstr(&document, "[1e400]"));
+   bstr_json_document_destroy(&document);
+}
+
+static void test_bstr_json_document_simd(CuTest* tc)
+{
+   size_t length;
+   char *json = generate_json(&length);
+   uint64_t *expectedTape = 0;
+   size_t expectedTapeLen = 0u;
+   size_t i;
+   CuAssertPtrNotNull(tc, json);
+   for (i = 0u; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      bstr_json_document_t document;
+      bstr_json_value_t item;
+      int count = 0;
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      bstr_json_document_create(&document, 0);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_json_document_parse(&document, (const uint8_t*) json, (const uint8_t*) json + length));
+      CuAssertIntEquals(tc, NUM_GENERATED_ITEMS, (int) bstr_json_value_count(bstr_json_document_root(&document)));
+      CuAssertTrue(tc, bstr_json_value_child(bstr_json_document_root(&document), &item));
+      do
+      {
+         bstr_json_value_t value;
+         int64_t id;
+         CuAssertTrue(tc, bstr_json_value_find_cstr(item, "id", &value));
+         CuAssertTrue(tc, bstr_json_value_get_int64(value, &id));
+         CuAssertIntEquals(tc, count, (int) id);
+         CuAssertTrue(tc, bstr_json_value_find_cstr(item, "text", &value));
+         CuAssertTrue(tc, string_equals(value, m_unescapedTexts[count % 4]));
+         CuAssertTrue(tc, bstr_json_value_find_cstr(item, "values", &value));
+         CuAssertIntEquals(tc, 5, (int) bstr_json_value_count(value));
+         CuAssertTrue(tc, bstr_json_value_at(value, 4u, &value));
+         CuAssertIntEquals(tc, BSTR_JSON_NULL, bstr_json_value_type(value));
+         count++;
+      } while (bstr_json_value_next(&item));
+      CuAssertIntEquals(tc, NUM_GENERATED_ITEMS, count);
+      //every kernel finds the same structurals and therefore writes the same tape
+      if (expectedTape == 0)
+      {
+         expectedTapeLen = document.tapeLen;
+         expectedTape = (uint64_t*) malloc(expectedTapeLen * sizeof(uint64_t));
+         CuAssertPtrNotNull(tc, expectedTape);
+         memcpy(expectedTape, document.tape, expectedTapeLen * sizeof(uint64_t));
+      }
+      else
+      {
+         CuAssertIntEquals(tc, (int) expectedTapeLen, (int) document.tapeLen);
+         CuAssertTrue(tc, memcmp(expectedTape, document.tape, expectedTapeLen * sizeof(uint64_t)) == 0);
+      }
+      bstr_json_document_destroy(&document);
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+   free(expectedTape);
+   free(json);
+}
+
+static void test_bstr_json_document_errors(CuTest* tc)
+{
+   static const struct
+   {
+      const char *json;
+      bstr_error_t error;
+      int errorOffset;
+   } cases[] = {
+      {"", BSTR_PREMATURE_END_OF_BUFFER_ERROR, 0},
+      {"   ", BSTR_PREMATURE_END_OF_BUFFER_ERROR, 3},
+      {"[1,2", BSTR_PREMATURE_END_OF_BUFFER_ERROR, 4},
+      {"{\"a\"", BSTR_PREMATURE_END_OF_BUFFER_ERROR, 4},
+      {"{\"a\":", BSTR_PREMATURE_END_OF_BUFFER_ERROR, 5},
+      {"[\"abc]", BSTR_PREMATURE_END_OF_BUFFER_ERROR, 1},
+      {"[1] 2", BSTR_PARSE_ERROR, 4},
+      {"[1,]", BSTR_PARSE_ERROR, 3},
+      {"{\"a\":1,}", BSTR_PARSE_ERROR, 7},
+      {"{\"a\" 1}", BSTR_PARSE_ERROR, 5},
+      {"{1:2}", BSTR_PARSE_ERROR, 1},
+      {"[1}", BSTR_PARSE_ERROR, 2},
+      {"[1 2]", BSTR_PARSE_ERROR, 3},
+      {"[\"a\"\"b\"]", BSTR_PARSE_ERROR, 4},
+      {"[\"a\"x]", BSTR_PARSE_ERROR, 4},
+      {"[12a]", BSTR_PARSE_ERROR, 1},
+      {"[01]", BSTR_PARSE_ERROR, 1},
+      {"[-]", BSTR_PARSE_ERROR, 1},
+      {"[tru]", BSTR_PARSE_ERROR, 1},
+      {"[truex]", BSTR_PARSE_ERROR, 1},
+      {"[nul", BSTR_PARSE_ERROR, 1},
+      {"{\"a\":1 \"b\":2}", BSTR_PARSE_ERROR, 7},
+      {"[\"a\\x\"]", BSTR_INVALID_CHARACTER_ERROR, 1},
+      {"[\"a\x01\"]", BSTR_INVALID_CHARACTER_ERROR, 1},
+   };
+   bstr_json_document_t document;
+   char *deep;
+   size_t i;
+
+   bstr_json_document_create(&document, 0);
+   for (i = 0u; i < sizeof(cases) / sizeof(cases[0]); i++)
+   {
+      const uint8_t *pBegin = (const uint8_t*) cases[i].json;
+      CuAssertIntEquals(tc, cases[i].error, bstr_json_document_parse(&document, pBegin, pBegin + strlen(cases[i].json)));
+      CuAssertIntEquals(tc, cases[i].error, document.lastError);
+      CuAssertIntEquals(tc, cases[i].errorOffset, (int) (document.pError - pBegin));
+      CuAssertIntEquals(tc, BSTR_JSON_NONE, bstr_json_value_type(bstr_json_document_root(&document)));
+   }
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_json_document_parse(&document, 0, 0));
+   //nesting limit
+   deep = (char*) malloc(2u * BSTR_JSON_MAX_DEPTH + 4u);
+   CuAssertPtrNotNull(tc, deep);
+   memset(deep, '[', BSTR_JSON_MAX_DEPTH);
+   deep[BSTR_JSON_MAX_DEPTH] = '1';
+   memset(deep + BSTR_JSON_MAX_DEPTH + 1u, ']', BSTR_JSON_MAX_DEPTH);
+   deep[2u * BSTR_JSON_MAX_DEPTH + 1u] = '\0';
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_cstr(&document, deep));
+   memset(deep, '[', BSTR_JSON_MAX_DEPTH + 1u);
+   deep[BSTR_JSON_MAX_DEPTH + 1u] = '1';
+   memset(deep + BSTR_JSON_MAX_DEPTH + 2u, ']', BSTR_JSON_MAX_DEPTH + 1u);
+   deep[2u * BSTR_JSON_MAX_DEPTH + 3u] = '\0';
+   CuAssertIntEquals(tc, BSTR_PARSE_ERROR, parse_cstr(&document, deep));
+   CuAssertIntEquals(tc, BSTR_JSON_MAX_DEPTH, (int) (document.pError - (const uint8_t*) deep));
+   free(deep);
+   //a failed parse doesn't prevent reuse
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, parse_cstr(&document, "{\"ok\":true}"));
+   CuAssertIntEquals(tc, BSTR_JSON_OBJECT, bstr_json_value_type(bstr_json_document_root(&document)));
+   CuAssertPtrEquals(tc, 0, (void*) document.pError);
+   bstr_json_document_destroy(&document);
+}
+
+static void test_bstr_json_cursor_find(CuTest* tc)
+{
+   const char *json = " {\"name\": \"bstr\", \"escaped\": \"a\\nb\\u0041\", \"version\": 3, \"ratio\": 0.25,\n"
+                      "  \"enabled\": true, \"owner\": null, \"tags\": [\"x\", \"y\"], \"empty\": {}, \"k\\u0065y\": 7} ";
+   bstr_json_cursor_t root;
+   bstr_json_cursor_t cursor;
+   bstr_buf_t buf;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   int64_t i64;
+   double f64;
+   bool b;
+   bstr_number_t number;
+
+   bstr_buf_create(&buf, 0);
+   cursor_create_cstr(&root, json);
+   CuAssertIntEquals(tc, BSTR_JSON_OBJECT, bstr_json_cursor_type(&root));
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "name"));
+   CuAssertIntEquals(tc, BSTR_JSON_STRING, bstr_json_cursor_type(&cursor));
+   CuAssertTrue(tc, cursor_string_equals(&cursor, "bstr"));
+   CuAssertTrue(tc, bstr_json_cursor_get_raw(&cursor, &pBegin, &pEnd));
+   CuAssertIntEquals(tc, 6, (int) (pEnd - pBegin));
+   CuAssertTrue(tc, memcmp(pBegin, "\"bstr\"", 6) == 0);
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "escaped"));
+   CuAssertTrue(tc, cursor_string_equals(&cursor, "a\nbA"));
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "version"));
+   CuAssertIntEquals(tc, BSTR_JSON_NUMBER, bstr_json_cursor_type(&cursor));
+   CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, 3, (int) i64);
+   CuAssertTrue(tc, bstr_json_cursor_get_double(&cursor, &f64));
+   CuAssertDblEquals(tc, 3.0, f64, 0.0);
+   CuAssertTrue(tc, !bstr_json_cursor_get_bool(&cursor, &b));
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "ratio"));
+   CuAssertTrue(tc, !bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertTrue(tc, bstr_json_cursor_get_number(&cursor, &number));
+   CuAssertIntEquals(tc, BSTR_NUMBER_DOUBLE, number.type);
+   CuAssertTrue(tc, bstr_json_cursor_get_double(&cursor, &f64));
+   CuAssertDblEquals(tc, 0.25, f64, 0.0);
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "enabled"));
+   CuAssertIntEquals(tc, BSTR_JSON_TRUE, bstr_json_cursor_type(&cursor));
+   CuAssertTrue(tc, bstr_json_cursor_get_bool(&cursor, &b));
+   CuAssertTrue(tc, b);
+   CuAssertTrue(tc, !bstr_json_cursor_get_string(&cursor, &buf, &pBegin, &pEnd));
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "owner"));
+   CuAssertIntEquals(tc, BSTR_JSON_NULL, bstr_json_cursor_type(&cursor));
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "tags"));
+   CuAssertIntEquals(tc, BSTR_JSON_ARRAY, bstr_json_cursor_type(&cursor));
+   CuAssertTrue(tc, bstr_json_cursor_get_raw(&cursor, &pBegin, &pEnd));
+   CuAssertIntEquals(tc, 10, (int) (pEnd - pBegin));
+   CuAssertTrue(tc, bstr_json_cursor_at(&cursor, 1u));
+   CuAssertTrue(tc, cursor_string_equals(&cursor, "y"));
+   //keys are compared after unescaping
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "key"));
+   CuAssertTrue(tc, bstr_json_cursor_get_key(&cursor, &buf, &pBegin, &pEnd));
+   CuAssertIntEquals(tc, 3, (int) (pEnd - pBegin));
+   CuAssertTrue(tc, memcmp(pBegin, "key", 3) == 0);
+   CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, 7, (int) i64);
+   //missing keys and wrong types leave the cursor unchanged without an error
+   cursor = root;
+   CuAssertTrue(tc, !bstr_json_cursor_find_cstr(&cursor, "missing"));
+   CuAssertTrue(tc, !bstr_json_cursor_find_cstr(&cursor, "nam"));
+   CuAssertTrue(tc, cursor.pValue == root.pValue);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, cursor.lastError);
+   CuAssertTrue(tc, !bstr_json_cursor_at(&cursor, 0u));
+   CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "empty"));
+   CuAssertTrue(tc, !bstr_json_cursor_find_cstr(&cursor, "x"));
+   CuAssertTrue(tc, !bstr_json_cursor_child(&cursor));
+   CuAssertTrue(tc, bstr_json_cursor_get_raw(&cursor, &pBegin, &pEnd));
+   CuAssertIntEquals(tc, 2, (int) (pEnd - pBegin));
+   //a scalar at the top level
+   cursor_create_cstr(&cursor, " -12 ");
+   CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, -12, (int) i64);
+   CuAssertTrue(tc, !bstr_json_cursor_next(&cursor));
+   bstr_buf_destroy(&buf);
+}
+
+static void test_bstr_json_cursor_pointer(CuTest* tc)
+{
+   const char *json = "{\"a\": {\"b\": [10, 20, {\"c\": \"deep\"}]}, \"x/y\": 1, \"m~n\": 2, \"\": 3, \"a b\": [[4]]}";
+   bstr_json_cursor_t root;
+   bstr_json_cursor_t cursor;
+   int64_t i64;
+
+   cursor_create_cstr(&root, json);
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, ""));
+   CuAssertTrue(tc, cursor.pValue == root.pValue);
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/a/b/1"));
+   CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, 20, (int) i64);
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/a/b/2/c"));
+   CuAssertTrue(tc, cursor_string_equals(&cursor, "deep"));
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/a"));
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/b/0"));
+   CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, 10, (int) i64);
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/x~1y"));
+   CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, 1, (int) i64);
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/m~0n"));
+   CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, 2, (int) i64);
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/"));
+   CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, 3, (int) i64);
+   cursor = root;
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/a b/0/0"));
+   CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, 4, (int) i64);
+   //references to missing values fail without moving the cursor
+   cursor = root;
+   CuAssertTrue(tc, !bstr_json_cursor_pointer(&cursor, "/a/b/3"));
+   CuAssertTrue(tc, !bstr_json_cursor_pointer(&cursor, "/a/b/01"));
+   CuAssertTrue(tc, !bstr_json_cursor_pointer(&cursor, "/a/b/-"));
+   CuAssertTrue(tc, !bstr_json_cursor_pointer(&cursor, "/a/b/0/c"));
+   CuAssertTrue(tc, !bstr_json_cursor_pointer(&cursor, "/x/y"));
+   CuAssertTrue(tc, cursor.pValue == root.pValue);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, cursor.lastError);
+   //malformed pointers
+   CuAssertTrue(tc, !bstr_json_cursor_pointer(&cursor, "a"));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, cursor.lastError);
+   cursor.lastError = BSTR_NO_ERROR;
+   CuAssertTrue(tc, !bstr_json_cursor_pointer(&cursor, "/m~2n"));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, cursor.lastError);
+   CuAssertTrue(tc, cursor.pValue == root.pValue);
+}
+
+static void test_bstr_json_cursor_iterate(CuTest* tc)
+{
+   const char *json = "{ \"a\" : [ 1 , \"two\" , [3, [4]] , {\"five\": 5} , null ] , \"b\":{} }";
+   const char *expectedRaw[5] = {"1", "\"two\"", "[3, [4]]", "{\"five\": 5}", "null"};
+   bstr_json_cursor_t cursor;
+   bstr_buf_t buf;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   int count = 0;
+
+   bstr_buf_create(&buf, 0);
+   cursor_create_cstr(&cursor, json);
+   CuAssertTrue(tc, bstr_json_cursor_child(&cursor));
+   CuAssertIntEquals(tc, BSTR_JSON_OBJECT, cursor.container);
+   CuAssertTrue(tc, bstr_json_cursor_get_key(&cursor, &buf, &pBegin, &pEnd));
+   CuAssertIntEquals(tc, 1, (int) (pEnd - pBegin));
+   CuAssertIntEquals(tc, 'a', *pBegin);
+   CuAssertTrue(tc, bstr_json_cursor_child(&cursor));
+   CuAssertIntEquals(tc, BSTR_JSON_ARRAY, cursor.container);
+   CuAssertTrue(tc, !bstr_json_cursor_get_key(&cursor, &buf, &pBegin, &pEnd));
+   do
+   {
+      size_t len = strlen(expectedRaw[count]);
+      CuAssertTrue(tc, bstr_json_cursor_get_raw(&cursor, &pBegin, &pEnd));
+      CuAssertIntEquals(tc, (int) len, (int) (pEnd - pBegin));
+      CuAssertTrue(tc, memcmp(pBegin, expectedRaw[count], len) == 0);
+      count++;
+   } while (bstr_json_cursor_next(&cursor));
+   CuAssertIntEquals(tc, 5, count);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, cursor.lastError);
+   CuAssertIntEquals(tc, BSTR_JSON_NULL, bstr_json_cursor_type(&cursor));
+   bstr_buf_destroy(&buf);
+}
+
+static void test_bstr_json_cursor_simd(CuTest* tc)
+{
+   size_t length;
+   char *items = generate_json(&length);
+   char *json;
+   size_t i;
+   CuAssertPtrNotNull(tc, items);
+   //the generated array is skipped as a single value before "after"
+   json = (char*) malloc(length + 32u);
+   CuAssertPtrNotNull(tc, json);
+   memcpy(json, "{\"items\":", 9u);
+   memcpy(json + 9u, items, length);
+   memcpy(json + 9u + length, ",\"after\":-1}", 12u);
+   length += 21u;
+   for (i = 0u; i < NUM_SIMD_FEATURE_SETS; i++)
+   {
+      bstr_json_cursor_t root;
+      bstr_json_cursor_t item;
+      bstr_json_cursor_t cursor;
+      const uint8_t *pBegin;
+      const uint8_t *pEnd;
+      int64_t i64;
+      int count = 0;
+      bstr_simd_set_features(m_simdFeatureSets[i]);
+      bstr_json_cursor_create(&root, (const uint8_t*) json, (const uint8_t*) json + length);
+      cursor = root;
+      CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "after"));
+      CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+      CuAssertIntEquals(tc, -1, (int) i64);
+      CuAssertTrue(tc, bstr_json_cursor_get_raw(&root, &pBegin, &pEnd));
+      CuAssertTrue(tc, pEnd == (const uint8_t*) json + length);
+      item = root;
+      CuAssertTrue(tc, bstr_json_cursor_pointer(&item, "/items/0"));
+      do
+      {
+         char pointer[32];
+         cursor = item;
+         CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "nested"));
+         CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/k/1"));
+         CuAssertIntEquals(tc, BSTR_JSON_OBJECT, bstr_json_cursor_type(&cursor));
+         cursor = item;
+         CuAssertTrue(tc, bstr_json_cursor_find_cstr(&cursor, "text"));
+         CuAssertTrue(tc, cursor_string_equals(&cursor, m_unescapedTexts[count % 4]));
+         sprintf(pointer, "/items/%d/id", count);
+         cursor = root;
+         CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, pointer));
+         CuAssertTrue(tc, bstr_json_cursor_get_int64(&cursor, &i64));
+         CuAssertIntEquals(tc, count, (int) i64);
+         count++;
+      } while (bstr_json_cursor_next(&item));
+      CuAssertIntEquals(tc, NUM_GENERATED_ITEMS, count);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, item.lastError);
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+   free(json);
+   free(items);
+}
+
+static void test_bstr_json_cursor_errors(CuTest* tc)
+{
+   static const struct
+   {
+      const char *json;
+      const char *pointer;
+      bstr_error_t error;
+   } cases[] = {
+      {"", "", BSTR_PREMATURE_END_OF_BUFFER_ERROR},
+      {"{\"a\":[1,2", "/b", BSTR_PREMATURE_END_OF_BUFFER_ERROR},
+      {"{\"a\":\"abc", "/b", BSTR_PREMATURE_END_OF_BUFFER_ERROR},
+      {"{\"a\"", "/a", BSTR_PREMATURE_END_OF_BUFFER_ERROR},
+      {"{\"a\":", "/a", BSTR_PREMATURE_END_OF_BUFFER_ERROR},
+      {"{\"a\":[1}, \"b\":2}", "/b", BSTR_PARSE_ERROR},
+      {"{\"a\":1,}", "/b", BSTR_PARSE_ERROR},
+      {"{\"a\" 1}", "/a", BSTR_PARSE_ERROR},
+      {"{1:2}", "/a", BSTR_PARSE_ERROR},
+      {"{\"a\":1 \"b\":2}", "/b", BSTR_PARSE_ERROR},
+      {"[1,]", "/1", BSTR_PARSE_ERROR},
+      {"[,1]", "/1", BSTR_PARSE_ERROR},
+      {"{\"a\":\"x\\", "/b", BSTR_PREMATURE_END_OF_BUFFER_ERROR},
+      {"{\"a\":\"x\x01\", \"b\":2}", "/b", BSTR_INVALID_CHARACTER_ERROR},
+   };
+   bstr_json_cursor_t cursor;
+   bstr_buf_t buf;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   int64_t i64;
+   size_t i;
+
+   for (i = 0u; i < sizeof(cases) / sizeof(cases[0]); i++)
+   {
+      cursor_create_cstr(&cursor, cases[i].json);
+      if (cursor.lastError == BSTR_NO_ERROR)
+      {
+         CuAssertTrue(tc, !bstr_json_cursor_pointer(&cursor, cases[i].pointer));
+      }
+      CuAssertIntEquals(tc, cases[i].error, cursor.lastError);
+   }
+   //values are only validated when they are read
+   bstr_buf_create(&buf, 0);
+   cursor_create_cstr(&cursor, "{\"a\":12x, \"b\":\"\\q\", \"c\":tru, \"d\":1}");
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/d"));
+   cursor_create_cstr(&cursor, "{\"a\":12x, \"b\":\"\\q\", \"c\":tru, \"d\":1}");
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/a"));
+   CuAssertTrue(tc, !bstr_json_cursor_get_int64(&cursor, &i64));
+   CuAssertIntEquals(tc, BSTR_PARSE_ERROR, cursor.lastError);
+   cursor_create_cstr(&cursor, "{\"a\":12x, \"b\":\"\\q\", \"c\":tru, \"d\":1}");
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/b"));
+   CuAssertTrue(tc, !bstr_json_cursor_get_string(&cursor, &buf, &pBegin, &pEnd));
+   CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, cursor.lastError);
+   cursor_create_cstr(&cursor, "{\"a\":12x, \"b\":\"\\q\", \"c\":tru, \"d\":1}");
+   CuAssertTrue(tc, bstr_json_cursor_pointer(&cursor, "/c"));
+   CuAssertIntEquals(tc, BSTR_JSON_NONE, bstr_json_cursor_type(&cursor));
+   bstr_buf_destroy(&buf);
+   bstr_json_cursor_create(&cursor, 0, 0);
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, cursor.lastError);
+   CuAssertIntEquals(tc, BSTR_JSON_NONE, bstr_json_cursor_type(&cursor));
+}
+
+static void cursor_create_cstr(bstr_json_cursor_t *cursor, const char *json)
+{
+   const uint8_t *pBegin = (const uint8_t*) json;
+   bstr_json_cursor_create(cursor, pBegin, pBegin + strlen(json));
+}
+
+static bool cursor_string_equals(bstr_json_cursor_t *cursor, const char *cstr)
+{
+   bstr_buf_t buf;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   size_t len = strlen(cstr);
+   bool isEqual;
+   bstr_buf_create(&buf, 0);
+   isEqual = bstr_json_cursor_get_string(cursor, &buf, &pBegin, &pEnd) && ((size_t) (pEnd - pBegin) == len) && (memcmp(pBegin, cstr, len) == 0);
+   bstr_buf_destroy(&buf);
+   return isEqual;
+}
+
+static bstr_error_t parse_cstr(bstr_json_document_t *document, const char *json)
+{
+   const uint8_t *pBegin = (const uint8_t*) json;
+   return bstr_json_document_parse(document, pBegin, pBegin + strlen(json));
+}
+
+static bool string_equals(bstr_json_value_t value, const char *cstr)
+{
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   size_t len = strlen(cstr);
+   return bstr_json_value_get_string(value, &pBegin, &pEnd) && ((size_t) (pEnd - pBegin) == len) && (memcmp(pBegin, cstr, len) == 0);
+}
+
+/**
+ * Returns an array of NUM_GENERATED_ITEMS objects. Indentation varies so that strings, escapes and numbers end up
+ * at every position relative to the 64-byte blocks of the structural scan.
+ */
+static char *generate_json(size_t *length)
+{
+   char *json = (char*) malloc((size_t) NUM_GENERATED_ITEMS * 160u + 16u);
+   size_t offset = 0u;
+   int i;
+   if (json == 0)
+   {
+      return 0;
+   }
+   json[offset++] = '[';
+   for (i = 0; i < NUM_GENERATED_ITEMS; i++)
+   {
+      int len = sprintf(&json[offset], "%s\n%*s{\"id\":%d,\"text\":\"%s\",\"values\":[%d, -%d.5, %de3,true,null],\"nested\":{\"k\":[[],{}]}}",
+                        (i > 0) ? "," : "", i % 13, "", i, m_texts[i % 4], i, i, i);
+      offset += (size_t) len;
+   }
+   json[offset++] = ']';
+   *length = offset;
+   return json;
+}
@@ -0,0 +1,259 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "bstr_matcher.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MAX_RECORDED_MATCHES 2000
+
+typedef struct match_log_tag
+{
+   const uint8_t *pBase;
+   uint32_t numMatches;
+   uint32_t maxMatches;
+   uint32_t offset[MAX_RECORDED_MATCHES];
+   uint32_t length[MAX_RECORDED_MATCHES];
+   uint32_t patternId[MAX_RECORDED_MATCHES];
+} match_log_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_bstr_matcher_overlapping(CuTest* tc);
+static void test_bstr_matcher_find(CuTest* tc);
+static void test_bstr_matcher_invalid_arguments(CuTest* tc);
+static void test_bstr_matcher_teddy_equals_dfa(CuTest* tc);
+static void test_bstr_matcher_large_set(CuTest* tc);
+static void match_log_create(match_log_t *log, const uint8_t *pBase, uint32_t maxMatches);
+static bool match_log_add(void *arg, const bstr_match_t *match);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static match_log_t m_log1;
+static match_log_t m_log2;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testsuite_bstr_matcher(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_bstr_matcher_overlapping);
+   SUITE_ADD_TEST(suite, test_bstr_matcher_find);
+   SUITE_ADD_TEST(suite, test_bstr_matcher_invalid_arguments);
+   SUITE_ADD_TEST(suite, test_bstr_matcher_teddy_equals_dfa);
+   SUITE_ADD_TEST(suite, test_bstr_matcher_large_set);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_bstr_matcher_overlapping(CuTest* tc)
+{
+   const char *test1 = "ushers";
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   bstr_matcher_t matcher;
+   uint32_t i;
+   const uint32_t featureSets[2] = {0u, 0xFFFFFFFFu};
+
+   bstr_matcher_create(&matcher);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_add_cstr(&matcher, "he", 1u));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_add_cstr(&matcher, "she", 2u));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_add_cstr(&matcher, "his", 3u));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_add_cstr(&matcher, "hers", 4u));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_compile(&matcher));
+   CuAssertTrue(tc, matcher.hasTeddy);
+
+   pBegin = (const uint8_t*) test1, pEnd = pBegin + strlen(test1);
+   for (i = 0u; i < 2u; i++)
+   {
+      bstr_simd_set_features(featureSets[i]);
+      match_log_create(&m_log1, pBegin, MAX_RECORDED_MATCHES);
+      CuAssertUIntEquals(tc, 3u, bstr_matcher_scan(&matcher, pBegin, pEnd, match_log_add, &m_log1));
+      CuAssertUIntEquals(tc, 3u, m_log1.numMatches);
+      //"she" and "he" end at the same position, longest first
+      CuAssertUIntEquals(tc, 2u, m_log1.patternId[0]);
+      CuAssertUIntEquals(tc, 1u, m_log1.offset[0]);
+      CuAssertUIntEquals(tc, 1u, m_log1.patternId[1]);
+      CuAssertUIntEquals(tc, 2u, m_log1.offset[1]);
+      CuAssertUIntEquals(tc, 4u, m_log1.patternId[2]);
+      CuAssertUIntEquals(tc, 2u, m_log1.offset[2]);
+      CuAssertUIntEquals(tc, 4u, m_log1.length[2]);
+   }
+   bstr_simd_set_features(0xFFFFFFFFu);
+   bstr_matcher_destroy(&matcher);
+}
+
+static void test_bstr_matcher_find(CuTest* tc)
+{
+   const char *test1 = "Oct 17 kernel: usb 1-1: device descriptor read error";
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   const uint8_t *pResult;
+   bstr_matcher_t *matcher;
+   bstr_match_t match;
+
+   matcher = bstr_matcher_new();
+   CuAssertPtrNotNull(tc, matcher);
+   bstr_matcher_add_cstr(matcher, "error", 10u);
+   bstr_matcher_add_cstr(matcher, "warning", 20u);
+   bstr_matcher_add_cstr(matcher, "usb", 30u);
+   bstr_matcher_compile(matcher);
+
+   pBegin = (const uint8_t*) test1, pEnd = pBegin + strlen(test1);
+   pResult = bstr_matcher_find(matcher, pBegin, pEnd, &match);
+   CuAssertConstPtrEquals(tc, pBegin + 18, pResult);
+   CuAssertUIntEquals(tc, 30u, match.patternId);
+   CuAssertConstPtrEquals(tc, pBegin + 15, match.pBegin);
+   pResult = bstr_matcher_find(matcher, pResult, pEnd, &match);
+   CuAssertConstPtrEquals(tc, pEnd, pResult);
+   CuAssertUIntEquals(tc, 10u, match.patternId);
+   pResult = bstr_matcher_find(matcher, pResult, pEnd, &match);
+   CuAssertConstPtrEquals(tc, pEnd, pResult);
+   //matches must lie completely inside the given bounds
+   CuAssertConstPtrEquals(tc, pBegin + 16, bstr_matcher_find(matcher, pBegin + 16, pEnd - 1, &match));
+   bstr_matcher_delete(matcher);
+}
+
+static void test_bstr_matcher_invalid_arguments(CuTest* tc)
+{
+   const char *test1 = "abc";
+   bstr_matcher_t matcher;
+   bstr_match_t match;
+
+   bstr_matcher_create(&matcher);
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_matcher_add_cstr(&matcher, "", 1u));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_matcher_add_cstr(&matcher, NULL, 1u));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_add_cstr(&matcher, "b", 1u));
+   //not compiled yet
+   CuAssertConstPtrEquals(tc, NULL, bstr_matcher_find(&matcher, (const uint8_t*) test1, (const uint8_t*) test1 + 3, &match));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_compile(&matcher));
+   CuAssertConstPtrEquals(tc, test1 + 2, bstr_matcher_find(&matcher, (const uint8_t*) test1, (const uint8_t*) test1 + 3, &match));
+   CuAssertUIntEquals(tc, 0u, bstr_matcher_scan(&matcher, (const uint8_t*) test1, (const uint8_t*) test1, NULL, NULL));
+   bstr_matcher_destroy(&matcher);
+}
+
+static void test_bstr_matcher_teddy_equals_dfa(CuTest* tc)
+{
+   uint8_t buf[3000];
+   bstr_matcher_t matcher;
+   uint32_t seed = 99u;
+   uint32_t numPatterns;
+   size_t k;
+
+   for (k = 0u; k < sizeof(buf); k++)
+   {
+      seed = seed * 1103515245u + 12345u;
+      buf[k] = (uint8_t) ('a' + (seed >> 16) % 6u);
+   }
+   for (numPatterns = 1u; numPatterns <= BSTR_TEDDY_MAX_PATTERNS; numPatterns += 5u)
+   {
+      uint32_t i;
+      char msg[32];
+      bstr_matcher_create(&matcher);
+      for (i = 0u; i < numPatterns; i++)
+      {
+         uint8_t pattern[8];
+         size_t len = 1u + (i % 6u);
+         for (k = 0u; k < len; k++)
+         {
+            seed = seed * 1103515245u + 12345u;
+            pattern[k] = (uint8_t) ('a' + (seed >> 16) % 6u);
+         }
+         bstr_matcher_add_bstr(&matcher, pattern, pattern + len, i);
+      }
+      bstr_matcher_compile(&matcher);
+      sprintf(msg, "numPatterns=%u", (unsigned) numPatterns);
+      CuAssert(tc, msg, matcher.hasTeddy);
+      bstr_simd_set_features(0u);
+      match_log_create(&m_log1, buf, MAX_RECORDED_MATCHES);
+      bstr_matcher_scan(&matcher, buf, buf + sizeof(buf), match_log_add, &m_log1);
+      bstr_simd_set_features(0xFFFFFFFFu);
+      match_log_create(&m_log2, buf, MAX_RECORDED_MATCHES);
+      bstr_matcher_scan(&matcher, buf, buf + sizeof(buf), match_log_add, &m_log2);
+      CuAssertUIntEquals_Msg(tc, msg, m_log1.numMatches, m_log2.numMatches);
+      CuAssert(tc, msg, memcmp(m_log1.offset, m_log2.offset, m_log1.numMatches * sizeof(uint32_t)) == 0);
+      CuAssert(tc, msg, memcmp(m_log1.patternId, m_log2.patternId, m_log1.numMatches * sizeof(uint32_t)) == 0);
+      bstr_simd_set_features(BSTR_SIMD_SSE2 | BSTR_SIMD_SSSE3);
+      match_log_create(&m_log2, buf, MAX_RECORDED_MATCHES);
+      bstr_matcher_scan(&matcher, buf, buf + sizeof(buf), match_log_add, &m_log2);
+      bstr_simd_set_features(0xFFFFFFFFu);
+      CuAssertUIntEquals_Msg(tc, msg, m_log1.numMatches, m_log2.numMatches);
+      CuAssert(tc, msg, memcmp(m_log1.offset, m_log2.offset, m_log1.numMatches * sizeof(uint32_t)) == 0);
+      CuAssert(tc, msg, memcmp(m_log1.patternId, m_log2.patternId, m_log1.numMatches * sizeof(uint32_t)) == 0);
+      bstr_matcher_destroy(&matcher);
+   }
+}
+
+static void test_bstr_matcher_large_set(CuTest* tc)
+{
+   const char *test1 = "key17=1;key170=2;key999=3;nokey";
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   bstr_matcher_t matcher;
+   uint32_t i;
+
+   bstr_matcher_create(&matcher);
+   for (i = 0u; i < 500u; i++)
+   {
+      char pattern[16];
+      sprintf(pattern, "key%u=", (unsigned) i);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_add_cstr(&matcher, pattern, i));
+   }
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_matcher_compile(&matcher));
+   CuAssertTrue(tc, !matcher.hasTeddy);
+   pBegin = (const uint8_t*) test1, pEnd = pBegin + strlen(test1);
+   match_log_create(&m_log1, pBegin, MAX_RECORDED_MATCHES);
+   CuAssertUIntEquals(tc, 2u, bstr_matcher_scan(&matcher, pBegin, pEnd, match_log_add, &m_log1));
+   CuAssertUIntEquals(tc, 17u, m_log1.patternId[0]);
+   CuAssertUIntEquals(tc, 0u, m_log1.offset[0]);
+   CuAssertUIntEquals(tc, 170u, m_log1.patternId[1]);
+   CuAssertUIntEquals(tc, 8u, m_log1.offset[1]);
+   //stop after first match
+   match_log_create(&m_log1, pBegin, 1u);
+   CuAssertUIntEquals(tc, 1u, bstr_matcher_scan(&matcher, pBegin, pEnd, match_log_add, &m_log1));
+   bstr_matcher_destroy(&matcher);
+}
+
+static void match_log_create(match_log_t *log, const uint8_t *pBase, uint32_t maxMatches)
+{
+   log->pBase = pBase;
+   log->numMatches = 0u;
+   log->maxMatches = maxMatches;
+}
+
+static bool match_log_add(void *arg, const bstr_match_t *match)
+{
+   match_log_t *log = (match_log_t*) arg;
+   if (log->numMatches < MAX_RECORDED_MATCHES)
+   {
+      log->offset[log->numMatches] = (uint32_t) (match->pBegin - log->pBase);
+      log->length[log->numMatches] = (uint32_t) (match->pEnd - match->pBegin);
+      log->patternId[log->numMatches] = match->patternId;
+   }
+   log->numMatches++;
+   return log->numMatches < log->maxMatches;
+}
@@ -0,0 +1,367 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "bstr_parallel.h"
+#include "test_util.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_GENERATED_LINES 5000
+#define LINE_FORMAT "%d %.*s\n"   //lines of different lengths starting with their number
+#define LINE_PADDING "{\"padding\":\"abcdefghijklmnopqrstuvwxyz\"}"
+
+typedef struct line_stats_tag
+{
+   unsigned seen[NUM_GENERATED_LINES];       //each line is visited by one worker only
+   size_t numLines[BSTR_PARALLEL_MAX_THREADS];
+   size_t numEmpty[BSTR_PARALLEL_MAX_THREADS];
+   size_t numBytes[BSTR_PARALLEL_MAX_THREADS];
+   unsigned numThreads;                      //lines visited by a worker index outside 0..numThreads-1 stop processing
+   int stopAt;                               //line number to return false at, -1 to visit all lines
+} line_stats_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_bstr_parallel_lines(CuTest* tc);
+static void test_bstr_parallel_ordered(CuTest* tc);
+static void test_bstr_parallel_edge_cases(CuTest* tc);
+static void test_bstr_parallel_stop(CuTest* tc);
+static void line_stats_reset(line_stats_t *stats, unsigned numThreads, int stopAt);
+static size_t line_stats_sum(const size_t *values);
+static bool count_line(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out);
+static bool copy_line(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out);
+static bool copy_number(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out);
+static int line_number(const uint8_t *pBegin, const uint8_t *pEnd);
+static void *sized_alloc(void *arg, size_t size);
+static void *sized_realloc(void *arg, void *ptr, size_t oldSize, size_t newSize);
+static void sized_free(void *arg, void *ptr, size_t size);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const unsigned m_threadCounts[4] = {1u, 3u, 8u, 17u};
+static line_stats_t m_stats;
+static unsigned m_numSizeMismatches; //only written when a block is resized or freed with the wrong size
+static const bstr_allocator_t m_sizedAllocator = {sized_alloc, sized_realloc, sized_free, &m_numSizeMismatches};
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_bstr_parallel(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_bstr_parallel_lines);
+   SUITE_ADD_TEST(suite, test_bstr_parallel_ordered);
+   SUITE_ADD_TEST(suite, test_bstr_parallel_edge_cases);
+   SUITE_ADD_TEST(suite, test_bstr_parallel_stop);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_bstr_parallel_lines(CuTest* tc)
+{
+   size_t length;
+   char *input = test_generate_lines(NUM_GENERATED_LINES, LINE_FORMAT, LINE_PADDING, &length);
+   const uint8_t *pBegin = (const uint8_t*) input;
+   bstr_parallel_options_t options;
+   size_t i;
+   int j;
+   CuAssertPtrNotNull(tc, input);
+   bstr_parallel_options_create(&options);
+   CuAssertTrue(tc, bstr_parallel_num_processors() >= 1u);
+   CuAssertIntEquals(tc, (int) bstr_parallel_num_processors(), (int) bstr_parallel_num_threads(&options));
+   for (i = 0u; i < 8u; i++)
+   {
+      //small chunks make boundaries fall inside lines and give the workers something to steal
+      options.numThreads = m_threadCounts[i % 4u];
+      options.minChunkSize = (i < 4u) ? 1u : 0u;
+      CuAssertIntEquals(tc, (int) m_threadCounts[i % 4u], (int) bstr_parallel_num_threads(&options));
+      line_stats_reset(&m_stats, options.numThreads, -1);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_parallel_lines(pBegin, pBegin + length, count_line, &m_stats, &options, 0));
+      CuAssertIntEquals(tc, NUM_GENERATED_LINES, (int) line_stats_sum(m_stats.numLines));
+      CuAssertIntEquals(tc, (int) (length - NUM_GENERATED_LINES), (int) line_stats_sum(m_stats.numBytes));
+      for (j = 0; j < NUM_GENERATED_LINES; j++)
+      {
+         CuAssertIntEquals(tc, 1, (int) m_stats.seen[j]);
+      }
+   }
+   options.numThreads = 100000u;
+   CuAssertIntEquals(tc, BSTR_PARALLEL_MAX_THREADS, (int) bstr_parallel_num_threads(&options));
+   free(input);
+}
+
+static void test_bstr_parallel_ordered(CuTest* tc)
+{
+   size_t length;
+   char *input = test_generate_lines(NUM_GENERATED_LINES, LINE_FORMAT, LINE_PADDING, &length);
+   const uint8_t *pBegin = (const uint8_t*) input;
+   bstr_parallel_options_t options;
+   bstr_buf_t output;
+   size_t i;
+   CuAssertPtrNotNull(tc, input);
+   bstr_parallel_options_create(&options);
+   bstr_buf_create(&output, 0);
+   for (i = 0u; i < 4u; i++)
+   {
+      const uint8_t *pOutBegin;
+      const uint8_t *pOutEnd;
+      int expected = 0;
+      options.numThreads = m_threadCounts[i];
+      options.minChunkSize = 100u;
+      //the output of each chunk is merged in input order, whichever worker ran it
+      bstr_buf_clear(&output);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_parallel_lines(pBegin, pBegin + length, copy_line, 0, &options, &output));
+      CuAssertIntEquals(tc, (int) length, (int) bstr_buf_length(&output));
+      CuAssertTrue(tc, memcmp(bstr_buf_data(&output), input, length) == 0);
+      bstr_buf_clear(&output);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_parallel_lines(pBegin, pBegin + length, copy_number, 0, &options, &output));
+      CuAssertIntEquals(tc, NUM_GENERATED_LINES * (int) sizeof(int), (int) bstr_buf_length(&output));
+      bstr_buf_view(&output, &pOutBegin, &pOutEnd);
+      for (; pOutBegin < pOutEnd; pOutBegin += sizeof(int))
+      {
+         int number;
+         memcpy(&number, pOutBegin, sizeof(int));
+         CuAssertIntEquals(tc, expected++, number);
+      }
+   }
+   bstr_buf_destroy(&output);
+   free(input);
+}
+
+static void test_bstr_parallel_edge_cases(CuTest* tc)
+{
+   static const struct
+   {
+      const char *input;
+      int numLines;
+      int numEmpty;
+      int numBytes;
+   } cases[] = {
+      {"", 0, 0, 0},
+      {"\n", 1, 1, 0},
+      {"\n\n\n", 3, 3, 0},
+      {"single line without newline", 1, 0, 27},
+      {"a\nb", 2, 0, 2},
+      {"a\r\nb\r\n", 2, 0, 4},
+      {"\nmiddle\n\n", 3, 2, 6},
+   };
+   bstr_parallel_options_t options;
+   char *longLine;
+   size_t i;
+   size_t j;
+   bstr_parallel_options_create(&options);
+   options.minChunkSize = 1u;
+   for (i = 0u; i < sizeof(cases) / sizeof(cases[0]); i++)
+   {
+      const uint8_t *pBegin = (const uint8_t*) cases[i].input;
+      for (j = 0u; j < 4u; j++)
+      {
+         options.numThreads = m_threadCounts[j];
+         line_stats_reset(&m_stats, options.numThreads, -1);
+         CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_parallel_lines(pBegin, pBegin + strlen(cases[i].input), count_line, &m_stats, &options, 0));
+         CuAssertIntEquals(tc, cases[i].numLines, (int) line_stats_sum(m_stats.numLines));
+         CuAssertIntEquals(tc, cases[i].numEmpty, (int) line_stats_sum(m_stats.numEmpty));
+         CuAssertIntEquals(tc, cases[i].numBytes, (int) line_stats_sum(m_stats.numBytes));
+      }
+   }
+   //a line longer than all chunks together, the job arrays are still freed with the size they were allocated with
+   longLine = (char*) malloc(10000u);
+   CuAssertPtrNotNull(tc, longLine);
+   memset(longLine, 'x', 10000u);
+   longLine[9999] = '\n';
+   options.numThreads = 8u;
+   options.allocator = &m_sizedAllocator;
+   m_numSizeMismatches = 0u;
+   for (j = 0u; j < 2u; j++)
+   {
+      bstr_buf_t output;
+      bstr_buf_create(&output, 0);
+      line_stats_reset(&m_stats, options.numThreads, -1);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_parallel_lines((const uint8_t*) longLine, (const uint8_t*) longLine + 10000u, count_line, &m_stats, &options, (j == 0u) ? 0 : &output));
+      CuAssertIntEquals(tc, 1, (int) line_stats_sum(m_stats.numLines));
+      CuAssertIntEquals(tc, 9999, (int) line_stats_sum(m_stats.numBytes));
+      bstr_buf_destroy(&output);
+   }
+   CuAssertIntEquals(tc, 0, (int) m_numSizeMismatches);
+   options.allocator = 0;
+   free(longLine);
+   //NULL options selects the defaults
+   line_stats_reset(&m_stats, bstr_parallel_num_threads(0), -1);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_parallel_lines((const uint8_t*) "1\n2\n", (const uint8_t*) "1\n2\n" + 4, count_line, &m_stats, 0, 0));
+   CuAssertIntEquals(tc, 2, (int) line_stats_sum(m_stats.numLines));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_parallel_lines(0, 0, count_line, &m_stats, 0, 0));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_parallel_lines((const uint8_t*) "1\n", (const uint8_t*) "1\n" + 2, 0, 0, 0, 0));
+}
+
+static void test_bstr_parallel_stop(CuTest* tc)
+{
+   size_t length;
+   char *input = test_generate_lines(NUM_GENERATED_LINES, LINE_FORMAT, LINE_PADDING, &length);
+   const uint8_t *pBegin = (const uint8_t*) input;
+   bstr_parallel_options_t options;
+   bstr_buf_t output;
+   size_t i;
+   CuAssertPtrNotNull(tc, input);
+   bstr_parallel_options_create(&options);
+   bstr_buf_create(&output, 0);
+   options.minChunkSize = 1000u;
+   //a single worker visits lines in order and stops right away
+   options.numThreads = 1u;
+   line_stats_reset(&m_stats, options.numThreads, 100);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_parallel_lines(pBegin, pBegin + length, count_line, &m_stats, &options, 0));
+   CuAssertIntEquals(tc, 101, (int) line_stats_sum(m_stats.numLines));
+   CuAssertIntEquals(tc, 1, (int) m_stats.seen[100]);
+   CuAssertIntEquals(tc, 0, (int) m_stats.seen[101]);
+   //with more workers the chunks not yet started are skipped
+   for (i = 1u; i < 4u; i++)
+   {
+      options.numThreads = m_threadCounts[i];
+      line_stats_reset(&m_stats, options.numThreads, 0);
+      bstr_buf_clear(&output);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_parallel_lines(pBegin, pBegin + length, count_line, &m_stats, &options, &output));
+      CuAssertIntEquals(tc, 1, (int) m_stats.seen[0]);
+      CuAssertTrue(tc, line_stats_sum(m_stats.numLines) < NUM_GENERATED_LINES);
+      //the stopping chunk is the first one so nothing is merged
+      CuAssertIntEquals(tc, 0, (int) bstr_buf_length(&output));
+   }
+   bstr_buf_destroy(&output);
+   free(input);
+}
+
+static void line_stats_reset(line_stats_t *stats, unsigned numThreads, int stopAt)
+{
+   memset(stats, 0, sizeof(line_stats_t));
+   stats->numThreads = numThreads;
+   stats->stopAt = stopAt;
+}
+
+static size_t line_stats_sum(const size_t *values)
+{
+   size_t sum = 0u;
+   unsigned i;
+   for (i = 0u; i < BSTR_PARALLEL_MAX_THREADS; i++)
+   {
+      sum += values[i];
+   }
+   return sum;
+}
+
+static bool count_line(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out)
+{
+   line_stats_t *stats = (line_stats_t*) arg;
+   int number = line_number(pBegin, pEnd);
+   (void) out;
+   if (worker >= stats->numThreads)
+   {
+      return false;
+   }
+   if ( (number >= 0) && (number < NUM_GENERATED_LINES) )
+   {
+      stats->seen[number]++;
+   }
+   stats->numLines[worker]++;
+   stats->numBytes[worker] += (size_t) (pEnd - pBegin);
+   if (pBegin == pEnd)
+   {
+      stats->numEmpty[worker]++;
+   }
+   return (stats->stopAt < 0) || (number != stats->stopAt);
+}
+
+static bool copy_line(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out)
+{
+   (void) arg;
+   (void) worker;
+   return (bstr_buf_append_bstr(out, pBegin, pEnd) == BSTR_NO_ERROR) && (bstr_buf_push(out, (uint8_t) '\n') == BSTR_NO_ERROR);
+}
+
+static bool copy_number(void *arg, unsigned worker, const uint8_t *pBegin, const uint8_t *pEnd, bstr_buf_t *out)
+{
+   int number = line_number(pBegin, pEnd);
+   (void) arg;
+   (void) worker;
+   return (bstr_buf_append_bstr(out, (const uint8_t*) &number, (const uint8_t*) &number + sizeof(int)) == BSTR_NO_ERROR);
+}
+
+/**
+ * Returns the decimal number at the start of the line, -1 when there is none.
+ */
+static int line_number(const uint8_t *pBegin, const uint8_t *pEnd)
+{
+   int number = -1;
+   while ( (pBegin < pEnd) && (*pBegin >= (uint8_t) '0') && (*pBegin <= (uint8_t) '9') )
+   {
+      number = ((number < 0) ? 0 : number * 10) + (int) (*pBegin - '0');
+      pBegin++;
+   }
+   return number;
+}
+
+/**
+ * Each block is prefixed with its size so that the size given back by bstr_parallel_lines can be verified
+ */
+static void *sized_alloc(void *arg, size_t size)
+{
+   size_t *p = (size_t*) malloc(size + 2u * sizeof(size_t));
+   (void) arg;
+   if (p == 0)
+   {
+      return 0;
+   }
+   p[0] = size;
+   return p + 2;
+}
+
+static void *sized_realloc(void *arg, void *ptr, size_t oldSize, size_t newSize)
+{
+   size_t *p;
+   if (ptr == 0)
+   {
+      return sized_alloc(arg, newSize);
+   }
+   p = ((size_t*) ptr) - 2;
+   if (p[0] != oldSize)
+   {
+      (*(unsigned*) arg)++;
+   }
+   p = (size_t*) realloc(p, newSize + 2u * sizeof(size_t));
+   if (p == 0)
+   {
+      return 0;
+   }
+   p[0] = newSize;
+   return p + 2;
+}
+
+static void sized_free(void *arg, void *ptr, size_t size)
+{
+   if (ptr != 0)
+   {
+      size_t *p = ((size_t*) ptr) - 2;
+      if (p[0] != size)
+      {
+         (*(unsigned*) arg)++;
+      }
+      free(p);
+   }
+}
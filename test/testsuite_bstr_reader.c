@@ -0,0 +1,316 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE //fileno
+#endif
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "CuTest.h"
+#include "bstr_reader.h"
+#include "test_util.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define TEST_FILE_NAME "bstr_reader_test.tmp"
+#define NUM_GENERATED_LINES 5000
+#define LONG_LINE_LENGTH 10000
+#define LINE_FORMAT "{\"id\":%d,\"text\":\"%.*s\"}\n"
+#define LINE_PADDING "abcdefghijklmnopqrstuvwxyz01234"
+
+#if defined(_WIN32)
+#define fileno _fileno
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_bstr_reader_lines(CuTest* tc);
+static void test_bstr_reader_tokens(CuTest* tc);
+static void test_bstr_reader_pin(CuTest* tc);
+#if !defined(_WIN32)
+static void test_bstr_reader_pipe(CuTest* tc);
+#endif
+static char *generate_input(size_t *length);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint32_t m_flags[4] = {
+   0u,
+   BSTR_READER_RING,
+   BSTR_READER_IO_URING,
+   BSTR_READER_RING | BSTR_READER_IO_URING
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+CuSuite* testsuite_bstr_reader(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_bstr_reader_lines);
+   SUITE_ADD_TEST(suite, test_bstr_reader_tokens);
+   SUITE_ADD_TEST(suite, test_bstr_reader_pin);
+#if !defined(_WIN32)
+   SUITE_ADD_TEST(suite, test_bstr_reader_pipe);
+#endif
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Reads lines through small buffers with every backend.
+ */
+static void test_bstr_reader_lines(CuTest* tc)
+{
+   static const size_t capacities[3] = {100u, 4096u, 0u};
+   size_t length;
+   char *data = generate_input(&length);
+   bstr_reader_t invalid;
+   size_t i;
+   size_t j;
+   CuAssertPtrNotNull(tc, data);
+   CuAssertTrue(tc, test_write_file(TEST_FILE_NAME, data, length));
+   for (i = 0u; i < sizeof(m_flags) / sizeof(m_flags[0]); i++)
+   {
+      for (j = 0u; j < sizeof(capacities) / sizeof(capacities[0]); j++)
+      {
+         FILE *fh = fopen(TEST_FILE_NAME, "rb");
+         bstr_reader_t reader;
+         const uint8_t *pExpected = (const uint8_t*) data;
+         const uint8_t *pDataEnd = (const uint8_t*) data + length;
+         const uint8_t *pBegin;
+         const uint8_t *pEnd;
+         size_t numLines = 0u;
+         CuAssertPtrNotNull(tc, fh);
+         CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_reader_create(&reader, fileno(fh), capacities[j], m_flags[i], 0));
+         CuAssertTrue(tc, (reader.flags & ~m_flags[i]) == 0u);
+         while (bstr_reader_next_line(&reader, &pBegin, &pEnd))
+         {
+            const uint8_t *pExpectedEnd = bstr_line(pExpected, pDataEnd);
+            if ( (pExpectedEnd == pDataEnd) || (*pExpectedEnd != (uint8_t) '\n') )
+            {
+               pExpectedEnd = pDataEnd;
+            }
+            CuAssertIntEquals(tc, (int) (pExpectedEnd - pExpected), (int) (pEnd - pBegin));
+            CuAssertTrue(tc, memcmp(pBegin, pExpected, (size_t) (pEnd - pBegin)) == 0);
+            pExpected = (pExpectedEnd < pDataEnd) ? pExpectedEnd + 1 : pDataEnd;
+            numLines++;
+         }
+         CuAssertIntEquals(tc, BSTR_NO_ERROR, reader.lastError);
+         CuAssertTrue(tc, bstr_reader_eof(&reader));
+         CuAssertIntEquals(tc, NUM_GENERATED_LINES + 2, (int) numLines);
+         CuAssertTrue(tc, pExpected == pDataEnd);
+         CuAssertTrue(tc, !bstr_reader_next_line(&reader, &pBegin, &pEnd));
+         bstr_reader_destroy(&reader);
+         bstr_reader_destroy(&reader);
+         fclose(fh);
+      }
+   }
+   //empty file
+   CuAssertTrue(tc, test_write_file(TEST_FILE_NAME, data, 0u));
+   for (i = 0u; i < sizeof(m_flags) / sizeof(m_flags[0]); i++)
+   {
+      FILE *fh = fopen(TEST_FILE_NAME, "rb");
+      bstr_reader_t reader;
+      const uint8_t *pBegin;
+      const uint8_t *pEnd;
+      CuAssertPtrNotNull(tc, fh);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_reader_create(&reader, fileno(fh), 0u, m_flags[i], 0));
+      CuAssertTrue(tc, !bstr_reader_next_line(&reader, &pBegin, &pEnd));
+      CuAssertTrue(tc, bstr_reader_eof(&reader));
+      bstr_reader_destroy(&reader);
+      fclose(fh);
+   }
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_reader_create(0, 0, 0u, 0u, 0));
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_reader_create(&invalid, -1, 0u, 0u, 0));
+   (void) remove(TEST_FILE_NAME);
+   free(data);
+}
+
+static void test_bstr_reader_tokens(CuTest* tc)
+{
+   static const char *expected[7] = {"a", "bc", "", "d", "", "ef", "g h"};
+   const char *data = "a,bc;;d\n\nef,g h";
+   bstr_byteset_t separators;
+   size_t i;
+   bstr_byteset_create_cstr(&separators, ",;\n");
+   CuAssertTrue(tc, test_write_file(TEST_FILE_NAME, data, strlen(data)));
+   for (i = 0u; i < sizeof(m_flags) / sizeof(m_flags[0]); i++)
+   {
+      FILE *fh = fopen(TEST_FILE_NAME, "rb");
+      bstr_reader_t reader;
+      const uint8_t *pBegin;
+      const uint8_t *pEnd;
+      size_t numTokens = 0u;
+      CuAssertPtrNotNull(tc, fh);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_reader_create(&reader, fileno(fh), 4u, m_flags[i], 0));
+      while (bstr_reader_next_token(&reader, &separators, &pBegin, &pEnd))
+      {
+         CuAssertTrue(tc, numTokens < 7u);
+         CuAssertIntEquals(tc, (int) strlen(expected[numTokens]), (int) (pEnd - pBegin));
+         CuAssertTrue(tc, memcmp(pBegin, expected[numTokens], (size_t) (pEnd - pBegin)) == 0);
+         numTokens++;
+      }
+      CuAssertIntEquals(tc, 7, (int) numTokens);
+      CuAssertTrue(tc, bstr_reader_eof(&reader));
+      CuAssertTrue(tc, !bstr_reader_next_token(&reader, 0, &pBegin, &pEnd));
+      bstr_reader_destroy(&reader);
+      fclose(fh);
+   }
+   (void) remove(TEST_FILE_NAME);
+}
+
+/**
+ * Pinned views keep their address and content while reading on, until the buffer is full.
+ */
+static void test_bstr_reader_pin(CuTest* tc)
+{
+   static const char pinnedLine[] = "{\"id\":1,\"text\":\"a\"}";
+   size_t length;
+   char *data = generate_input(&length);
+   size_t i;
+   CuAssertPtrNotNull(tc, data);
+   CuAssertTrue(tc, test_write_file(TEST_FILE_NAME, data, length));
+   for (i = 0u; i < sizeof(m_flags) / sizeof(m_flags[0]); i++)
+   {
+      FILE *fh = fopen(TEST_FILE_NAME, "rb");
+      bstr_reader_t reader;
+      const uint8_t *pPinned;
+      const uint8_t *pPinnedEnd;
+      const uint8_t *pBegin;
+      const uint8_t *pEnd;
+      const uint8_t *pExpected;
+      size_t numLines = 1u;
+      size_t numPinned = 1u;
+      CuAssertPtrNotNull(tc, fh);
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_reader_create(&reader, fileno(fh), 4096u, m_flags[i], 0));
+      CuAssertTrue(tc, bstr_reader_next_line(&reader, &pBegin, &pEnd));
+      CuAssertTrue(tc, bstr_reader_next_line(&reader, &pPinned, &pPinnedEnd));
+      CuAssertIntEquals(tc, (int) sizeof(pinnedLine) - 1, (int) (pPinnedEnd - pPinned));
+      bstr_reader_pin(&reader);
+      bstr_reader_pin(&reader);
+      pExpected = (const uint8_t*) data + (pPinnedEnd - pPinned) + (pEnd - pBegin) + 2;
+      while (bstr_reader_next_line(&reader, &pBegin, &pEnd))
+      {
+         CuAssertTrue(tc, memcmp(pPinned, pinnedLine, sizeof(pinnedLine) - 1u) == 0);
+         CuAssertTrue(tc, memcmp(pBegin, pExpected, (size_t) (pEnd - pBegin)) == 0);
+         pExpected += (pEnd - pBegin) + 1;
+         numPinned++;
+      }
+      //the buffer is full of pinned lines
+      CuAssertIntEquals(tc, BSTR_MEM_ERROR, reader.lastError);
+      CuAssertTrue(tc, !bstr_reader_eof(&reader));
+      CuAssertTrue(tc, numPinned > 10u);
+      CuAssertTrue(tc, memcmp(pPinned, pinnedLine, sizeof(pinnedLine) - 1u) == 0);
+      bstr_reader_unpin(&reader);
+      numLines += numPinned;
+      while (bstr_reader_next_line(&reader, &pBegin, &pEnd))
+      {
+         CuAssertTrue(tc, memcmp(pBegin, pExpected, (size_t) (pEnd - pBegin)) == 0);
+         pExpected += (pEnd - pBegin) + 1;
+         numLines++;
+      }
+      CuAssertIntEquals(tc, BSTR_NO_ERROR, reader.lastError);
+      CuAssertTrue(tc, bstr_reader_eof(&reader));
+      CuAssertIntEquals(tc, NUM_GENERATED_LINES + 2, (int) numLines);
+      bstr_reader_destroy(&reader);
+      fclose(fh);
+   }
+   (void) remove(TEST_FILE_NAME);
+   free(data);
+}
+
+#if !defined(_WIN32)
+/**
+ * A non-blocking pipe without a complete line gives false without being at the end of the stream. With io_uring the
+ * reader is destroyed while its read-ahead waits for the writer.
+ */
+static void test_bstr_reader_pipe(CuTest* tc)
+{
+   bstr_reader_t reader;
+   const uint8_t *pBegin;
+   const uint8_t *pEnd;
+   int fds[2];
+   CuAssertIntEquals(tc, 0, pipe(fds));
+   CuAssertIntEquals(tc, 0, fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_reader_create(&reader, fds[0], 16u, BSTR_READER_RING, 0));
+   CuAssertTrue(tc, !bstr_reader_next_line(&reader, &pBegin, &pEnd));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, reader.lastError);
+   CuAssertTrue(tc, !bstr_reader_eof(&reader));
+   CuAssertIntEquals(tc, 6, (int) write(fds[1], "abc\nde", 6u));
+   CuAssertTrue(tc, bstr_reader_next_line(&reader, &pBegin, &pEnd));
+   CuAssertTrue(tc, (pEnd - pBegin == 3) && (memcmp(pBegin, "abc", 3u) == 0));
+   CuAssertTrue(tc, !bstr_reader_next_line(&reader, &pBegin, &pEnd));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, reader.lastError);
+   CuAssertTrue(tc, !bstr_reader_eof(&reader));
+   CuAssertIntEquals(tc, 4, (int) write(fds[1], "f\ngh", 4u));
+   CuAssertTrue(tc, bstr_reader_next_line(&reader, &pBegin, &pEnd));
+   CuAssertTrue(tc, (pEnd - pBegin == 3) && (memcmp(pBegin, "def", 3u) == 0));
+   close(fds[1]);
+   CuAssertTrue(tc, bstr_reader_next_line(&reader, &pBegin, &pEnd));
+   CuAssertTrue(tc, (pEnd - pBegin == 2) && (memcmp(pBegin, "gh", 2u) == 0));
+   CuAssertTrue(tc, !bstr_reader_next_line(&reader, &pBegin, &pEnd));
+   CuAssertTrue(tc, bstr_reader_eof(&reader));
+   bstr_reader_destroy(&reader);
+   close(fds[0]);
+
+   CuAssertIntEquals(tc, 0, pipe(fds));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_reader_create(&reader, fds[0], 0u, BSTR_READER_RING | BSTR_READER_IO_URING, 0));
+   CuAssertIntEquals(tc, 4, (int) write(fds[1], "x\ny\n", 4u));
+   CuAssertTrue(tc, bstr_reader_next_line(&reader, &pBegin, &pEnd));
+   CuAssertTrue(tc, (pEnd - pBegin == 1) && (*pBegin == (uint8_t) 'x'));
+   CuAssertTrue(tc, bstr_reader_next_line(&reader, &pBegin, &pEnd));
+   CuAssertTrue(tc, (pEnd - pBegin == 1) && (*pBegin == (uint8_t) 'y'));
+   bstr_reader_destroy(&reader);
+   close(fds[1]);
+   close(fds[0]);
+}
+#endif
+
+/**
+ * Generated lines followed by a line longer than the reader buffers, which makes them grow, and a last line without
+ * '\n'. That's NUM_GENERATED_LINES+2 lines.
+ */
+static char *generate_input(size_t *length)
+{
+   char *lines = test_generate_lines(NUM_GENERATED_LINES, LINE_FORMAT, LINE_PADDING, length);
+   char *data;
+   if (lines == 0)
+   {
+      return 0;
+   }
+   data = (char*) realloc(lines, *length + LONG_LINE_LENGTH + 5u);
+   if (data == 0)
+   {
+      free(lines);
+      *length = 0u;
+      return 0;
+   }
+   memset(&data[*length], 'x', LONG_LINE_LENGTH);
+   data[*length + LONG_LINE_LENGTH] = '\n';
+   memcpy(&data[*length + LONG_LINE_LENGTH + 1u], "last", 4u);
+   *length += LONG_LINE_LENGTH + 5u;
+   return data;
+}
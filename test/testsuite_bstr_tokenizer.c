@@ -0,0 +1,265 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "bstr_tokenizer.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define TOKEN_TEXT_SIZE 1024
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_bstr_tokenizer_single_chunk(CuTest* tc);
+static void test_bstr_tokenizer_split(CuTest* tc);
+static void test_bstr_tokenizer_errors(CuTest* tc);
+static bstr_error_t tokenize_chunks(const char *doc, size_t firstChunkLen, size_t chunkLen, char *text);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_document = "{\"name\": \"caf\xc3\xa9 \\u00e9\\ud83d\\ude00\", \"list\": [1, -2.5e3, 12345678901234567890, true, false, null],\r\n"
+                                "\t\"escaped\": \"a\\\"b\\\\\\/c\\n\", \"empty\": \"\", \"long\": \"0123456789abcdef0123456789abcdef0123456789\"}";
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testsuite_bstr_tokenizer(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_bstr_tokenizer_single_chunk);
+   SUITE_ADD_TEST(suite, test_bstr_tokenizer_split);
+   SUITE_ADD_TEST(suite, test_bstr_tokenizer_errors);
+
+   return suite;
+}
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_bstr_tokenizer_single_chunk(CuTest* tc)
+{
+   const uint8_t *pBegin = (const uint8_t*) m_document;
+   const uint8_t *pEnd = pBegin + strlen(m_document);
+   bstr_tokenizer_t tokenizer;
+   bstr_token_t token;
+   char text[TOKEN_TEXT_SIZE];
+
+   bstr_tokenizer_create(&tokenizer, 0);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_feed(&tokenizer, pBegin, pEnd));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_BEGIN_OBJECT, token.type);
+   CuAssertConstPtrEquals(tc, pBegin, token.pBegin);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_STRING, token.type);
+   CuAssertTrue(tc, token.isView);
+   CuAssertConstPtrEquals(tc, pBegin + 2, token.pBegin);
+   CuAssertConstPtrEquals(tc, pBegin + 6, token.pEnd);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_NAME_SEPARATOR, token.type);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_STRING, token.type);
+   CuAssertTrue(tc, !token.isView);
+   CuAssertIntEquals(tc, 12, (int) (token.pEnd - token.pBegin));
+   CuAssertTrue(tc, memcmp(token.pBegin, "caf\xc3\xa9 \xc3\xa9\xf0\x9f\x98\x80", 12) == 0);
+   bstr_tokenizer_destroy(&tokenizer);
+
+   //the number at the end of the input is only complete after bstr_tokenizer_finish
+   bstr_tokenizer_create(&tokenizer, 0);
+   pBegin = (const uint8_t*) "[-12.5";
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_feed(&tokenizer, pBegin, pBegin + 6));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_BEGIN_ARRAY, token.type);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_NEED_MORE, token.type);
+   bstr_tokenizer_finish(&tokenizer);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_NUMBER, token.type);
+   CuAssertIntEquals(tc, BSTR_NUMBER_DOUBLE, token.number.type);
+   CuAssertDblEquals(tc, -12.5, token.number.value.f64, 0.0);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_END, token.type);
+   bstr_tokenizer_destroy(&tokenizer);
+
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, tokenize_chunks(m_document, strlen(m_document), 0u, text));
+   CuAssertStrEquals(tc, "2{|8name|6:|8caf\xc3\xa9 \xc3\xa9\xf0\x9f\x98\x80|7,|8list|6:|4[|9(1)1|7,|9(3)-2.5e3|7,"
+                         "|9(2)12345678901234567890|7,|10true|7,|11false|7,|12null|5]|7,|8escaped|6:|8a\"b\\/c\n|7,|8empty|6:|8|7,"
+                         "|8long|6:|80123456789abcdef0123456789abcdef0123456789|3}|1|", text);
+}
+
+/**
+ * Every way of cutting the document must give the same tokens as a single chunk
+ */
+static void test_bstr_tokenizer_split(CuTest* tc)
+{
+   size_t len = strlen(m_document);
+   size_t i;
+   char expected[TOKEN_TEXT_SIZE];
+   char text[TOKEN_TEXT_SIZE];
+   char msg[40];
+
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, tokenize_chunks(m_document, len, 0u, expected));
+   for (i = 0u; i <= len; i++)
+   {
+      sprintf(msg, "split=%u", (unsigned) i);
+      CuAssertIntEquals_Msg(tc, msg, BSTR_NO_ERROR, tokenize_chunks(m_document, i, len, text));
+      CuAssertStrEquals_Msg(tc, msg, expected, text);
+   }
+   for (i = 1u; i <= 7u; i++)
+   {
+      sprintf(msg, "chunk=%u", (unsigned) i);
+      CuAssertIntEquals_Msg(tc, msg, BSTR_NO_ERROR, tokenize_chunks(m_document, i, i, text));
+      CuAssertStrEquals_Msg(tc, msg, expected, text);
+   }
+}
+
+static void test_bstr_tokenizer_errors(CuTest* tc)
+{
+   bstr_tokenizer_t tokenizer;
+   bstr_token_t token;
+   char text[TOKEN_TEXT_SIZE];
+   const uint8_t *chunk1 = (const uint8_t*) "[\"ab\\";
+   const uint8_t *chunk2 = (const uint8_t*) "q\"]";
+   const uint8_t *chunk3 = (const uint8_t*) "]]";
+   static const char *badNumbers[4] = {"01", "1e5-0.5", "null01", "[1, 2.5.1]"};
+   static const char *badEscapes[3] = {"\"\\u12\"", "\"\\uD800\\uDC\"", "[\"\\u12\", \"x\"]"};
+   size_t i;
+
+   //invalid escape cut by the chunk boundary
+   bstr_tokenizer_create(&tokenizer, 0);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_feed(&tokenizer, chunk1, chunk1 + 5));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_NEED_MORE, token.type);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_feed(&tokenizer, chunk2, chunk2 + 3));
+   CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   //errors are sticky
+   CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   bstr_tokenizer_reset(&tokenizer);
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_feed(&tokenizer, chunk3, chunk3 + 2));
+   CuAssertIntEquals(tc, BSTR_NO_ERROR, bstr_tokenizer_next(&tokenizer, &token));
+   CuAssertIntEquals(tc, BSTR_TOKEN_END_ARRAY, token.type);
+   //feeding before the chunk is consumed is not allowed
+   CuAssertIntEquals(tc, BSTR_INVALID_ARGUMENT_ERROR, bstr_tokenizer_feed(&tokenizer, chunk1, chunk1 + 1));
+   bstr_tokenizer_destroy(&tokenizer);
+
+   CuAssertIntEquals(tc, BSTR_PREMATURE_END_OF_BUFFER_ERROR, tokenize_chunks("[\"abc", 2u, 2u, text));
+   CuAssertIntEquals(tc, BSTR_PREMATURE_END_OF_BUFFER_ERROR, tokenize_chunks("[tru", 2u, 1u, text));
+   CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, tokenize_chunks("[trux]", 2u, 1u, text));
+   CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, tokenize_chunks("[1, x]", 2u, 1u, text));
+   CuAssertIntEquals(tc, BSTR_PARSE_ERROR, tokenize_chunks("[1.e5]", 2u, 1u, text));
+   CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, tokenize_chunks("[\"a\xc3\"]", 3u, 1u, text));
+   CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, tokenize_chunks("[\"a\x01\"]", 3u, 1u, text));
+   CuAssertIntEquals(tc, BSTR_INVALID_CHARACTER_ERROR, tokenize_chunks("[\"a\x01\"]", 7u, 1u, text));
+   //a number followed by number characters fails wherever the chunks are cut
+   for (i = 0u; i < sizeof(badNumbers) / sizeof(badNumbers[0]); i++)
+   {
+      size_t len = strlen(badNumbers[i]);
+      size_t j;
+      for (j = 1u; j <= len; j++)
+      {
+         char msg[48];
+         sprintf(msg, "%s chunk=%u", badNumbers[i], (unsigned) j);
+         CuAssertIntEquals_Msg(tc, msg, BSTR_PARSE_ERROR, tokenize_chunks(badNumbers[i], j, len, text));
+      }
+   }
+   //so does a \u escape cut short by the closing quotation mark
+   for (i = 0u; i < sizeof(badEscapes) / sizeof(badEscapes[0]); i++)
+   {
+      size_t len = strlen(badEscapes[i]);
+      size_t j;
+      for (j = 1u; j <= len; j++)
+      {
+         char msg[48];
+         sprintf(msg, "%s chunk=%u", badEscapes[i], (unsigned) j);
+         CuAssertIntEquals_Msg(tc, msg, BSTR_INVALID_CHARACTER_ERROR, tokenize_chunks(badEscapes[i], j, len, text));
+      }
+   }
+}
+
+/**
+ * Feeds doc to a tokenizer in chunks of chunkLen bytes (firstChunkLen for the first one) and writes the tokens
+ * as "type:text|" to text. Each chunk is a separate allocation which is freed once the tokenizer has consumed it.
+ */
+static bstr_error_t tokenize_chunks(const char *doc, size_t firstChunkLen, size_t chunkLen, char *text)
+{
+   bstr_tokenizer_t tokenizer;
+   bstr_token_t token;
+   bstr_error_t result = BSTR_NO_ERROR;
+   size_t len = strlen(doc);
+   size_t offset = 0u;
+   size_t textLen = 0u;
+   size_t numChunks = 0u;
+   uint8_t *chunk = 0;
+
+   bstr_tokenizer_create(&tokenizer, 0);
+   text[0] = '\0';
+   for (;;)
+   {
+      result = bstr_tokenizer_next(&tokenizer, &token);
+      if (result != BSTR_NO_ERROR)
+      {
+         break;
+      }
+      if (token.type == BSTR_TOKEN_NEED_MORE)
+      {
+         size_t n = (numChunks++ == 0u)? firstChunkLen : chunkLen;
+         if (n > (len - offset))
+         {
+            n = len - offset;
+         }
+         free(chunk);
+         chunk = (uint8_t*) malloc(n + 1u);
+         assert(chunk != 0);
+         memcpy(chunk, doc + offset, n);
+         (void) bstr_tokenizer_feed(&tokenizer, chunk, chunk + n);
+         offset += n;
+         if (offset == len)
+         {
+            bstr_tokenizer_finish(&tokenizer);
+         }
+         continue;
+      }
+      if (token.type == BSTR_TOKEN_NUMBER)
+      {
+         textLen += (size_t) sprintf(&text[textLen], "%u(%u)", (unsigned) token.type, (unsigned) token.number.type);
+      }
+      else
+      {
+         textLen += (size_t) sprintf(&text[textLen], "%u", (unsigned) token.type);
+      }
+      assert(textLen + (size_t) (token.pEnd - token.pBegin) + 2u < TOKEN_TEXT_SIZE);
+      if (token.pBegin != 0)
+      {
+         memcpy(&text[textLen], token.pBegin, (size_t) (token.pEnd - token.pBegin));
+         textLen += (size_t) (token.pEnd - token.pBegin);
+      }
+      text[textLen++] = '|';
+      text[textLen] = '\0';
+      if (token.type == BSTR_TOKEN_END)
+      {
+         break;
+      }
+   }
+   free(chunk);
+   bstr_tokenizer_destroy(&tokenizer);
+   return result;
+}